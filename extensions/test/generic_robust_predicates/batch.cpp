@@ -0,0 +1,119 @@
+// Boost.Geometry (aka GGL, Generic Geometry Library)
+// Unit Test
+
+// Copyright (c) 2020 Tinko Bartels, Berlin, Germany.
+
+// Contributed and/or modified by Tinko Bartels,
+//   as part of Google Summer of Code 2020 program.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include <geometry_test_common.hpp>
+
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/batch.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/expressions.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/stage_a.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/stage_b.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/stage_d.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/staged_predicate.hpp>
+
+namespace bgrp = bg::detail::generic_robust_predicates;
+
+template <typename Expression, typename Batch, std::size_t N>
+void test_expression(std::array<std::vector<double>, N> const& coordinates)
+{
+    using semi_static = bgrp::stage_a_semi_static<Expression, double>;
+    using exact = bgrp::stage_d<Expression, double>;
+    using fallback = bgrp::staged_predicate
+        <
+            Expression,
+            bgrp::stage_b<Expression, double>,
+            exact
+        >;
+
+    std::size_t const count = coordinates[0].size();
+    typename Batch::inputs_type inputs;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        inputs[i] = coordinates[i].data();
+    }
+
+    // the filter gives the same results as the scalar one
+    std::vector<int> signs(count);
+    Batch::apply(inputs, count, signs.data());
+    std::size_t uncertain = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        BOOST_CHECK_EQUAL(signs[i], (Batch::template apply_scalar<semi_static>(
+            inputs, i, std::make_index_sequence<N>())));
+        if (signs[i] == bgrp::sign_uncertain)
+        {
+            ++uncertain;
+        }
+    }
+    BOOST_CHECK(uncertain > 0);
+
+    // the uncertain instances are decided by the fallback
+    std::vector<int> robust_signs(count);
+    bgrp::apply_batch<Batch>(inputs, count, robust_signs.data(), fallback());
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        BOOST_CHECK_EQUAL(robust_signs[i], (Batch::template apply_scalar<exact>(
+            inputs, i, std::make_index_sequence<N>())));
+    }
+}
+
+// The points are taken from a small grid so many of them are collinear
+// or cocircular, some are moved by a small distance.
+template <std::size_t N>
+std::array<std::vector<double>, N> generate_coordinates(std::size_t count)
+{
+    std::mt19937 gen(12345);
+    std::uniform_int_distribution<int> grid(-3, 3);
+    std::uniform_int_distribution<int> perturb(0, 9);
+    std::array<std::vector<double>, N> result;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        for (std::size_t j = 0; j < N; ++j)
+        {
+            double c = 1000.0 + grid(gen) * 0.1;
+            if (perturb(gen) == 0)
+            {
+                c += 1e-14;
+            }
+            result[j].push_back(c);
+        }
+    }
+    return result;
+}
+
+int test_main(int, char* [])
+{
+    test_expression
+        <
+            bgrp::orient2d,
+            bgrp::stage_a_semi_static_batch<bgrp::orient2d, double>
+        >(generate_coordinates<6>(1003));
+    test_expression
+        <
+            bgrp::orient2d,
+            bgrp::stage_a_semi_static_batch<bgrp::orient2d, double, 8>
+        >(generate_coordinates<6>(1003));
+    test_expression
+        <
+            bgrp::incircle,
+            bgrp::stage_a_semi_static_batch<bgrp::incircle, double>
+        >(generate_coordinates<8>(1001));
+    test_expression
+        <
+            bgrp::orient3d,
+            bgrp::stage_a_semi_static_batch<bgrp::orient3d, double>
+        >(generate_coordinates<12>(517));
+    return 0;
+}
@@ -0,0 +1,222 @@
+// Boost.Geometry (aka GGL, Generic Geometry Library)
+// Unit Test
+
+// Copyright (c) 2020 Tinko Bartels, Berlin, Germany.
+
+// Contributed and/or modified by Tinko Bartels,
+//   as part of Google Summer of Code 2020 program.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <array>
+#include <cstdint>
+#include <random>
+
+#include <geometry_test_common.hpp>
+
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/expressions.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/stage_a.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/stage_b.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/stage_d.hpp>
+
+namespace bgrp = bg::detail::generic_robust_predicates;
+
+using int_t = __int128;
+
+int sign(int_t v)
+{
+    return v > 0 ? 1 : (v < 0 ? -1 : 0);
+}
+
+int_t det2x2(int_t a11, int_t a12, int_t a21, int_t a22)
+{
+    return a11 * a22 - a12 * a21;
+}
+
+// the same cofactor expansion as det3x3 in expressions.hpp
+int_t det3x3(int_t a11, int_t a12, int_t a13,
+             int_t a21, int_t a22, int_t a23,
+             int_t a31, int_t a32, int_t a33)
+{
+    return a11 * det2x2(a22, a23, a32, a33)
+         + a21 * det2x2(a12, a13, a32, a33)
+         + a31 * det2x2(a12, a13, a22, a23);
+}
+
+int orient3d_sign(std::array<std::int64_t, 12> const& p)
+{
+    int_t d[9];
+    for (int i = 0; i < 9; ++i)
+    {
+        d[i] = int_t(p[i]) - int_t(p[9 + i % 3]);
+    }
+    return sign(det3x3(d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8]));
+}
+
+int incircle_sign(std::array<std::int64_t, 8> const& p)
+{
+    int_t d[6];
+    for (int i = 0; i < 6; ++i)
+    {
+        d[i] = int_t(p[i]) - int_t(p[6 + i % 2]);
+    }
+    int_t lift[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        lift[i] = d[2 * i] * d[2 * i] + d[2 * i + 1] * d[2 * i + 1];
+    }
+    return sign(det3x3(lift[0], d[0], d[1],
+                       lift[1], d[2], d[3],
+                       lift[2], d[4], d[5]));
+}
+
+template <typename Stage, typename Arr, std::size_t... I>
+int apply_stage(Arr const& a, std::index_sequence<I...>)
+{
+    return Stage::apply(static_cast<double>(a[I])...);
+}
+
+template <typename Stage, typename T, std::size_t N>
+int apply_stage(std::array<T, N> const& a)
+{
+    return apply_stage<Stage>(a, std::make_index_sequence<N>());
+}
+
+// Nearly coplanar and cocircular points with large coordinates. The integer
+// coordinates are exactly representable so the signs are checked against
+// the determinants calculated with 128-bit integers.
+void test_integer_coordinates()
+{
+    std::mt19937_64 gen(12345);
+    std::uniform_int_distribution<std::int64_t> small(-1000, 1000);
+    std::uniform_int_distribution<std::int64_t> perturbation(-1, 1);
+    std::int64_t const offset = std::int64_t(1) << 38;
+
+    int uncertain_a = 0;
+    for (int i = 0; i < 2000; ++i)
+    {
+        // the points on the plane z = a * x + b * y + c
+        std::int64_t const a = small(gen), b = small(gen), c = offset;
+        std::array<std::int64_t, 12> p;
+        for (int j = 0; j < 4; ++j)
+        {
+            p[3 * j] = offset + small(gen) * 1000;
+            p[3 * j + 1] = offset + small(gen) * 1000;
+            p[3 * j + 2] = a * (p[3 * j] - offset) + b * (p[3 * j + 1] - offset) + c;
+        }
+        p[11] += perturbation(gen);
+        int const expected = orient3d_sign(p);
+        BOOST_CHECK_EQUAL(expected, (apply_stage<bgrp::stage_d<bgrp::orient3d, double>>(p)));
+        // the differences of the coordinates are exact
+        BOOST_CHECK_EQUAL(expected, (apply_stage<bgrp::stage_b<bgrp::orient3d, double>>(p)));
+        int const sign_a = apply_stage<bgrp::stage_a_semi_static<bgrp::orient3d, double>>(p);
+        if (sign_a == bgrp::sign_uncertain)
+        {
+            ++uncertain_a;
+        }
+        else
+        {
+            BOOST_CHECK_EQUAL(expected, sign_a);
+        }
+    }
+    // the filter can't decide the degenerate cases
+    BOOST_CHECK(uncertain_a > 0);
+
+    // the points close to the circle centered at the offset with radius 5 * k
+    std::array<std::int64_t, 8> const circle = {{ 3, 4, -4, 3, 0, -5, 5, 0 }};
+    for (int i = 0; i < 2000; ++i)
+    {
+        std::int64_t const k = 1 + (i % 50) * 100000;
+        std::array<std::int64_t, 8> p;
+        for (int j = 0; j < 4; ++j)
+        {
+            int const point = (i + j) % 4;
+            p[2 * j] = offset + circle[2 * point] * k + perturbation(gen);
+            p[2 * j + 1] = offset + circle[2 * point + 1] * k + perturbation(gen);
+        }
+        int const expected = incircle_sign(p);
+        BOOST_CHECK_EQUAL(expected, (apply_stage<bgrp::stage_d<bgrp::incircle, double>>(p)));
+        BOOST_CHECK_EQUAL(expected, (apply_stage<bgrp::stage_b<bgrp::incircle, double>>(p)));
+    }
+}
+
+void test_rounded_differences()
+{
+    // the differences are not exact so stage B can't decide
+    double const tiny = 1e-30;
+    BOOST_CHECK_EQUAL(bgrp::sign_uncertain,
+                      (bgrp::stage_b<bgrp::orient2d, double>::apply(1.0, 0.0,
+                                                                   0.0, 1.0,
+                                                                   tiny, tiny)));
+    BOOST_CHECK_EQUAL(1,
+                      (bgrp::stage_d<bgrp::orient2d, double>::apply(1.0, 0.0,
+                                                                      0.0, 1.0,
+                                                                      tiny, tiny)));
+
+    // the classic example of the rounded orient2d giving wrong results,
+    // the points are close to the line y = x
+    double const ulp = std::ldexp(1.0, -53);
+    for (int i = 0; i < 64; ++i)
+    {
+        for (int j = 0; j < 64; ++j)
+        {
+            double const x = 0.5 + i * ulp;
+            double const y = 0.5 + j * ulp;
+            bg::detail::precise_math::vec2d<double> p1 {x, y}, p2 {12, 12}, p3 {24, 24};
+            double const expected = bg::detail::precise_math::orient2d(p1, p2, p3);
+            int const expected_sign = expected > 0 ? 1 : (expected < 0 ? -1 : 0);
+            BOOST_CHECK_EQUAL(expected_sign,
+                              (bgrp::stage_d<bgrp::orient2d, double>::apply(x, y, 12., 12., 24., 24.)));
+        }
+    }
+}
+
+void test_operators()
+{
+    using bgrp::_1;
+    using bgrp::_2;
+    using bgrp::_3;
+    using bgrp::sum;
+    using bgrp::difference;
+    using bgrp::product;
+    using bgrp::max;
+    using bgrp::min;
+    using bgrp::abs;
+
+    // 1e20 + 1 - 1e20 is rounded to 0
+    using cancellation = sum<sum<_1, _2>, _3>;
+    BOOST_CHECK_EQUAL(1,
+                      (bgrp::stage_d<cancellation, double>::apply(1e20, 1., -1e20)));
+    BOOST_CHECK_EQUAL(bgrp::sign_uncertain,
+                      (bgrp::stage_b<cancellation, double>::apply(1e20, 1., -1e20)));
+    BOOST_CHECK_EQUAL(0,
+                      (bgrp::stage_d<cancellation, double>::apply(1e20, 0., -1e20)));
+
+    // max(|a + b|, c) - c - |b| == 0
+    using max_expr = difference<difference<max<abs<sum<_1, _2>>, _3>, _3>, abs<_2>>;
+    BOOST_CHECK_EQUAL(0,
+                      (bgrp::stage_d<max_expr, double>::apply(-1e20, -1., 1e20)));
+    BOOST_CHECK_EQUAL(0,
+                      (bgrp::stage_d<max_expr, double>::apply(1e20, 1., 1e20)));
+    using min_expr = difference<min<sum<_1, _2>, _3>, _3>;
+    BOOST_CHECK_EQUAL(-1,
+                      (bgrp::stage_d<min_expr, double>::apply(1e20, -1., 1e20)));
+    BOOST_CHECK_EQUAL(0,
+                      (bgrp::stage_d<min_expr, double>::apply(1e20, 1., 1e20)));
+
+    // (1 + 2^-60) * (1 - 2^-60) - 1 = -2^-120
+    double const e = std::ldexp(1.0, -60);
+    using product_expr = difference<product<sum<_1, _2>, difference<_1, _2>>, _1>;
+    BOOST_CHECK_EQUAL(-1,
+                      (bgrp::stage_d<product_expr, double>::apply(1., e)));
+}
+
+int test_main(int, char* [])
+{
+    test_integer_coordinates();
+    test_rounded_differences();
+    test_operators();
+    return 0;
+}
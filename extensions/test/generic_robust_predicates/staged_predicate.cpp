@@ -0,0 +1,84 @@
+// Boost.Geometry (aka GGL, Generic Geometry Library)
+// Unit Test
+
+// Copyright (c) 2020 Tinko Bartels, Berlin, Germany.
+
+// Contributed and/or modified by Tinko Bartels,
+//   as part of Google Summer of Code 2020 program.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#define BOOST_GEOMETRY_GENERIC_ROBUST_PREDICATES_STAGE_COUNTERS
+
+#include <array>
+
+#include <geometry_test_common.hpp>
+
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/expressions.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/stage_a.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/stage_b.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/stage_d.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/staged_predicate.hpp>
+
+template <typename CalculationType>
+void test_all()
+{
+    using bg::detail::generic_robust_predicates::orient2d;
+    using bg::detail::generic_robust_predicates::stage_a_semi_static;
+    using bg::detail::generic_robust_predicates::stage_a_static;
+    using bg::detail::generic_robust_predicates::stage_b;
+    using bg::detail::generic_robust_predicates::stage_d;
+    using bg::detail::generic_robust_predicates::staged_predicate;
+    using bg::detail::generic_robust_predicates::sign_uncertain;
+    using ct = CalculationType;
+
+    using semi_static = stage_a_semi_static<orient2d, ct>;
+    using exact_rounded = stage_b<orient2d, ct>;
+    using exact = stage_d<orient2d, ct>;
+
+    staged_predicate<orient2d, semi_static, exact_rounded, exact> robust;
+    // decided by the filter
+    BOOST_CHECK_EQUAL(1, robust.apply(0., 0., 1., 0., 0., 1.));
+    BOOST_CHECK_EQUAL(-1, robust(0., 0., 0., 1., 1., 0.));
+    // collinear points with exact differences, decided by stage B
+    BOOST_CHECK_EQUAL(0, robust.apply(1., 1., 2., 2., 3., 3.));
+    // collinear points, the differences are not exact, decided by stage D
+    double const tiny = 1e-30;
+    BOOST_CHECK_EQUAL(0, robust.apply(tiny, tiny, 1., 1., 2., 2.));
+
+    BOOST_CHECK_EQUAL(2u, robust.counters()[0]);
+    BOOST_CHECK_EQUAL(1u, robust.counters()[1]);
+    BOOST_CHECK_EQUAL(1u, robust.counters()[2]);
+    BOOST_CHECK_EQUAL(0u, robust.counters()[3]);
+
+    // nearly collinear points
+    for (int i = -4; i <= 4; ++i)
+    {
+        double const x = 0.5 + i * std::ldexp(1.0, -53);
+        BOOST_CHECK_EQUAL(exact::apply(x, 0.5, 12., 12., 24., 24.),
+                          robust.apply(x, 0.5, 12., 12., 24., 24.));
+    }
+    BOOST_CHECK_EQUAL(0u, robust.counters()[3]);
+
+    robust.reset_counters();
+    BOOST_CHECK_EQUAL(0u, robust.counters()[0] + robust.counters()[1] + robust.counters()[2]);
+
+    // the static filter is constructed with the bounds of the input and
+    // sign_uncertain is returned if no stage decides
+    using static_filter = stage_a_static<orient2d, ct>;
+    staged_predicate<orient2d, static_filter> bounded(
+        static_filter(1e10, 1e10, 1e10, 1e10, 1e10, 1e10,
+                      0, 0, 0, 0, 0, 0));
+    BOOST_CHECK_EQUAL(1, bounded.apply(0., 0., 1e9, 0., 0., 1e9));
+    BOOST_CHECK_EQUAL(sign_uncertain, bounded.apply(1., 1., 2., 2., 3., 3.));
+    BOOST_CHECK_EQUAL(1u, bounded.counters()[0]);
+    BOOST_CHECK_EQUAL(1u, bounded.counters()[1]);
+}
+
+int test_main(int, char* [])
+{
+    test_all<double>();
+    return 0;
+}
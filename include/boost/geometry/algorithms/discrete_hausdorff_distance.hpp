@@ -28,6 +28,7 @@
 
 #include <boost/geometry/algorithms/detail/throw_on_empty_input.hpp>
 #include <boost/geometry/algorithms/not_implemented.hpp>
+#include <boost/geometry/core/cs.hpp>
 #include <boost/geometry/core/point_type.hpp>
 #include <boost/geometry/core/tag.hpp>
 #include <boost/geometry/core/tags.hpp>
@@ -36,6 +37,7 @@
 #include <boost/geometry/util/range.hpp>
 
 #ifdef BOOST_GEOMETRY_ENABLE_SIMILARITY_RTREE
+#include <boost/iterator/function_output_iterator.hpp>
 #include <boost/geometry/index/rtree.hpp>
 #endif // BOOST_GEOMETRY_ENABLE_SIMILARITY_RTREE
 
@@ -83,6 +85,80 @@ struct point_range
     }
 };
 
+#ifdef BOOST_GEOMETRY_ENABLE_SIMILARITY_RTREE
+// Updates the maximum of the distances between the points and their nearest neighbours
+template <typename Strategy, typename Result>
+struct max_nearest_distance
+{
+    max_nearest_distance(Strategy const& strategy, Result & dis_max)
+        : m_strategy(strategy), m_dis_max(dis_max)
+    {}
+
+    template <typename Pair>
+    void operator()(Pair const& p) const
+    {
+        Result const dis_min = m_strategy.apply(p.first, p.second);
+        if (dis_min > m_dis_max)
+        {
+            m_dis_max = dis_min;
+        }
+    }
+
+    Strategy const& m_strategy;
+    Result & m_dis_max;
+};
+
+// The rtree can't calculate the distances between the nodes of two trees in
+// non-cartesian coordinate systems so the nearest points are queried one by one
+template <typename CSTag>
+struct range_range_rtree
+{
+    template <typename Range1, typename Range2, typename Strategy, typename Result>
+    static inline void apply(Range1 const& r1, Range2 const& r2,
+                             Strategy const& strategy, Result & dis_max)
+    {
+        namespace bgi = boost::geometry::index;
+        typedef typename point_type<Range1>::type point_t;
+        typedef bgi::rtree<point_t, bgi::linear<4> > rtree_type;
+        typedef typename boost::range_size<Range1>::type size_type;
+
+        rtree_type rtree(boost::begin(r2), boost::end(r2));
+        point_t res;
+
+        size_type const n = boost::size(r1);
+        for (size_type i = 0 ; i < n ; i++)
+        {
+            rtree.query(bgi::nearest(range::at(r1, i), 1), &res);
+            Result dis_min = strategy.apply(range::at(r1,i), res);
+            if (dis_min > dis_max )
+            {
+                dis_max = dis_min;
+            }
+        }
+    }
+};
+
+template <>
+struct range_range_rtree<cartesian_tag>
+{
+    template <typename Range1, typename Range2, typename Strategy, typename Result>
+    static inline void apply(Range1 const& r1, Range2 const& r2,
+                             Strategy const& strategy, Result & dis_max)
+    {
+        namespace bgi = boost::geometry::index;
+        typedef typename point_type<Range1>::type point1_t;
+        typedef typename point_type<Range2>::type point2_t;
+        bgi::rtree<point1_t, bgi::linear<4> > rtree1(boost::begin(r1), boost::end(r1));
+        bgi::rtree<point2_t, bgi::linear<4> > rtree2(boost::begin(r2), boost::end(r2));
+
+        // the nearest points of the second range are found for all points of the first one at once
+        bgi::all_nearest(rtree1, rtree2, 1,
+                         boost::make_function_output_iterator(
+                             max_nearest_distance<Strategy, Result>(strategy, dis_max)));
+    }
+};
+#endif // BOOST_GEOMETRY_ENABLE_SIMILARITY_RTREE
+
 struct range_range
 {
     template <typename Range1, typename Range2, typename Strategy>
@@ -103,35 +179,29 @@ struct range_range
                 Strategy
             >::type result_type;
 
-        typedef typename boost::range_size<Range1>::type size_type;
-
         boost::geometry::detail::throw_on_empty_input(r1);
         boost::geometry::detail::throw_on_empty_input(r2);
 
-        size_type const n = boost::size(r1);
         result_type dis_max = 0;
 
 #ifdef BOOST_GEOMETRY_ENABLE_SIMILARITY_RTREE
-        namespace bgi = boost::geometry::index;
-        typedef typename point_type<Range1>::type point_t;
-        typedef bgi::rtree<point_t, bgi::linear<4> > rtree_type;
-        rtree_type rtree(boost::begin(r2), boost::end(r2));
-        point_t res;
-#endif
+        range_range_rtree
+            <
+                typename cs_tag<Range1>::type
+            >::apply(r1, r2, strategy, dis_max);
+#else
+        typedef typename boost::range_size<Range1>::type size_type;
 
+        size_type const n = boost::size(r1);
         for (size_type i = 0 ; i < n ; i++)
         {
-#ifdef BOOST_GEOMETRY_ENABLE_SIMILARITY_RTREE
-            size_type found = rtree.query(bgi::nearest(range::at(r1, i), 1), &res);
-            result_type dis_min = strategy.apply(range::at(r1,i), res);
-#else
             result_type dis_min = point_range::apply(range::at(r1, i), r2, strategy);
-#endif
             if (dis_min > dis_max )
             {
                 dis_max = dis_min;
             }
         }
+#endif
         return dis_max;
     }
 };
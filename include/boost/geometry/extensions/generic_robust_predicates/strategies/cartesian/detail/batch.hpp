@@ -0,0 +1,336 @@
+// Boost.Geometry (aka GGL, Generic Geometry Library)
+
+// Copyright (c) 2020 Tinko Bartels, Berlin, Germany.
+
+// Contributed and/or modified by Tinko Bartels,
+//   as part of Google Summer of Code 2020 program.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_BATCH_HPP
+#define BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_BATCH_HPP
+
+#include <cstddef>
+#include <cmath>
+#include <array>
+#include <utility>
+
+#include <boost/mp11/integral.hpp>
+#include <boost/mp11/list.hpp>
+#include <boost/mp11/algorithm.hpp>
+#include <boost/mp11/set.hpp>
+
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/expression_tree.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/semi_static_filter.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/stage_a.hpp>
+
+// The predicates are evaluated for many independent inputs stored as
+// structures of arrays, one array per argument of the expression. The inputs
+// are processed in blocks of Width instances. The interim results of the
+// expression are calculated for all instances of a block at once in loops
+// of fixed length without branches, which the compiler turns into SIMD
+// instructions. The instances for which the filter is uncertain are passed to
+// the fallback one by one. The default Width of 4 is a good choice for SSE2 and
+// AVX2, wider blocks only pay off with wider vector registers.
+
+namespace boost { namespace geometry
+{
+
+namespace detail { namespace generic_robust_predicates
+{
+
+template <operator_types Op>
+struct batch_operator {};
+
+template <>
+struct batch_operator<operator_types::sum>
+{
+    template <typename Real>
+    static inline Real apply(Real const& l, Real const& r) { return l + r; }
+};
+
+template <>
+struct batch_operator<operator_types::difference>
+{
+    template <typename Real>
+    static inline Real apply(Real const& l, Real const& r) { return l - r; }
+};
+
+template <>
+struct batch_operator<operator_types::product>
+{
+    template <typename Real>
+    static inline Real apply(Real const& l, Real const& r) { return l * r; }
+};
+
+template <>
+struct batch_operator<operator_types::max>
+{
+    template <typename Real>
+    static inline Real apply(Real const& l, Real const& r) { return l < r ? r : l; }
+};
+
+template <>
+struct batch_operator<operator_types::min>
+{
+    template <typename Real>
+    static inline Real apply(Real const& l, Real const& r) { return r < l ? r : l; }
+};
+
+template <>
+struct batch_operator<operator_types::abs>
+{
+    template <typename Real>
+    static inline Real apply(Real const& c) { return std::abs(c); }
+};
+
+template <typename Node, typename Real, bool IsArgument = (Node::argn > 0)>
+struct batch_leaf_value
+{
+    template <typename Inputs>
+    static inline Real apply(Inputs const& inputs, std::size_t i)
+    {
+        return inputs[Node::argn - 1][i];
+    }
+};
+
+template <typename Node, typename Real>
+struct batch_leaf_value<Node, Real, false>
+{
+    template <typename Inputs>
+    static inline Real apply(Inputs const&, std::size_t)
+    {
+        return Node::value;
+    }
+};
+
+// The value of the Node in the lane of the block starting at offset
+template
+<
+    typename All,
+    typename Node,
+    typename Real,
+    bool IsLeaf = Node::is_leaf
+>
+struct batch_value
+{
+    template <typename Results, typename Inputs>
+    static inline Real apply(Results const& results, Inputs const&,
+                             std::size_t, std::size_t lane)
+    {
+        return results[boost::mp11::mp_find<All, Node>::value][lane];
+    }
+};
+
+template <typename All, typename Node, typename Real>
+struct batch_value<All, Node, Real, true>
+{
+    template <typename Results, typename Inputs>
+    static inline Real apply(Results const&, Inputs const& inputs,
+                             std::size_t offset, std::size_t lane)
+    {
+        return batch_leaf_value<Node, Real>::apply(inputs, offset + lane);
+    }
+};
+
+template
+<
+    typename All,
+    typename Node,
+    typename Real,
+    operator_arities Arity = Node::operator_arity
+>
+struct batch_eval_node {};
+
+template <typename All, typename Node, typename Real>
+struct batch_eval_node<All, Node, Real, operator_arities::binary>
+{
+    template <typename Results, typename Inputs>
+    static inline void apply(Results& results, Inputs const& inputs,
+                             std::size_t offset)
+    {
+        using left = batch_value<All, typename Node::left, Real>;
+        using right = batch_value<All, typename Node::right, Real>;
+        auto& result = results[boost::mp11::mp_find<All, Node>::value];
+        for (std::size_t lane = 0; lane < result.size(); ++lane)
+        {
+            result[lane] = batch_operator<Node::operator_type>::apply(
+                left::apply(results, inputs, offset, lane),
+                right::apply(results, inputs, offset, lane));
+        }
+    }
+};
+
+template <typename All, typename Node, typename Real>
+struct batch_eval_node<All, Node, Real, operator_arities::unary>
+{
+    template <typename Results, typename Inputs>
+    static inline void apply(Results& results, Inputs const& inputs,
+                             std::size_t offset)
+    {
+        using child = batch_value<All, typename Node::child, Real>;
+        auto& result = results[boost::mp11::mp_find<All, Node>::value];
+        for (std::size_t lane = 0; lane < result.size(); ++lane)
+        {
+            result[lane] = batch_operator<Node::operator_type>::apply(
+                child::apply(results, inputs, offset, lane));
+        }
+    }
+};
+
+template
+<
+    typename All,
+    typename Remaining,
+    typename Real,
+    bool Empty = boost::mp11::mp_empty<Remaining>::value
+>
+struct batch_approximate_interim
+{
+    template <typename Results, typename Inputs>
+    static inline void apply(Results& results, Inputs const& inputs,
+                             std::size_t offset)
+    {
+        batch_eval_node<All, boost::mp11::mp_front<Remaining>, Real>
+            ::apply(results, inputs, offset);
+        batch_approximate_interim
+            <
+                All,
+                boost::mp11::mp_pop_front<Remaining>,
+                Real
+            >::apply(results, inputs, offset);
+    }
+};
+
+template <typename All, typename Remaining, typename Real>
+struct batch_approximate_interim<All, Remaining, Real, true>
+{
+    template <typename Results, typename Inputs>
+    static inline void apply(Results&, Inputs const&, std::size_t) {}
+};
+
+// The batch version of semi_static_filter. The signs or sign_uncertain are
+// written to signs for count instances whose arguments are read from inputs.
+template
+<
+    typename Expression,
+    typename CalculationType,
+    typename ErrorExpression,
+    std::size_t Width = 4
+>
+struct semi_static_filter_batch
+{
+private:
+    using ct = CalculationType;
+    using stack = typename boost::mp11::mp_unique<post_order<Expression>>;
+    using evals = typename boost::mp11::mp_remove_if<stack, is_leaf>;
+    using error_eval_stack = boost::mp11::mp_unique
+        <
+            post_order<ErrorExpression>
+        >;
+    using error_eval_stack_remainder = boost::mp11::mp_set_difference
+        <
+            boost::mp11::mp_remove_if<error_eval_stack, is_leaf>,
+            evals
+        >;
+    using all_evals = boost::mp11::mp_append
+        <
+            evals,
+            error_eval_stack_remainder
+        >;
+    using scalar_filter = semi_static_filter<Expression, ct, ErrorExpression>;
+public:
+    static constexpr std::size_t arguments = max_argn<Expression>::value;
+    static constexpr std::size_t width = Width;
+    using inputs_type = std::array<ct const*, arguments>;
+
+    static inline void apply(inputs_type const& inputs, std::size_t count,
+                             int* signs)
+    {
+        std::array
+            <
+                std::array<ct, Width>,
+                boost::mp11::mp_size<all_evals>::value
+            > results;
+        std::size_t offset = 0;
+        for (; offset + Width <= count; offset += Width)
+        {
+            batch_approximate_interim<all_evals, all_evals, ct>
+                ::apply(results, inputs, offset);
+            for (std::size_t lane = 0; lane < Width; ++lane)
+            {
+                ct const error_bound = batch_value<all_evals, ErrorExpression, ct>
+                    ::apply(results, inputs, offset, lane);
+                ct const det = batch_value<all_evals, Expression, ct>
+                    ::apply(results, inputs, offset, lane);
+                // without branches, so the loop is vectorized as well
+                int const sign = int(det > error_bound) - int(det < -error_bound);
+                int const uncertain = int(sign == 0)
+                                    & int(error_bound != 0 || det != 0);
+                signs[offset + lane] = sign + uncertain * sign_uncertain;
+            }
+        }
+        // the remaining instances are evaluated one by one
+        for (; offset < count; ++offset)
+        {
+            signs[offset] = apply_scalar<scalar_filter>(
+                inputs, offset, std::make_index_sequence<arguments>());
+        }
+    }
+
+    template <typename Stage, std::size_t ...I>
+    static inline int apply_scalar(inputs_type const& inputs, std::size_t i,
+                                   std::index_sequence<I...>)
+    {
+        return Stage::apply(inputs[I][i]...);
+    }
+};
+
+template
+<
+    typename Expression,
+    typename CalculationType,
+    std::size_t Width = 4
+>
+using stage_a_semi_static_batch = semi_static_filter_batch
+        <
+            Expression,
+            CalculationType,
+            stage_a_error_bound<Expression, CalculationType>,
+            Width
+        >;
+
+template <typename Fallback, typename Inputs, std::size_t ...I>
+inline int apply_fallback(Fallback const& fallback, Inputs const& inputs,
+                          std::size_t i, std::index_sequence<I...>)
+{
+    return fallback.apply(inputs[I][i]...);
+}
+
+// Evaluates the BatchFilter for count instances and calls the fallback,
+// e.g. a staged_predicate of slower stages, for the instances for which
+// the filter is uncertain.
+template <typename BatchFilter, typename Fallback>
+inline void apply_batch(typename BatchFilter::inputs_type const& inputs,
+                        std::size_t count,
+                        int* signs,
+                        Fallback const& fallback)
+{
+    BatchFilter::apply(inputs, count, signs);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (signs[i] == sign_uncertain)
+        {
+            signs[i] = apply_fallback(fallback, inputs, i,
+                std::make_index_sequence<BatchFilter::arguments>());
+        }
+    }
+}
+
+}} // namespace detail::generic_robust_predicates
+
+}} // namespace boost::geometry
+
+#endif // BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_BATCH_HPP
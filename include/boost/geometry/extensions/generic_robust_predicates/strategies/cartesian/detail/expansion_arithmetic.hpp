@@ -0,0 +1,398 @@
+// Boost.Geometry (aka GGL, Generic Geometry Library)
+
+// Copyright (c) 2020 Tinko Bartels, Berlin, Germany.
+
+// Contributed and/or modified by Tinko Bartels,
+//   as part of Google Summer of Code 2020 program.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_EXPANSION_ARITHMETIC_HPP
+#define BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_EXPANSION_ARITHMETIC_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <array>
+
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/expression_tree.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/approximate.hpp>
+#include <boost/geometry/extensions/triangulation/strategies/cartesian/detail/precise_math.hpp>
+
+// The expressions are evaluated exactly as nonoverlapping expansions, see
+// "Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric
+// Predicates" by Richard Shewchuk, J. Discrete Comput Geom (1997) 18: 305.
+// The components of the expansions are stored in ascending order of magnitude
+// with zeros eliminated, a zero is represented by a single zero component.
+// Overflow and underflow are not handled.
+
+namespace boost { namespace geometry
+{
+
+namespace detail { namespace generic_robust_predicates
+{
+
+// If RoundedLeafSums is true the sums and differences of two leafs are
+// rounded to single components, see stage_b.
+template
+<
+    typename Node,
+    bool RoundedLeafSums,
+    operator_types Op = Node::operator_type
+>
+struct is_rounded_leaf_sum : boost::mp11::mp_false {};
+
+template <typename Node>
+struct is_rounded_leaf_sum<Node, true, operator_types::sum>
+    : boost::mp11::mp_bool<Node::left::is_leaf && Node::right::is_leaf> {};
+
+template <typename Node>
+struct is_rounded_leaf_sum<Node, true, operator_types::difference>
+    : is_rounded_leaf_sum<Node, true, operator_types::sum> {};
+
+// The maximum number of components of the expansion of the Node
+template
+<
+    typename Node,
+    bool RoundedLeafSums,
+    operator_types Op = Node::operator_type
+>
+struct expansion_size {};
+
+template <typename Node, bool RoundedLeafSums>
+struct expansion_size<Node, RoundedLeafSums, operator_types::no_op>
+{
+    static constexpr std::size_t value = 1;
+};
+
+template <typename Node, bool RoundedLeafSums>
+struct expansion_size<Node, RoundedLeafSums, operator_types::sum>
+{
+    static constexpr std::size_t value =
+        is_rounded_leaf_sum<Node, RoundedLeafSums>::value ? 1 :
+          expansion_size<typename Node::left, RoundedLeafSums>::value
+        + expansion_size<typename Node::right, RoundedLeafSums>::value;
+};
+
+template <typename Node, bool RoundedLeafSums>
+struct expansion_size<Node, RoundedLeafSums, operator_types::difference>
+    : expansion_size<Node, RoundedLeafSums, operator_types::sum> {};
+
+template <typename Node, bool RoundedLeafSums>
+struct expansion_size<Node, RoundedLeafSums, operator_types::product>
+{
+    static constexpr std::size_t value =
+          2
+        * expansion_size<typename Node::left, RoundedLeafSums>::value
+        * expansion_size<typename Node::right, RoundedLeafSums>::value;
+};
+
+template <typename Node, bool RoundedLeafSums>
+struct expansion_size<Node, RoundedLeafSums, operator_types::max>
+{
+    static constexpr std::size_t value = std::max
+        (
+            expansion_size<typename Node::left, RoundedLeafSums>::value,
+            expansion_size<typename Node::right, RoundedLeafSums>::value
+        );
+};
+
+template <typename Node, bool RoundedLeafSums>
+struct expansion_size<Node, RoundedLeafSums, operator_types::min>
+    : expansion_size<Node, RoundedLeafSums, operator_types::max> {};
+
+template <typename Node, bool RoundedLeafSums>
+struct expansion_size<Node, RoundedLeafSums, operator_types::abs>
+    : expansion_size<typename Node::child, RoundedLeafSums> {};
+
+template <typename Real, std::size_t Size>
+inline int expansion_sign(std::array<Real, Size> const& e, int length)
+{
+    // the component of the largest magnitude determines the sign
+    Real const largest = e[length - 1];
+    return largest > 0 ? 1 : (largest < 0 ? -1 : 0);
+}
+
+template <typename Real, std::size_t Size>
+inline void negate_expansion(std::array<Real, Size>& e, int length)
+{
+    for (int i = 0; i < length; ++i)
+    {
+        e[i] = -e[i];
+    }
+}
+
+// Writes the expansion of the first two components of the error-free
+// transformation x + y = a (op) b, x is the rounded value and y the roundoff
+template <typename Real, std::size_t Size>
+inline int two_component_expansion(std::array<Real, 2> const& xy,
+                                   std::array<Real, Size>& h)
+{
+    if (xy[1] != 0)
+    {
+        h[0] = xy[1];
+        h[1] = xy[0];
+        return 2;
+    }
+    h[0] = xy[0];
+    return 1;
+}
+
+// The exact evaluation of the Node. Returns the number of components written
+// to h. If RoundedLeafSums is true and the rounding of a sum or a difference
+// of two leafs is not exact, exact is set to false.
+template
+<
+    typename Node,
+    bool RoundedLeafSums,
+    typename Real,
+    operator_types Op = Node::operator_type,
+    bool IsRoundedLeafSum = is_rounded_leaf_sum<Node, RoundedLeafSums>::value
+>
+struct eval_expansion_impl {};
+
+template
+<
+    typename Node,
+    bool RoundedLeafSums,
+    typename Real,
+    typename InputArr
+>
+inline int eval_expansion(
+        InputArr const& input,
+        std::array<Real, expansion_size<Node, RoundedLeafSums>::value>& h,
+        bool& exact)
+{
+    return eval_expansion_impl<Node, RoundedLeafSums, Real>
+        ::apply(input, h, exact);
+}
+
+template <typename Node, bool RoundedLeafSums, typename Real>
+struct eval_expansion_impl
+    <
+        Node, RoundedLeafSums, Real, operator_types::no_op, false
+    >
+{
+    template <typename InputArr, typename Arr>
+    static inline int apply(InputArr const& input, Arr& h, bool&)
+    {
+        h[0] = get_nth_real<Node, Node::argn, Real, InputArr>(input);
+        return 1;
+    }
+};
+
+template <typename Node, bool RoundedLeafSums, typename Real, operator_types Op>
+struct eval_expansion_impl<Node, RoundedLeafSums, Real, Op, true>
+{
+    template <typename InputArr, typename Arr>
+    static inline int apply(InputArr const& input, Arr& h, bool& exact)
+    {
+        Real const l = get_nth_real
+            <
+                typename Node::left, Node::left::argn, Real, InputArr
+            >(input);
+        Real const r = get_nth_real
+            <
+                typename Node::right, Node::right::argn, Real, InputArr
+            >(input);
+        std::array<Real, 2> const xy =
+            Op == operator_types::sum ? detail::precise_math::two_sum(l, r)
+                                      : detail::precise_math::two_diff(l, r);
+        if (xy[1] != 0)
+        {
+            exact = false;
+        }
+        h[0] = xy[0];
+        return 1;
+    }
+};
+
+template <typename Node, bool RoundedLeafSums, typename Real>
+struct eval_expansion_impl
+    <
+        Node, RoundedLeafSums, Real, operator_types::sum, false
+    >
+{
+    template <typename InputArr, typename Arr>
+    static inline int apply(InputArr const& input, Arr& h, bool& exact)
+    {
+        return apply(input, h, exact, false);
+    }
+
+    template <typename InputArr, typename Arr>
+    static inline int apply(InputArr const& input, Arr& h, bool& exact,
+                            bool negate_right)
+    {
+        using left = typename Node::left;
+        using right = typename Node::right;
+        return apply(input, h, exact, negate_right,
+                     boost::mp11::mp_bool<left::is_leaf && right::is_leaf>());
+    }
+
+private:
+    // the sum of two leafs is calculated with a single error-free transformation
+    template <typename InputArr, typename Arr>
+    static inline int apply(InputArr const& input, Arr& h, bool&,
+                            bool negate_right, boost::mp11::mp_true)
+    {
+        using left = typename Node::left;
+        using right = typename Node::right;
+        Real const l = get_nth_real<left, left::argn, Real, InputArr>(input);
+        Real const r = get_nth_real<right, right::argn, Real, InputArr>(input);
+        return two_component_expansion(
+            negate_right ? detail::precise_math::two_diff(l, r)
+                         : detail::precise_math::two_sum(l, r),
+            h);
+    }
+
+    template <typename InputArr, typename Arr>
+    static inline int apply(InputArr const& input, Arr& h, bool& exact,
+                            bool negate_right, boost::mp11::mp_false)
+    {
+        using left = typename Node::left;
+        using right = typename Node::right;
+        std::array<Real, expansion_size<left, RoundedLeafSums>::value> l;
+        std::array<Real, expansion_size<right, RoundedLeafSums>::value> r;
+        int const l_length =
+            eval_expansion<left, RoundedLeafSums, Real>(input, l, exact);
+        int const r_length =
+            eval_expansion<right, RoundedLeafSums, Real>(input, r, exact);
+        if (negate_right)
+        {
+            negate_expansion(r, r_length);
+        }
+        return detail::precise_math::fast_expansion_sum_zeroelim(
+            l, r, h, l_length, r_length);
+    }
+};
+
+template <typename Node, bool RoundedLeafSums, typename Real>
+struct eval_expansion_impl
+    <
+        Node, RoundedLeafSums, Real, operator_types::difference, false
+    >
+{
+    template <typename InputArr, typename Arr>
+    static inline int apply(InputArr const& input, Arr& h, bool& exact)
+    {
+        return eval_expansion_impl
+            <
+                Node, RoundedLeafSums, Real, operator_types::sum, false
+            >::apply(input, h, exact, true);
+    }
+};
+
+template <typename Node, bool RoundedLeafSums, typename Real>
+struct eval_expansion_impl
+    <
+        Node, RoundedLeafSums, Real, operator_types::product, false
+    >
+{
+    template <typename InputArr, typename Arr>
+    static inline int apply(InputArr const& input, Arr& h, bool& exact)
+    {
+        using left = typename Node::left;
+        using right = typename Node::right;
+        constexpr std::size_t l_size = expansion_size<left, RoundedLeafSums>::value;
+        constexpr std::size_t r_size = expansion_size<right, RoundedLeafSums>::value;
+        std::array<Real, l_size> l;
+        std::array<Real, r_size> r;
+        int const l_length =
+            eval_expansion<left, RoundedLeafSums, Real>(input, l, exact);
+        int const r_length =
+            eval_expansion<right, RoundedLeafSums, Real>(input, r, exact);
+
+        // the left expansion is scaled by the components of the right one
+        // and the partial products are summed up
+        std::array<Real, 2 * l_size> scaled;
+        int length = detail::precise_math::scale_expansion_zeroelim(
+            l, r[0], scaled, l_length);
+        std::copy(scaled.begin(), scaled.begin() + length, h.begin());
+        if (r_length > 1)
+        {
+            Arr partial;
+            for (int i = 1; i < r_length; ++i)
+            {
+                int const scaled_length =
+                    detail::precise_math::scale_expansion_zeroelim(
+                        l, r[i], scaled, l_length);
+                length = detail::precise_math::fast_expansion_sum_zeroelim(
+                    h, scaled, partial, length, scaled_length);
+                std::copy(partial.begin(), partial.begin() + length, h.begin());
+            }
+        }
+        return length;
+    }
+};
+
+template <typename Node, bool RoundedLeafSums, typename Real>
+struct eval_expansion_impl
+    <
+        Node, RoundedLeafSums, Real, operator_types::abs, false
+    >
+{
+    template <typename InputArr, typename Arr>
+    static inline int apply(InputArr const& input, Arr& h, bool& exact)
+    {
+        int const length = eval_expansion<typename Node::child, RoundedLeafSums, Real>(
+            input, h, exact);
+        if (expansion_sign(h, length) < 0)
+        {
+            negate_expansion(h, length);
+        }
+        return length;
+    }
+};
+
+template <typename Node, bool RoundedLeafSums, typename Real, bool Max>
+struct eval_expansion_max_min
+{
+    template <typename InputArr, typename Arr>
+    static inline int apply(InputArr const& input, Arr& h, bool& exact)
+    {
+        using left = typename Node::left;
+        using right = typename Node::right;
+        constexpr std::size_t l_size = expansion_size<left, RoundedLeafSums>::value;
+        constexpr std::size_t r_size = expansion_size<right, RoundedLeafSums>::value;
+        std::array<Real, l_size> l;
+        std::array<Real, r_size> r;
+        int const l_length =
+            eval_expansion<left, RoundedLeafSums, Real>(input, l, exact);
+        int const r_length =
+            eval_expansion<right, RoundedLeafSums, Real>(input, r, exact);
+
+        // the sign of left - right decides which one is copied
+        std::array<Real, r_size> r_negated = r;
+        negate_expansion(r_negated, r_length);
+        std::array<Real, l_size + r_size> diff;
+        int const diff_length = detail::precise_math::fast_expansion_sum_zeroelim(
+            l, r_negated, diff, l_length, r_length);
+        int const sign = expansion_sign(diff, diff_length);
+        if (Max ? sign >= 0 : sign <= 0)
+        {
+            std::copy(l.begin(), l.begin() + l_length, h.begin());
+            return l_length;
+        }
+        std::copy(r.begin(), r.begin() + r_length, h.begin());
+        return r_length;
+    }
+};
+
+template <typename Node, bool RoundedLeafSums, typename Real>
+struct eval_expansion_impl
+    <
+        Node, RoundedLeafSums, Real, operator_types::max, false
+    > : eval_expansion_max_min<Node, RoundedLeafSums, Real, true> {};
+
+template <typename Node, bool RoundedLeafSums, typename Real>
+struct eval_expansion_impl
+    <
+        Node, RoundedLeafSums, Real, operator_types::min, false
+    > : eval_expansion_max_min<Node, RoundedLeafSums, Real, false> {};
+
+}} // namespace detail::generic_robust_predicates
+
+}} // namespace boost::geometry
+
+#endif // BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_EXPANSION_ARITHMETIC_HPP
@@ -0,0 +1,67 @@
+// Boost.Geometry (aka GGL, Generic Geometry Library)
+
+// Copyright (c) 2020 Tinko Bartels, Berlin, Germany.
+
+// Contributed and/or modified by Tinko Bartels,
+//   as part of Google Summer of Code 2020 program.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_STAGE_B_HPP
+#define BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_STAGE_B_HPP
+
+#include <cstddef>
+#include <array>
+
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/expression_tree.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/expansion_arithmetic.hpp>
+
+namespace boost { namespace geometry
+{
+
+namespace detail { namespace generic_robust_predicates
+{
+
+// The sums and differences of the arguments, e.g. the coordinates of vectors
+// in orient2d, are rounded and the rest of the expression is evaluated exactly
+// with the rounded values, which are much shorter expansions than the exact
+// ones. The sign is returned if all rounded sums and differences are exact,
+// which is the common case if the arguments are close to each other,
+// otherwise sign_uncertain is returned.
+template
+<
+    typename Expression,
+    typename CalculationType
+>
+struct stage_b
+{
+private:
+    using ct = CalculationType;
+public:
+    static constexpr std::size_t expansion_length =
+        expansion_size<Expression, true>::value;
+
+    template <typename ...Reals>
+    static inline int apply(const Reals&... args)
+    {
+        std::array<ct, sizeof...(Reals)> input
+            {{ static_cast<ct>(args)... }};
+        std::array<ct, expansion_length> result;
+        bool exact = true;
+        int const length =
+            eval_expansion<Expression, true, ct>(input, result, exact);
+        if (!exact)
+        {
+            return sign_uncertain;
+        }
+        return expansion_sign(result, length);
+    }
+};
+
+}} // namespace detail::generic_robust_predicates
+
+}} // namespace boost::geometry
+
+#endif // BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_STAGE_B_HPP
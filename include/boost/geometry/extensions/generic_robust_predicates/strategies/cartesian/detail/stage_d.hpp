@@ -0,0 +1,60 @@
+// Boost.Geometry (aka GGL, Generic Geometry Library)
+
+// Copyright (c) 2020 Tinko Bartels, Berlin, Germany.
+
+// Contributed and/or modified by Tinko Bartels,
+//   as part of Google Summer of Code 2020 program.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_STAGE_D_HPP
+#define BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_STAGE_D_HPP
+
+#include <cstddef>
+#include <array>
+
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/expression_tree.hpp>
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/expansion_arithmetic.hpp>
+
+namespace boost { namespace geometry
+{
+
+namespace detail { namespace generic_robust_predicates
+{
+
+// The expression is evaluated exactly, so the sign is always determined.
+// This is the slowest stage and is meant to be called only if the previous
+// stages return sign_uncertain.
+template
+<
+    typename Expression,
+    typename CalculationType
+>
+struct stage_d
+{
+private:
+    using ct = CalculationType;
+public:
+    static constexpr std::size_t expansion_length =
+        expansion_size<Expression, false>::value;
+
+    template <typename ...Reals>
+    static inline int apply(const Reals&... args)
+    {
+        std::array<ct, sizeof...(Reals)> input
+            {{ static_cast<ct>(args)... }};
+        std::array<ct, expansion_length> result;
+        bool exact = true;
+        int const length =
+            eval_expansion<Expression, false, ct>(input, result, exact);
+        return expansion_sign(result, length);
+    }
+};
+
+}} // namespace detail::generic_robust_predicates
+
+}} // namespace boost::geometry
+
+#endif // BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_STAGE_D_HPP
@@ -0,0 +1,130 @@
+// Boost.Geometry (aka GGL, Generic Geometry Library)
+
+// Copyright (c) 2020 Tinko Bartels, Berlin, Germany.
+
+// Contributed and/or modified by Tinko Bartels,
+//   as part of Google Summer of Code 2020 program.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_STAGED_PREDICATE_HPP
+#define BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_STAGED_PREDICATE_HPP
+
+#include <cstddef>
+#include <array>
+#include <tuple>
+
+#include <boost/geometry/extensions/generic_robust_predicates/strategies/cartesian/detail/expression_tree.hpp>
+
+// If BOOST_GEOMETRY_GENERIC_ROBUST_PREDICATES_STAGE_COUNTERS is defined the
+// staged predicates count the calls decided by each stage. The counters are
+// not synchronized so a staged predicate shouldn't be shared between threads
+// in this case.
+
+namespace boost { namespace geometry
+{
+
+namespace detail { namespace generic_robust_predicates
+{
+
+template <std::size_t I, std::size_t End>
+struct staged_predicate_apply
+{
+    template <typename Stages, typename ...Reals>
+    static inline int apply(Stages const& stages, std::size_t& stage,
+                            const Reals&... args)
+    {
+        int const sign = std::get<I>(stages).apply(args...);
+        if (sign != sign_uncertain)
+        {
+            stage = I;
+            return sign;
+        }
+        return staged_predicate_apply<I + 1, End>::apply(stages, stage, args...);
+    }
+};
+
+template <std::size_t End>
+struct staged_predicate_apply<End, End>
+{
+    template <typename Stages, typename ...Reals>
+    static inline int apply(Stages const&, std::size_t& stage, const Reals&...)
+    {
+        stage = End;
+        return sign_uncertain;
+    }
+};
+
+// The stages are called in order until one of them returns a sign other
+// than sign_uncertain. The stages may be filters having a static apply,
+// e.g. stage_a_semi_static, stage_b or stage_d, or objects, e.g. stage_a_static
+// constructed with the bounds of the input. The latter are passed to the
+// constructor, the others are default constructed. If the last stage is not
+// exact sign_uncertain may be returned.
+template
+<
+    typename Expression,
+    typename ...Stages
+>
+class staged_predicate
+{
+private:
+    using stages_type = std::tuple<Stages...>;
+    stages_type m_stages;
+#ifdef BOOST_GEOMETRY_GENERIC_ROBUST_PREDICATES_STAGE_COUNTERS
+    mutable std::array<std::size_t, sizeof...(Stages) + 1> m_counters {{}};
+#endif
+public:
+    static constexpr std::size_t stages_count = sizeof...(Stages);
+
+    inline staged_predicate() {}
+
+    inline staged_predicate(Stages const&... stages)
+        : m_stages(stages...)
+    {}
+
+    stages_type const& stages() const { return m_stages; }
+    stages_type& stages() { return m_stages; }
+
+    template <typename ...Reals>
+    inline int apply(const Reals&... args) const
+    {
+        static_assert(sizeof...(Reals) == max_argn<Expression>::value,
+                      "Number of arguments is incompatible with the expression.");
+        std::size_t stage = 0;
+        int const sign = staged_predicate_apply<0, stages_count>
+            ::apply(m_stages, stage, args...);
+#ifdef BOOST_GEOMETRY_GENERIC_ROBUST_PREDICATES_STAGE_COUNTERS
+        ++m_counters[stage];
+#endif
+        return sign;
+    }
+
+    template <typename ...Reals>
+    inline int operator()(const Reals&... args) const
+    {
+        return apply(args...);
+    }
+
+#ifdef BOOST_GEOMETRY_GENERIC_ROBUST_PREDICATES_STAGE_COUNTERS
+    // The number of calls decided by each stage, the last element is the
+    // number of calls for which all stages returned sign_uncertain
+    std::array<std::size_t, sizeof...(Stages) + 1> const& counters() const
+    {
+        return m_counters;
+    }
+
+    void reset_counters()
+    {
+        m_counters.fill(0);
+    }
+#endif
+};
+
+}} // namespace detail::generic_robust_predicates
+
+}} // namespace boost::geometry
+
+#endif // BOOST_GEOMETRY_EXTENSIONS_GENERIC_ROBUST_PREDICATES_STRATEGIES_CARTESIAN_DETAIL_STAGED_PREDICATE_HPP
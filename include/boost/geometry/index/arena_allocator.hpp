@@ -0,0 +1,330 @@
+// Boost.Geometry Index
+//
+// Allocator carving the nodes of the rtree out of large slabs
+//
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_ARENA_ALLOCATOR_HPP
+#define BOOST_GEOMETRY_INDEX_ARENA_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+
+#include <boost/geometry/index/detail/parallel.hpp>
+
+namespace boost { namespace geometry { namespace index {
+
+namespace detail {
+
+// The memory of the arena is allocated in slabs growing up to the max slab size.
+// The deallocated blocks are kept in the free lists of blocks of the same size
+// and reused. All slabs are released at once when the arena is released or destroyed.
+class node_arena
+    : boost::noncopyable
+{
+    static const std::size_t min_slab_size = 4096;
+    static const std::size_t block_alignment = 2 * sizeof(void*);
+
+    struct free_block
+    {
+        free_block * next;
+    };
+
+    struct free_list
+    {
+        free_list(std::size_t s) : size(s), head(0) {}
+
+        std::size_t size;
+        free_block * head;
+    };
+
+public:
+    explicit node_arena(std::size_t max_slab_size)
+        : m_max_slab_size(max_slab_size < min_slab_size ? min_slab_size : max_slab_size)
+        , m_next_slab_size(min_slab_size)
+        , m_pos(0), m_end(0), m_allocated_bytes(0)
+    {}
+
+    ~node_arena()
+    {
+        release();
+    }
+
+    void * allocate(std::size_t size, std::size_t alignment)
+    {
+#ifdef BOOST_GEOMETRY_INDEX_DETAIL_HAS_THREADS
+        std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+        size = block_size(size);
+
+        free_list & list = find_free_list(size);                                                // MAY THROW (A)
+        if ( list.head )
+        {
+            free_block * b = list.head;
+            list.head = b->next;
+            return b;
+        }
+
+        char * p = aligned(m_pos, alignment);
+        if ( m_pos == 0 || p + size > m_end )
+        {
+            add_slab(size + alignment);                                                         // MAY THROW (A)
+            p = aligned(m_pos, alignment);
+        }
+
+        m_pos = p + size;
+        return p;
+    }
+
+    void deallocate(void * p, std::size_t size)
+    {
+#ifdef BOOST_GEOMETRY_INDEX_DETAIL_HAS_THREADS
+        std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+        free_list & list = find_free_list(block_size(size));                                    // nothrow, the list exists
+        free_block * b = static_cast<free_block*>(p);
+        b->next = list.head;
+        list.head = b;
+    }
+
+    // Releases all slabs, the memory allocated before is no longer valid
+    void release()
+    {
+        for ( std::size_t i = 0 ; i < m_slabs.size() ; ++i )
+            ::operator delete(m_slabs[i]);
+        m_slabs.clear();
+        m_free_lists.clear();
+        m_next_slab_size = min_slab_size;
+        m_pos = 0;
+        m_end = 0;
+        m_allocated_bytes = 0;
+    }
+
+    std::size_t max_slab_size() const { return m_max_slab_size; }
+    std::size_t allocated_bytes() const { return m_allocated_bytes; }
+
+private:
+    static std::size_t block_size(std::size_t size)
+    {
+        if ( size < sizeof(free_block) )
+            size = sizeof(free_block);
+        return (size + block_alignment - 1) / block_alignment * block_alignment;
+    }
+
+    static char * aligned(char * p, std::size_t alignment)
+    {
+        std::size_t const a = alignment < block_alignment ? block_alignment : alignment;
+        std::size_t const mod = reinterpret_cast<std::size_t>(p) % a;
+        return mod == 0 ? p : p + (a - mod);
+    }
+
+    free_list & find_free_list(std::size_t size)
+    {
+        for ( std::size_t i = 0 ; i < m_free_lists.size() ; ++i )
+        {
+            if ( m_free_lists[i].size == size )
+                return m_free_lists[i];
+        }
+        m_free_lists.push_back(free_list(size));                                                // MAY THROW (A)
+        return m_free_lists.back();
+    }
+
+    void add_slab(std::size_t min_size)
+    {
+        std::size_t size = m_next_slab_size;
+        if ( size < min_size )
+            size = min_size;
+
+        m_slabs.reserve(m_slabs.size() + 1);                                                    // MAY THROW (A)
+        char * slab = static_cast<char*>(::operator new(size));                                 // MAY THROW (A)
+        m_slabs.push_back(slab);
+
+        m_pos = slab;
+        m_end = slab + size;
+        m_allocated_bytes += size;
+
+        if ( m_next_slab_size < m_max_slab_size )
+            m_next_slab_size = m_next_slab_size * 2 < m_max_slab_size ? m_next_slab_size * 2 : m_max_slab_size;
+    }
+
+    std::size_t m_max_slab_size;
+    std::size_t m_next_slab_size;
+    std::vector<char*> m_slabs;
+    std::vector<free_list> m_free_lists;
+    char * m_pos;
+    char * m_end;
+    std::size_t m_allocated_bytes;
+
+#ifdef BOOST_GEOMETRY_INDEX_DETAIL_HAS_THREADS
+    std::mutex m_mutex;
+#endif
+};
+
+struct arena_allocator_access;
+
+} // namespace detail
+
+/*!
+\brief The allocator carving the memory out of large slabs.
+
+If it's passed as the Allocator of the rtree the nodes are allocated in slabs
+instead of one at a time. The memory of the destroyed nodes is reused by the nodes
+created later. The slabs are released when the last copy of the allocator is destroyed.
+
+If the rtree is the only owner of its allocator, the Value and the bounding box are
+trivially destructible and the nodes store static-size containers (the default, i.e.
+the parameters aren't dynamic) the whole tree is released at once in the destructor
+and clear(), without traversing the nodes. Copies of the rtree get their own slabs.
+
+The allocator is meant to be used by one rtree. All copies of the allocator share the slabs
+so the memory of all rtrees using them is released when the last of them is destroyed.
+
+\par Example
+\verbatim
+typedef bgi::rtree<value_t, bgi::rstar<16>, bgi::indexable<value_t>,
+                   bgi::equal_to<value_t>, bgi::arena_allocator<value_t> > rtree_t;
+rtree_t tree(values.begin(), values.end());
+\endverbatim
+
+\tparam T   The type of allocated objects.
+*/
+template <typename T>
+class arena_allocator
+{
+    template <typename U> friend class arena_allocator;
+    friend struct detail::arena_allocator_access;
+
+public:
+    typedef T value_type;
+    typedef T * pointer;
+    typedef T const* const_pointer;
+    typedef T & reference;
+    typedef T const& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    typedef boost::false_type propagate_on_container_copy_assignment;
+    typedef boost::true_type propagate_on_container_move_assignment;
+    typedef boost::true_type propagate_on_container_swap;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef arena_allocator<U> other;
+    };
+
+    /*!
+    \brief The constructor.
+
+    \param max_slab_size    The maximum size of a slab in bytes. The slabs are growing
+                            from 4kB up to this size.
+
+    \par Throws
+    If allocation throws.
+    */
+    explicit arena_allocator(std::size_t max_slab_size = 1024 * 1024)
+        : m_arena(boost::make_shared<detail::node_arena>(max_slab_size))
+    {}
+
+    template <typename U>
+    arena_allocator(arena_allocator<U> const& other)
+        : m_arena(other.m_arena)
+    {}
+
+    pointer allocate(size_type n)
+    {
+        return static_cast<pointer>(m_arena->allocate(n * sizeof(T), boost::alignment_of<T>::value));
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        m_arena->deallocate(p, n * sizeof(T));
+    }
+
+    size_type max_size() const
+    {
+        return (std::numeric_limits<size_type>::max)() / sizeof(T);
+    }
+
+    template <typename U>
+    void destroy(U * p)
+    {
+        p->~U();
+    }
+
+    // The copies of the containers get their own slabs
+    arena_allocator select_on_container_copy_construction() const
+    {
+        return arena_allocator(m_arena->max_slab_size());
+    }
+
+    /*!
+    \brief Returns the number of bytes of all slabs allocated so far.
+
+    \par Throws
+    Nothing.
+    */
+    std::size_t allocated_bytes() const
+    {
+        return m_arena->allocated_bytes();
+    }
+
+    template <typename U>
+    bool operator==(arena_allocator<U> const& other) const
+    {
+        return m_arena == other.m_arena;
+    }
+
+    template <typename U>
+    bool operator!=(arena_allocator<U> const& other) const
+    {
+        return m_arena != other.m_arena;
+    }
+
+private:
+    boost::shared_ptr<detail::node_arena> m_arena;
+};
+
+namespace detail {
+
+struct arena_allocator_access
+{
+    // Releases all slabs if the allocator is the only owner of the arena
+    template <typename T>
+    static bool release_if_unique(arena_allocator<T> & a)
+    {
+        if ( !a.m_arena.unique() )
+            return false;
+        a.m_arena->release();
+        return true;
+    }
+};
+
+template <typename Allocator>
+struct is_arena_allocator
+    : boost::false_type
+{};
+
+template <typename T>
+struct is_arena_allocator<arena_allocator<T> >
+    : boost::true_type
+{};
+
+} // namespace detail
+
+}}} // namespace boost::geometry::index
+
+#endif // BOOST_GEOMETRY_INDEX_ARENA_ALLOCATOR_HPP
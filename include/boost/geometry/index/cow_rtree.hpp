@@ -0,0 +1,617 @@
+// Boost.Geometry Index
+//
+// Copy-on-write R-tree with immutable snapshots
+//
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_COW_RTREE_HPP
+#define BOOST_GEOMETRY_INDEX_COW_RTREE_HPP
+
+#include <boost/mpl/assert.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <boost/geometry/index/rtree.hpp>
+
+#include <boost/geometry/index/detail/rtree/cow/insert.hpp>
+#include <boost/geometry/index/detail/rtree/cow/nodes.hpp>
+#include <boost/geometry/index/detail/rtree/cow/remove.hpp>
+
+namespace boost { namespace geometry { namespace index {
+
+namespace detail { namespace rtree { namespace cow {
+
+// The published version of the tree
+template <typename Rtree, typename MembersHolder>
+struct version
+{
+    typedef typename MembersHolder::node_pointer node_pointer;
+    typedef typename MembersHolder::size_type size_type;
+    typedef retired_nodes<Rtree, MembersHolder> retired_nodes_type;
+
+    version(node_pointer r, size_type ll, size_type vc,
+            boost::shared_ptr<retired_nodes_type> const& rn,
+            boost::shared_ptr<Rtree> const& rt)
+        : root(r), leafs_level(ll), values_count(vc)
+        , retired(rn), rtree(rt)
+    {}
+
+    node_pointer root;
+    size_type leafs_level;
+    size_type values_count;
+
+    // the nodes of this version which aren't a part of the next one
+    boost::shared_ptr<retired_nodes_type> retired;
+    // the parameters, translator and allocators
+    boost::shared_ptr<Rtree> rtree;
+};
+
+}}} // namespace detail::rtree::cow
+
+/*!
+\brief The immutable version of the copy-on-write R-tree.
+
+The snapshot is taken with cow_rtree::snapshot() and it's not affected by the modifications
+of the cow_rtree performed later. The nodes of the snapshot are kept alive as long as the snapshot
+or any of its copies exists, even if the cow_rtree is destroyed. Copying the snapshot is cheap.
+The snapshot may be used concurrently by many threads.
+
+\tparam Value           The type of objects stored in the container.
+\tparam Parameters      Compile-time parameters.
+\tparam IndexableGetter The function object extracting Indexable from Value.
+\tparam EqualTo         The function object comparing objects of type Value.
+\tparam Allocator       The allocator used to allocate/deallocate memory,
+                        construct/destroy nodes and Values.
+*/
+template
+<
+    typename Value,
+    typename Parameters,
+    typename IndexableGetter = index::indexable<Value>,
+    typename EqualTo = index::equal_to<Value>,
+    typename Allocator = boost::container::new_allocator<Value>
+>
+class cow_rtree_snapshot
+{
+    typedef index::rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> rtree_type;
+    typedef detail::rtree::const_private_view<rtree_type> view_type;
+    typedef typename view_type::members_holder members_holder;
+    typedef detail::rtree::cow::version<rtree_type, members_holder> version_type;
+
+    template <typename V, typename P, typename I, typename E, typename A>
+    friend class cow_rtree;
+
+public:
+    /*! \brief The type of Value stored in the container. */
+    typedef Value value_type;
+    /*! \brief Unsigned integral type used by the container. */
+    typedef typename rtree_type::size_type size_type;
+
+    /*!
+    \brief The constructor creating an empty snapshot.
+
+    \par Throws
+    Nothing.
+    */
+    inline cow_rtree_snapshot()
+    {}
+
+    /*!
+    \brief Returns the number of stored values.
+
+    \return         The number of stored values.
+
+    \par Throws
+    Nothing.
+    */
+    inline size_type size() const
+    {
+        return m_version ? m_version->values_count : 0;
+    }
+
+    /*!
+    \brief Query if the container is empty.
+
+    \return         true if the container is empty.
+
+    \par Throws
+    Nothing.
+    */
+    inline bool empty() const
+    {
+        return 0 == this->size();
+    }
+
+    /*!
+    \brief Returns the depth of the R-tree, the level of the leafs.
+
+    \par Throws
+    Nothing.
+    */
+    inline size_type depth() const
+    {
+        return m_version ? m_version->leafs_level : 0;
+    }
+
+    /*!
+    \brief Finds values meeting passed predicates e.g. nearest to some Point and/or intersecting some Box.
+
+    The same predicates as in rtree::query() may be passed.
+
+    \par Throws
+    If Value copy constructor or copy assignment throws.
+    If predicates copy throws.
+
+    \param predicates   Predicates.
+    \param out_it       The output iterator, e.g. generated by std::back_inserter().
+
+    \return             The number of values found.
+    */
+    template <typename Predicates, typename OutIter>
+    size_type query(Predicates const& predicates, OutIter out_it) const
+    {
+        if ( !m_version || !m_version->root )
+            return 0;
+
+        static const unsigned distance_predicates_count = detail::predicates_count_distance<Predicates>::value;
+        static const bool is_distance_predicate = 0 < distance_predicates_count;
+        BOOST_MPL_ASSERT_MSG((distance_predicates_count <= 1), PASS_ONLY_ONE_DISTANCE_PREDICATE, (Predicates));
+
+        return query_dispatch(predicates, out_it, boost::mpl::bool_<is_distance_predicate>());
+    }
+
+private:
+    explicit cow_rtree_snapshot(boost::shared_ptr<version_type const> const& v)
+        : m_version(v)
+    {}
+
+    members_holder const& members() const
+    {
+        return view_type(*m_version->rtree).members();
+    }
+
+    template <typename Predicates, typename OutIter>
+    size_type query_dispatch(Predicates const& predicates, OutIter out_it, boost::mpl::bool_<false> const& /*is_distance_predicate*/) const
+    {
+        detail::rtree::visitors::spatial_query<members_holder, Predicates, OutIter>
+            find_v(members().parameters(), members().translator(), predicates, out_it);
+
+        detail::rtree::apply_visitor(find_v, *m_version->root);
+
+        return find_v.found_count;
+    }
+
+    template <typename Predicates, typename OutIter>
+    size_type query_dispatch(Predicates const& predicates, OutIter out_it, boost::mpl::bool_<true> const& /*is_distance_predicate*/) const
+    {
+        static const unsigned distance_predicate_index = detail::predicates_find_distance<Predicates>::value;
+        typename detail::rtree::visitors::distance_query_visitor<
+            members_holder,
+            Predicates,
+            distance_predicate_index,
+            OutIter
+        >::type distance_v(members().parameters(), members().translator(), predicates, out_it);
+
+        detail::rtree::apply_visitor(distance_v, *m_version->root);
+
+        return distance_v.finish();
+    }
+
+    boost::shared_ptr<version_type const> m_version;
+};
+
+/*!
+\brief The copy-on-write R-tree with a single writer and concurrent readers.
+
+The cow_rtree is modified by one thread at a time. Each modifying method publishes
+a new version of the tree. The readers take snapshots of the last published version
+and query them without locking while the writer modifies the tree. The nodes on the path
+from the root to the modified node are copied, the other nodes are shared by the versions.
+The nodes which are no longer a part of the tree are destroyed when all snapshots
+referencing them are released.
+
+The same insert algorithm is used for all Parameters, the forced reinsertions of the R*-tree
+aren't performed because they'd modify the nodes outside of the path to the modified node.
+The tree created from a range of values is packed.
+
+\par Example
+\verbatim
+bgi::cow_rtree<value_t, bgi::rstar<16> > tree;
+
+// the writer thread
+tree.insert(v);
+
+// the reader threads
+bgi::cow_rtree<value_t, bgi::rstar<16> >::snapshot_type s = tree.snapshot();
+s.query(bgi::intersects(box), std::back_inserter(result));
+\endverbatim
+
+\warning
+The nodes of the released snapshots are destroyed in the threads releasing them
+so the Allocator must be safe to use concurrently, e.g. the default one.
+The arena_allocator can't be used.
+
+\tparam Value           The type of objects stored in the container.
+\tparam Parameters      Compile-time parameters.
+\tparam IndexableGetter The function object extracting Indexable from Value.
+\tparam EqualTo         The function object comparing objects of type Value.
+\tparam Allocator       The allocator used to allocate/deallocate memory,
+                        construct/destroy nodes and Values.
+*/
+template
+<
+    typename Value,
+    typename Parameters,
+    typename IndexableGetter = index::indexable<Value>,
+    typename EqualTo = index::equal_to<Value>,
+    typename Allocator = boost::container::new_allocator<Value>
+>
+class cow_rtree
+{
+    typedef index::rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> rtree_type;
+    typedef detail::rtree::private_view<rtree_type> view_type;
+    typedef typename view_type::members_holder members_holder;
+
+    typedef typename members_holder::internal_node internal_node;
+    typedef typename members_holder::leaf leaf;
+    typedef typename members_holder::node_pointer node_pointer;
+    typedef typename members_holder::allocators_type allocators_type;
+
+    typedef detail::rtree::cow::nodes_copier<rtree_type, members_holder> nodes_copier_type;
+    typedef typename nodes_copier_type::retired_nodes_type retired_nodes_type;
+    typedef detail::rtree::cow::version<rtree_type, members_holder> version_type;
+
+    cow_rtree(cow_rtree const&);
+    cow_rtree & operator=(cow_rtree const&);
+
+public:
+    /*! \brief The type of Value stored in the container. */
+    typedef Value value_type;
+    /*! \brief R-tree parameters type. */
+    typedef Parameters parameters_type;
+    /*! \brief The function object extracting Indexable from Value. */
+    typedef IndexableGetter indexable_getter;
+    /*! \brief The function object comparing objects of type Value. */
+    typedef EqualTo value_equal;
+    /*! \brief The type of allocator used by the container. */
+    typedef Allocator allocator_type;
+    /*! \brief Unsigned integral type used by the container. */
+    typedef typename rtree_type::size_type size_type;
+    /*! \brief The type of the immutable version of the tree. */
+    typedef cow_rtree_snapshot<Value, Parameters, IndexableGetter, EqualTo, Allocator> snapshot_type;
+
+    /*!
+    \brief The constructor.
+
+    \param parameters   The parameters object.
+    \param getter       The function object extracting Indexable from Value.
+    \param equal        The function object comparing Values.
+    \param allocator    The allocator object.
+
+    \par Throws
+    If allocator default constructor throws.
+    If allocation throws.
+    */
+    inline explicit cow_rtree(parameters_type const& parameters = parameters_type(),
+                              indexable_getter const& getter = indexable_getter(),
+                              value_equal const& equal = value_equal(),
+                              allocator_type const& allocator = allocator_type())
+        : m_rtree(new rtree_type(parameters, getter, equal, allocator))
+        , m_copier(members().allocators())
+    {
+        this->publish_first();
+    }
+
+    /*!
+    \brief The constructor.
+
+    The tree is created using packing algorithm.
+
+    \param rng          The range of Values.
+    \param parameters   The parameters object.
+    \param getter       The function object extracting Indexable from Value.
+    \param equal        The function object comparing Values.
+    \param allocator    The allocator object.
+
+    \par Throws
+    \li If allocator copy constructor throws.
+    \li If Value copy constructor or copy assignment throws.
+    \li If allocation throws or returns invalid value.
+    */
+    template <typename Range>
+    inline explicit cow_rtree(Range const& rng,
+                              parameters_type const& parameters = parameters_type(),
+                              indexable_getter const& getter = indexable_getter(),
+                              value_equal const& equal = value_equal(),
+                              allocator_type const& allocator = allocator_type())
+        : m_rtree(new rtree_type(rng, parameters, getter, equal, allocator))
+        , m_copier(members().allocators())
+    {
+        this->publish_first();
+    }
+
+    /*!
+    \brief The destructor.
+
+    The nodes of the last version are destroyed when all snapshots are released.
+
+    \par Throws
+    Nothing.
+    */
+    inline ~cow_rtree()
+    {
+        members_holder & m = members();
+        m_retired->set_root(m.root);
+        m.root = 0;
+        m.values_count = 0;
+        m.leafs_level = 0;
+    }
+
+    /*!
+    \brief Returns the last published version of the tree.
+
+    This method may be called concurrently with the modifying methods.
+
+    \return     The snapshot.
+
+    \par Throws
+    Nothing.
+    */
+    inline snapshot_type snapshot() const
+    {
+        return snapshot_type(boost::atomic_load(&m_version));
+    }
+
+    /*!
+    \brief Insert a value to the index and publish the new version.
+
+    \param value    The value which will be stored in the container.
+
+    \par Throws
+    \li If Value copy constructor or copy assignment throws.
+    \li If allocation throws or returns invalid value.
+
+    \warning
+    After an exception is thrown the cow_rtree may be left in an inconsistent state,
+    elements must not be inserted or removed. The snapshots aren't affected.
+    */
+    inline void insert(value_type const& value)
+    {
+        this->raw_insert(value);                                                                    // MAY THROW
+        this->publish();                                                                            // MAY THROW (alloc)
+    }
+
+    /*!
+    \brief Insert a range of values to the index and publish the new version.
+
+    \param first    The beginning of the range of values.
+    \param last     The end of the range of values.
+
+    \par Throws
+    \li If Value copy constructor or copy assignment throws.
+    \li If allocation throws or returns invalid value.
+
+    \warning
+    After an exception is thrown the cow_rtree may be left in an inconsistent state,
+    elements must not be inserted or removed. The snapshots aren't affected.
+    */
+    template <typename Iterator>
+    inline void insert(Iterator first, Iterator last)
+    {
+        for ( ; first != last ; ++first )
+            this->raw_insert(*first);                                                               // MAY THROW
+        this->publish();                                                                            // MAY THROW (alloc)
+    }
+
+    /*!
+    \brief Remove a value from the container and publish the new version.
+
+    In contrast to the \c std::set or <tt>std::map erase()</tt> method
+    this method removes only one value from the container.
+
+    \param value    The value which will be removed from the container.
+
+    \return         1 if the value was removed, 0 otherwise.
+
+    \par Throws
+    \li If Value copy constructor or copy assignment throws.
+    \li If allocation throws or returns invalid value.
+
+    \warning
+    After an exception is thrown the cow_rtree may be left in an inconsistent state,
+    elements must not be inserted or removed. The snapshots aren't affected.
+    */
+    inline size_type remove(value_type const& value)
+    {
+        size_type const result = this->raw_remove(value);                                          // MAY THROW
+        if ( 0 < result )
+            this->publish();                                                                        // MAY THROW (alloc)
+        return result;
+    }
+
+    /*!
+    \brief Remove a range of values from the container and publish the new version.
+
+    This method removes only one value for each one passed in the range, not all equal values.
+
+    \param first    The beginning of the range of values.
+    \param last     The end of the range of values.
+
+    \return         The number of removed values.
+
+    \par Throws
+    \li If Value copy constructor or copy assignment throws.
+    \li If allocation throws or returns invalid value.
+
+    \warning
+    After an exception is thrown the cow_rtree may be left in an inconsistent state,
+    elements must not be inserted or removed. The snapshots aren't affected.
+    */
+    template <typename Iterator>
+    inline size_type remove(Iterator first, Iterator last)
+    {
+        size_type result = 0;
+        for ( ; first != last ; ++first )
+            result += this->raw_remove(*first);                                                     // MAY THROW
+        if ( 0 < result )
+            this->publish();                                                                        // MAY THROW (alloc)
+        return result;
+    }
+
+    /*!
+    \brief Removes all values stored in the container and publish the new version.
+
+    \par Throws
+    If allocation throws.
+    */
+    inline void clear()
+    {
+        members_holder & m = members();
+        if ( m.root )
+        {
+            this->raw_clear(m.root, 0);                                                             // MAY THROW (alloc)
+            m.root = 0;
+            m.values_count = 0;
+            m.leafs_level = 0;
+        }
+        this->publish();                                                                            // MAY THROW (alloc)
+    }
+
+    /*!
+    \brief Returns the number of stored values.
+
+    \return         The number of stored values.
+
+    \par Throws
+    Nothing.
+    */
+    inline size_type size() const
+    {
+        return members().values_count;
+    }
+
+    /*!
+    \brief Query if the container is empty.
+
+    \return         true if the container is empty.
+
+    \par Throws
+    Nothing.
+    */
+    inline bool empty() const
+    {
+        return 0 == members().values_count;
+    }
+
+private:
+    members_holder & members()
+    {
+        return view_type(*m_rtree).members();
+    }
+
+    members_holder const& members() const
+    {
+        return view_type(*m_rtree).members();
+    }
+
+    inline void raw_insert(value_type const& value)
+    {
+        members_holder & m = members();
+
+        BOOST_GEOMETRY_INDEX_ASSERT(detail::is_valid(m.translator()(value)), "Indexable is invalid");
+
+        if ( !m.root )
+        {
+            m.root = detail::rtree::create_node<allocators_type, leaf>::apply(m.allocators());      // MAY THROW (N: alloc)
+            m.values_count = 0;
+            m.leafs_level = 0;
+            m_copier.add_private(m.root);                                                           // MAY THROW (alloc)
+        }
+        else
+        {
+            m_copier.make_private(m.root, 0 == m.leafs_level);                                      // MAY THROW (V, E: alloc, copy, N: alloc)
+        }
+
+        detail::rtree::cow::insert<value_type, members_holder, nodes_copier_type>
+            insert_v(m.root, m.leafs_level, value,
+                     m.parameters(), m.translator(), m.allocators(), m_copier);
+
+        detail::rtree::apply_visitor(insert_v, *m.root);                                            // MAY THROW (V, E: alloc, copy, N: alloc)
+
+        ++m.values_count;
+    }
+
+    inline size_type raw_remove(value_type const& value)
+    {
+        members_holder & m = members();
+
+        if ( !m.root )
+            return 0;
+
+        detail::rtree::cow::remove<members_holder, nodes_copier_type>
+            remove_v(m.root, m.leafs_level, value,
+                     m.parameters(), m.translator(), m.allocators(), m_copier);
+
+        if ( ! remove_v.apply() )                                                                   // MAY THROW (V, E: alloc, copy, N: alloc)
+            return 0;
+
+        BOOST_GEOMETRY_INDEX_ASSERT(0 < m.values_count, "unexpected state");
+        --m.values_count;
+
+        return 1;
+    }
+
+    void raw_clear(node_pointer n, size_type level)
+    {
+        if ( level == members().leafs_level )
+        {
+            m_copier.template destroy<leaf>(n);                                                     // MAY THROW (alloc)
+            return;
+        }
+
+        typedef typename detail::rtree::elements_type<internal_node>::type elements_type;
+        elements_type & elements = detail::rtree::elements(detail::rtree::get<internal_node>(*n));
+        for ( typename elements_type::iterator it = elements.begin() ; it != elements.end() ; ++it )
+            this->raw_clear(it->second, level + 1);                                                 // MAY THROW (alloc)
+
+        m_copier.template destroy<internal_node>(n);                                                // MAY THROW (alloc)
+    }
+
+    void publish_first()
+    {
+        m_retired.reset(new retired_nodes_type(m_rtree));                                           // MAY THROW (alloc)
+        m_copier.reset(m_retired);
+
+        members_holder const& m = members();
+        m_version.reset(new version_type(m.root, m.leafs_level, m.values_count, m_retired, m_rtree)); // MAY THROW (alloc)
+    }
+
+    void publish()
+    {
+        boost::shared_ptr<retired_nodes_type> retired(new retired_nodes_type(m_rtree));            // MAY THROW (alloc)
+
+        members_holder const& m = members();
+        boost::shared_ptr<version_type const>
+            v(new version_type(m.root, m.leafs_level, m.values_count, retired, m_rtree));          // MAY THROW (alloc)
+
+        // the nodes retired by the new version are destroyed after the ones retired by the previous one
+        m_retired->set_next(retired);
+        m_retired = retired;
+        m_copier.reset(retired);
+
+        boost::atomic_store(&m_version, v);
+    }
+
+    boost::shared_ptr<rtree_type> m_rtree;
+    nodes_copier_type m_copier;
+    boost::shared_ptr<retired_nodes_type> m_retired;
+    boost::shared_ptr<version_type const> m_version;
+};
+
+}}} // namespace boost::geometry::index
+
+#endif // BOOST_GEOMETRY_INDEX_COW_RTREE_HPP
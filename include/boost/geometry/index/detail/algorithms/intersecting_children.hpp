@@ -0,0 +1,347 @@
+// Boost.Geometry Index
+//
+// Intersection tests of the boxes of the children of a node with a query box
+//
+// Copyright (c) 2011-2020 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_ALGORITHMS_INTERSECTING_CHILDREN_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_ALGORITHMS_INTERSECTING_CHILDREN_HPP
+
+#include <cstddef>
+
+#include <boost/cstdint.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+#include <boost/geometry/core/access.hpp>
+#include <boost/geometry/core/coordinate_dimension.hpp>
+#include <boost/geometry/core/coordinate_system.hpp>
+#include <boost/geometry/core/coordinate_type.hpp>
+#include <boost/geometry/core/cs.hpp>
+#include <boost/geometry/core/tags.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/point_xy.hpp>
+
+#include <boost/geometry/index/detail/predicates.hpp>
+
+// The SIMD kernels may be disabled by defining BOOST_GEOMETRY_INDEX_DETAIL_NO_SIMD
+#if !defined(BOOST_GEOMETRY_INDEX_DETAIL_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BOOST_GEOMETRY_INDEX_DETAIL_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(BOOST_GEOMETRY_INDEX_DETAIL_SIMD_SSE2) && defined(__AVX__)
+#define BOOST_GEOMETRY_INDEX_DETAIL_SIMD_AVX
+#include <immintrin.h>
+#endif
+#endif // !BOOST_GEOMETRY_INDEX_DETAIL_NO_SIMD
+
+namespace boost { namespace geometry { namespace index { namespace detail {
+
+// The predicates for which the boxes of the children are checked with intersects(Box, G)
+// (see predicate_check<..., bounds_tag>) and G is a cartesian box so the check may be
+// performed with the specialised kernels below.
+template <typename Predicates, typename Box>
+struct is_box_intersects_bounds_check
+    : boost::false_type
+{};
+
+template <typename Tag, bool Negated>
+struct is_box_intersects_bounds_tag
+    : boost::false_type
+{};
+
+template <> struct is_box_intersects_bounds_tag<predicates::intersects_tag, false> : boost::true_type {};
+template <> struct is_box_intersects_bounds_tag<predicates::covered_by_tag, false> : boost::true_type {};
+template <> struct is_box_intersects_bounds_tag<predicates::overlaps_tag, false> : boost::true_type {};
+template <> struct is_box_intersects_bounds_tag<predicates::touches_tag, false> : boost::true_type {};
+template <> struct is_box_intersects_bounds_tag<predicates::within_tag, false> : boost::true_type {};
+template <> struct is_box_intersects_bounds_tag<predicates::disjoint_tag, true> : boost::true_type {};
+
+template <typename Geometry, typename Tag, bool Negated, typename Box>
+struct is_box_intersects_bounds_check<predicates::spatial_predicate<Geometry, Tag, Negated>, Box>
+    : boost::mpl::bool_
+        <
+            is_box_intersects_bounds_tag<Tag, Negated>::value
+         && boost::is_same<typename geometry::tag<Geometry>::type, box_tag>::value
+         && boost::is_same<typename geometry::cs_tag<Geometry>::type, cartesian_tag>::value
+         && boost::is_same<typename geometry::cs_tag<Box>::type, cartesian_tag>::value
+         && geometry::dimension<Geometry>::value == geometry::dimension<Box>::value
+        >
+{
+    typedef Geometry query_box_type;
+};
+
+// The children of a node tested at once by intersecting_children
+static const std::size_t intersecting_children_max_count = 64;
+
+template <typename Box, typename QueryBox,
+          std::size_t I = 0, std::size_t D = geometry::dimension<Box>::value>
+struct box_intersects_query_box
+{
+    static inline bool apply(Box const& box, QueryBox const& query_box)
+    {
+        if ( geometry::get<max_corner, I>(box) < geometry::get<min_corner, I>(query_box)
+          || geometry::get<min_corner, I>(box) > geometry::get<max_corner, I>(query_box) )
+        {
+            return false;
+        }
+
+        return box_intersects_query_box<Box, QueryBox, I + 1, D>::apply(box, query_box);
+    }
+};
+
+template <typename Box, typename QueryBox, std::size_t D>
+struct box_intersects_query_box<Box, QueryBox, D, D>
+{
+    static inline bool apply(Box const&, QueryBox const&)
+    {
+        return true;
+    }
+};
+
+// Returns the mask of the children of an internal node intersecting the query box,
+// the i-th bit is set if the box of the i-th child intersects it.
+// The boxes are compared the way the cartesian disjoint box/box strategy does it.
+// Children is a random access iterator to the elements of an internal node,
+// the count must not be greater than intersecting_children_max_count.
+template <typename Box, typename QueryBox>
+struct intersecting_children_scalar
+{
+    template <typename Children>
+    static inline boost::uint64_t apply(Children children, std::size_t count, QueryBox const& query_box)
+    {
+        boost::uint64_t result = 0;
+        for ( std::size_t i = 0 ; i < count ; ++i )
+        {
+            if ( box_intersects_query_box<Box, QueryBox>::apply(children[i].first, query_box) )
+                result |= boost::uint64_t(1) << i;
+        }
+        return result;
+    }
+};
+
+// The boxes storing their coordinates contiguously in the corners
+template <typename Box>
+struct simd_box_traits
+{
+    static const bool enabled = false;
+};
+
+template <typename CoordinateType, std::size_t DimensionCount>
+struct simd_box_traits<model::box<model::point<CoordinateType, DimensionCount, cs::cartesian> > >
+{
+    static const bool enabled = true;
+    typedef CoordinateType coordinate_type;
+    static const std::size_t dimension = DimensionCount;
+
+    template <typename Point>
+    static inline coordinate_type const* coordinates(Point const& p)
+    {
+        return &(p.template get<0>());
+    }
+};
+
+template <typename CoordinateType>
+struct simd_box_traits<model::box<model::d2::point_xy<CoordinateType, cs::cartesian> > >
+    : simd_box_traits<model::box<model::point<CoordinateType, 2, cs::cartesian> > >
+{};
+
+#ifdef BOOST_GEOMETRY_INDEX_DETAIL_SIMD_SSE2
+
+template <typename CoordinateType, std::size_t Dimension>
+struct simd_disjoint_coordinates
+{
+    static const bool enabled = false;
+};
+
+// For each pair of dimensions the lanes are set if the box is on the other side
+// of the query box. The unused lanes are zeroed in both boxes so they're never set.
+template <std::size_t Dimension>
+struct simd_disjoint_coordinates<double, Dimension>
+{
+    static const bool enabled = true;
+
+    struct query_type
+    {
+        query_type(double const* qmin, double const* qmax)
+        {
+            for ( std::size_t d = 0 ; d < Dimension ; ++d )
+            {
+                min[d] = qmin[d];
+                max[d] = qmax[d];
+            }
+        }
+
+        double min[Dimension];
+        double max[Dimension];
+    };
+
+    static inline bool apply(double const* bmin, double const* bmax, query_type const& q)
+    {
+        std::size_t d = 0;
+
+#ifdef BOOST_GEOMETRY_INDEX_DETAIL_SIMD_AVX
+        if ( Dimension >= 3 )
+        {
+            __m256d out = _mm256_setzero_pd();
+            for ( ; d + 4 <= Dimension ; d += 4 )
+            {
+                out = _mm256_or_pd(out, _mm256_or_pd(
+                        _mm256_cmp_pd(_mm256_loadu_pd(bmax + d), _mm256_loadu_pd(q.min + d), _CMP_LT_OQ),
+                        _mm256_cmp_pd(_mm256_loadu_pd(q.max + d), _mm256_loadu_pd(bmin + d), _CMP_LT_OQ)));
+            }
+            if ( Dimension - d == 3 )
+            {
+                out = _mm256_or_pd(out, _mm256_or_pd(
+                        _mm256_cmp_pd(_mm256_setr_pd(bmax[d], bmax[d + 1], bmax[d + 2], 0),
+                                      _mm256_setr_pd(q.min[d], q.min[d + 1], q.min[d + 2], 0), _CMP_LT_OQ),
+                        _mm256_cmp_pd(_mm256_setr_pd(q.max[d], q.max[d + 1], q.max[d + 2], 0),
+                                      _mm256_setr_pd(bmin[d], bmin[d + 1], bmin[d + 2], 0), _CMP_LT_OQ)));
+                d += 3;
+            }
+            if ( _mm256_movemask_pd(out) != 0 )
+                return true;
+        }
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_SIMD_AVX
+
+        __m128d out = _mm_setzero_pd();
+        for ( ; d + 2 <= Dimension ; d += 2 )
+        {
+            out = _mm_or_pd(out, _mm_or_pd(
+                    _mm_cmplt_pd(_mm_loadu_pd(bmax + d), _mm_loadu_pd(q.min + d)),
+                    _mm_cmplt_pd(_mm_loadu_pd(q.max + d), _mm_loadu_pd(bmin + d))));
+        }
+        if ( d < Dimension )
+        {
+            out = _mm_or_pd(out, _mm_or_pd(
+                    _mm_cmplt_sd(_mm_set_sd(bmax[d]), _mm_set_sd(q.min[d])),
+                    _mm_cmplt_sd(_mm_set_sd(q.max[d]), _mm_set_sd(bmin[d]))));
+        }
+        return _mm_movemask_pd(out) != 0;
+    }
+};
+
+template <std::size_t Dimension>
+struct simd_disjoint_coordinates<float, Dimension>
+{
+    static const bool enabled = true;
+
+    struct query_type
+    {
+        query_type(float const* qmin, float const* qmax)
+        {
+            for ( std::size_t d = 0 ; d < Dimension ; ++d )
+            {
+                min[d] = qmin[d];
+                max[d] = qmax[d];
+            }
+        }
+
+        float min[Dimension];
+        float max[Dimension];
+    };
+
+    static inline __m128 load(float const* p, std::size_t n)
+    {
+        return n >= 4 ? _mm_loadu_ps(p)
+             : n == 3 ? _mm_setr_ps(p[0], p[1], p[2], 0)
+             : n == 2 ? _mm_setr_ps(p[0], p[1], 0, 0)
+             :          _mm_setr_ps(p[0], 0, 0, 0);
+    }
+
+    static inline bool apply(float const* bmin, float const* bmax, query_type const& q)
+    {
+        __m128 out = _mm_setzero_ps();
+        for ( std::size_t d = 0 ; d < Dimension ; d += 4 )
+        {
+            std::size_t const n = Dimension - d;
+            out = _mm_or_ps(out, _mm_or_ps(
+                    _mm_cmplt_ps(load(bmax + d, n), load(q.min + d, n)),
+                    _mm_cmplt_ps(load(q.max + d, n), load(bmin + d, n))));
+        }
+        return _mm_movemask_ps(out) != 0;
+    }
+};
+
+template <typename Box, typename QueryBox>
+struct intersecting_children_simd
+{
+    typedef simd_box_traits<Box> box_traits;
+    typedef simd_box_traits<QueryBox> query_box_traits;
+    typedef typename box_traits::coordinate_type coordinate_type;
+    typedef simd_disjoint_coordinates<coordinate_type, box_traits::dimension> disjoint_coordinates;
+    typedef typename disjoint_coordinates::query_type query_type;
+
+    template <typename Children>
+    static inline boost::uint64_t apply(Children children, std::size_t count, QueryBox const& query_box)
+    {
+        query_type const q(query_box_traits::coordinates(query_box.min_corner()),
+                           query_box_traits::coordinates(query_box.max_corner()));
+
+        boost::uint64_t result = 0;
+        for ( std::size_t i = 0 ; i < count ; ++i )
+        {
+            Box const& b = children[i].first;
+            if ( ! disjoint_coordinates::apply(box_traits::coordinates(b.min_corner()),
+                                               box_traits::coordinates(b.max_corner()), q) )
+            {
+                result |= boost::uint64_t(1) << i;
+            }
+        }
+        return result;
+    }
+};
+
+template <typename Box, typename QueryBox,
+          bool Enabled = simd_box_traits<Box>::enabled && simd_box_traits<QueryBox>::enabled>
+struct is_simd_intersecting_children
+    : boost::false_type
+{};
+
+template <typename Box, typename QueryBox>
+struct is_simd_intersecting_children<Box, QueryBox, true>
+    : boost::mpl::bool_
+        <
+            boost::is_same
+                <
+                    typename simd_box_traits<Box>::coordinate_type,
+                    typename simd_box_traits<QueryBox>::coordinate_type
+                >::value
+         && simd_disjoint_coordinates
+                <
+                    typename simd_box_traits<Box>::coordinate_type,
+                    simd_box_traits<Box>::dimension
+                >::enabled
+        >
+{};
+
+template <typename Box, typename QueryBox,
+          bool UseSimd = is_simd_intersecting_children<Box, QueryBox>::value>
+struct intersecting_children
+    : intersecting_children_scalar<Box, QueryBox>
+{};
+
+template <typename Box, typename QueryBox>
+struct intersecting_children<Box, QueryBox, true>
+    : intersecting_children_simd<Box, QueryBox>
+{};
+
+#else // BOOST_GEOMETRY_INDEX_DETAIL_SIMD_SSE2
+
+template <typename Box, typename QueryBox>
+struct intersecting_children
+    : intersecting_children_scalar<Box, QueryBox>
+{};
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_SIMD_SSE2
+
+}}}} // namespace boost::geometry::index::detail
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_ALGORITHMS_INTERSECTING_CHILDREN_HPP
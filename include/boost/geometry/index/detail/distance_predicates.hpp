@@ -239,8 +239,8 @@ struct calculate_distance
 };
 
 // this handles nearest() with default Point parameter, to_nearest() and bounds
-template <typename PointRelation, typename Indexable, typename Strategy, typename Tag>
-struct calculate_distance< predicates::nearest<PointRelation>, Indexable, Strategy, Tag>
+template <typename PointRelation, typename Traversal, typename Indexable, typename Strategy, typename Tag>
+struct calculate_distance< predicates::nearest<PointRelation, Traversal>, Indexable, Strategy, Tag>
 {
     typedef detail::relation<PointRelation> relation;
     typedef comparable_distance_call
@@ -251,7 +251,7 @@ struct calculate_distance< predicates::nearest<PointRelation>, Indexable, Strate
         > call_type;
     typedef typename call_type::result_type result_type;
 
-    static inline bool apply(predicates::nearest<PointRelation> const& p, Indexable const& i,
+    static inline bool apply(predicates::nearest<PointRelation, Traversal> const& p, Indexable const& i,
                              Strategy const& s, result_type & result)
     {
         result = call_type::apply(relation::value(p.point_or_relation), i, s);
@@ -259,8 +259,8 @@ struct calculate_distance< predicates::nearest<PointRelation>, Indexable, Strate
     }
 };
 
-template <typename Point, typename Indexable, typename Strategy>
-struct calculate_distance< predicates::nearest< to_centroid<Point> >, Indexable, Strategy, value_tag>
+template <typename Point, typename Traversal, typename Indexable, typename Strategy>
+struct calculate_distance< predicates::nearest< to_centroid<Point>, Traversal >, Indexable, Strategy, value_tag>
 {
     typedef Point point_type;
     typedef typename geometry::default_comparable_distance_result
@@ -268,7 +268,7 @@ struct calculate_distance< predicates::nearest< to_centroid<Point> >, Indexable,
             point_type, Indexable
         >::type result_type;
 
-    static inline bool apply(predicates::nearest< to_centroid<Point> > const& p, Indexable const& i,
+    static inline bool apply(predicates::nearest< to_centroid<Point>, Traversal > const& p, Indexable const& i,
                              Strategy const& , result_type & result)
     {
         result = index::detail::comparable_distance_centroid(p.point_or_relation.value, i);
@@ -276,8 +276,8 @@ struct calculate_distance< predicates::nearest< to_centroid<Point> >, Indexable,
     }
 };
 
-template <typename Point, typename Indexable, typename Strategy>
-struct calculate_distance< predicates::nearest< to_furthest<Point> >, Indexable, Strategy, value_tag>
+template <typename Point, typename Traversal, typename Indexable, typename Strategy>
+struct calculate_distance< predicates::nearest< to_furthest<Point>, Traversal >, Indexable, Strategy, value_tag>
 {
     typedef Point point_type;
     typedef typename geometry::default_comparable_distance_result
@@ -285,7 +285,7 @@ struct calculate_distance< predicates::nearest< to_furthest<Point> >, Indexable,
             point_type, Indexable
         >::type result_type;
 
-    static inline bool apply(predicates::nearest< to_furthest<Point> > const& p, Indexable const& i,
+    static inline bool apply(predicates::nearest< to_furthest<Point>, Traversal > const& p, Indexable const& i,
                              Strategy const& , result_type & result)
     {
         result = index::detail::comparable_distance_far(p.point_or_relation.value, i);
@@ -0,0 +1,245 @@
+// Boost.Geometry Index
+//
+// Multithreading utilities
+//
+// Copyright (c) 2011-2014 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_PARALLEL_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_PARALLEL_HPP
+
+#include <boost/config.hpp>
+
+// Threads are used only if they're supported by the standard library
+// and exceptions thrown in worker threads can be propagated to the caller.
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) \
+ && !defined(BOOST_NO_CXX11_HDR_EXCEPTION) \
+ && !defined(BOOST_NO_CXX11_LAMBDAS) \
+ && !defined(BOOST_NO_EXCEPTIONS) \
+ && !defined(BOOST_GEOMETRY_INDEX_DISABLE_THREADS)
+#define BOOST_GEOMETRY_INDEX_DETAIL_HAS_THREADS
+#endif
+
+#include <cstddef>
+
+#ifdef BOOST_GEOMETRY_INDEX_DETAIL_HAS_THREADS
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+namespace boost { namespace geometry { namespace index { namespace detail {
+
+#ifdef BOOST_GEOMETRY_INDEX_DETAIL_HAS_THREADS
+
+// Runs a function object in a separate thread and stores the exception
+// thrown by it. The thread is always joined before destruction.
+class worker_thread
+{
+    worker_thread(worker_thread const&);
+    worker_thread & operator=(worker_thread const&);
+
+public:
+    template <typename Function>
+    explicit worker_thread(Function const& f)
+        : m_thread([this, f]()
+                   {
+                       try { f(); }
+                       catch (...) { m_exception = std::current_exception(); }
+                   })
+    {}
+
+    ~worker_thread()
+    {
+        join();
+    }
+
+    void join()
+    {
+        if ( m_thread.joinable() )
+            m_thread.join();
+    }
+
+    // Joins the thread and rethrows the exception thrown in it, if any
+    void join_and_rethrow()
+    {
+        join();
+        if ( m_exception )
+            std::rethrow_exception(m_exception);
+    }
+
+    bool failed() const
+    {
+        return static_cast<bool>(m_exception);
+    }
+
+private:
+    std::exception_ptr m_exception;
+    std::thread m_thread;
+};
+
+// The range of indexes processed by one thread. The owner takes indexes
+// from the front, other threads steal the back half of the range.
+class work_range
+{
+    work_range(work_range const&);
+    work_range & operator=(work_range const&);
+
+public:
+    work_range()
+        : m_first(0), m_last(0)
+    {}
+
+    void assign(std::size_t first, std::size_t last)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_first = first;
+        m_last = last;
+    }
+
+    bool pop_front(std::size_t & index)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if ( m_first == m_last )
+            return false;
+        index = m_first++;
+        return true;
+    }
+
+    bool steal_back(std::size_t & first, std::size_t & last)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::size_t const count = m_last - m_first;
+        if ( count == 0 )
+            return false;
+        last = m_last;
+        first = m_last - (count + 1) / 2;
+        m_last = first;
+        return true;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::size_t m_first;
+    std::size_t m_last;
+};
+
+// Work-stealing scheduler executing f(i) for i in [0, count).
+// Each thread starts with a contiguous part of the range. A thread which
+// has no more work steals half of the remaining indexes of other threads.
+// If f throws the remaining indexes are not processed and the first
+// exception is rethrown after all threads are joined.
+class work_stealing_for
+{
+public:
+    template <typename Function>
+    static inline void apply(std::size_t count, std::size_t threads_count, Function const& f)
+    {
+        threads_count = (std::min)(threads_count, count);
+        if ( threads_count <= 1 )
+        {
+            for ( std::size_t i = 0 ; i < count ; ++i )
+                f(i);
+            return;
+        }
+
+        std::vector<work_range> ranges(threads_count);
+        for ( std::size_t t = 0 ; t < threads_count ; ++t )
+            ranges[t].assign(count * t / threads_count, count * (t + 1) / threads_count);
+
+        std::atomic<bool> stop(false);
+
+        {
+            std::vector<std::unique_ptr<worker_thread> > threads;
+            threads.reserve(threads_count - 1);
+
+            try
+            {
+                for ( std::size_t t = 1 ; t < threads_count ; ++t )
+                {
+                    threads.emplace_back(new worker_thread([&, t]()
+                    {
+                        work(t, ranges, stop, f);
+                    }));
+                }
+
+                work(0, ranges, stop, f);
+            }
+            catch (...)
+            {
+                stop = true;
+                throw; // the threads are joined in destructors
+            }
+
+            for ( std::size_t t = 0 ; t < threads.size() ; ++t )
+                threads[t]->join_and_rethrow();
+        }
+    }
+
+private:
+    template <typename Function>
+    static inline void work(std::size_t t, std::vector<work_range> & ranges,
+                            std::atomic<bool> & stop, Function const& f)
+    {
+        std::size_t const threads_count = ranges.size();
+        try
+        {
+            for (;;)
+            {
+                std::size_t i = 0;
+                while ( ! stop && ranges[t].pop_front(i) )
+                    f(i);
+
+                if ( stop )
+                    return;
+
+                // steal from the other threads, starting from the next one
+                bool stolen = false;
+                for ( std::size_t v = 1 ; v < threads_count && ! stolen ; ++v )
+                {
+                    std::size_t first = 0, last = 0;
+                    if ( ranges[(t + v) % threads_count].steal_back(first, last) )
+                    {
+                        ranges[t].assign(first, last);
+                        stolen = true;
+                    }
+                }
+
+                // no work is left, the indexes being processed by other threads can't be stolen
+                if ( ! stolen )
+                    return;
+            }
+        }
+        catch (...)
+        {
+            stop = true;
+            throw;
+        }
+    }
+};
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_HAS_THREADS
+
+// Calls f(i) for i in [0, count) using at most threads_count threads
+// or in the calling thread if threads are not supported.
+template <typename Function>
+inline void parallel_for(std::size_t count, std::size_t threads_count, Function const& f)
+{
+#ifdef BOOST_GEOMETRY_INDEX_DETAIL_HAS_THREADS
+    work_stealing_for::apply(count, threads_count, f);
+#else
+    for ( std::size_t i = 0 ; i < count ; ++i )
+        f(i);
+#endif
+}
+
+}}}} // namespace boost::geometry::index::detail
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_PARALLEL_HPP
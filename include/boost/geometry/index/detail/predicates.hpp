@@ -15,10 +15,19 @@
 #ifndef BOOST_GEOMETRY_INDEX_DETAIL_PREDICATES_HPP
 #define BOOST_GEOMETRY_INDEX_DETAIL_PREDICATES_HPP
 
-//#include <utility>
+#include <cstddef>
 
 #include <boost/mpl/assert.hpp>
+#include <boost/mpl/bool.hpp>
 #include <boost/tuple/tuple.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+#include <boost/geometry/core/access.hpp>
+#include <boost/geometry/core/coordinate_dimension.hpp>
+#include <boost/geometry/core/coordinate_system.hpp>
+#include <boost/geometry/core/cs.hpp>
+#include <boost/geometry/core/tag.hpp>
+#include <boost/geometry/core/tags.hpp>
 
 #include <boost/geometry/index/detail/tags.hpp>
 
@@ -78,13 +87,33 @@ struct spatial_predicate
 
 // ------------------------------------------------------------------ //
 
+// The dimension of during() predicate meaning the last dimension of the indexables
+static const std::size_t last_dimension = static_cast<std::size_t>(-1);
+
+// The closed interval of coordinates in one dimension, e.g. the time
+template <typename T, std::size_t Dimension>
+struct during
+{
+    during() {}
+    during(T const& f, T const& l) : first(f), last(l) {}
+    T first;
+    T last;
+};
+
+// ------------------------------------------------------------------ //
+
 // CONSIDER: separated nearest<> and path<> may be replaced by
 //           nearest_predicate<Geometry, Tag>
 //           where Tag = point_tag | path_tag
 // IMPROVEMENT: user-defined nearest predicate allowing to define
 //              all or only geometrical aspects of the search
 
-template <typename PointOrRelation>
+// The traversals of the tree performed by the k-nearest neighbours query
+
+struct depth_first_tag {};
+struct best_first_tag {};
+
+template <typename PointOrRelation, typename Traversal = depth_first_tag>
 struct nearest
 {
     nearest()
@@ -151,6 +180,105 @@ struct predicate_check<predicates::satisfies<Fun, true>, value_tag>
 
 // ------------------------------------------------------------------ //
 
+// The kernels comparing the coordinates of a cartesian point with a cartesian box
+// the way the cartesian point/box strategies do it.
+template <typename Point, typename Box,
+          std::size_t I = 0, std::size_t D = geometry::dimension<Box>::value>
+struct point_box_coordinates
+{
+    static inline bool covered_by(Point const& p, Box const& b)
+    {
+        return geometry::get<I>(p) >= geometry::get<min_corner, I>(b)
+            && geometry::get<I>(p) <= geometry::get<max_corner, I>(b)
+            && point_box_coordinates<Point, Box, I + 1, D>::covered_by(p, b);
+    }
+
+    static inline bool within(Point const& p, Box const& b)
+    {
+        return geometry::get<I>(p) > geometry::get<min_corner, I>(b)
+            && geometry::get<I>(p) < geometry::get<max_corner, I>(b)
+            && point_box_coordinates<Point, Box, I + 1, D>::within(p, b);
+    }
+};
+
+template <typename Point, typename Box, std::size_t D>
+struct point_box_coordinates<Point, Box, D, D>
+{
+    static inline bool covered_by(Point const&, Box const&) { return true; }
+    static inline bool within(Point const&, Box const&) { return true; }
+};
+
+template <typename Indexable, typename Geometry>
+struct is_cartesian_point_box
+    : boost::mpl::bool_
+        <
+            boost::is_same<typename geometry::tag<Indexable>::type, point_tag>::value
+         && boost::is_same<typename geometry::tag<Geometry>::type, box_tag>::value
+         && boost::is_same<typename geometry::cs_tag<Indexable>::type, cartesian_tag>::value
+         && boost::is_same<typename geometry::cs_tag<Geometry>::type, cartesian_tag>::value
+         && geometry::dimension<Indexable>::value == geometry::dimension<Geometry>::value
+        >
+{};
+
+// The kernel comparing the coordinates of two cartesian boxes the way
+// the cartesian box/box strategies do it.
+template <typename Box1, typename Box2,
+          std::size_t I = 0, std::size_t D = geometry::dimension<Box2>::value>
+struct box_box_coordinates
+{
+    static inline bool intersects(Box1 const& b1, Box2 const& b2)
+    {
+        return geometry::get<max_corner, I>(b1) >= geometry::get<min_corner, I>(b2)
+            && geometry::get<min_corner, I>(b1) <= geometry::get<max_corner, I>(b2)
+            && box_box_coordinates<Box1, Box2, I + 1, D>::intersects(b1, b2);
+    }
+};
+
+template <typename Box1, typename Box2, std::size_t D>
+struct box_box_coordinates<Box1, Box2, D, D>
+{
+    static inline bool intersects(Box1 const&, Box2 const&) { return true; }
+};
+
+// The query box having less dimensions than the indexable or the bounds, e.g. 2d box
+// and the indexables having additional time dimension, constrains only the first
+// coordinates of the indexables.
+template
+<
+    typename Geometry, typename Box,
+    typename Tag = typename geometry::tag<Geometry>::type,
+    bool IsProjection = (geometry::dimension<Box>::value < geometry::dimension<Geometry>::value)
+                     && boost::is_same<typename geometry::tag<Box>::type, box_tag>::value
+                     && boost::is_same<typename geometry::cs_tag<Geometry>::type, cartesian_tag>::value
+                     && boost::is_same<typename geometry::cs_tag<Box>::type, cartesian_tag>::value
+>
+struct projected_intersects
+{
+    static const bool enabled = false;
+};
+
+template <typename Point, typename Box>
+struct projected_intersects<Point, Box, point_tag, true>
+{
+    static const bool enabled = true;
+
+    static inline bool apply(Point const& p, Box const& b)
+    {
+        return point_box_coordinates<Point, Box>::covered_by(p, b);
+    }
+};
+
+template <typename Box1, typename Box2>
+struct projected_intersects<Box1, Box2, box_tag, true>
+{
+    static const bool enabled = true;
+
+    static inline bool apply(Box1 const& b1, Box2 const& b2)
+    {
+        return box_box_coordinates<Box1, Box2>::intersects(b1, b2);
+    }
+};
+
 template <typename Tag>
 struct spatial_predicate_call
 {
@@ -234,9 +362,22 @@ struct spatial_predicate_call<predicates::intersects_tag>
 {
     template <typename G1, typename G2, typename S>
     static inline bool apply(G1 const& g1, G2 const& g2, S const& s)
+    {
+        return apply(g1, g2, s, boost::mpl::bool_<projected_intersects<G1, G2>::enabled>());
+    }
+
+private:
+    template <typename G1, typename G2, typename S>
+    static inline bool apply(G1 const& g1, G2 const& g2, S const& s, boost::mpl::bool_<false> const&)
     {
         return spatial_predicate_intersects<G1, G2>::apply(g1, g2, s);
     }
+
+    template <typename G1, typename G2, typename S>
+    static inline bool apply(G1 const& g1, G2 const& g2, S const&, boost::mpl::bool_<true> const&)
+    {
+        return projected_intersects<G1, G2>::apply(g1, g2);
+    }
 };
 
 template <>
@@ -271,6 +412,57 @@ struct spatial_predicate_call<predicates::within_tag>
 
 // ------------------------------------------------------------------ //
 
+// The indexables of the values are checked with the generic algorithms unless
+// they're cartesian points and the predicate geometry is a cartesian box.
+template
+<
+    typename Tag, typename Indexable, typename Geometry,
+    bool IsPointBox = is_cartesian_point_box<Indexable, Geometry>::value
+>
+struct spatial_predicate_value
+{
+    template <typename S>
+    static inline bool apply(Indexable const& i, Geometry const& g, S const& s)
+    {
+        return spatial_predicate_call<Tag>::apply(i, g, s);
+    }
+};
+
+template <typename Indexable, typename Geometry>
+struct spatial_predicate_value<predicates::covered_by_tag, Indexable, Geometry, true>
+{
+    template <typename S>
+    static inline bool apply(Indexable const& i, Geometry const& g, S const&)
+    {
+        return point_box_coordinates<Indexable, Geometry>::covered_by(i, g);
+    }
+};
+
+template <typename Indexable, typename Geometry>
+struct spatial_predicate_value<predicates::intersects_tag, Indexable, Geometry, true>
+    : spatial_predicate_value<predicates::covered_by_tag, Indexable, Geometry, true>
+{};
+
+template <typename Indexable, typename Geometry>
+struct spatial_predicate_value<predicates::disjoint_tag, Indexable, Geometry, true>
+{
+    template <typename S>
+    static inline bool apply(Indexable const& i, Geometry const& g, S const&)
+    {
+        return ! point_box_coordinates<Indexable, Geometry>::covered_by(i, g);
+    }
+};
+
+template <typename Indexable, typename Geometry>
+struct spatial_predicate_value<predicates::within_tag, Indexable, Geometry, true>
+{
+    template <typename S>
+    static inline bool apply(Indexable const& i, Geometry const& g, S const&)
+    {
+        return point_box_coordinates<Indexable, Geometry>::within(i, g);
+    }
+};
+
 // spatial predicate
 template <typename Geometry, typename Tag>
 struct predicate_check<predicates::spatial_predicate<Geometry, Tag, false>, value_tag>
@@ -280,7 +472,7 @@ struct predicate_check<predicates::spatial_predicate<Geometry, Tag, false>, valu
     template <typename Value, typename Indexable, typename Strategy>
     static inline bool apply(Pred const& p, Value const&, Indexable const& i, Strategy const& s)
     {
-        return spatial_predicate_call<Tag>::apply(i, p.geometry, s);
+        return spatial_predicate_value<Tag, Indexable, Geometry>::apply(i, p.geometry, s);
     }
 };
 
@@ -293,17 +485,101 @@ struct predicate_check<predicates::spatial_predicate<Geometry, Tag, true>, value
     template <typename Value, typename Indexable, typename Strategy>
     static inline bool apply(Pred const& p, Value const&, Indexable const& i, Strategy const& s)
     {
-        return !spatial_predicate_call<Tag>::apply(i, p.geometry, s);
+        return !spatial_predicate_value<Tag, Indexable, Geometry>::apply(i, p.geometry, s);
     }
 };
 
 // ------------------------------------------------------------------ //
 
-template <typename DistancePredicates>
-struct predicate_check<predicates::nearest<DistancePredicates>, value_tag>
+// during predicate
+
+template <std::size_t Dimension, typename Geometry>
+struct during_dimension
+{
+    static const std::size_t value = Dimension;
+};
+
+template <typename Geometry>
+struct during_dimension<predicates::last_dimension, Geometry>
+{
+    static const std::size_t value = geometry::dimension<Geometry>::value - 1;
+};
+
+// Checks if the coordinates of the geometry in the Dimension overlap the interval
+template
+<
+    typename Geometry, std::size_t Dimension,
+    typename Tag = typename geometry::tag<Geometry>::type
+>
+struct coordinates_in_interval
+{
+    BOOST_MPL_ASSERT_MSG(
+        (false),
+        NOT_IMPLEMENTED_FOR_THIS_GEOMETRY,
+        (coordinates_in_interval));
+};
+
+template <typename Point, std::size_t Dimension>
+struct coordinates_in_interval<Point, Dimension, point_tag>
+{
+    template <typename T>
+    static inline bool apply(Point const& p, T const& first, T const& last)
+    {
+        return first <= geometry::get<Dimension>(p)
+            && geometry::get<Dimension>(p) <= last;
+    }
+};
+
+template <typename Box, std::size_t Dimension>
+struct coordinates_in_interval<Box, Dimension, box_tag>
+{
+    template <typename T>
+    static inline bool apply(Box const& b, T const& first, T const& last)
+    {
+        return first <= geometry::get<max_corner, Dimension>(b)
+            && geometry::get<min_corner, Dimension>(b) <= last;
+    }
+};
+
+template <typename Segment, std::size_t Dimension>
+struct coordinates_in_interval<Segment, Dimension, segment_tag>
+{
+    template <typename T>
+    static inline bool apply(Segment const& s, T const& first, T const& last)
+    {
+        return ( first <= geometry::get<0, Dimension>(s) || first <= geometry::get<1, Dimension>(s) )
+            && ( geometry::get<0, Dimension>(s) <= last || geometry::get<1, Dimension>(s) <= last );
+    }
+};
+
+template <typename T, std::size_t Dimension, typename Geometry>
+inline bool during_check(predicates::during<T, Dimension> const& p, Geometry const& g)
+{
+    static const std::size_t dimension = during_dimension<Dimension, Geometry>::value;
+    BOOST_MPL_ASSERT_MSG((dimension < geometry::dimension<Geometry>::value),
+                         INVALID_DIMENSION,
+                         (predicates::during<T, Dimension>));
+
+    return coordinates_in_interval<Geometry, dimension>::apply(g, p.first, p.last);
+}
+
+template <typename T, std::size_t Dimension>
+struct predicate_check<predicates::during<T, Dimension>, value_tag>
+{
+    template <typename Value, typename Indexable, typename Strategy>
+    static inline bool apply(predicates::during<T, Dimension> const& p, Value const&, Indexable const& i, Strategy const&)
+    {
+        return during_check(p, i);
+    }
+};
+
+// ------------------------------------------------------------------ //
+
+template <typename DistancePredicates, typename Traversal>
+struct predicate_check<predicates::nearest<DistancePredicates, Traversal>, value_tag>
 {
     template <typename Value, typename Box, typename Strategy>
-    static inline bool apply(predicates::nearest<DistancePredicates> const&, Value const&, Box const&, Strategy const&)
+    static inline bool apply(predicates::nearest<DistancePredicates, Traversal> const&, Value const&, Box const&, Strategy const&)
     {
         return true;
     }
@@ -491,11 +767,23 @@ struct predicate_check<predicates::spatial_predicate<Geometry, predicates::touch
 
 // ------------------------------------------------------------------ //
 
-template <typename DistancePredicates>
-struct predicate_check<predicates::nearest<DistancePredicates>, bounds_tag>
+template <typename T, std::size_t Dimension>
+struct predicate_check<predicates::during<T, Dimension>, bounds_tag>
+{
+    template <typename Value, typename Box, typename Strategy>
+    static inline bool apply(predicates::during<T, Dimension> const& p, Value const&, Box const& b, Strategy const&)
+    {
+        return during_check(p, b);
+    }
+};
+
+// ------------------------------------------------------------------ //
+
+template <typename DistancePredicates, typename Traversal>
+struct predicate_check<predicates::nearest<DistancePredicates, Traversal>, bounds_tag>
 {
     template <typename Value, typename Box, typename Strategy>
-    static inline bool apply(predicates::nearest<DistancePredicates> const&, Value const&, Box const&, Strategy const&)
+    static inline bool apply(predicates::nearest<DistancePredicates, Traversal> const&, Value const&, Box const&, Strategy const&)
     {
         return true;
     }
@@ -750,8 +1038,8 @@ struct predicates_is_distance
     static const unsigned value = 0;
 };
 
-template <typename DistancePredicates>
-struct predicates_is_distance< predicates::nearest<DistancePredicates> >
+template <typename DistancePredicates, typename Traversal>
+struct predicates_is_distance< predicates::nearest<DistancePredicates, Traversal> >
 {
     static const unsigned value = 1;
 };
@@ -862,6 +1150,20 @@ struct predicates_find_distance< boost::tuples::cons<Head, Tail> >
     >::value;
 };
 
+// predicates_distance_traversal
+
+template <typename P>
+struct predicates_distance_traversal
+{
+    typedef predicates::depth_first_tag type;
+};
+
+template <typename DistancePredicates, typename Traversal>
+struct predicates_distance_traversal< predicates::nearest<DistancePredicates, Traversal> >
+{
+    typedef Traversal type;
+};
+
 }}}} // namespace boost::geometry::index::detail
 
 #endif // BOOST_GEOMETRY_INDEX_DETAIL_PREDICATES_HPP
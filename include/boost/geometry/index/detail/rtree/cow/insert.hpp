@@ -0,0 +1,219 @@
+// Boost.Geometry Index
+//
+// R-tree copy-on-write inserting visitor implementation
+//
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_COW_INSERT_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_COW_INSERT_HPP
+
+#include <limits>
+
+#include <boost/geometry/index/detail/rtree/visitors/insert.hpp>
+
+namespace boost { namespace geometry { namespace index {
+
+namespace detail { namespace rtree { namespace cow {
+
+namespace detail {
+
+// The default insert algorithm copying the nodes shared with the published versions
+// on the path from the root to the modified node. The root must already be private.
+// The forced reinsertions of the R*-tree aren't performed because they'd modify
+// the nodes outside of this path.
+template <typename Element, typename MembersHolder, typename NodesCopier>
+class insert
+    : public rtree::visitors::detail::insert<Element, MembersHolder>
+{
+protected:
+    typedef rtree::visitors::detail::insert<Element, MembersHolder> base;
+
+    typedef typename base::parameters_type parameters_type;
+    typedef typename base::translator_type translator_type;
+    typedef typename base::allocators_type allocators_type;
+
+    typedef typename base::internal_node internal_node;
+
+    typedef typename base::node_pointer node_pointer;
+    typedef typename base::size_type size_type;
+
+    inline insert(node_pointer & root,
+                  size_type & leafs_level,
+                  Element const& element,
+                  parameters_type const& parameters,
+                  translator_type const& translator,
+                  allocators_type & allocators,
+                  NodesCopier & copier,
+                  size_type relative_level = 0)
+        : base(root, leafs_level, element, parameters, translator, allocators, relative_level)
+        , m_copier(copier)
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(m_copier.is_private(root), "the root must be private");
+    }
+
+    template <typename Visitor>
+    inline void traverse(Visitor & visitor, internal_node & n)
+    {
+        // choose next node
+        size_t choosen_node_index = rtree::choose_next_node<MembersHolder>
+            ::apply(n, rtree::element_indexable(base::m_element, base::m_translator),
+                    base::m_parameters,
+                    base::m_leafs_level - base::m_traverse_data.current_level);
+
+        // copy the next node before it's modified
+        bool const next_is_leaf = base::m_traverse_data.current_level + 1 == base::m_leafs_level;
+        m_copier.make_private(rtree::elements(n)[choosen_node_index].second, next_is_leaf);          // MAY THROW, STRONG (V, E: alloc, copy, N: alloc)
+
+        // expand the node to contain value
+        index::detail::expand(
+            rtree::elements(n)[choosen_node_index].first,
+            base::m_element_bounds,
+            index::detail::get_strategy(base::m_parameters));
+
+        // next traversing step
+        base::traverse_apply_visitor(visitor, n, choosen_node_index);                               // MAY THROW (V, E: alloc, copy, N:alloc)
+    }
+
+    template <typename Node>
+    inline void post_traverse(Node & n)
+    {
+        node_pointer const root = base::m_root_node;
+        bool const is_root = base::m_traverse_data.current_is_root();
+        size_t const parent_size = is_root ? 0 : base::m_traverse_data.parent_elements().size();
+
+        base::post_traverse(n);                                                                     // MAY THROW (V, E: alloc, copy, N: alloc)
+
+        // the nodes created by the split are private
+        if ( base::m_root_node != root )
+        {
+            m_copier.add_private(base::m_root_node);                                                // MAY THROW (alloc)
+            m_copier.add_private(rtree::elements(rtree::get<internal_node>(*base::m_root_node)).back().second); // MAY THROW (alloc)
+        }
+        else if ( ! is_root && parent_size < base::m_traverse_data.parent_elements().size() )
+        {
+            m_copier.add_private(base::m_traverse_data.parent_elements().back().second);            // MAY THROW (alloc)
+        }
+    }
+
+    NodesCopier & m_copier;
+};
+
+} // namespace detail
+
+// Copy-on-write insert visitor used for nodes elements
+template <typename Element, typename MembersHolder, typename NodesCopier>
+class insert
+    : public detail::insert<Element, MembersHolder, NodesCopier>
+{
+public:
+    typedef detail::insert<Element, MembersHolder, NodesCopier> base;
+
+    typedef typename base::parameters_type parameters_type;
+    typedef typename base::translator_type translator_type;
+    typedef typename base::allocators_type allocators_type;
+
+    typedef typename base::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+
+    typedef typename base::node_pointer node_pointer;
+    typedef typename base::size_type size_type;
+
+    inline insert(node_pointer & root,
+                  size_type & leafs_level,
+                  Element const& element,
+                  parameters_type const& parameters,
+                  translator_type const& translator,
+                  allocators_type & allocators,
+                  NodesCopier & copier,
+                  size_type relative_level = 0)
+        : base(root, leafs_level, element, parameters, translator, allocators, copier, relative_level)
+    {}
+
+    inline void operator()(internal_node & n)
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(base::m_traverse_data.current_level < base::m_leafs_level, "unexpected level");
+
+        if ( base::m_traverse_data.current_level < base::m_level )
+        {
+            // next traversing step
+            base::traverse(*this, n);                                                               // MAY THROW (E: alloc, copy, N: alloc)
+        }
+        else
+        {
+            BOOST_GEOMETRY_INDEX_ASSERT(base::m_level == base::m_traverse_data.current_level, "unexpected level");
+
+            // push new child node, the subtree may be shared so it's not destroyed if this throws
+            rtree::elements(n).push_back(base::m_element);                                          // MAY THROW, STRONG (E: alloc, copy)
+        }
+
+        base::post_traverse(n);                                                                     // MAY THROW (E: alloc, copy, N: alloc)
+    }
+
+    inline void operator()(leaf &)
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(false, "this visitor can't be used for a leaf");
+    }
+};
+
+// Copy-on-write insert visitor specialized for Values elements
+template <typename MembersHolder, typename NodesCopier>
+class insert<typename MembersHolder::value_type, MembersHolder, NodesCopier>
+    : public detail::insert<typename MembersHolder::value_type, MembersHolder, NodesCopier>
+{
+public:
+    typedef detail::insert<typename MembersHolder::value_type, MembersHolder, NodesCopier> base;
+
+    typedef typename MembersHolder::value_type value_type;
+    typedef typename base::parameters_type parameters_type;
+    typedef typename base::translator_type translator_type;
+    typedef typename base::allocators_type allocators_type;
+
+    typedef typename base::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+
+    typedef typename base::node_pointer node_pointer;
+    typedef typename base::size_type size_type;
+
+    inline insert(node_pointer & root,
+                  size_type & leafs_level,
+                  value_type const& value,
+                  parameters_type const& parameters,
+                  translator_type const& translator,
+                  allocators_type & allocators,
+                  NodesCopier & copier,
+                  size_type relative_level = 0)
+        : base(root, leafs_level, value, parameters, translator, allocators, copier, relative_level)
+    {}
+
+    inline void operator()(internal_node & n)
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(base::m_traverse_data.current_level < base::m_leafs_level, "unexpected level");
+        BOOST_GEOMETRY_INDEX_ASSERT(base::m_traverse_data.current_level < base::m_level, "unexpected level");
+
+        // next traversing step
+        base::traverse(*this, n);                                                                   // MAY THROW (V, E: alloc, copy, N: alloc)
+
+        base::post_traverse(n);                                                                     // MAY THROW (E: alloc, copy, N: alloc)
+    }
+
+    inline void operator()(leaf & n)
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(base::m_traverse_data.current_level == base::m_leafs_level, "unexpected level");
+        BOOST_GEOMETRY_INDEX_ASSERT(base::m_level == base::m_traverse_data.current_level ||
+                                    base::m_level == (std::numeric_limits<size_t>::max)(), "unexpected level");
+
+        rtree::elements(n).push_back(base::m_element);                                              // MAY THROW, STRONG (V: alloc, copy)
+
+        base::post_traverse(n);                                                                     // MAY THROW (V: alloc, copy, N: alloc)
+    }
+};
+
+}}} // namespace detail::rtree::cow
+
+}}} // namespace boost::geometry::index
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_RTREE_COW_INSERT_HPP
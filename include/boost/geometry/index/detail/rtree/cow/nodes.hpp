@@ -0,0 +1,210 @@
+// Boost.Geometry Index
+//
+// R-tree nodes shared by the versions of the copy-on-write rtree
+//
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_COW_NODES_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_COW_NODES_HPP
+
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <boost/core/addressof.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+#include <boost/geometry/index/detail/rtree/node/node.hpp>
+#include <boost/geometry/index/detail/rtree/private_view.hpp>
+#include <boost/geometry/index/detail/rtree/visitors/destroy.hpp>
+
+namespace boost { namespace geometry { namespace index {
+
+namespace detail { namespace rtree { namespace cow {
+
+// The nodes of a version of the tree which aren't a part of the next version.
+// The objects are chained from the oldest to the newest version and each version
+// holds the object of its own. So the nodes are destroyed when all versions up to
+// the one which retired them are released, regardless of the order of releasing.
+// The nodes are destroyed shallowly, their children are still used by the next versions.
+// The Rtree is the object storing the allocators, it's kept alive as long as the nodes.
+template <typename Rtree, typename MembersHolder>
+class retired_nodes
+{
+    typedef typename MembersHolder::allocators_type allocators_type;
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+    typedef typename allocators_type::node_pointer node_pointer;
+
+    retired_nodes(retired_nodes const&);
+    retired_nodes & operator=(retired_nodes const&);
+
+public:
+    explicit retired_nodes(boost::shared_ptr<Rtree> const& rtree)
+        : m_rtree(rtree)
+        , m_root(0)
+    {}
+
+    ~retired_nodes()
+    {
+        allocators_type & allocators = private_view<Rtree>(*m_rtree).members().allocators();
+
+        for ( typename nodes_type::iterator it = m_nodes.begin() ; it != m_nodes.end() ; ++it )
+        {
+            if ( it->second )
+                rtree::destroy_node<allocators_type, leaf>::apply(allocators, it->first);
+            else
+                rtree::destroy_node<allocators_type, internal_node>::apply(allocators, it->first);
+        }
+
+        if ( m_root )
+            rtree::visitors::destroy<MembersHolder>::apply(m_root, allocators);
+
+        // release the chain iteratively to not recurse for each released version
+        boost::shared_ptr<retired_nodes> next;
+        next.swap(m_next);
+        while ( next && next.unique() )
+        {
+            boost::shared_ptr<retired_nodes> next_next;
+            next_next.swap(next->m_next);
+            next.swap(next_next);
+        }
+    }
+
+    void push_back(node_pointer n, bool is_leaf)
+    {
+        m_nodes.push_back(std::make_pair(n, is_leaf));                                              // MAY THROW (alloc)
+    }
+
+    // The nodes retired by the next version are destroyed after these ones
+    void set_next(boost::shared_ptr<retired_nodes> const& next)
+    {
+        m_next = next;
+    }
+
+    // The whole tree of the last version, destroyed together with the retired nodes
+    void set_root(node_pointer root)
+    {
+        m_root = root;
+    }
+
+private:
+    typedef std::vector<std::pair<node_pointer, bool> > nodes_type;
+
+    boost::shared_ptr<Rtree> m_rtree;
+    nodes_type m_nodes;
+    node_pointer m_root;
+    boost::shared_ptr<retired_nodes> m_next;
+};
+
+// Copies the nodes shared with the published versions before they're modified.
+// The nodes created after the last version was published are private and are
+// modified in place. The copied nodes are passed to the retired nodes.
+template <typename Rtree, typename MembersHolder>
+class nodes_copier
+{
+    typedef typename MembersHolder::allocators_type allocators_type;
+    typedef typename MembersHolder::node node;
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+    typedef typename allocators_type::node_pointer node_pointer;
+
+    typedef rtree::subtree_destroyer<MembersHolder> subtree_destroyer;
+
+public:
+    typedef retired_nodes<Rtree, MembersHolder> retired_nodes_type;
+
+    nodes_copier(allocators_type & allocators)
+        : m_allocators(allocators)
+    {}
+
+    void reset(boost::shared_ptr<retired_nodes_type> const& retired)
+    {
+        m_retired = retired;
+        m_private.clear();
+    }
+
+    bool is_private(node_pointer n) const
+    {
+        return m_private.find(boost::addressof(*n)) != m_private.end();
+    }
+
+    // Registers the node created while modifying the tree
+    void add_private(node_pointer n)
+    {
+        m_private.insert(boost::addressof(*n));                                                     // MAY THROW (alloc)
+    }
+
+    // Replaces the pointer to a shared node with the pointer to its copy
+    template <typename Node>
+    void make_private(node_pointer & n)
+    {
+        if ( is_private(n) )
+            return;
+
+        subtree_destroyer new_node(rtree::create_node<allocators_type, Node>::apply(m_allocators), m_allocators); // MAY THROW, STRONG (N: alloc)
+
+        typedef typename rtree::elements_type<Node>::type elements_type;
+        elements_type const& elements = rtree::elements(rtree::get<Node>(*n));
+        elements_type & elements_dst = rtree::elements(rtree::get<Node>(*new_node));
+
+        BOOST_TRY
+        {
+            for ( typename elements_type::const_iterator it = elements.begin() ; it != elements.end() ; ++it )
+                elements_dst.push_back(*it);                                                        // MAY THROW, STRONG (V, E: alloc, copy)
+
+            add_private(new_node.get());                                                            // MAY THROW (alloc)
+            m_retired->push_back(n, boost::is_same<Node, leaf>::value);                             // MAY THROW (alloc)
+        }
+        BOOST_CATCH(...)
+        {
+            // the children are owned by the shared node
+            elements_dst.clear();
+            m_private.erase(boost::addressof(*new_node.get()));
+            BOOST_RETHROW                                                                           // RETHROW
+        }
+        BOOST_CATCH_END
+
+        n = new_node.get();
+        new_node.release();
+    }
+
+    void make_private(node_pointer & n, bool is_leaf)
+    {
+        if ( is_leaf )
+            make_private<leaf>(n);
+        else
+            make_private<internal_node>(n);
+    }
+
+    // Destroys the node removed from the tree, the private one is destroyed immediately
+    template <typename Node>
+    void destroy(node_pointer n)
+    {
+        if ( is_private(n) )
+        {
+            m_private.erase(boost::addressof(*n));
+            rtree::destroy_node<allocators_type, Node>::apply(m_allocators, n);
+        }
+        else
+        {
+            m_retired->push_back(n, boost::is_same<Node, leaf>::value);                             // MAY THROW (alloc)
+        }
+    }
+
+private:
+    allocators_type & m_allocators;
+    boost::shared_ptr<retired_nodes_type> m_retired;
+    std::set<node const*> m_private;
+};
+
+}}} // namespace detail::rtree::cow
+
+}}} // namespace boost::geometry::index
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_RTREE_COW_NODES_HPP
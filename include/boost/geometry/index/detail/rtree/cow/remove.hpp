@@ -0,0 +1,225 @@
+// Boost.Geometry Index
+//
+// R-tree copy-on-write removing algorithm implementation
+//
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_COW_REMOVE_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_COW_REMOVE_HPP
+
+#include <utility>
+#include <vector>
+
+#include <boost/geometry/algorithms/detail/covered_by/interface.hpp>
+
+#include <boost/geometry/index/detail/rtree/cow/insert.hpp>
+
+namespace boost { namespace geometry { namespace index {
+
+namespace detail { namespace rtree { namespace cow {
+
+// The default remove algorithm copying the nodes shared with the published versions.
+// In contrast to the remove visitor the path to the value is found first without
+// modifying the tree. Then the nodes on this path are copied and the value is removed.
+// The elements of the underflowed nodes are reinserted with the copy-on-write insert visitor.
+template <typename MembersHolder, typename NodesCopier>
+class remove
+{
+    typedef typename MembersHolder::box_type box_type;
+    typedef typename MembersHolder::value_type value_type;
+    typedef typename MembersHolder::parameters_type parameters_type;
+    typedef typename MembersHolder::translator_type translator_type;
+    typedef typename MembersHolder::allocators_type allocators_type;
+
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+
+    typedef typename allocators_type::node_pointer node_pointer;
+    typedef typename allocators_type::size_type size_type;
+
+    typedef typename rtree::elements_type<internal_node>::type internal_elements;
+    typedef typename rtree::elements_type<leaf>::type leaf_elements;
+
+public:
+    inline remove(node_pointer & root,
+                  size_type & leafs_level,
+                  value_type const& value,
+                  parameters_type const& parameters,
+                  translator_type const& translator,
+                  allocators_type & allocators,
+                  NodesCopier & copier)
+        : m_value(value)
+        , m_parameters(parameters)
+        , m_translator(translator)
+        , m_allocators(allocators)
+        , m_copier(copier)
+        , m_root_node(root)
+        , m_leafs_level(leafs_level)
+        , m_value_index(0)
+    {}
+
+    // Returns true if the value was found and removed
+    inline bool apply()
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(m_root_node, "The root must exist");
+
+        if ( ! find(m_root_node, 0) )
+            return false;
+
+        // copy the nodes on the path, the nodes are not modified before all of them are copied
+        std::vector<internal_node*> parents;
+        parents.reserve(m_leafs_level);                                                             // MAY THROW (alloc)
+
+        m_copier.make_private(m_root_node, 0 == m_leafs_level);                                     // MAY THROW, STRONG (V, E: alloc, copy, N: alloc)
+        node_pointer n = m_root_node;
+        for ( size_type level = 0 ; level < m_leafs_level ; ++level )
+        {
+            internal_node & in = rtree::get<internal_node>(*n);
+            node_pointer & child = rtree::elements(in)[m_path[level]].second;
+            m_copier.make_private(child, level + 1 == m_leafs_level);                               // MAY THROW, STRONG (V, E: alloc, copy, N: alloc)
+            parents.push_back(boost::addressof(in));
+            n = child;
+        }
+
+        // remove the value
+        leaf_elements & values = rtree::elements(rtree::get<leaf>(*n));
+        rtree::move_from_back(values, values.begin() + m_value_index);                             // MAY THROW (V: copy)
+        values.pop_back();
+
+        // adjust the boxes and remove the underflowed nodes
+        std::vector< std::pair<size_type, node_pointer> > underflowed_nodes;
+        bool is_underflow = values.size() < m_parameters.get_min_elements();
+        for ( size_type level = m_leafs_level ; 0 < level ; --level )
+        {
+            internal_elements & elements = rtree::elements(*parents[level - 1]);
+            typename internal_elements::iterator it = elements.begin() + m_path[level - 1];
+
+            if ( is_underflow )
+            {
+                // store node's relative level, the leafs have level 1
+                underflowed_nodes.push_back(std::make_pair(m_leafs_level - level + 1, it->second)); // MAY THROW (alloc)
+                rtree::move_from_back(elements, it);                                                // MAY THROW (E: copy)
+                elements.pop_back();
+            }
+            else if ( level == m_leafs_level )
+            {
+                it->first = rtree::values_box<box_type>(values.begin(), values.end(), m_translator,
+                                                        index::detail::get_strategy(m_parameters));
+            }
+            else
+            {
+                internal_elements const& child_elements = rtree::elements(*parents[level]);
+                it->first = rtree::elements_box<box_type>(child_elements.begin(), child_elements.end(), m_translator,
+                                                          index::detail::get_strategy(m_parameters));
+            }
+
+            is_underflow = elements.size() < m_parameters.get_min_elements();
+        }
+
+        // reinsert the elements of the underflowed nodes, begin with levels closer to the root
+        for ( typename std::vector< std::pair<size_type, node_pointer> >::reverse_iterator
+                it = underflowed_nodes.rbegin() ; it != underflowed_nodes.rend() ; ++it )
+        {
+            if ( it->first == 1 )
+            {
+                reinsert_node_elements(rtree::get<leaf>(*it->second), it->first);                   // MAY THROW (V, E: alloc, copy, N: alloc)
+                m_copier.template destroy<leaf>(it->second);
+            }
+            else
+            {
+                reinsert_node_elements(rtree::get<internal_node>(*it->second), it->first);          // MAY THROW (V, E: alloc, copy, N: alloc)
+                m_copier.template destroy<internal_node>(it->second);
+            }
+        }
+
+        // shorten the tree
+        if ( 0 < m_leafs_level
+          && rtree::elements(rtree::get<internal_node>(*m_root_node)).size() <= 1 )
+        {
+            internal_elements & elements = rtree::elements(rtree::get<internal_node>(*m_root_node));
+            node_pointer root_to_destroy = m_root_node;
+            m_root_node = elements.empty() ? node_pointer(0) : elements[0].second;
+            --m_leafs_level;
+
+            m_copier.template destroy<internal_node>(root_to_destroy);
+        }
+
+        return true;
+    }
+
+private:
+    // Finds the path to the value in the same order as the remove visitor
+    bool find(node_pointer n, size_type level)
+    {
+        if ( level == m_leafs_level )
+        {
+            leaf_elements const& values = rtree::elements(rtree::get<leaf>(*n));
+            for ( typename leaf_elements::size_type i = 0 ; i < values.size() ; ++i )
+            {
+                if ( m_translator.equals(values[i], m_value, index::detail::get_strategy(m_parameters)) )
+                {
+                    m_value_index = i;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        internal_elements const& children = rtree::elements(rtree::get<internal_node>(*n));
+        for ( typename internal_elements::size_type i = 0 ; i < children.size() ; ++i )
+        {
+            if ( index::detail::covered_by_bounds(m_translator(m_value),
+                                                  children[i].first,
+                                                  index::detail::get_strategy(m_parameters)) )
+            {
+                m_path.push_back(i);                                                                // MAY THROW (alloc)
+                if ( find(children[i].second, level + 1) )
+                    return true;
+                m_path.pop_back();
+            }
+        }
+        return false;
+    }
+
+    template <typename Node>
+    void reinsert_node_elements(Node & n, size_type node_relative_level)
+    {
+        typedef typename rtree::elements_type<Node>::type elements_type;
+        elements_type & elements = rtree::elements(n);
+
+        for ( typename elements_type::iterator it = elements.begin() ; it != elements.end() ; ++it )
+        {
+            cow::insert<typename elements_type::value_type, MembersHolder, NodesCopier>
+                insert_v(m_root_node, m_leafs_level, *it,
+                         m_parameters, m_translator, m_allocators, m_copier,
+                         node_relative_level - 1);
+
+            rtree::apply_visitor(insert_v, *m_root_node);                                           // MAY THROW (V, E: alloc, copy, N: alloc)
+        }
+
+        // the children are owned by other nodes now
+        elements.clear();
+    }
+
+    value_type const& m_value;
+    parameters_type const& m_parameters;
+    translator_type const& m_translator;
+    allocators_type & m_allocators;
+    NodesCopier & m_copier;
+
+    node_pointer & m_root_node;
+    size_type & m_leafs_level;
+
+    std::vector<size_type> m_path;
+    size_type m_value_index;
+};
+
+}}} // namespace detail::rtree::cow
+
+}}} // namespace boost::geometry::index
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_RTREE_COW_REMOVE_HPP
@@ -0,0 +1,671 @@
+// Boost.Geometry Index
+//
+// R-tree flat, offset-based layout
+//
+// Copyright (c) 2011-2014 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_FLAT_LAYOUT_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_FLAT_LAYOUT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <limits>
+#include <vector>
+
+#include <boost/core/addressof.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+#include <boost/math/special_functions/next.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+
+#include <boost/geometry/core/access.hpp>
+#include <boost/geometry/core/coordinate_dimension.hpp>
+#include <boost/geometry/core/coordinate_type.hpp>
+
+#include <boost/geometry/index/detail/exception.hpp>
+
+namespace boost { namespace geometry { namespace index { namespace detail { namespace rtree { namespace flat {
+
+// The flat layout of the rtree. The nodes are stored one after another
+// in breadth-first order so the upper levels are at the beginning of the file.
+// A node is referenced by the offset of its header from the beginning of the file.
+//
+// file:          file_header, padding, nodes...
+// internal node: node_header, [origin[dimension], scale[dimension],]
+//                min coordinates of the children for each dimension,
+//                max coordinates of the children for each dimension, uint64 offsets[count]
+// leaf:          node_header, padding, Value[count], padding
+//
+// The coordinates of the children are stored in structure-of-arrays form, each array
+// starts at the cache line boundary (relative to the beginning of the file) and is padded
+// to the multiple of the cache line size. So the boxes of all children may be tested
+// in one pass over contiguous arrays, one dimension at a time.
+//
+// If the boxes of the children are quantized (child_box_bits is 8 or 16) the coordinates
+// are stored as unsigned integers of this size relative to the origin and scale of
+// the node, coordinate = origin + code * scale. The first array starts at the cache line
+// boundary but the arrays are padded only to the alignment. The codes are rounded outward so the
+// decoded box always contains the original box and the queries find the same values,
+// only more nodes may be traversed. The Values in the leafs are stored unchanged.
+//
+// The data is stored in the native byte order and with the native representation
+// of the Box and Value so a file can only be read on the same kind of platform.
+
+static const boost::uint32_t layout_version = 2;
+static const boost::uint32_t layout_byte_order = 0x01020304;
+static const std::size_t layout_cache_line_size = 64;
+
+inline char const* layout_magic()
+{
+    return "BGIRTREE";
+}
+
+struct file_header
+{
+    char magic[8];
+    boost::uint32_t version;
+    boost::uint32_t byte_order;
+    boost::uint32_t dimension;
+    boost::uint32_t coordinate_size;
+    boost::uint32_t box_size;
+    boost::uint32_t value_size;
+    boost::uint32_t child_box_bits; // 0 - not quantized, 8 or 16
+    boost::uint32_t reserved;
+    boost::uint64_t size;       // the number of values
+    boost::uint64_t depth;      // the level of the leafs
+    boost::uint64_t root;       // the offset of the root, 0 if the tree is empty
+    boost::uint64_t file_size;
+};
+
+struct node_header
+{
+    boost::uint32_t is_leaf;
+    boost::uint32_t count;
+};
+
+template <typename Box,
+          std::size_t I = 0,
+          std::size_t D = geometry::dimension<Box>::value>
+struct box_from_coords
+{
+    typedef typename geometry::coordinate_type<Box>::type coordinate_type;
+
+    template <typename Layout>
+    static inline void apply(char const* data, boost::uint64_t offset, std::size_t count, std::size_t i, Box & b)
+    {
+        geometry::set<min_corner, I>(b, Layout::min_coords(data, offset, count, I)[i]);
+        geometry::set<max_corner, I>(b, Layout::max_coords(data, offset, count, I)[i]);
+        box_from_coords<Box, I + 1, D>::template apply<Layout>(data, offset, count, i, b);
+    }
+};
+
+template <typename Box, std::size_t D>
+struct box_from_coords<Box, D, D>
+{
+    template <typename Layout>
+    static inline void apply(char const*, boost::uint64_t, std::size_t, std::size_t, Box &)
+    {}
+};
+
+template <typename Box,
+          std::size_t I = 0,
+          std::size_t D = geometry::dimension<Box>::value>
+struct box_from_codes
+{
+    typedef typename geometry::coordinate_type<Box>::type coordinate_type;
+
+    template <typename Layout, typename Code>
+    static inline void apply(char const* data, boost::uint64_t offset, std::size_t count, std::size_t i, Box & b)
+    {
+        coordinate_type const origin = Layout::quantization_origin(data, offset)[I];
+        coordinate_type const scale = Layout::quantization_scale(data, offset)[I];
+        geometry::set<min_corner, I>(b, Layout::decode(origin, scale, Layout::template min_codes<Code>(data, offset, count, I)[i]));
+        geometry::set<max_corner, I>(b, Layout::decode(origin, scale, Layout::template max_codes<Code>(data, offset, count, I)[i]));
+        box_from_codes<Box, I + 1, D>::template apply<Layout, Code>(data, offset, count, i, b);
+    }
+};
+
+template <typename Box, std::size_t D>
+struct box_from_codes<Box, D, D>
+{
+    template <typename Layout, typename Code>
+    static inline void apply(char const*, boost::uint64_t, std::size_t, std::size_t, Box &)
+    {}
+};
+
+// Copies the coordinates of the box into the arrays of the coordinates of all dimensions
+template <typename Box,
+          std::size_t I = 0,
+          std::size_t D = geometry::dimension<Box>::value>
+struct box_to_coords
+{
+    template <typename T>
+    static inline void apply(Box const& b, T * mins, T * maxs)
+    {
+        mins[I] = static_cast<T>(geometry::get<min_corner, I>(b));
+        maxs[I] = static_cast<T>(geometry::get<max_corner, I>(b));
+        box_to_coords<Box, I + 1, D>::apply(b, mins, maxs);
+    }
+};
+
+template <typename Box, std::size_t D>
+struct box_to_coords<Box, D, D>
+{
+    template <typename T>
+    static inline void apply(Box const&, T *, T *)
+    {}
+};
+
+template <typename Value, typename Box>
+struct layout
+{
+    typedef boost::uint64_t offset_type;
+    typedef typename geometry::coordinate_type<Box>::type coordinate_type;
+
+    static const std::size_t dimension = geometry::dimension<Box>::value;
+
+    static const std::size_t coordinate_alignment = boost::alignment_of<coordinate_type>::value;
+    static const std::size_t value_alignment = boost::alignment_of<Value>::value;
+    static const std::size_t elements_alignment = coordinate_alignment < value_alignment ? value_alignment : coordinate_alignment;
+
+    // the offsets are 8-byte so everything is aligned at least to 8 bytes
+    static const std::size_t alignment = elements_alignment < 8 ? 8 : elements_alignment;
+
+    static const std::size_t coords_alignment = alignment < layout_cache_line_size ? layout_cache_line_size : alignment;
+
+    static inline std::size_t align(std::size_t s, std::size_t a = alignment)
+    {
+        return (s + a - 1) / a * a;
+    }
+
+    static inline std::size_t root_offset()
+    {
+        return align(sizeof(file_header));
+    }
+
+    static inline std::size_t header_size()
+    {
+        return align(sizeof(node_header));
+    }
+
+    static inline bool is_valid_child_box_bits(unsigned bits)
+    {
+        return bits == 0 || bits == 8 || bits == 16;
+    }
+
+    static inline unsigned child_box_bits(char const* data)
+    {
+        return reinterpret_cast<file_header const*>(data)->child_box_bits;
+    }
+
+    // The size of the part of the internal node preceding the coordinates
+    static inline std::size_t prefix_size(unsigned bits)
+    {
+        return header_size() + (bits == 0 ? 0 : align(2 * dimension * sizeof(coordinate_type)));
+    }
+
+    // The arrays of the codes aren't padded to the cache line size so the codes
+    // of all children of a node may fit into a few cache lines
+    static inline std::size_t coords_size(std::size_t count, unsigned bits)
+    {
+        return bits == 0
+             ? align(count * sizeof(coordinate_type), coords_alignment)
+             : align(count * (bits / 8));
+    }
+
+    // The offset of the internal node written at position pos or further,
+    // the header is placed so the coordinates start at the cache line boundary
+    static inline std::size_t internal_node_offset(std::size_t pos, unsigned bits)
+    {
+        return align(pos + prefix_size(bits), coords_alignment) - prefix_size(bits);
+    }
+
+    static inline std::size_t leaf_offset(std::size_t pos)
+    {
+        return align(pos);
+    }
+
+    static inline std::size_t internal_node_size(std::size_t count, unsigned bits)
+    {
+        return prefix_size(bits) + 2 * dimension * coords_size(count, bits) + align(count * sizeof(offset_type));
+    }
+
+    static inline std::size_t leaf_size(std::size_t count)
+    {
+        return header_size() + align(count * sizeof(Value));
+    }
+
+    static inline node_header const& header(char const* data, offset_type offset)
+    {
+        return *reinterpret_cast<node_header const*>(data + offset);
+    }
+
+    // The k-th array of coordinates, the min coordinates are followed by the max coordinates
+    static inline char const* coords_array(char const* data, offset_type offset, std::size_t count,
+                                           unsigned bits, std::size_t k)
+    {
+        return data + offset + prefix_size(bits) + k * coords_size(count, bits);
+    }
+
+    // The coordinates of the children if the boxes aren't quantized
+    static inline coordinate_type const* min_coords(char const* data, offset_type offset, std::size_t count, std::size_t d)
+    {
+        return reinterpret_cast<coordinate_type const*>(coords_array(data, offset, count, 0, d));
+    }
+
+    static inline coordinate_type const* max_coords(char const* data, offset_type offset, std::size_t count, std::size_t d)
+    {
+        return reinterpret_cast<coordinate_type const*>(coords_array(data, offset, count, 0, dimension + d));
+    }
+
+    // The codes of the coordinates of the children if the boxes are quantized
+    template <typename Code>
+    static inline Code const* min_codes(char const* data, offset_type offset, std::size_t count, std::size_t d)
+    {
+        return reinterpret_cast<Code const*>(coords_array(data, offset, count, sizeof(Code) * 8, d));
+    }
+
+    template <typename Code>
+    static inline Code const* max_codes(char const* data, offset_type offset, std::size_t count, std::size_t d)
+    {
+        return reinterpret_cast<Code const*>(coords_array(data, offset, count, sizeof(Code) * 8, dimension + d));
+    }
+
+    static inline coordinate_type const* quantization_origin(char const* data, offset_type offset)
+    {
+        return reinterpret_cast<coordinate_type const*>(data + offset + header_size());
+    }
+
+    static inline coordinate_type const* quantization_scale(char const* data, offset_type offset)
+    {
+        return quantization_origin(data, offset) + dimension;
+    }
+
+    template <typename Code>
+    static inline coordinate_type decode(coordinate_type origin, coordinate_type scale, Code code)
+    {
+        return origin + static_cast<coordinate_type>(code) * scale;
+    }
+
+    // The scale for which the greatest code is decoded as the coordinate greater or equal to hi
+    template <typename Code>
+    static inline coordinate_type compute_scale(coordinate_type lo, coordinate_type hi)
+    {
+        static const Code max_code = (std::numeric_limits<Code>::max)();
+
+        if ( !(lo < hi) )
+            return 0;
+
+        coordinate_type scale = (hi - lo) / static_cast<coordinate_type>(max_code);
+        if ( !boost::math::isfinite(lo) || !boost::math::isfinite(scale) )
+            throw_invalid_argument("boost::geometry::index::write_mapped: the boxes can't be quantized");
+
+        while ( decode(lo, scale, max_code) < hi )
+            scale = boost::math::float_next(scale);
+        return scale;
+    }
+
+    // The greatest code decoded as the coordinate lesser or equal to v
+    template <typename Code>
+    static inline Code encode_min(coordinate_type origin, coordinate_type scale, coordinate_type v)
+    {
+        static const Code max_code = (std::numeric_limits<Code>::max)();
+
+        if ( scale == 0 )
+            return 0;
+
+        coordinate_type const q = std::floor((v - origin) / scale);
+        Code c = q <= 0 ? 0 : q >= max_code ? max_code : static_cast<Code>(q);
+        while ( c > 0 && decode(origin, scale, c) > v )
+            --c;
+        return c;
+    }
+
+    // The smallest code decoded as the coordinate greater or equal to v
+    template <typename Code>
+    static inline Code encode_max(coordinate_type origin, coordinate_type scale, coordinate_type v)
+    {
+        static const Code max_code = (std::numeric_limits<Code>::max)();
+
+        if ( scale == 0 )
+            return 0;
+
+        coordinate_type const q = std::ceil((v - origin) / scale);
+        Code c = q <= 0 ? 0 : q >= max_code ? max_code : static_cast<Code>(q);
+        while ( c < max_code && decode(origin, scale, c) < v )
+            ++c;
+        return c;
+    }
+
+    static inline offset_type const* children(char const* data, offset_type offset, std::size_t count)
+    {
+        return reinterpret_cast<offset_type const*>(coords_array(data, offset, count, child_box_bits(data),
+                                                                 2 * dimension));
+    }
+
+    // Reconstructs the box of the i-th child
+    static inline void box(char const* data, offset_type offset, std::size_t count, std::size_t i, Box & b)
+    {
+        switch ( child_box_bits(data) )
+        {
+        case 8:
+            box_from_codes<Box>::template apply<layout, boost::uint8_t>(data, offset, count, i, b);
+            break;
+        case 16:
+            box_from_codes<Box>::template apply<layout, boost::uint16_t>(data, offset, count, i, b);
+            break;
+        default:
+            box_from_coords<Box>::template apply<layout>(data, offset, count, i, b);
+            break;
+        }
+    }
+
+    static inline Value const* values(char const* data, offset_type offset)
+    {
+        return reinterpret_cast<Value const*>(data + offset + header_size());
+    }
+
+    static inline void init_header(file_header & h, std::size_t size, std::size_t depth,
+                                   std::size_t root, std::size_t file_size, unsigned bits)
+    {
+        typedef typename geometry::coordinate_type<Box>::type coordinate_type;
+
+        std::memset(&h, 0, sizeof(file_header));
+        std::memcpy(h.magic, layout_magic(), sizeof(h.magic));
+        h.version = layout_version;
+        h.byte_order = layout_byte_order;
+        h.dimension = geometry::dimension<Box>::value;
+        h.coordinate_size = sizeof(coordinate_type);
+        h.box_size = 2 * dimension * sizeof(coordinate_type);
+        h.value_size = sizeof(Value);
+        h.child_box_bits = bits;
+        h.size = size;
+        h.depth = depth;
+        h.root = root;
+        h.file_size = file_size;
+    }
+
+    // Checks the header only, the nodes aren't validated
+    static inline file_header const& check_header(char const* data, std::size_t size)
+    {
+        if ( size < sizeof(file_header) )
+            throw_runtime_error("boost::geometry::index::mapped_rtree: the data is too small");
+        if ( reinterpret_cast<std::size_t>(data) % alignment != 0 )
+            throw_runtime_error("boost::geometry::index::mapped_rtree: the data is not aligned");
+
+        file_header const& h = *reinterpret_cast<file_header const*>(data);
+
+        file_header expected;
+        init_header(expected, 0, 0, 0, 0, 0);
+
+        if ( std::memcmp(h.magic, expected.magic, sizeof(h.magic)) != 0
+          || h.version != expected.version
+          || h.byte_order != expected.byte_order )
+            throw_runtime_error("boost::geometry::index::mapped_rtree: unknown format");
+        if ( h.dimension != expected.dimension
+          || h.coordinate_size != expected.coordinate_size
+          || h.box_size != expected.box_size
+          || h.value_size != expected.value_size )
+            throw_runtime_error("boost::geometry::index::mapped_rtree: incompatible value or box type");
+        if ( !is_valid_child_box_bits(h.child_box_bits) )
+            throw_runtime_error("boost::geometry::index::mapped_rtree: unknown format");
+        if ( size < h.file_size
+          || (h.size != 0 && (h.root < root_offset() || h.file_size < h.root + header_size())) )
+            throw_runtime_error("boost::geometry::index::mapped_rtree: the data is truncated");
+
+        return h;
+    }
+};
+
+// Gathers the nodes in breadth-first order
+template <typename MembersHolder>
+class flat_gather
+    : public MembersHolder::visitor_const
+{
+public:
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+    typedef typename MembersHolder::node_pointer node_pointer;
+
+    typedef layout<typename MembersHolder::value_type, typename MembersHolder::box_type> layout_type;
+
+    inline void operator()(internal_node const& n)
+    {
+        typedef typename rtree::elements_type<internal_node>::type elements_type;
+        elements_type const& elements = rtree::elements(n);
+
+        for ( typename elements_type::const_iterator it = elements.begin() ; it != elements.end() ; ++it )
+            nodes.push_back(it->second);                                                        // MAY THROW (A)
+
+        node_offset = layout_type::internal_node_offset(position, bits);
+        position = node_offset + layout_type::internal_node_size(elements.size(), bits);
+    }
+
+    inline void operator()(leaf const& n)
+    {
+        node_offset = layout_type::leaf_offset(position);
+        position = node_offset + layout_type::leaf_size(rtree::elements(n).size());
+    }
+
+    std::vector<node_pointer> nodes;
+    std::size_t node_offset;
+    std::size_t position;
+    unsigned bits;
+};
+
+// Writes the nodes, the children of the internal nodes are written
+// in the same order so their offsets are consecutive elements of offsets
+template <typename MembersHolder>
+class flat_write
+    : public MembersHolder::visitor_const
+{
+public:
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+    typedef typename MembersHolder::box_type box_type;
+
+    typedef layout<typename MembersHolder::value_type, box_type> layout_type;
+    typedef typename layout_type::offset_type offset_type;
+    typedef typename layout_type::coordinate_type coordinate_type;
+
+    static const std::size_t dimension = layout_type::dimension;
+
+    inline flat_write(std::ostream & os, std::vector<offset_type> const& offs, unsigned bits)
+        : m_os(os), m_offsets(offs), m_current(0), m_next_child(1), m_position(0), m_bits(bits)
+    {}
+
+    inline void operator()(internal_node const& n)
+    {
+        typedef typename rtree::elements_type<internal_node>::type elements_type;
+        elements_type const& elements = rtree::elements(n);
+        std::size_t const count = elements.size();
+
+        write_header(false, count);
+
+        m_mins.resize(count * dimension);                                                       // MAY THROW (A)
+        m_maxs.resize(count * dimension);                                                       // MAY THROW (A)
+        for ( std::size_t i = 0 ; i < count ; ++i )
+            box_to_coords<box_type>::apply(elements[i].first, &m_mins[i * dimension], &m_maxs[i * dimension]);
+
+        if ( m_bits == 0 )
+            write_coords(count);
+        else
+            write_quantized(count, boost::is_floating_point<coordinate_type>());
+
+        for ( std::size_t i = 0 ; i < count ; ++i, ++m_next_child )
+            write(m_offsets[m_next_child]);
+        pad_to(layout_type::align(m_position));
+    }
+
+    inline void operator()(leaf const& n)
+    {
+        typedef typename rtree::elements_type<leaf>::type elements_type;
+        elements_type const& elements = rtree::elements(n);
+
+        write_header(true, elements.size());
+
+        for ( typename elements_type::const_iterator it = elements.begin() ; it != elements.end() ; ++it )
+            write(*it);
+        pad_to(layout_type::align(m_position));
+    }
+
+    template <typename T>
+    inline void write(T const& v)
+    {
+        m_os.write(reinterpret_cast<char const*>(boost::addressof(v)), sizeof(T));
+        m_position += sizeof(T);
+    }
+
+    inline void pad_to(std::size_t position)
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(m_position <= position, "invalid position");
+        static const char zeros[layout_type::coords_alignment] = { 0 };
+        while ( m_position < position )
+        {
+            std::size_t const n = (std::min)(position - m_position, sizeof(zeros));
+            m_os.write(zeros, n);
+            m_position += n;
+        }
+    }
+
+private:
+    inline void write_header(bool is_leaf, std::size_t count)
+    {
+        pad_to(m_offsets[m_current]);
+        ++m_current;
+
+        node_header h;
+        h.is_leaf = is_leaf ? 1 : 0;
+        h.count = static_cast<boost::uint32_t>(count);
+        write(h);
+        pad_to(layout_type::align(m_position));
+    }
+
+    inline void write_coords(std::size_t count)
+    {
+        for ( std::size_t k = 0 ; k < 2 * dimension ; ++k )
+        {
+            std::vector<coordinate_type> const& coords = k < dimension ? m_mins : m_maxs;
+            std::size_t const d = k % dimension;
+
+            for ( std::size_t i = 0 ; i < count ; ++i )
+                write(coords[i * dimension + d]);
+            pad_to(layout_type::align(m_position, layout_type::coords_alignment));
+        }
+    }
+
+    inline void write_quantized(std::size_t count, boost::true_type const& /*is_floating_point*/)
+    {
+        if ( m_bits == 8 )
+            write_codes<boost::uint8_t>(count);
+        else
+            write_codes<boost::uint16_t>(count);
+    }
+
+    inline void write_quantized(std::size_t /*count*/, boost::false_type const& /*is_floating_point*/)
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(false, "the boxes with integral coordinates can't be quantized");
+    }
+
+    // The children are quantized relative to the box of the node
+    template <typename Code>
+    inline void write_codes(std::size_t count)
+    {
+        coordinate_type origin[dimension];
+        coordinate_type scale[dimension];
+        for ( std::size_t d = 0 ; d < dimension ; ++d )
+        {
+            coordinate_type lo = m_mins[d];
+            coordinate_type hi = m_maxs[d];
+            for ( std::size_t i = 1 ; i < count ; ++i )
+            {
+                lo = (std::min)(lo, m_mins[i * dimension + d]);
+                hi = (std::max)(hi, m_maxs[i * dimension + d]);
+            }
+            origin[d] = lo;
+            scale[d] = layout_type::template compute_scale<Code>(lo, hi);
+        }
+
+        for ( std::size_t d = 0 ; d < dimension ; ++d )
+            write(origin[d]);
+        for ( std::size_t d = 0 ; d < dimension ; ++d )
+            write(scale[d]);
+        pad_to(layout_type::align(m_position));
+
+        for ( std::size_t k = 0 ; k < 2 * dimension ; ++k )
+        {
+            std::size_t const d = k % dimension;
+            for ( std::size_t i = 0 ; i < count ; ++i )
+            {
+                write(k < dimension
+                    ? layout_type::template encode_min<Code>(origin[d], scale[d], m_mins[i * dimension + d])
+                    : layout_type::template encode_max<Code>(origin[d], scale[d], m_maxs[i * dimension + d]));
+            }
+            pad_to(layout_type::align(m_position));
+        }
+    }
+
+    std::ostream & m_os;
+    std::vector<offset_type> const& m_offsets;
+    std::size_t m_current;
+    std::size_t m_next_child;
+    std::size_t m_position;
+    unsigned m_bits;
+    std::vector<coordinate_type> m_mins;
+    std::vector<coordinate_type> m_maxs;
+};
+
+template <typename MembersHolder>
+inline void write(MembersHolder const& members, std::size_t size, std::ostream & os, unsigned bits)
+{
+    typedef flat_gather<MembersHolder> gather_type;
+    typedef typename gather_type::layout_type layout_type;
+    typedef typename layout_type::offset_type offset_type;
+    typedef typename layout_type::coordinate_type coordinate_type;
+
+    if ( !layout_type::is_valid_child_box_bits(bits) )
+        throw_invalid_argument("boost::geometry::index::write_mapped: invalid number of bits of quantized boxes");
+    if ( bits != 0 && !boost::is_floating_point<coordinate_type>::value )
+        throw_invalid_argument("boost::geometry::index::write_mapped: the boxes with integral coordinates can't be quantized");
+
+    gather_type gather_v;
+    gather_v.position = layout_type::root_offset();
+    gather_v.bits = bits;
+
+    std::vector<offset_type> offsets;
+
+    if ( members.root && size > 0 )
+    {
+        gather_v.nodes.push_back(members.root);
+        for ( std::size_t i = 0 ; i < gather_v.nodes.size() ; ++i )
+        {
+            rtree::apply_visitor(gather_v, *gather_v.nodes[i]);
+            offsets.push_back(gather_v.node_offset);
+        }
+    }
+
+    file_header h;
+    layout_type::init_header(h, size, members.leafs_level,
+                             offsets.empty() ? 0 : static_cast<std::size_t>(offsets.front()),
+                             gather_v.position, bits);
+
+    flat_write<MembersHolder> write_v(os, offsets, bits);
+    write_v.write(h);
+    write_v.pad_to(layout_type::root_offset());
+
+    for ( std::size_t i = 0 ; i < offsets.size() ; ++i )
+        rtree::apply_visitor(write_v, *gather_v.nodes[i]);
+}
+
+}}}}}} // namespace boost::geometry::index::detail::rtree::flat
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_RTREE_FLAT_LAYOUT_HPP
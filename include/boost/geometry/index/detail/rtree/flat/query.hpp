@@ -0,0 +1,818 @@
+// Boost.Geometry Index
+//
+// R-tree queries and query iterators of the flat layout
+//
+// Copyright (c) 2011-2014 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_FLAT_QUERY_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_FLAT_QUERY_HPP
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include <boost/core/addressof.hpp>
+#include <boost/mpl/bool.hpp>
+
+#include <boost/geometry/index/detail/algorithms/intersecting_children.hpp>
+#include <boost/geometry/index/detail/rtree/flat/layout.hpp>
+
+namespace boost { namespace geometry { namespace index { namespace detail { namespace rtree { namespace flat {
+
+// Members is the equivalent of the rtree's members_holder defined by the mapped_rtree.
+// It's a translator and parameters and stores the pointer to the data.
+
+// Clears the elements of the mask for the children not intersecting the query box.
+// The coordinates are tested one dimension at a time in branchless loops over
+// contiguous arrays which are vectorized by the compiler.
+template <typename Layout, typename QueryBox,
+          std::size_t I = 0, std::size_t D = Layout::dimension>
+struct children_intersecting_box
+{
+    typedef typename Layout::coordinate_type coordinate_type;
+    typedef typename Layout::offset_type offset_type;
+    typedef typename geometry::coordinate_type<QueryBox>::type query_coordinate_type;
+
+    static inline void apply(char const* data, offset_type offset, std::size_t count,
+                             std::size_t first, std::size_t n,
+                             QueryBox const& query_box, unsigned char * mask)
+    {
+        coordinate_type const* mins = Layout::min_coords(data, offset, count, I) + first;
+        coordinate_type const* maxs = Layout::max_coords(data, offset, count, I) + first;
+        query_coordinate_type const qmin = geometry::get<min_corner, I>(query_box);
+        query_coordinate_type const qmax = geometry::get<max_corner, I>(query_box);
+
+        for ( std::size_t i = 0 ; i < n ; ++i )
+            mask[i] &= static_cast<unsigned char>(!(maxs[i] < qmin) & !(qmax < mins[i]));
+
+        children_intersecting_box<Layout, QueryBox, I + 1, D>::apply(data, offset, count, first, n, query_box, mask);
+    }
+};
+
+template <typename Layout, typename QueryBox, std::size_t D>
+struct children_intersecting_box<Layout, QueryBox, D, D>
+{
+    static inline void apply(char const*, typename Layout::offset_type, std::size_t,
+                             std::size_t, std::size_t, QueryBox const&, unsigned char *)
+    {}
+};
+
+// The same for the quantized boxes, the codes are decoded in the loops
+template <typename Layout, typename Code, typename QueryBox,
+          std::size_t I = 0, std::size_t D = Layout::dimension>
+struct quantized_children_intersecting_box
+{
+    typedef typename Layout::coordinate_type coordinate_type;
+    typedef typename Layout::offset_type offset_type;
+    typedef typename geometry::coordinate_type<QueryBox>::type query_coordinate_type;
+
+    static inline void apply(char const* data, offset_type offset, std::size_t count,
+                             std::size_t first, std::size_t n,
+                             QueryBox const& query_box, unsigned char * mask)
+    {
+        Code const* mins = Layout::template min_codes<Code>(data, offset, count, I) + first;
+        Code const* maxs = Layout::template max_codes<Code>(data, offset, count, I) + first;
+        coordinate_type const origin = Layout::quantization_origin(data, offset)[I];
+        coordinate_type const scale = Layout::quantization_scale(data, offset)[I];
+        query_coordinate_type const qmin = geometry::get<min_corner, I>(query_box);
+        query_coordinate_type const qmax = geometry::get<max_corner, I>(query_box);
+
+        for ( std::size_t i = 0 ; i < n ; ++i )
+        {
+            mask[i] &= static_cast<unsigned char>(!(Layout::decode(origin, scale, maxs[i]) < qmin)
+                                                & !(qmax < Layout::decode(origin, scale, mins[i])));
+        }
+
+        quantized_children_intersecting_box<Layout, Code, QueryBox, I + 1, D>::apply(data, offset, count, first, n, query_box, mask);
+    }
+};
+
+template <typename Layout, typename Code, typename QueryBox, std::size_t D>
+struct quantized_children_intersecting_box<Layout, Code, QueryBox, D, D>
+{
+    static inline void apply(char const*, typename Layout::offset_type, std::size_t,
+                             std::size_t, std::size_t, QueryBox const&, unsigned char *)
+    {}
+};
+
+template <typename Members, typename Predicates, typename OutIter>
+class spatial_query
+{
+    typedef typename Members::value_type value_type;
+    typedef typename Members::box_type box_type;
+    typedef typename Members::translator_type translator_type;
+    typedef typename Members::layout_type layout_type;
+    typedef typename layout_type::offset_type offset_type;
+
+    typedef typename index::detail::strategy_type<typename Members::parameters_type>::type strategy_type;
+
+public:
+    typedef std::size_t size_type;
+
+    static const unsigned predicates_len = index::detail::predicates_length<Predicates>::value;
+
+    inline spatial_query(Members const& members, Predicates const& p, OutIter out_it)
+        : m_data(members.data), m_tr(members.translator()), m_pred(p), out_iter(out_it)
+        , found_count(0), m_strategy(index::detail::get_strategy(members.parameters()))
+    {}
+
+    inline void apply(offset_type offset)
+    {
+        node_header const& h = layout_type::header(m_data, offset);
+
+        if ( h.is_leaf )
+        {
+            value_type const* values = layout_type::values(m_data, offset);
+            for ( std::size_t i = 0 ; i < h.count ; ++i )
+            {
+                // if value meets predicates
+                if ( index::detail::predicates_check
+                        <
+                            index::detail::value_tag, 0, predicates_len
+                        >(m_pred, values[i], m_tr(values[i]), m_strategy) )
+                {
+                    *out_iter = values[i];
+                    ++out_iter;
+
+                    ++found_count;
+                }
+            }
+        }
+        else
+        {
+            apply_internal(offset, h.count,
+                           boost::mpl::bool_<index::detail::is_box_intersects_bounds_check<Predicates, box_type>::value>());
+        }
+    }
+
+private:
+    inline void apply_internal(offset_type offset, std::size_t count, boost::mpl::bool_<false> const& /*is_box_intersects*/)
+    {
+        offset_type const* children = layout_type::children(m_data, offset, count);
+        box_type box;
+        for ( std::size_t i = 0 ; i < count ; ++i )
+        {
+            layout_type::box(m_data, offset, count, i, box);
+
+            // if node meets predicates
+            // 0 - dummy value
+            if ( index::detail::predicates_check
+                    <
+                        index::detail::bounds_tag, 0, predicates_len
+                    >(m_pred, 0, box, m_strategy) )
+            {
+                apply(children[i]);
+            }
+        }
+    }
+
+    inline void apply_internal(offset_type offset, std::size_t count, boost::mpl::bool_<true> const& /*is_box_intersects*/)
+    {
+        typedef typename is_box_intersects_bounds_check
+            <
+                Predicates, box_type
+            >::query_box_type query_box_type;
+        static const std::size_t chunk_size = 64;
+
+        offset_type const* children = layout_type::children(m_data, offset, count);
+        unsigned const bits = layout_type::child_box_bits(m_data);
+        unsigned char mask[chunk_size];
+
+        for ( std::size_t first = 0 ; first < count ; first += chunk_size )
+        {
+            std::size_t const n = (std::min)(chunk_size, count - first);
+
+            std::fill(mask, mask + n, static_cast<unsigned char>(1));
+            if ( bits == 8 )
+                quantized_children_intersecting_box<layout_type, boost::uint8_t, query_box_type>
+                    ::apply(m_data, offset, count, first, n, m_pred.geometry, mask);
+            else if ( bits == 16 )
+                quantized_children_intersecting_box<layout_type, boost::uint16_t, query_box_type>
+                    ::apply(m_data, offset, count, first, n, m_pred.geometry, mask);
+            else
+                children_intersecting_box<layout_type, query_box_type>
+                    ::apply(m_data, offset, count, first, n, m_pred.geometry, mask);
+
+            for ( std::size_t i = 0 ; i < n ; ++i )
+            {
+                if ( mask[i] )
+                    apply(children[first + i]);
+            }
+        }
+    }
+
+private:
+    char const* m_data;
+    translator_type const& m_tr;
+
+    Predicates m_pred;
+
+public:
+    OutIter out_iter;
+    size_type found_count;
+
+private:
+    strategy_type m_strategy;
+};
+
+// The same algorithm as in visitors::distance_query
+template <typename Members, typename Predicates, unsigned DistancePredicateIndex, typename OutIter>
+class distance_query
+{
+    typedef typename Members::value_type value_type;
+    typedef typename Members::box_type box_type;
+    typedef typename Members::translator_type translator_type;
+    typedef typename Members::layout_type layout_type;
+    typedef typename layout_type::offset_type offset_type;
+
+    typedef typename index::detail::strategy_type<typename Members::parameters_type>::type strategy_type;
+
+    typedef index::detail::predicates_element<DistancePredicateIndex, Predicates> nearest_predicate_access;
+    typedef typename nearest_predicate_access::type nearest_predicate_type;
+    typedef typename indexable_type<translator_type>::type indexable_type;
+
+    typedef index::detail::calculate_distance<nearest_predicate_type, indexable_type, strategy_type, value_tag> calculate_value_distance;
+    typedef index::detail::calculate_distance<nearest_predicate_type, box_type, strategy_type, bounds_tag> calculate_node_distance;
+    typedef typename calculate_value_distance::result_type value_distance_type;
+    typedef typename calculate_node_distance::result_type node_distance_type;
+
+    typedef std::pair<node_distance_type, offset_type> branch_data;
+    typedef std::vector<branch_data> active_branch_list_type;
+
+public:
+    static const unsigned predicates_len = index::detail::predicates_length<Predicates>::value;
+
+    inline distance_query(Members const& members, Predicates const& pred, OutIter out_it)
+        : m_data(members.data), m_tr(members.translator())
+        , m_pred(pred)
+        , m_result(nearest_predicate_access::get(m_pred).count, out_it)
+        , m_strategy(index::detail::get_strategy(members.parameters()))
+    {}
+
+    inline void apply(offset_type offset)
+    {
+        node_header const& h = layout_type::header(m_data, offset);
+
+        if ( h.is_leaf )
+        {
+            value_type const* values = layout_type::values(m_data, offset);
+            for ( std::size_t i = 0 ; i < h.count ; ++i )
+            {
+                // if value meets predicates
+                if ( index::detail::predicates_check
+                        <
+                            index::detail::value_tag, 0, predicates_len
+                        >(m_pred, values[i], m_tr(values[i]), m_strategy) )
+                {
+                    // calculate values distance for distance predicate
+                    value_distance_type value_distance;
+                    // if distance is ok
+                    if ( calculate_value_distance::apply(predicate(), m_tr(values[i]),
+                                                         m_strategy, value_distance) )
+                    {
+                        // store value
+                        m_result.store(values[i], value_distance);
+                    }
+                }
+            }
+            return;
+        }
+
+        offset_type const* children = layout_type::children(m_data, offset, h.count);
+        box_type box;
+
+        active_branch_list_type active_branch_list;
+        active_branch_list.reserve(h.count);                                                    // MAY THROW (A)
+
+        // fill array of nodes meeting predicates
+        for ( std::size_t i = 0 ; i < h.count ; ++i )
+        {
+            layout_type::box(m_data, offset, h.count, i, box);
+
+            // 0 - dummy value
+            if ( !index::detail::predicates_check
+                    <
+                        index::detail::bounds_tag, 0, predicates_len
+                    >(m_pred, 0, box, m_strategy) )
+            {
+                continue;
+            }
+
+            // calculate node's distance(s) for distance predicate
+            node_distance_type node_distance;
+            // if distance isn't ok - move to the next node
+            if ( !calculate_node_distance::apply(predicate(), box, m_strategy, node_distance) )
+                continue;
+
+            // if current node is further than found neighbors - don't analyze it
+            if ( m_result.has_enough_neighbors() &&
+                 m_result.greatest_comparable_distance() <= node_distance )
+                continue;
+
+            active_branch_list.push_back(branch_data(node_distance, children[i]));
+        }
+
+        std::sort(active_branch_list.begin(), active_branch_list.end(), abl_less);
+
+        // recursively visit nodes
+        for ( typename active_branch_list_type::const_iterator it = active_branch_list.begin();
+              it != active_branch_list.end() ; ++it )
+        {
+            // if current node is further than furthest neighbor, the rest of nodes also will be further
+            if ( m_result.has_enough_neighbors() &&
+                 m_result.greatest_comparable_distance() <= it->first )
+                break;
+
+            apply(it->second);
+        }
+    }
+
+    inline std::size_t finish()
+    {
+        return m_result.finish();
+    }
+
+private:
+    static inline bool abl_less(branch_data const& p1, branch_data const& p2)
+    {
+        return p1.first < p2.first;
+    }
+
+    nearest_predicate_type const& predicate() const
+    {
+        return nearest_predicate_access::get(m_pred);
+    }
+
+    char const* m_data;
+    translator_type const& m_tr;
+
+    Predicates m_pred;
+    visitors::distance_query_result<value_type, translator_type, value_distance_type, OutIter> m_result;
+
+    strategy_type m_strategy;
+};
+
+// The types used by the query iterators instead of the types of the rtree's allocators
+template <typename Value>
+struct query_iterator_types
+{
+    typedef Value const& const_reference;
+    typedef std::ptrdiff_t difference_type;
+    typedef Value const* const_pointer;
+};
+
+// The equivalent of iterators::spatial_query_iterator using visitors::spatial_query_incremental
+template <typename Members, typename Predicates>
+class spatial_query_iterator
+{
+    typedef typename Members::box_type box_type;
+    typedef typename Members::layout_type layout_type;
+    typedef typename layout_type::offset_type offset_type;
+
+    typedef typename index::detail::strategy_type<typename Members::parameters_type>::type strategy_type;
+
+    struct internal_range
+    {
+        internal_range(offset_type o, std::size_t c)
+            : offset(o), current(0), count(c)
+        {}
+
+        offset_type offset;
+        std::size_t current;
+        std::size_t count;
+    };
+
+    static const unsigned predicates_len = index::detail::predicates_length<Predicates>::value;
+
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename Members::value_type value_type;
+    typedef value_type const& reference;
+    typedef std::ptrdiff_t difference_type;
+    typedef value_type const* pointer;
+
+    typedef iterators::end_query_iterator<value_type, query_iterator_types<value_type> > end_iterator_type;
+
+    inline spatial_query_iterator()
+        : m_members(0), m_current(0), m_last(0)
+    {}
+
+    inline spatial_query_iterator(Members const& members, Predicates const& p)
+        : m_members(boost::addressof(members))
+        , m_pred(p)
+        , m_current(0), m_last(0)
+        , m_strategy(index::detail::get_strategy(members.parameters()))
+    {
+        if ( members.header->root )
+        {
+            visit(members.header->root);
+            search_value();
+        }
+    }
+
+    // Takes over the state of the traversal of the other iterator
+    inline spatial_query_iterator(spatial_query_iterator & o, move_state_tag)
+        : m_members(o.m_members)
+        , m_pred(o.m_pred)
+        , m_current(o.m_current), m_last(o.m_last)
+        , m_strategy(o.m_strategy)
+    {
+        m_internal_stack.swap(o.m_internal_stack);
+    }
+
+    reference operator*() const
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(m_current, "not dereferencable");
+        return *m_current;
+    }
+
+    const value_type * operator->() const
+    {
+        return m_current;
+    }
+
+    spatial_query_iterator & operator++()
+    {
+        ++m_current;
+        search_value();
+        return *this;
+    }
+
+    spatial_query_iterator operator++(int)
+    {
+        spatial_query_iterator temp = *this;
+        this->operator++();
+        return temp;
+    }
+
+    friend bool operator==(spatial_query_iterator const& l, spatial_query_iterator const& r)
+    {
+        return l.m_current == r.m_current;
+    }
+
+    friend bool operator==(spatial_query_iterator const& l, end_iterator_type const& /*r*/)
+    {
+        return 0 == l.m_current;
+    }
+
+    friend bool operator==(end_iterator_type const& /*l*/, spatial_query_iterator const& r)
+    {
+        return 0 == r.m_current;
+    }
+
+    friend bool operator!=(spatial_query_iterator const& l, spatial_query_iterator const& r)
+    {
+        return !(l == r);
+    }
+
+    friend bool operator!=(spatial_query_iterator const& l, end_iterator_type const& r)
+    {
+        return !(l == r);
+    }
+
+    friend bool operator!=(end_iterator_type const& l, spatial_query_iterator const& r)
+    {
+        return !(l == r);
+    }
+
+private:
+    void visit(offset_type offset)
+    {
+        char const* data = m_members->data;
+        node_header const& h = layout_type::header(data, offset);
+
+        if ( h.is_leaf )
+        {
+            m_current = layout_type::values(data, offset);
+            m_last = m_current + h.count;
+        }
+        else
+        {
+            m_internal_stack.push_back(internal_range(offset, h.count));
+        }
+    }
+
+    void search_value()
+    {
+        for (;;)
+        {
+            // if leaf is choosen, move to the next value in leaf
+            if ( m_current )
+            {
+                if ( m_current != m_last )
+                {
+                    // return if next value is found
+                    if ( index::detail::predicates_check
+                            <
+                                index::detail::value_tag, 0, predicates_len
+                            >(m_pred, *m_current, m_members->translator()(*m_current), m_strategy) )
+                    {
+                        return;
+                    }
+
+                    ++m_current;
+                }
+                // no more values, clear current leaf
+                else
+                {
+                    m_current = 0;
+                }
+            }
+            // if leaf isn't choosen, move to the next leaf
+            else
+            {
+                // return if there is no more nodes to traverse
+                if ( m_internal_stack.empty() )
+                    return;
+
+                internal_range & range = m_internal_stack.back();
+
+                // no more children in current node, remove it from stack
+                if ( range.current == range.count )
+                {
+                    m_internal_stack.pop_back();
+                    continue;
+                }
+
+                char const* data = m_members->data;
+                box_type box;
+                layout_type::box(data, range.offset, range.count, range.current, box);
+                offset_type const child = layout_type::children(data, range.offset, range.count)[range.current];
+                ++range.current;
+
+                // next node is found, push it to the stack
+                if ( index::detail::predicates_check
+                        <
+                            index::detail::bounds_tag, 0, predicates_len
+                        >(m_pred, 0, box, m_strategy) )
+                {
+                    visit(child);
+                }
+            }
+        }
+    }
+
+    Members const* m_members;
+    Predicates m_pred;
+
+    std::vector<internal_range> m_internal_stack;
+    value_type const* m_current;
+    value_type const* m_last;
+
+    strategy_type m_strategy;
+};
+
+// Incremental best-first knn search (Hjaltason, Samet). The branches and the values
+// are kept in two priority queues, the closest value is returned if there is
+// no branch closer than it.
+template <typename Members, typename Predicates, unsigned DistancePredicateIndex>
+class distance_query_iterator
+{
+    typedef typename Members::box_type box_type;
+    typedef typename Members::translator_type translator_type;
+    typedef typename Members::layout_type layout_type;
+    typedef typename layout_type::offset_type offset_type;
+
+    typedef typename index::detail::strategy_type<typename Members::parameters_type>::type strategy_type;
+
+    typedef index::detail::predicates_element<DistancePredicateIndex, Predicates> nearest_predicate_access;
+    typedef typename nearest_predicate_access::type nearest_predicate_type;
+    typedef typename indexable_type<translator_type>::type indexable_type;
+
+    typedef index::detail::calculate_distance<nearest_predicate_type, indexable_type, strategy_type, value_tag> calculate_value_distance;
+    typedef index::detail::calculate_distance<nearest_predicate_type, box_type, strategy_type, bounds_tag> calculate_node_distance;
+    typedef typename calculate_value_distance::result_type value_distance_type;
+    typedef typename calculate_node_distance::result_type node_distance_type;
+
+    static const unsigned predicates_len = index::detail::predicates_length<Predicates>::value;
+
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename Members::value_type value_type;
+    typedef value_type const& reference;
+    typedef std::ptrdiff_t difference_type;
+    typedef value_type const* pointer;
+
+    typedef iterators::end_query_iterator<value_type, query_iterator_types<value_type> > end_iterator_type;
+
+private:
+    typedef std::pair<node_distance_type, offset_type> branch_data;
+    typedef std::pair<value_distance_type, value_type const*> neighbor_data;
+
+public:
+    inline distance_query_iterator()
+        : m_members(0), m_current(0), m_returned_count(0)
+    {}
+
+    inline distance_query_iterator(Members const& members, Predicates const& pred)
+        : m_members(boost::addressof(members))
+        , m_pred(pred)
+        , m_current(0), m_returned_count(0)
+        , m_strategy(index::detail::get_strategy(members.parameters()))
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(0 < max_count(), "k must be greather than 0");
+
+        if ( members.header->root )
+        {
+            push_branch(node_distance_type(), members.header->root);
+            increment();
+        }
+    }
+
+    // Takes over the state of the traversal of the other iterator
+    inline distance_query_iterator(distance_query_iterator & o, move_state_tag)
+        : m_members(o.m_members)
+        , m_pred(o.m_pred)
+        , m_current(o.m_current), m_returned_count(o.m_returned_count)
+        , m_strategy(o.m_strategy)
+    {
+        m_branches.swap(o.m_branches);
+        m_neighbors.swap(o.m_neighbors);
+    }
+
+    reference operator*() const
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(m_current, "not dereferencable");
+        return *m_current;
+    }
+
+    const value_type * operator->() const
+    {
+        return m_current;
+    }
+
+    distance_query_iterator & operator++()
+    {
+        increment();
+        return *this;
+    }
+
+    distance_query_iterator operator++(int)
+    {
+        distance_query_iterator temp = *this;
+        this->operator++();
+        return temp;
+    }
+
+    friend bool operator==(distance_query_iterator const& l, distance_query_iterator const& r)
+    {
+        return l.m_current == r.m_current
+            && (0 == l.m_current || l.m_returned_count == r.m_returned_count);
+    }
+
+    friend bool operator==(distance_query_iterator const& l, end_iterator_type const& /*r*/)
+    {
+        return 0 == l.m_current;
+    }
+
+    friend bool operator==(end_iterator_type const& /*l*/, distance_query_iterator const& r)
+    {
+        return 0 == r.m_current;
+    }
+
+    friend bool operator!=(distance_query_iterator const& l, distance_query_iterator const& r)
+    {
+        return !(l == r);
+    }
+
+    friend bool operator!=(distance_query_iterator const& l, end_iterator_type const& r)
+    {
+        return !(l == r);
+    }
+
+    friend bool operator!=(end_iterator_type const& l, distance_query_iterator const& r)
+    {
+        return !(l == r);
+    }
+
+private:
+    void increment()
+    {
+        m_current = 0;
+
+        if ( max_count() <= m_returned_count )
+            return;
+
+        for (;;)
+        {
+            // expand the closest branch if it's closer than the closest value
+            if ( ! m_branches.empty()
+              && ( m_neighbors.empty() || m_branches.front().first < m_neighbors.front().first ) )
+            {
+                offset_type const offset = m_branches.front().second;
+                std::pop_heap(m_branches.begin(), m_branches.end(), branch_greater);
+                m_branches.pop_back();
+
+                expand(offset);
+            }
+            // otherwise return the closest value
+            else if ( ! m_neighbors.empty() )
+            {
+                m_current = m_neighbors.front().second;
+                std::pop_heap(m_neighbors.begin(), m_neighbors.end(), neighbor_greater);
+                m_neighbors.pop_back();
+
+                ++m_returned_count;
+                return;
+            }
+            else
+            {
+                return;
+            }
+        }
+    }
+
+    void expand(offset_type offset)
+    {
+        char const* data = m_members->data;
+        node_header const& h = layout_type::header(data, offset);
+
+        if ( h.is_leaf )
+        {
+            value_type const* values = layout_type::values(data, offset);
+            for ( std::size_t i = 0 ; i < h.count ; ++i )
+            {
+                indexable_type const& indexable = m_members->translator()(values[i]);
+
+                // if value meets predicates
+                if ( index::detail::predicates_check
+                        <
+                            index::detail::value_tag, 0, predicates_len
+                        >(m_pred, values[i], indexable, m_strategy) )
+                {
+                    value_distance_type dist;
+                    if ( calculate_value_distance::apply(predicate(), indexable, m_strategy, dist) )
+                    {
+                        m_neighbors.push_back(neighbor_data(dist, values + i));                 // MAY THROW (A)
+                        std::push_heap(m_neighbors.begin(), m_neighbors.end(), neighbor_greater);
+                    }
+                }
+            }
+        }
+        else
+        {
+            offset_type const* children = layout_type::children(data, offset, h.count);
+            box_type box;
+            for ( std::size_t i = 0 ; i < h.count ; ++i )
+            {
+                layout_type::box(data, offset, h.count, i, box);
+
+                // 0 - dummy value
+                if ( index::detail::predicates_check
+                        <
+                            index::detail::bounds_tag, 0, predicates_len
+                        >(m_pred, 0, box, m_strategy) )
+                {
+                    node_distance_type dist;
+                    if ( calculate_node_distance::apply(predicate(), box, m_strategy, dist) )
+                        push_branch(dist, children[i]);
+                }
+            }
+        }
+    }
+
+    void push_branch(node_distance_type const& dist, offset_type offset)
+    {
+        m_branches.push_back(branch_data(dist, offset));                                        // MAY THROW (A)
+        std::push_heap(m_branches.begin(), m_branches.end(), branch_greater);
+    }
+
+    static inline bool branch_greater(branch_data const& l, branch_data const& r)
+    {
+        return r.first < l.first;
+    }
+
+    static inline bool neighbor_greater(neighbor_data const& l, neighbor_data const& r)
+    {
+        return r.first < l.first;
+    }
+
+    nearest_predicate_type const& predicate() const
+    {
+        return nearest_predicate_access::get(m_pred);
+    }
+
+    std::size_t max_count() const
+    {
+        return nearest_predicate_access::get(m_pred).count;
+    }
+
+    Members const* m_members;
+    Predicates m_pred;
+
+    std::vector<branch_data> m_branches;
+    std::vector<neighbor_data> m_neighbors;
+    value_type const* m_current;
+    std::size_t m_returned_count;
+
+    strategy_type m_strategy;
+};
+
+}}}}}} // namespace boost::geometry::index::detail::rtree::flat
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_RTREE_FLAT_QUERY_HPP
@@ -11,8 +11,18 @@
 #ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_KMEANS_SPLIT_HPP
 #define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_KMEANS_SPLIT_HPP
 
-#include <boost/geometry/index/rtree/node/node.hpp>
-#include <boost/geometry/index/rtree/visitors/insert.hpp>
+#include <algorithm>
+#include <vector>
+
+#include <boost/geometry/core/access.hpp>
+#include <boost/geometry/core/coordinate_dimension.hpp>
+#include <boost/geometry/core/coordinate_type.hpp>
+#include <boost/geometry/util/select_most_precise.hpp>
+
+#include <boost/geometry/index/detail/algorithms/bounds.hpp>
+
+#include <boost/geometry/index/detail/rtree/node/node.hpp>
+#include <boost/geometry/index/detail/rtree/visitors/insert.hpp>
 
 namespace boost { namespace geometry { namespace index {
 
@@ -20,63 +30,375 @@ namespace detail { namespace rtree {
 
 namespace kmeans {
 
-// some details
+// The maximum number of Lloyd's iterations performed for one split.
+// The algorithm usually converges after a few iterations since the number
+// of clustered elements is small (Max + 1).
+static const size_t max_iterations = 16;
+
+template <typename Box,
+          size_t Dimension = 0,
+          size_t DimensionCount = dimension<Box>::value>
+struct box_center
+{
+    template <typename T>
+    static inline void apply(Box const& b, T * center)
+    {
+        center[Dimension] = ( T(geometry::get<min_corner, Dimension>(b))
+                            + T(geometry::get<max_corner, Dimension>(b)) ) / T(2);
+        box_center<Box, Dimension + 1, DimensionCount>::apply(b, center);
+    }
+};
+
+template <typename Box, size_t DimensionCount>
+struct box_center<Box, DimensionCount, DimensionCount>
+{
+    template <typename T>
+    static inline void apply(Box const&, T *) {}
+};
+
+template <typename T>
+inline T comparable_distance(T const* p1, T const* p2, size_t dimension_count)
+{
+    T result = 0;
+    for ( size_t d = 0 ; d < dimension_count ; ++d )
+    {
+        T const diff = p1[d] - p2[d];
+        result += diff * diff;
+    }
+    return result;
+}
+
+template <typename T>
+inline size_t farthest_from(std::vector<T> const& centers, T const* p,
+                            size_t count, size_t dimension_count)
+{
+    size_t result = 0;
+    T greatest_distance = -1;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        T const dist = comparable_distance(&centers[i * dimension_count], p, dimension_count);
+        if ( greatest_distance < dist )
+        {
+            greatest_distance = dist;
+            result = i;
+        }
+    }
+    return result;
+}
+
+// Calculates means of both groups, returns false if one of the groups is empty.
+template <typename T>
+inline bool calculate_means(std::vector<T> const& centers,
+                            std::vector<unsigned char> const& groups,
+                            size_t count, size_t dimension_count,
+                            T * mean1, T * mean2)
+{
+    size_t count1 = 0, count2 = 0;
+    std::fill(mean1, mean1 + dimension_count, T(0));
+    std::fill(mean2, mean2 + dimension_count, T(0));
+
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        T * mean = groups[i] == 0 ? mean1 : mean2;
+        (groups[i] == 0 ? count1 : count2) += 1;
+        for ( size_t d = 0 ; d < dimension_count ; ++d )
+            mean[d] += centers[i * dimension_count + d];
+    }
+
+    if ( count1 == 0 || count2 == 0 )
+        return false;
+
+    for ( size_t d = 0 ; d < dimension_count ; ++d )
+    {
+        mean1[d] /= T(count1);
+        mean2[d] /= T(count2);
+    }
+    return true;
+}
+
+// Moves the elements closest to the underfull group until it has min_elements.
+template <typename T>
+inline void fill_group(std::vector<T> const& centers,
+                       std::vector<unsigned char> & groups,
+                       size_t count, size_t dimension_count,
+                       T const* mean_to, T const* mean_from,
+                       unsigned char group_to, size_t & count_to, size_t & count_from,
+                       size_t min_elements)
+{
+    while ( count_to < min_elements )
+    {
+        size_t best = count;
+        T smallest_cost = 0;
+        for ( size_t i = 0 ; i < count ; ++i )
+        {
+            if ( groups[i] == group_to )
+                continue;
+
+            T const* c = &centers[i * dimension_count];
+            T const cost = comparable_distance(c, mean_to, dimension_count)
+                         - comparable_distance(c, mean_from, dimension_count);
+            if ( best == count || cost < smallest_cost )
+            {
+                smallest_cost = cost;
+                best = i;
+            }
+        }
+
+        BOOST_GEOMETRY_INDEX_ASSERT(best < count, "unexpected state");
+
+        groups[best] = group_to;
+        ++count_to;
+        --count_from;
+    }
+}
+
+// Divides the elements into two clusters with Lloyd's algorithm.
+// The result is stored in groups (0 or 1 for each element), both groups
+// containing at least min_elements.
+template <typename Box, typename Elements, typename Translator, typename Strategy>
+inline void cluster(Elements const& elements,
+                    size_t min_elements,
+                    Translator const& translator,
+                    Strategy const& strategy,
+                    std::vector<unsigned char> & groups)
+{
+    typedef typename select_most_precise
+        <
+            typename coordinate_type<Box>::type,
+            double
+        >::type calc_type;
+
+    static const size_t dimension_count = dimension<Box>::value;
+
+    size_t const count = elements.size();
+    BOOST_GEOMETRY_INDEX_ASSERT(2 <= count, "unexpected number of elements");
+    BOOST_GEOMETRY_INDEX_ASSERT(2 * min_elements <= count, "unexpected number of elements");
+
+    // centers of elements' bounds
+    std::vector<calc_type> centers(count * dimension_count);                                    // MAY THROW (alloc)
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        Box b;
+        index::detail::bounds(rtree::element_indexable(elements[i], translator), b, strategy);
+        box_center<Box>::apply(b, &centers[i * dimension_count]);
+    }
+
+    // initial means - the element farthest from the centroid of all elements
+    // and the element farthest from it
+    calc_type mean1[dimension_count];
+    calc_type mean2[dimension_count];
+    std::fill(mean1, mean1 + dimension_count, calc_type(0));
+    for ( size_t i = 0 ; i < count ; ++i )
+        for ( size_t d = 0 ; d < dimension_count ; ++d )
+            mean1[d] += centers[i * dimension_count + d];
+    for ( size_t d = 0 ; d < dimension_count ; ++d )
+        mean1[d] /= calc_type(count);
+
+    size_t const seed1 = farthest_from(centers, mean1, count, dimension_count);
+    size_t const seed2 = farthest_from(centers, &centers[seed1 * dimension_count], count, dimension_count);
+    std::copy(&centers[seed1 * dimension_count], &centers[seed1 * dimension_count] + dimension_count, mean1);
+    std::copy(&centers[seed2 * dimension_count], &centers[seed2 * dimension_count] + dimension_count, mean2);
+
+    // Lloyd's iterations
+    groups.assign(count, 2);                                                                    // MAY THROW (alloc)
+    for ( size_t iter = 0 ; iter < max_iterations ; ++iter )
+    {
+        bool changed = false;
+        for ( size_t i = 0 ; i < count ; ++i )
+        {
+            calc_type const* c = &centers[i * dimension_count];
+            unsigned char const g = comparable_distance(c, mean1, dimension_count)
+                                 <= comparable_distance(c, mean2, dimension_count) ? 0 : 1;
+            if ( groups[i] != g )
+            {
+                groups[i] = g;
+                changed = true;
+            }
+        }
+
+        if ( ! changed )
+            break;
+
+        // all of the elements have the same center, the groups are balanced below
+        if ( ! calculate_means(centers, groups, count, dimension_count, mean1, mean2) )
+            break;
+    }
+
+    // the elements assigned to the group closer to them, the means are
+    // refreshed so the balancing below uses the final clusters
+    size_t count1 = 0;
+    for ( size_t i = 0 ; i < count ; ++i )
+        if ( groups[i] == 0 )
+            ++count1;
+    size_t count2 = count - count1;
+
+    if ( count1 < min_elements )
+        fill_group(centers, groups, count, dimension_count, mean1, mean2,
+                   0, count1, count2, min_elements);
+    else if ( count2 < min_elements )
+        fill_group(centers, groups, count, dimension_count, mean2, mean1,
+                   1, count2, count1, min_elements);
+}
 
 } // namespace kmeans
 
-// split_kmeans_tag
-// OR
-// split_clusters_tag and redistribute_kmeans_tag - then redistribute will probably slightly different interface
-// or some other than "redistribute"
-
-// 1. for this algorithm one probably MUST USE NON-STATIC NODES with node_default_tag
-//    or the algorithm must be changed somehow - to not store additional nodes in the current node
-//    but return excessive element/elements container instead (possibly pushable_array<1> or std::vector)
-//    this would also cause building of smaller trees since +1 element in nodes wouldn't be needed in different redistributing algorithms
-// 2. it is probably possible to add e.g. 2 levels of tree in one insert
-
-// Edge case is that every node split generates M + 1 children, in parent containing M nodes
-// result is 2M + 1 nodes in parent on this level
-// On next level the same, next the same and so on.
-// We have Depth*M+1 nodes in the root
-// The tree may then gain some > 1 levels in one insert
-// split::apply() manages this but special attention is required
-
-// which algorithm should be used to choose current node in traversing while inserting?
-// some of the currently used ones or some using mean values as well?
-
-// TODO
-// 1. Zmienic troche algorytm zeby przekazywal nadmiarowe elementy do split
-//    i pobieral ze split nadmiarowe elementy rodzica
-//    W zaleznosci od algorytmu w rozny sposob - l/q/r* powinny zwracac np pushable_array<1>
-//    wtedy tez is_overerflow (z R* insert?) bedzie nieportrzebne
-//    Dla kmeans zapewne std::vector, jednak w wezlach nadal moglaby byc pushable_array
-// 2. Fajnie byloby tez uproscic te wszystkie parametry root,parent,index itd. Mozliwe ze okazalyby sie zbedne
-// 3. Sprawdzyc czasy wykonywania i zajetosc pamieci
-// 4. Pamietac o parametryzacji kontenera z nadmiarowymi elementami
-// PS. Z R* reinsertami moze byc masakra
-
-template <typename Value, typename Options, typename Translator, typename Box, typename Allocators>
-class split<Value, Options, Translator, Box, Allocators, split_kmeans_tag>
+// The k-means split divides the overflowing node into two clusters.
+//
+// NOTE: The generalization of this algorithm into K > 2 clusters would require
+// the parent to be able to store more than Max + 1 elements, i.e. the overflow
+// of M + 1 children in each of the nodes on the path to the root. This is not
+// possible with static nodes so K = 2 and one additional node is returned.
+
+template <typename MembersHolder>
+class split<MembersHolder, split_kmeans_tag>
 {
 protected:
-    typedef typename rtree::node<Value, typename Options::parameters_type, Box, Allocators, typename Options::node_tag>::type node;
-    typedef typename rtree::internal_node<Value, typename Options::parameters_type, Box, Allocators, typename Options::node_tag>::type internal_node;
-    typedef typename rtree::leaf<Value, typename Options::parameters_type, Box, Allocators, typename Options::node_tag>::type leaf;
+    typedef typename MembersHolder::parameters_type parameters_type;
+    typedef typename MembersHolder::box_type box_type;
+    typedef typename MembersHolder::translator_type translator_type;
+    typedef typename MembersHolder::allocators_type allocators_type;
+    typedef typename MembersHolder::size_type size_type;
 
-    typedef typename Options::parameters_type parameters_type;
+    typedef typename MembersHolder::node node;
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+
+    typedef typename MembersHolder::node_pointer node_pointer;
 
 public:
+    typedef index::detail::varray<
+        typename rtree::elements_type<internal_node>::type::value_type,
+        1
+    > nodes_container_type;
+
     template <typename Node>
-    static inline void apply(node* & root_node,
-                             size_t & leafs_level,
+    static inline void apply(nodes_container_type & additional_nodes,
                              Node & n,
-                             internal_node *parent_node,
-                             size_t current_child_index,
-                             Translator const& tr,
-                             Allocators & allocators)
+                             box_type & n_box,
+                             parameters_type const& parameters,
+                             translator_type const& translator,
+                             allocators_type & allocators)
     {
+        // create additional node, use auto destroyer for automatic destruction on exception
+        node_pointer n2_ptr = rtree::create_node<allocators_type, Node>::apply(allocators);                  // MAY THROW, STRONG (N: alloc)
+        // create reference to the newly created node
+        Node & n2 = rtree::get<Node>(*n2_ptr);
+
+        BOOST_TRY
+        {
+            box_type box2;
+            redistribute(n, n2, n_box, box2, parameters, translator, allocators);                           // MAY THROW (V, E: alloc, copy, copy)
+
+            // check numbers of elements
+            BOOST_GEOMETRY_INDEX_ASSERT(parameters.get_min_elements() <= rtree::elements(n).size() &&
+                rtree::elements(n).size() <= parameters.get_max_elements(),
+                "unexpected number of elements");
+            BOOST_GEOMETRY_INDEX_ASSERT(parameters.get_min_elements() <= rtree::elements(n2).size() &&
+                rtree::elements(n2).size() <= parameters.get_max_elements(),
+                "unexpected number of elements");
 
+            // return the list of newly created nodes (this algorithm returns one)
+            additional_nodes.push_back(rtree::make_ptr_pair(box2, n2_ptr));                                  // MAY THROW, STRONG (alloc, copy)
+        }
+        BOOST_CATCH(...)
+        {
+            // NOTE: This code is here to prevent leaving the rtree in a state
+            //  after an exception is thrown in which pushing new element could
+            //  result in assert or putting it outside the memory of node elements.
+            typename rtree::elements_type<Node>::type & elements = rtree::elements(n);
+            size_type const max_size = parameters.get_max_elements();
+            if (elements.size() > max_size)
+            {
+                rtree::destroy_element<MembersHolder>::apply(elements[max_size], allocators);
+                elements.pop_back();
+            }
+
+            rtree::visitors::destroy<MembersHolder>::apply(n2_ptr, allocators);
+
+            BOOST_RETHROW
+        }
+        BOOST_CATCH_END
+    }
+
+private:
+    template <typename Node>
+    static inline void redistribute(Node & n,
+                                    Node & second_node,
+                                    box_type & box1,
+                                    box_type & box2,
+                                    parameters_type const& parameters,
+                                    translator_type const& translator,
+                                    allocators_type & allocators)
+    {
+        typedef typename rtree::elements_type<Node>::type elements_type;
+        typedef typename elements_type::value_type element_type;
+
+        elements_type & elements1 = rtree::elements(n);
+        elements_type & elements2 = rtree::elements(second_node);
+
+        BOOST_GEOMETRY_INDEX_ASSERT(elements1.size() == parameters.get_max_elements() + 1, "unexpected elements number");
+        BOOST_GEOMETRY_INDEX_ASSERT(elements2.empty(), "second node's elements container should be empty");
+
+        typename index::detail::strategy_type<parameters_type>::type const&
+            strategy = index::detail::get_strategy(parameters);
+
+        // assign elements to clusters
+        std::vector<unsigned char> groups;
+        kmeans::cluster<box_type>(elements1, parameters.get_min_elements(),
+                                  translator, strategy, groups);                                            // MAY THROW, STRONG (alloc)
+
+        // copy original elements - use in-memory storage (std::allocator)
+        // TODO: move if noexcept
+        typedef typename rtree::container_from_elements_type<elements_type, element_type>::type
+            container_type;
+        container_type elements_copy(elements1.begin(), elements1.end());                                   // MAY THROW, STRONG (alloc, copy)
+
+        elements1.clear();
+
+        BOOST_TRY
+        {
+            bool first1 = true, first2 = true;
+            for ( size_t i = 0 ; i < elements_copy.size() ; ++i )
+            {
+                element_type const& elem = elements_copy[i];
+                if ( groups[i] == 0 )
+                {
+                    elements1.push_back(elem);                                                              // MAY THROW, STRONG (copy)
+                    expand_or_init(box1, first1, rtree::element_indexable(elem, translator), strategy);
+                }
+                else
+                {
+                    elements2.push_back(elem);                                                              // MAY THROW, STRONG (alloc, copy)
+                    expand_or_init(box2, first2, rtree::element_indexable(elem, translator), strategy);
+                }
+            }
+        }
+        BOOST_CATCH(...)
+        {
+            elements1.clear();
+            elements2.clear();
+
+            rtree::destroy_elements<MembersHolder>::apply(elements_copy, allocators);
+
+            BOOST_RETHROW                                                                                     // RETHROW, BASIC
+        }
+        BOOST_CATCH_END
+    }
+
+    template <typename Indexable, typename Strategy>
+    static inline void expand_or_init(box_type & box, bool & first,
+                                      Indexable const& indexable,
+                                      Strategy const& strategy)
+    {
+        if ( first )
+        {
+            index::detail::bounds(indexable, box, strategy);
+            first = false;
+        }
+        else
+        {
+            index::detail::expand(box, indexable, strategy);
+        }
     }
 };
 
@@ -0,0 +1,175 @@
+// Boost.Geometry Index
+//
+// R-tree repacking of the subtrees of overlapping nodes
+//
+// Copyright (c) 2011-2020 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_OPTIMIZE_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_OPTIMIZE_HPP
+
+#include <vector>
+
+#include <boost/geometry/index/detail/algorithms/content.hpp>
+#include <boost/geometry/index/detail/algorithms/intersection_content.hpp>
+#include <boost/geometry/index/detail/rtree/pack_create.hpp>
+
+namespace boost { namespace geometry { namespace index { namespace detail { namespace rtree {
+
+// The tree is traversed from the root and the subtrees whose children overlap
+// more than the threshold are packed again. The overlap of the children of a node
+// is the sum of contents of pairwise intersections of their boxes divided by the
+// sum of their contents. The values of the subtree are packed into a new subtree
+// and the elements of the root of the new subtree are swapped with the elements of
+// the old one, so the node and its box stored in the parent are not changed.
+// The subtree is replaced only if the new one has the same height, the root of
+// the new one has at least min elements and its children overlap less.
+// Otherwise the children of the node are checked. The root of the tree and the
+// leafs are never repacked.
+
+template <typename MembersHolder>
+class optimize
+{
+    typedef typename MembersHolder::value_type value_type;
+    typedef typename MembersHolder::box_type box_type;
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+
+    typedef typename MembersHolder::node_pointer node_pointer;
+    typedef typename MembersHolder::size_type size_type;
+    typedef typename MembersHolder::parameters_type parameters_type;
+    typedef typename MembersHolder::translator_type translator_type;
+    typedef typename MembersHolder::allocators_type allocators_type;
+
+    typedef typename rtree::elements_type<internal_node>::type internal_elements;
+    typedef typename rtree::elements_type<leaf>::type leaf_elements;
+
+    typedef typename index::detail::default_content_result<box_type>::type content_type;
+
+    typedef rtree::subtree_destroyer<MembersHolder> subtree_destroyer;
+
+public:
+    inline optimize(double overlap_threshold,
+                    parameters_type const& parameters,
+                    translator_type const& translator,
+                    allocators_type & allocators)
+        : m_overlap_threshold(overlap_threshold)
+        , m_parameters(parameters)
+        , m_translator(translator)
+        , m_allocators(allocators)
+    {}
+
+    // Returns the number of repacked subtrees
+    inline size_type apply(node_pointer root, size_type leafs_level)
+    {
+        if ( ! root || leafs_level == 0 )
+            return 0;
+
+        return optimize_children(rtree::get<internal_node>(*root), 0, leafs_level);                 // MAY THROW (V, E: alloc, copy, N: alloc)
+    }
+
+private:
+    size_type optimize_children(internal_node & n, size_type level, size_type leafs_level)
+    {
+        size_type result = 0;
+
+        // the leafs aren't repacked
+        if ( level + 1 == leafs_level )
+            return result;
+
+        internal_elements & elements = rtree::elements(n);
+        for ( typename internal_elements::iterator it = elements.begin() ; it != elements.end() ; ++it )
+        {
+            internal_node & child = rtree::get<internal_node>(*it->second);
+            if ( m_overlap_threshold < overlap_ratio(rtree::elements(child))
+              && repack(child, leafs_level - level - 1) )                                           // MAY THROW (V, E: alloc, copy, N: alloc)
+            {
+                ++result;
+            }
+            else
+            {
+                result += optimize_children(child, level + 1, leafs_level);                         // MAY THROW (V, E: alloc, copy, N: alloc)
+            }
+        }
+
+        return result;
+    }
+
+    // The node is not modified if an exception is thrown
+    bool repack(internal_node & n, size_type height)
+    {
+        std::vector<value_type> values;
+        gather_values(n, height, values);                                                           // MAY THROW (V: alloc, copy)
+
+        size_type packed_count = 0, packed_leafs_level = 0;
+        subtree_destroyer packed_root(
+            pack<MembersHolder>::apply(values.begin(), values.end(), packed_count, packed_leafs_level,
+                                       m_parameters, m_translator, m_allocators),                   // MAY THROW (V, E: alloc, copy, N: alloc)
+            m_allocators);
+
+        if ( packed_leafs_level != height )
+            return false;
+
+        internal_elements & packed_elements = rtree::elements(rtree::get<internal_node>(*packed_root));
+        internal_elements & elements = rtree::elements(n);
+        if ( packed_elements.size() < m_parameters.get_min_elements()
+          || overlap_ratio(elements) <= overlap_ratio(packed_elements) )
+        {
+            return false;
+        }
+
+        // the old subtree is destroyed with the root of the new one
+        elements.swap(packed_elements);
+
+        return true;
+    }
+
+    void gather_values(internal_node const& n, size_type height, std::vector<value_type> & values)
+    {
+        internal_elements const& elements = rtree::elements(n);
+        for ( typename internal_elements::const_iterator it = elements.begin() ; it != elements.end() ; ++it )
+        {
+            if ( height == 1 )
+            {
+                leaf_elements const& leaf_values = rtree::elements(rtree::get<leaf>(*it->second));
+                values.insert(values.end(), leaf_values.begin(), leaf_values.end());                // MAY THROW (V: alloc, copy)
+            }
+            else
+            {
+                gather_values(rtree::get<internal_node>(*it->second), height - 1, values);          // MAY THROW (V: alloc, copy)
+            }
+        }
+    }
+
+    content_type overlap_ratio(internal_elements const& elements) const
+    {
+        content_type overlap = 0;
+        content_type sum = 0;
+        for ( typename internal_elements::const_iterator it1 = elements.begin() ; it1 != elements.end() ; ++it1 )
+        {
+            sum += index::detail::content(it1->first);
+            for ( typename internal_elements::const_iterator it2 = it1 + 1 ; it2 != elements.end() ; ++it2 )
+            {
+                overlap += index::detail::intersection_content(it1->first, it2->first,
+                                                               index::detail::get_strategy(m_parameters));
+            }
+        }
+
+        if ( sum <= 0 )
+            return 0;
+
+        return overlap / sum;
+    }
+
+    double m_overlap_threshold;
+    parameters_type const& m_parameters;
+    translator_type const& m_translator;
+    allocators_type & m_allocators;
+};
+
+}}}}} // namespace boost::geometry::index::detail::rtree
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_RTREE_OPTIMIZE_HPP
@@ -0,0 +1,529 @@
+// Boost.Geometry Index
+//
+// R-tree bottom-up packing - STR, Hilbert and Z-order loading
+//
+// Copyright (c) 2011-2017 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_PACK_BOTTOM_UP_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_PACK_BOTTOM_UP_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include <boost/geometry/index/parameters.hpp>
+#include <boost/geometry/index/detail/rtree/pack_create.hpp>
+
+namespace boost { namespace geometry { namespace index { namespace detail { namespace rtree {
+
+namespace pack_utils {
+
+// Elements of a level are divided into count = ceil(elements / max) tiles
+// of sizes differing at most by 1. Since 2 * min <= max + 1 each tile
+// contains at least min elements if there is more than one tile.
+template <typename SizeType>
+struct level_tiles
+{
+    level_tiles(SizeType elements_count, SizeType max_elements)
+        : count((elements_count + max_elements - 1) / max_elements)
+        , base(elements_count / count)
+        , rem(elements_count % count)
+    {}
+
+    // the index of the first element of the tile
+    SizeType offset(SizeType tile) const
+    {
+        return tile * base + (std::min)(tile, rem);
+    }
+
+    SizeType count;
+    SizeType base;
+    SizeType rem;
+};
+
+// Sort-Tile-Recursive
+// Elements are sorted by the I-th coordinate and divided into
+// ceil(tiles^(1/(Dimension-I))) slices containing whole tiles.
+// Each slice is then sorted by the next coordinate.
+template <std::size_t I, std::size_t Dimension, bool Last = (I + 1 == Dimension)>
+struct str_sort_tiles
+{
+    template <typename EIt, typename Tiles, typename SizeType>
+    static inline void apply(EIt first, SizeType first_tile, SizeType last_tile, Tiles const& tiles)
+    {
+        std::sort(first + tiles.offset(first_tile), first + tiles.offset(last_tile),
+                  point_entries_comparer<I>());
+
+        SizeType const tiles_count = last_tile - first_tile;
+        double const remaining_dims = static_cast<double>(Dimension - I);
+        SizeType slices_count = static_cast<SizeType>(
+            std::pow(static_cast<double>(tiles_count), 1.0 / remaining_dims));
+        if ( slices_count < 1 )
+            slices_count = 1;
+        while ( std::pow(static_cast<double>(slices_count), remaining_dims) < static_cast<double>(tiles_count) )
+            ++slices_count;
+
+        SizeType const slice_tiles = (tiles_count + slices_count - 1) / slices_count;
+        for ( SizeType t = first_tile ; t < last_tile ; t += slice_tiles )
+        {
+            str_sort_tiles<I + 1, Dimension>::apply(first, t, (std::min)(t + slice_tiles, last_tile), tiles);
+        }
+    }
+};
+
+template <std::size_t I, std::size_t Dimension>
+struct str_sort_tiles<I, Dimension, true>
+{
+    template <typename EIt, typename Tiles, typename SizeType>
+    static inline void apply(EIt first, SizeType first_tile, SizeType last_tile, Tiles const& tiles)
+    {
+        std::sort(first + tiles.offset(first_tile), first + tiles.offset(last_tile),
+                  point_entries_comparer<I>());
+    }
+};
+
+template <std::size_t I, std::size_t Dimension>
+struct point_to_doubles
+{
+    template <typename Point>
+    static inline void apply(Point const& pt, double * coords)
+    {
+        coords[I] = static_cast<double>(geometry::get<I>(pt));
+        point_to_doubles<I + 1, Dimension>::apply(pt, coords);
+    }
+};
+
+template <std::size_t Dimension>
+struct point_to_doubles<Dimension, Dimension>
+{
+    template <typename Point>
+    static inline void apply(Point const& , double * ) {}
+};
+
+// Interleaves the bits of coordinates starting from the most significant ones
+inline boost::uint64_t interleave_bits(boost::uint32_t const* coords, std::size_t dimension, std::size_t bits)
+{
+    boost::uint64_t key = 0;
+    for ( std::size_t b = bits ; b > 0 ; --b )
+        for ( std::size_t i = 0 ; i < dimension ; ++i )
+            key = (key << 1) | ((coords[i] >> (b - 1)) & 1u);
+    return key;
+}
+
+// Transforms the coordinates into the transposed Hilbert index
+// J. Skilling, Programming the Hilbert curve, AIP Conf. Proc. 707, 2004
+inline void hilbert_transpose(boost::uint32_t * x, std::size_t dimension, std::size_t bits)
+{
+    boost::uint32_t const m = boost::uint32_t(1) << (bits - 1);
+
+    // inverse undo
+    for ( boost::uint32_t q = m ; q > 1 ; q >>= 1 )
+    {
+        boost::uint32_t const p = q - 1;
+        for ( std::size_t i = 0 ; i < dimension ; ++i )
+        {
+            if ( x[i] & q )
+            {
+                x[0] ^= p; // invert
+            }
+            else
+            {
+                boost::uint32_t const t = (x[0] ^ x[i]) & p; // exchange
+                x[0] ^= t;
+                x[i] ^= t;
+            }
+        }
+    }
+
+    // Gray encode
+    for ( std::size_t i = 1 ; i < dimension ; ++i )
+        x[i] ^= x[i - 1];
+    boost::uint32_t t = 0;
+    for ( boost::uint32_t q = m ; q > 1 ; q >>= 1 )
+        if ( x[dimension - 1] & q )
+            t ^= q - 1;
+    for ( std::size_t i = 0 ; i < dimension ; ++i )
+        x[i] ^= t;
+}
+
+template <typename PackingTag>
+struct curve_key;
+
+template <>
+struct curve_key<index::packing::z_order>
+{
+    static inline boost::uint64_t apply(boost::uint32_t * coords, std::size_t dimension, std::size_t bits)
+    {
+        return interleave_bits(coords, dimension, bits);
+    }
+};
+
+template <>
+struct curve_key<index::packing::hilbert>
+{
+    static inline boost::uint64_t apply(boost::uint32_t * coords, std::size_t dimension, std::size_t bits)
+    {
+        hilbert_transpose(coords, dimension, bits);
+        return interleave_bits(coords, dimension, bits);
+    }
+};
+
+// Sorts the elements by the position of their centroids on the space-filling curve.
+// Centroids are mapped into the grid of 2^bits cells in each dimension
+// covering the bounding box of all centroids.
+template <typename PackingTag, std::size_t Dimension>
+struct curve_sort
+{
+    static const std::size_t bits = 64 / Dimension < 32 ? 64 / Dimension : 32;
+    BOOST_STATIC_ASSERT(0 < bits);
+
+    template <typename Entries>
+    static inline void apply(Entries & entries)
+    {
+        typedef typename Entries::size_type size_type;
+        typedef std::pair<boost::uint64_t, size_type> key_type;
+
+        size_type const count = entries.size();
+
+        double mins[Dimension];
+        double maxs[Dimension];
+        double coords[Dimension];
+        for ( size_type i = 0 ; i < count ; ++i )
+        {
+            point_to_doubles<0, Dimension>::apply(entries[i].first, coords);
+            for ( std::size_t d = 0 ; d < Dimension ; ++d )
+            {
+                if ( i == 0 || coords[d] < mins[d] )
+                    mins[d] = coords[d];
+                if ( i == 0 || maxs[d] < coords[d] )
+                    maxs[d] = coords[d];
+            }
+        }
+
+        double const cells = static_cast<double>((boost::uint64_t(1) << bits) - 1);
+        double scales[Dimension];
+        for ( std::size_t d = 0 ; d < Dimension ; ++d )
+            scales[d] = mins[d] < maxs[d] ? cells / (maxs[d] - mins[d]) : 0;
+
+        std::vector<key_type> keys;
+        keys.reserve(count);                                                                        // MAY THROW (A)
+        boost::uint32_t cell_coords[Dimension];
+        for ( size_type i = 0 ; i < count ; ++i )
+        {
+            point_to_doubles<0, Dimension>::apply(entries[i].first, coords);
+            for ( std::size_t d = 0 ; d < Dimension ; ++d )
+            {
+                double const c = (coords[d] - mins[d]) * scales[d];
+                cell_coords[d] = c <= 0 ? 0
+                               : c >= cells ? static_cast<boost::uint32_t>(cells)
+                               : static_cast<boost::uint32_t>(c);
+            }
+            keys.push_back(key_type(curve_key<PackingTag>::apply(cell_coords, Dimension, bits), i));
+        }
+
+        // indexes of elements are unique so the resulting order is deterministic
+        std::sort(keys.begin(), keys.end());
+
+        Entries sorted;
+        sorted.reserve(count);                                                                      // MAY THROW (A)
+        for ( size_type i = 0 ; i < count ; ++i )
+            sorted.push_back(entries[keys[i].second]);
+        entries.swap(sorted);
+    }
+};
+
+template <typename PackingTag, std::size_t Dimension>
+struct sort_tiles
+{
+    template <typename Entries, typename Tiles>
+    static inline void apply(Entries & entries, Tiles const& )
+    {
+        curve_sort<PackingTag, Dimension>::apply(entries);
+    }
+};
+
+template <std::size_t Dimension>
+struct sort_tiles<index::packing::str, Dimension>
+{
+    template <typename Entries, typename Tiles>
+    static inline void apply(Entries & entries, Tiles const& tiles)
+    {
+        typedef typename Entries::size_type size_type;
+        str_sort_tiles<0, Dimension>::apply(entries.begin(), size_type(0), tiles.count, tiles);
+    }
+};
+
+} // namespace pack_utils
+
+// Bottom-up packing algorithms
+//
+// The centroids of all values are sorted according to the packing policy
+// (STR, Hilbert or Z-order curve) and consecutive values are stored in leafs.
+// Then the same is done for the centroids of the bounding boxes of the created
+// nodes until a single node, the root, is created. Nodes are filled as tightly
+// as possible, the numbers of elements in nodes of a level differ at most by 1
+// so they're always between Min and Max.
+//
+// The STR tiles are aligned to the node boundaries so each node contains
+// the elements of exactly one tile.
+
+template <typename MembersHolder, typename PackingTag>
+class pack_bottom_up
+{
+    typedef typename MembersHolder::node node;
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+
+    typedef typename MembersHolder::node_pointer node_pointer;
+    typedef typename MembersHolder::size_type size_type;
+    typedef typename MembersHolder::parameters_type parameters_type;
+    typedef typename MembersHolder::translator_type translator_type;
+    typedef typename MembersHolder::allocators_type allocators_type;
+
+    typedef typename MembersHolder::box_type box_type;
+    typedef typename geometry::point_type<box_type>::type point_type;
+    typedef typename detail::strategy_type<parameters_type>::type strategy_type;
+    static const std::size_t dimension = geometry::dimension<point_type>::value;
+
+    typedef typename rtree::elements_type<internal_node>::type internal_elements;
+    typedef typename internal_elements::value_type internal_element;
+
+    typedef std::pair<point_type, internal_element> level_entry;
+    typedef std::vector<level_entry> level_entries;
+
+    typedef pack_utils::level_tiles<size_type> tiles_type;
+    typedef pack_utils::sort_tiles<PackingTag, dimension> sort_tiles;
+    typedef pack_utils::expandable_box<box_type, strategy_type> expandable_box;
+
+    typedef rtree::subtree_destroyer<MembersHolder> subtree_destroyer;
+
+public:
+    // Arbitrary iterators
+    template <typename InIt> inline static
+    node_pointer apply(InIt first, InIt last,
+                       size_type & values_count,
+                       size_type & leafs_level,
+                       parameters_type const& parameters,
+                       translator_type const& translator,
+                       allocators_type & allocators)
+    {
+        typedef typename std::iterator_traits<InIt>::difference_type diff_type;
+
+        diff_type diff = std::distance(first, last);
+        if ( diff <= 0 )
+            return node_pointer(0);
+
+        typedef std::pair<point_type, InIt> entry_type;
+        std::vector<entry_type> entries;
+
+        values_count = static_cast<size_type>(diff);
+        entries.reserve(values_count);
+
+        for ( ; first != last ; ++first )
+        {
+            // NOTE: see pack::apply()
+            typename std::iterator_traits<InIt>::reference in_ref = *first;
+            typename translator_type::result_type indexable = translator(in_ref);
+
+            BOOST_GEOMETRY_INDEX_ASSERT(detail::is_valid(indexable), "Indexable is invalid");
+
+            point_type pt;
+            geometry::centroid(indexable, pt);
+            entries.push_back(std::make_pair(pt, first));
+        }
+
+        size_type const max_elements = parameters.get_max_elements();
+
+        level_entries level;
+        create_leafs(entries, level, max_elements, parameters, translator, allocators);             // MAY THROW (A,C)
+        leafs_level = 0;
+
+        while ( 1 < level.size() )
+        {
+            create_internal_nodes(level, max_elements, parameters, allocators);                     // MAY THROW (A)
+            ++leafs_level;
+        }
+
+        return level.front().second.second;
+    }
+
+private:
+    template <typename Entries> inline static
+    void create_leafs(Entries & entries,
+                      level_entries & level,
+                      size_type max_elements,
+                      parameters_type const& parameters,
+                      translator_type const& translator,
+                      allocators_type & allocators)
+    {
+        tiles_type tiles(entries.size(), max_elements);
+        sort_tiles::apply(entries, tiles);                                                          // MAY THROW (A)
+
+        level.reserve(tiles.count);                                                                 // MAY THROW (A)
+
+        BOOST_TRY
+        {
+            for ( size_type t = 0 ; t < tiles.count ; ++t )
+            {
+                internal_element el = create_leaf(entries.begin() + tiles.offset(t),
+                                                  entries.begin() + tiles.offset(t + 1),
+                                                  parameters, translator, allocators);              // MAY THROW (A,C)
+                level.push_back(level_entry(centroid(el.first), el));
+            }
+        }
+        BOOST_CATCH(...)
+        {
+            destroy(level.begin(), level.end(), allocators);
+            level.clear();
+            BOOST_RETHROW                                                                           // RETHROW
+        }
+        BOOST_CATCH_END
+    }
+
+    inline static
+    void create_internal_nodes(level_entries & level,
+                               size_type max_elements,
+                               parameters_type const& parameters,
+                               allocators_type & allocators)
+    {
+        tiles_type tiles(level.size(), max_elements);
+        level_entries next_level;
+
+        // the subtrees are owned by the level until they're stored in new nodes,
+        // then the pointers stored in the level are set to 0
+        typename level_entries::iterator it = level.begin();
+        BOOST_TRY
+        {
+            sort_tiles::apply(level, tiles);                                                        // MAY THROW (A)
+            it = level.begin();
+
+            next_level.reserve(tiles.count);                                                        // MAY THROW (A)
+
+            for ( size_type t = 0 ; t < tiles.count ; ++t )
+            {
+                typename level_entries::iterator last = level.begin() + tiles.offset(t + 1);
+                internal_element el = create_internal_node(it, last, parameters, allocators);       // MAY THROW (A)
+                it = last;
+                next_level.push_back(level_entry(centroid(el.first), el));
+            }
+        }
+        BOOST_CATCH(...)
+        {
+            destroy(it, level.end(), allocators);
+            destroy(next_level.begin(), next_level.end(), allocators);
+            level.clear();
+            BOOST_RETHROW                                                                           // RETHROW
+        }
+        BOOST_CATCH_END
+
+        level.swap(next_level);
+    }
+
+    template <typename EIt> inline static
+    internal_element create_leaf(EIt first, EIt last,
+                                 parameters_type const& parameters,
+                                 translator_type const& translator,
+                                 allocators_type & allocators)
+    {
+        // create new leaf node
+        node_pointer n = rtree::create_node<allocators_type, leaf>::apply(allocators);               // MAY THROW (A)
+        subtree_destroyer auto_remover(n, allocators);
+        leaf & l = rtree::get<leaf>(*n);
+
+        // reserve space for values
+        rtree::elements(l).reserve(static_cast<size_type>(std::distance(first, last)));             // MAY THROW (A)
+
+        // calculate values box and copy values
+        // NOTE: see pack::per_level()
+        expandable_box elements_box(translator(*(first->second)), detail::get_strategy(parameters));
+        rtree::elements(l).push_back(*(first->second));                                             // MAY THROW (A?,C)
+        for ( ++first ; first != last ; ++first )
+        {
+            elements_box.expand(translator(*(first->second)));
+            rtree::elements(l).push_back(*(first->second));                                         // MAY THROW (A?,C)
+        }
+
+#ifdef BOOST_GEOMETRY_INDEX_EXPERIMENTAL_ENLARGE_BY_EPSILON
+        // Enlarge bounds of a leaf node, see pack::per_level()
+        if ( BOOST_GEOMETRY_CONDITION((
+                ! index::detail::is_bounding_geometry
+                    <
+                        typename indexable_type<translator_type>::type
+                    >::value )) )
+        {
+            elements_box.expand_by_epsilon();
+        }
+#endif
+
+        auto_remover.release();
+        return internal_element(elements_box.get(), n);
+    }
+
+    template <typename EIt> inline static
+    internal_element create_internal_node(EIt first, EIt last,
+                                          parameters_type const& parameters,
+                                          allocators_type & allocators)
+    {
+        // create new internal node
+        node_pointer n = rtree::create_node<allocators_type, internal_node>::apply(allocators);      // MAY THROW (A)
+        subtree_destroyer auto_remover(n, allocators);
+        internal_node & in = rtree::get<internal_node>(*n);
+
+        // reserve space for the children
+        rtree::elements(in).reserve(static_cast<size_type>(std::distance(first, last)));            // MAY THROW (A)
+
+        expandable_box elements_box(first->second.first, detail::get_strategy(parameters));
+        for ( ; first != last ; ++first )
+        {
+            elements_box.expand(first->second.first);
+            // this container should have memory allocated, reserve() called above
+            rtree::elements(in).push_back(first->second);                                           // MAY THROW (A?,C) - however in normal conditions shouldn't
+            // the subtree is owned by the new node now
+            first->second.second = 0;
+        }
+
+        auto_remover.release();
+        return internal_element(elements_box.get(), n);
+    }
+
+    inline static point_type centroid(box_type const& box)
+    {
+        point_type pt;
+        geometry::centroid(box, pt);
+        return pt;
+    }
+
+    template <typename EIt> inline static
+    void destroy(EIt first, EIt last, allocators_type & allocators)
+    {
+        for ( ; first != last ; ++first )
+        {
+            subtree_destroyer dummy(first->second.second, allocators);
+            first->second.second = 0;
+        }
+    }
+};
+
+// Selects the packing algorithm corresponding to the packing tag
+template <typename MembersHolder, typename PackingTag>
+struct packing_algorithm
+{
+    typedef pack_bottom_up<MembersHolder, PackingTag> type;
+};
+
+template <typename MembersHolder>
+struct packing_algorithm<MembersHolder, index::packing::top_down>
+{
+    typedef pack<MembersHolder> type;
+};
+
+}}}}} // namespace boost::geometry::index::detail::rtree
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_RTREE_PACK_BOTTOM_UP_HPP
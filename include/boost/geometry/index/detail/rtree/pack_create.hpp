@@ -15,11 +15,14 @@
 #ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_PACK_CREATE_HPP
 #define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_PACK_CREATE_HPP
 
+#include <vector>
+
 #include <boost/core/ignore_unused.hpp>
 
 #include <boost/geometry/algorithms/expand.hpp>
 #include <boost/geometry/index/detail/algorithms/bounds.hpp>
 #include <boost/geometry/index/detail/algorithms/nth_element.hpp>
+#include <boost/geometry/index/detail/parallel.hpp>
 #include <boost/geometry/index/detail/rtree/node/subtree_destroyer.hpp>
 
 #include <boost/geometry/algorithms/detail/expand_by_epsilon.hpp>
@@ -98,6 +101,55 @@ struct nth_element_and_half_boxes<Dimension, Dimension>
     static inline void apply(EIt , EIt , EIt , Box const& , Box & , Box & , std::size_t ) {}
 };
 
+template <typename BoxType, typename Strategy>
+class expandable_box
+{
+public:
+    explicit expandable_box(Strategy const& strategy)
+        : m_strategy(strategy), m_initialized(false)
+    {}
+
+    template <typename Indexable>
+    explicit expandable_box(Indexable const& indexable, Strategy const& strategy)
+        : m_strategy(strategy), m_initialized(true)
+    {
+        detail::bounds(indexable, m_box, m_strategy);
+    }
+
+    template <typename Indexable>
+    void expand(Indexable const& indexable)
+    {
+        if ( !m_initialized )
+        {
+            // it's guaranteed that the Box will be initialized
+            // only for Points, Boxes and Segments but that's ok
+            // since only those Geometries can be stored
+            detail::bounds(indexable, m_box, m_strategy);
+            m_initialized = true;
+        }
+        else
+        {
+            detail::expand(m_box, indexable, m_strategy);
+        }
+    }
+
+    void expand_by_epsilon()
+    {
+        geometry::detail::expand_by_epsilon(m_box);
+    }
+
+    BoxType const& get() const
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(m_initialized, "uninitialized envelope accessed");
+        return m_box;
+    }
+
+private:
+    BoxType m_box;
+    Strategy m_strategy;
+    bool m_initialized;
+};
+
 } // namespace pack_utils
 
 // STR leafs number are calculated as rcount/max
@@ -126,6 +178,12 @@ struct nth_element_and_half_boxes<Dimension, Dimension>
 // L1          125               52
 // L2  25  25  25  25  25   25  17    10
 // L3  5x5 5x5 5x5 5x5 5x5  5x5 3x5+2 2x5
+//
+// The algorithm may be run in parallel. After the range of elements is divided
+// into two halves they're processed independently, the right half in a separate
+// thread. Subtrees created for the right half are stored in a temporary container
+// and appended after the subtrees of the left half so the resulting tree is
+// exactly the same as the one created by the serial algorithm.
 
 template <typename MembersHolder>
 class pack
@@ -157,6 +215,9 @@ class pack
 
     typedef rtree::subtree_destroyer<MembersHolder> subtree_destroyer;
 
+    // The minimum number of elements for which a new thread is created
+    static const size_type parallel_threshold = 4096;
+
 public:
     // Arbitrary iterators
     template <typename InIt> inline static
@@ -165,7 +226,8 @@ public:
                        size_type & leafs_level,
                        parameters_type const& parameters,
                        translator_type const& translator,
-                       allocators_type & allocators)
+                       allocators_type & allocators,
+                       size_type threads_count = 1)
     {
         typedef typename std::iterator_traits<InIt>::difference_type diff_type;
             
@@ -179,7 +241,7 @@ public:
         values_count = static_cast<size_type>(diff);
         entries.reserve(values_count);
         
-        expandable_box<box_type, strategy_type> hint_box(detail::get_strategy(parameters));
+        pack_utils::expandable_box<box_type, strategy_type> hint_box(detail::get_strategy(parameters));
         for ( ; first != last ; ++first )
         {
             // NOTE: support for iterators not returning true references adapted
@@ -202,61 +264,12 @@ public:
 
         subtree_elements_counts subtree_counts = calculate_subtree_elements_counts(values_count, parameters, leafs_level);
         internal_element el = per_level(entries.begin(), entries.end(), hint_box.get(), values_count, subtree_counts,
-                                        parameters, translator, allocators);
+                                        parameters, translator, allocators, threads_count);
 
         return el.second;
     }
 
 private:
-    template <typename BoxType, typename Strategy>
-    class expandable_box
-    {
-    public:
-        explicit expandable_box(Strategy const& strategy)
-            : m_strategy(strategy), m_initialized(false)
-        {}
-
-        template <typename Indexable>
-        explicit expandable_box(Indexable const& indexable, Strategy const& strategy)
-            : m_strategy(strategy), m_initialized(true)
-        {
-            detail::bounds(indexable, m_box, m_strategy);
-        }
-
-        template <typename Indexable>
-        void expand(Indexable const& indexable)
-        {
-            if ( !m_initialized )
-            {
-                // it's guaranteed that the Box will be initialized
-                // only for Points, Boxes and Segments but that's ok
-                // since only those Geometries can be stored
-                detail::bounds(indexable, m_box, m_strategy);
-                m_initialized = true;
-            }
-            else
-            {
-                detail::expand(m_box, indexable, m_strategy);
-            }
-        }
-
-        void expand_by_epsilon()
-        {
-            geometry::detail::expand_by_epsilon(m_box);
-        }
-
-        BoxType const& get() const
-        {
-            BOOST_GEOMETRY_INDEX_ASSERT(m_initialized, "uninitialized envelope accessed");
-            return m_box;
-        }
-
-    private:
-        BoxType m_box;
-        Strategy m_strategy;
-        bool m_initialized;
-    };
-
     struct subtree_elements_counts
     {
         subtree_elements_counts(size_type ma, size_type mi) : maxc(ma), minc(mi) {}
@@ -271,7 +284,8 @@ private:
                                subtree_elements_counts const& subtree_counts,
                                parameters_type const& parameters,
                                translator_type const& translator,
-                               allocators_type & allocators)
+                               allocators_type & allocators,
+                               size_type threads_count)
     {
         BOOST_GEOMETRY_INDEX_ASSERT(0 < std::distance(first, last) && static_cast<size_type>(std::distance(first, last)) == values_count,
                                     "unexpected parameters");
@@ -293,7 +307,7 @@ private:
 
             // calculate values box and copy values
             //   initialize the box explicitly to avoid GCC-4.4 uninitialized variable warnings with O2
-            expandable_box<box_type, strategy_type> elements_box(translator(*(first->second)),
+            pack_utils::expandable_box<box_type, strategy_type> elements_box(translator(*(first->second)),
                                                                  detail::get_strategy(parameters));
             rtree::elements(l).push_back(*(first->second));                                                 // MAY THROW (A?,C)
             for ( ++first ; first != last ; ++first )
@@ -340,27 +354,28 @@ private:
         size_type nodes_count = calculate_nodes_count(values_count, subtree_counts);
         rtree::elements(in).reserve(nodes_count);                                                           // MAY THROW (A)
         // calculate values box and copy values
-        expandable_box<box_type, strategy_type> elements_box(detail::get_strategy(parameters));
+        pack_utils::expandable_box<box_type, strategy_type> elements_box(detail::get_strategy(parameters));
         
         per_level_packets(first, last, hint_box, values_count, subtree_counts, next_subtree_counts,
                           rtree::elements(in), elements_box,
-                          parameters, translator, allocators);
+                          parameters, translator, allocators, threads_count);
 
         auto_remover.release();
         return internal_element(elements_box.get(), n);
     }
 
-    template <typename EIt, typename ExpandableBox> inline static
+    template <typename EIt, typename Elements, typename ExpandableBox> inline static
     void per_level_packets(EIt first, EIt last,
                            box_type const& hint_box,
                            size_type values_count,
                            subtree_elements_counts const& subtree_counts,
                            subtree_elements_counts const& next_subtree_counts,
-                           internal_elements & elements,
+                           Elements & elements,
                            ExpandableBox & elements_box,
                            parameters_type const& parameters,
                            translator_type const& translator,
-                           allocators_type & allocators)
+                           allocators_type & allocators,
+                           size_type threads_count)
     {
         BOOST_GEOMETRY_INDEX_ASSERT(0 < std::distance(first, last) && static_cast<size_type>(std::distance(first, last)) == values_count,
                                     "unexpected parameters");
@@ -373,7 +388,7 @@ private:
         {
             // the end, move to the next level
             internal_element el = per_level(first, last, hint_box, values_count, next_subtree_counts,
-                                            parameters, translator, allocators);
+                                            parameters, translator, allocators, threads_count);
 
             // in case if push_back() do throw here
             // and even if this is not probable (previously reserved memory, nonthrowing pairs copy)
@@ -397,16 +412,98 @@ private:
         pack_utils::nth_element_and_half_boxes<0, dimension>
             ::apply(first, median, last, hint_box, left, right, greatest_dim_index);
         
+
+#ifdef BOOST_GEOMETRY_INDEX_DETAIL_HAS_THREADS
+        if ( 1 < threads_count && parallel_threshold <= values_count )
+        {
+            per_level_packets_parallel(first, median, last, left, right,
+                                       values_count, median_count, subtree_counts, next_subtree_counts,
+                                       elements, elements_box,
+                                       parameters, translator, allocators, threads_count);
+            return;
+        }
+#endif
+
         per_level_packets(first, median, left,
                           median_count, subtree_counts, next_subtree_counts,
                           elements, elements_box,
-                          parameters, translator, allocators);
+                          parameters, translator, allocators, threads_count);
         per_level_packets(median, last, right,
                           values_count - median_count, subtree_counts, next_subtree_counts,
                           elements, elements_box,
-                          parameters, translator, allocators);
+                          parameters, translator, allocators, threads_count);
     }
 
+#ifdef BOOST_GEOMETRY_INDEX_DETAIL_HAS_THREADS
+    template <typename EIt, typename Elements, typename ExpandableBox> inline static
+    void per_level_packets_parallel(EIt first, EIt median, EIt last,
+                                    box_type const& left, box_type const& right,
+                                    size_type values_count,
+                                    size_type median_count,
+                                    subtree_elements_counts const& subtree_counts,
+                                    subtree_elements_counts const& next_subtree_counts,
+                                    Elements & elements,
+                                    ExpandableBox & elements_box,
+                                    parameters_type const& parameters,
+                                    translator_type const& translator,
+                                    allocators_type & allocators,
+                                    size_type threads_count)
+    {
+        // the subtrees of the right half are created in a separate thread
+        // and stored in a temporary container
+        std::vector<internal_element> right_elements;
+        right_elements.reserve(calculate_nodes_count(values_count - median_count, subtree_counts));      // MAY THROW (A)
+        ExpandableBox right_elements_box(detail::get_strategy(parameters));
+
+        size_type const right_threads_count = threads_count / 2;
+        size_type const left_threads_count = threads_count - right_threads_count;
+
+        BOOST_TRY
+        {
+            detail::worker_thread right_thread([&]()
+            {
+                per_level_packets(median, last, right,
+                                  values_count - median_count, subtree_counts, next_subtree_counts,
+                                  right_elements, right_elements_box,
+                                  parameters, translator, allocators, right_threads_count);
+            });
+
+            per_level_packets(first, median, left,
+                              median_count, subtree_counts, next_subtree_counts,
+                              elements, elements_box,
+                              parameters, translator, allocators, left_threads_count);
+
+            right_thread.join_and_rethrow();
+        }
+        BOOST_CATCH(...)
+        {
+            // the thread is joined at this point, elements created for the left half
+            // are destroyed by the caller
+            rtree::destroy_elements<MembersHolder>::apply(right_elements, allocators);
+            BOOST_RETHROW
+        }
+        BOOST_CATCH_END
+
+        // append the subtrees in the same order as in the serial version
+        typename std::vector<internal_element>::iterator it = right_elements.begin();
+        BOOST_TRY
+        {
+            for ( ; it != right_elements.end() ; ++it )
+            {
+                // this container should have memory allocated, reserve() called outside
+                elements.push_back(*it);                                            // MAY THROW (A?,C) - however in normal conditions shouldn't
+                elements_box.expand(it->first);
+            }
+        }
+        BOOST_CATCH(...)
+        {
+            rtree::destroy_elements<MembersHolder>::apply(it, right_elements.end(), allocators);
+            BOOST_RETHROW
+        }
+        BOOST_CATCH_END
+    }
+#endif
+
     inline static
     subtree_elements_counts calculate_subtree_elements_counts(size_type elements_count, parameters_type const& parameters, size_type & leafs_level)
     {
@@ -0,0 +1,172 @@
+// Boost.Geometry Index
+//
+// R-tree bulk insertion of packed subtrees
+//
+// Copyright (c) 2011-2020 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_PACK_INSERT_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_PACK_INSERT_HPP
+
+#include <boost/geometry/index/detail/rtree/pack_create.hpp>
+#include <boost/geometry/index/detail/rtree/visitors/destroy.hpp>
+#include <boost/geometry/index/detail/rtree/visitors/insert.hpp>
+
+namespace boost { namespace geometry { namespace index { namespace detail { namespace rtree {
+
+// The values are packed into a new tree which is then merged with the existing one.
+// The leafs of the smaller tree are grafted into the higher one with the insert
+// visitor at the level above the leafs, so instead of one insertion per value
+// only one insertion per leaf is performed. The internal nodes of the smaller
+// tree are destroyed. If the smaller tree is only a leaf its values are inserted
+// one by one.
+//
+// The leafs of the packed tree are tight but they may overlap the leafs of the
+// existing tree more than the leafs created by inserting values one by one,
+// so for small batches the values should rather be inserted one by one.
+
+template <typename MembersHolder>
+class pack_insert
+{
+    typedef typename MembersHolder::value_type value_type;
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+
+    typedef typename MembersHolder::node_pointer node_pointer;
+    typedef typename MembersHolder::size_type size_type;
+    typedef typename MembersHolder::parameters_type parameters_type;
+    typedef typename MembersHolder::translator_type translator_type;
+    typedef typename MembersHolder::allocators_type allocators_type;
+
+    typedef typename rtree::elements_type<internal_node>::type internal_elements;
+    typedef typename internal_elements::value_type internal_element;
+    typedef typename rtree::elements_type<leaf>::type leaf_elements;
+
+    typedef rtree::subtree_destroyer<MembersHolder> subtree_destroyer;
+
+public:
+    // Returns true if it's faster to pack the values than to insert them one by one
+    static inline bool is_worth(size_type count, parameters_type const& parameters)
+    {
+        size_type const max_elems = parameters.get_max_elements();
+        return count >= max_elems * max_elems;
+    }
+
+    template <typename FwdIt> inline static
+    void apply(FwdIt first, FwdIt last,
+               node_pointer & root,
+               size_type & values_count,
+               size_type & leafs_level,
+               parameters_type const& parameters,
+               translator_type const& translator,
+               allocators_type & allocators)
+    {
+        size_type packed_count = 0, packed_leafs_level = 0;
+        subtree_destroyer packed_root(
+            pack<MembersHolder>::apply(first, last, packed_count, packed_leafs_level,
+                                       parameters, translator, allocators),                         // MAY THROW (V, E: alloc, copy, N: alloc)
+            allocators);
+
+        if ( packed_count == 0 )
+            return;
+
+        if ( ! root || values_count == 0 )
+        {
+            // the existing tree may contain an empty root
+            if ( root )
+                visitors::destroy<MembersHolder>::apply(root, allocators);
+
+            root = packed_root.get();
+            values_count = packed_count;
+            leafs_level = packed_leafs_level;
+            packed_root.release();
+            return;
+        }
+
+        // The leafs are grafted into the higher tree or the bigger one if the heights are equal
+        node_pointer source_root = packed_root.get();
+        size_type source_leafs_level = packed_leafs_level;
+        if ( leafs_level < packed_leafs_level
+          || ( leafs_level == packed_leafs_level && values_count < packed_count ) )
+        {
+            source_root = root;
+            source_leafs_level = leafs_level;
+            root = packed_root.get();
+            leafs_level = packed_leafs_level;
+        }
+        packed_root.release();
+
+        // NOTE: If an exception is thrown the values_count may be invalid.
+        values_count += packed_count;
+
+        graft_subtree(source_root, 0, source_leafs_level,
+                      root, leafs_level, parameters, translator, allocators);                       // MAY THROW (V, E: alloc, copy, N: alloc)
+    }
+
+private:
+    // Grafts the leafs of the subtree into the tree and destroys the internal nodes
+    // of the subtree. The subtree is destroyed if an exception is thrown.
+    static inline void graft_subtree(node_pointer n, size_type level, size_type source_leafs_level,
+                                     node_pointer & root, size_type & leafs_level,
+                                     parameters_type const& parameters,
+                                     translator_type const& translator,
+                                     allocators_type & allocators)
+    {
+        if ( level == source_leafs_level )
+        {
+            // the source tree is a leaf so its values are inserted one by one
+            subtree_destroyer leaf_ptr(n, allocators);
+            leaf_elements & values = rtree::elements(rtree::get<leaf>(*n));
+            for ( typename leaf_elements::const_iterator it = values.begin() ; it != values.end() ; ++it )
+            {
+                visitors::insert<value_type, MembersHolder>
+                    insert_v(root, leafs_level, *it, parameters, translator, allocators);
+                rtree::apply_visitor(insert_v, *root);                                              // MAY THROW (V, E: alloc, copy, N: alloc)
+            }
+            return;
+        }
+
+        internal_elements & elements = rtree::elements(rtree::get<internal_node>(*n));
+        bool const children_are_leafs = level + 1 == source_leafs_level;
+
+        typename internal_elements::iterator it = elements.begin();
+        BOOST_TRY
+        {
+            for ( ; it != elements.end() ; ++it )
+            {
+                if ( children_are_leafs )
+                {
+                    // After passing the element to the insert visitor it's managed by the tree
+                    visitors::insert<internal_element, MembersHolder>
+                        insert_v(root, leafs_level, *it, parameters, translator, allocators, 1);
+                    rtree::apply_visitor(insert_v, *root);                                          // MAY THROW (E: alloc, copy, N: alloc)
+                }
+                else
+                {
+                    graft_subtree(it->second, level + 1, source_leafs_level,
+                                  root, leafs_level, parameters, translator, allocators);           // MAY THROW (V, E: alloc, copy, N: alloc)
+                }
+                it->second = 0;
+            }
+        }
+        BOOST_CATCH(...)
+        {
+            ++it;
+            rtree::destroy_elements<MembersHolder>::apply(it, elements.end(), allocators);
+            elements.clear();
+            rtree::destroy_node<allocators_type, internal_node>::apply(allocators, n);
+            BOOST_RETHROW                                                                           // RETHROW
+        }
+        BOOST_CATCH_END
+
+        elements.clear();
+        rtree::destroy_node<allocators_type, internal_node>::apply(allocators, n);
+    }
+};
+
+}}}}} // namespace boost::geometry::index::detail::rtree
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_RTREE_PACK_INSERT_HPP
@@ -0,0 +1,82 @@
+// Boost.Geometry Index
+//
+// R-tree queries performed in parallel
+//
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_PARALLEL_QUERY_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_PARALLEL_QUERY_HPP
+
+#include <numeric>
+#include <vector>
+
+#include <boost/range/begin.hpp>
+#include <boost/range/size.hpp>
+
+#include <boost/geometry/index/detail/parallel.hpp>
+
+namespace boost { namespace geometry { namespace index { namespace detail { namespace rtree {
+
+// Performs the query of a given index, called concurrently for different indexes.
+// The state shared by the threads is not modified, each query writes
+// only to its own output iterator and counter.
+template <typename Rtree, typename PredicatesIterator, typename OutIterIterator>
+class parallel_query_task
+{
+    typedef typename Rtree::size_type size_type;
+
+public:
+    parallel_query_task(Rtree const& tree,
+                        PredicatesIterator predicates,
+                        OutIterIterator out_iters,
+                        std::vector<size_type> & found_counts)
+        : m_tree(tree)
+        , m_predicates(predicates)
+        , m_out_iters(out_iters)
+        , m_found_counts(found_counts)
+    {}
+
+    void operator()(std::size_t i) const
+    {
+        typename std::iterator_traits<OutIterIterator>::value_type out_it = m_out_iters[i];
+        m_found_counts[i] = m_tree.query(m_predicates[i], out_it);
+    }
+
+private:
+    Rtree const& m_tree;
+    PredicatesIterator m_predicates;
+    OutIterIterator m_out_iters;
+    std::vector<size_type> & m_found_counts;
+};
+
+template <typename Rtree, typename PredicatesRange, typename OutIterRange> inline
+typename Rtree::size_type parallel_query(Rtree const& tree,
+                                         PredicatesRange const& predicates,
+                                         OutIterRange const& out_per_query,
+                                         typename Rtree::size_type threads_count)
+{
+    typedef typename Rtree::size_type size_type;
+    typedef typename boost::range_iterator<PredicatesRange const>::type predicates_iterator;
+    typedef typename boost::range_iterator<OutIterRange const>::type out_iter_iterator;
+
+    std::size_t const count = static_cast<std::size_t>(boost::size(predicates));
+    BOOST_GEOMETRY_INDEX_ASSERT(count <= static_cast<std::size_t>(boost::size(out_per_query)),
+                                "the number of output iterators is smaller than the number of predicates");
+
+    std::vector<size_type> found_counts(count, 0);                                              // MAY THROW (A)
+
+    parallel_query_task<Rtree, predicates_iterator, out_iter_iterator>
+        task(tree, boost::begin(predicates), boost::begin(out_per_query), found_counts);
+
+    index::detail::parallel_for(count, threads_count, task);                                    // MAY THROW
+
+    return std::accumulate(found_counts.begin(), found_counts.end(), size_type(0));
+}
+
+}}}}} // namespace boost::geometry::index::detail::rtree
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_RTREE_PARALLEL_QUERY_HPP
@@ -15,7 +15,12 @@
 #ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_QUERY_ITERATORS_HPP
 #define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_QUERY_ITERATORS_HPP
 
-#include <boost/scoped_ptr.hpp>
+#include <new>
+
+#include <boost/mpl/bool.hpp>
+#include <boost/type_traits/aligned_storage.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/type_with_alignment.hpp>
 
 //#define BOOST_GEOMETRY_INDEX_DETAIL_QUERY_ITERATORS_USE_MOVE
 
@@ -62,17 +67,19 @@ struct end_query_iterator
     }
 };
 
-template <typename MembersHolder, typename Predicates>
+template <typename MembersHolder, typename Predicates, typename Statistics = no_query_statistics>
 class spatial_query_iterator
 {
     typedef typename MembersHolder::parameters_type parameters_type;
     typedef typename MembersHolder::translator_type translator_type;
     typedef typename MembersHolder::allocators_type allocators_type;
 
-    typedef visitors::spatial_query_incremental<MembersHolder, Predicates> visitor_type;
+    typedef visitors::spatial_query_incremental<MembersHolder, Predicates, Statistics> visitor_type;
     typedef typename visitor_type::node_pointer node_pointer;
 
 public:
+    typedef typename visitor_type::buffers_type buffers_type;
+
     typedef std::forward_iterator_tag iterator_category;
     typedef typename MembersHolder::value_type value_type;
     typedef typename allocators_type::const_reference reference;
@@ -92,6 +99,29 @@ public:
         m_visitor.initialize(root);
     }
 
+    // The iterator uses the memory of the buffers, the copies of the iterator don't
+    inline spatial_query_iterator(node_pointer root, parameters_type const& par, translator_type const& t, Predicates const& p,
+                  buffers_type * buffers)
+        : m_visitor(par, t, p, buffers)
+    {
+        if ( root )
+            m_visitor.initialize(root);
+    }
+
+    // Takes over the state of the traversal of the other iterator
+    inline spatial_query_iterator(spatial_query_iterator & o, move_state_tag)
+        : m_visitor(o.m_visitor, move_state_tag())
+    {}
+
+    // The iterator and its copies gather the statistics of the traversal
+    inline spatial_query_iterator(node_pointer root, parameters_type const& par, translator_type const& t, Predicates const& p,
+                  Statistics const& stats)
+        : m_visitor(par, t, p, 0, stats)
+    {
+        if ( root )
+            m_visitor.initialize(root);
+    }
+
     reference operator*() const
     {
         return m_visitor.dereference();
@@ -134,17 +164,20 @@ private:
     visitor_type m_visitor;
 };
 
-template <typename MembersHolder, typename Predicates, unsigned NearestPredicateIndex>
+template <typename MembersHolder, typename Predicates, unsigned NearestPredicateIndex,
+          typename Statistics = no_query_statistics>
 class distance_query_iterator
 {
     typedef typename MembersHolder::parameters_type parameters_type;
     typedef typename MembersHolder::translator_type translator_type;
     typedef typename MembersHolder::allocators_type allocators_type;
 
-    typedef visitors::distance_query_incremental<MembersHolder, Predicates, NearestPredicateIndex> visitor_type;
+    typedef visitors::distance_query_incremental<MembersHolder, Predicates, NearestPredicateIndex, Statistics> visitor_type;
     typedef typename visitor_type::node_pointer node_pointer;
 
 public:
+    typedef typename visitor_type::buffers_type buffers_type;
+
     typedef std::forward_iterator_tag iterator_category;
     typedef typename MembersHolder::value_type value_type;
     typedef typename allocators_type::const_reference reference;
@@ -164,6 +197,29 @@ public:
         m_visitor.initialize(root);
     }
 
+    // The iterator uses the memory of the buffers, the copies of the iterator don't
+    inline distance_query_iterator(node_pointer root, parameters_type const& par, translator_type const& t, Predicates const& p,
+                  buffers_type * buffers)
+        : m_visitor(par, t, p, buffers)
+    {
+        if ( root )
+            m_visitor.initialize(root);
+    }
+
+    // Takes over the state of the traversal of the other iterator
+    inline distance_query_iterator(distance_query_iterator & o, move_state_tag)
+        : m_visitor(o.m_visitor, move_state_tag())
+    {}
+
+    // The iterator and its copies gather the statistics of the traversal
+    inline distance_query_iterator(node_pointer root, parameters_type const& par, translator_type const& t, Predicates const& p,
+                  Statistics const& stats)
+        : m_visitor(par, t, p, 0, stats)
+    {
+        if ( root )
+            m_visitor.initialize(root);
+    }
+
     reference operator*() const
     {
         return m_visitor.dereference();
@@ -214,6 +270,27 @@ inline bool operator!=(L const& l, R const& r)
 }
 
 
+// The iterators not bigger than this are stored in the type-erased query_iterator,
+// the bigger ones are allocated.
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_QUERY_ITERATOR_BUFFER_SIZE
+#define BOOST_GEOMETRY_INDEX_DETAIL_QUERY_ITERATOR_BUFFER_SIZE (32 * sizeof(void*))
+#endif
+
+typedef boost::aligned_storage
+    <
+        BOOST_GEOMETRY_INDEX_DETAIL_QUERY_ITERATOR_BUFFER_SIZE,
+        boost::alignment_of<boost::detail::max_align>::value
+    > query_iterator_buffer;
+
+// The wrapped iterators fitting the buffer are stored in it
+template <typename Wrapper>
+struct fits_query_iterator_buffer
+{
+    static const bool value
+        = sizeof(Wrapper) <= sizeof(query_iterator_buffer)
+       && boost::alignment_of<Wrapper>::value <= boost::alignment_of<query_iterator_buffer>::value;
+};
+
 template <typename Value, typename Allocators>
 class query_iterator_base
 {
@@ -226,7 +303,11 @@ public:
 
     virtual ~query_iterator_base() {}
 
-    virtual query_iterator_base * clone() const = 0;
+    // Creates the copy in the buffer if it fits, otherwise allocates it
+    virtual query_iterator_base * clone(query_iterator_buffer & buffer) const = 0;
+    // Creates the iterator taking over the state of this one in the buffer if it fits,
+    // otherwise allocates it
+    virtual query_iterator_base * move_to(query_iterator_buffer & buffer) = 0;
     
     virtual bool is_end() const = 0;
     virtual reference dereference() const = 0;
@@ -250,7 +331,43 @@ public:
     query_iterator_wrapper() : m_iterator() {}
     explicit query_iterator_wrapper(Iterator const& it) : m_iterator(it) {}
 
-    virtual base_t * clone() const { return new query_iterator_wrapper(m_iterator); }
+    // Creates the iterator in place, e.g. the one using the buffers which would be detached
+    // by a copy or the knn iterator whose containers would be copied
+    template <typename Root, typename Parameters, typename Translator, typename Predicates, typename Arg>
+    query_iterator_wrapper(Root const& root, Parameters const& par, Translator const& t, Predicates const& p, Arg const& arg)
+        : m_iterator(root, par, t, p, arg)
+    {}
+
+    // Takes over the state of the other wrapper
+    query_iterator_wrapper(query_iterator_wrapper & o, move_state_tag)
+        : m_iterator(o.m_iterator, move_state_tag())
+    {}
+
+    static base_t * create(Iterator const& it, query_iterator_buffer & buffer)
+    {
+        return create(it, buffer, boost::mpl::bool_<fits_query_iterator_buffer<query_iterator_wrapper>::value>());
+    }
+
+    // Creates the iterator in the buffer if it fits, otherwise allocates it
+    template <typename Root, typename Parameters, typename Translator, typename Predicates, typename Arg>
+    static base_t * emplace(query_iterator_buffer & buffer,
+                            Root const& root, Parameters const& par, Translator const& t, Predicates const& p, Arg const& arg)
+    {
+        if ( fits_query_iterator_buffer<query_iterator_wrapper>::value )
+            return new (buffer.address()) query_iterator_wrapper(root, par, t, p, arg);
+        else
+            return new query_iterator_wrapper(root, par, t, p, arg);                                // MAY THROW (A)
+    }
+
+    virtual base_t * clone(query_iterator_buffer & buffer) const { return create(m_iterator, buffer); }
+
+    virtual base_t * move_to(query_iterator_buffer & buffer)
+    {
+        if ( fits_query_iterator_buffer<query_iterator_wrapper>::value )
+            return new (buffer.address()) query_iterator_wrapper(*this, move_state_tag());
+        else
+            return new query_iterator_wrapper(*this, move_state_tag());                             // MAY THROW (A)
+    }
 
     virtual bool is_end() const { return m_iterator == end_query_iterator<Value, Allocators>(); }
     virtual reference dereference() const { return *m_iterator; }
@@ -263,15 +380,30 @@ public:
     }
 
 private:
+    static base_t * create(Iterator const& it, query_iterator_buffer & buffer, boost::mpl::bool_<true> const&)
+    {
+        return new (buffer.address()) query_iterator_wrapper(it);
+    }
+
+    static base_t * create(Iterator const& it, query_iterator_buffer &, boost::mpl::bool_<false> const&)
+    {
+        return new query_iterator_wrapper(it);
+    }
+
     Iterator m_iterator;
 };
 
 
+// Passed to the constructor of query_iterator creating the wrapped iterator of type It in place
+template <typename It>
+struct query_iterator_emplace_tag {};
+
+// The type-erased iterator. The wrapped iterator is stored in the internal buffer
+// if it fits there so no memory is allocated for it, otherwise it's allocated.
 template <typename Value, typename Allocators>
 class query_iterator
 {
     typedef query_iterator_base<Value, Allocators> iterator_base;
-    typedef boost::scoped_ptr<iterator_base> iterator_ptr;
 
 public:
     typedef std::forward_iterator_tag iterator_category;
@@ -281,27 +413,41 @@ public:
     typedef typename Allocators::const_pointer pointer;
 
     query_iterator()
+        : m_ptr(0)
     {}
 
     template <typename It>
     query_iterator(It const& it)
-        : m_ptr(static_cast<iterator_base*>(
-                    new query_iterator_wrapper<Value, Allocators, It>(it) ))
+        : m_ptr(query_iterator_wrapper<Value, Allocators, It>::create(it, m_buffer))
     {}
 
     query_iterator(end_query_iterator<Value, Allocators> const& /*it*/)
+        : m_ptr(0)
+    {}
+
+    // Creates the wrapped iterator directly in the buffer (or allocates it if it doesn't fit)
+    // from the arguments of the constructor of It so the iterator is never copied
+    template <typename It, typename Root, typename Parameters, typename Translator, typename Predicates, typename Arg>
+    query_iterator(query_iterator_emplace_tag<It>, Root const& root, Parameters const& par,
+                   Translator const& t, Predicates const& p, Arg const& arg)
+        : m_ptr(query_iterator_wrapper<Value, Allocators, It>::emplace(m_buffer, root, par, t, p, arg))
     {}
 
     query_iterator(query_iterator const& o)
-        : m_ptr(o.m_ptr.get() ? o.m_ptr->clone() : 0)
+        : m_ptr(o.m_ptr ? o.m_ptr->clone(m_buffer) : 0)
     {}
 
+    ~query_iterator()
+    {
+        destroy();
+    }
+
 #ifndef BOOST_GEOMETRY_INDEX_DETAIL_QUERY_ITERATORS_USE_MOVE
     query_iterator & operator=(query_iterator const& o)
     {
         if ( this != boost::addressof(o) )
         {
-            m_ptr.reset(o.m_ptr.get() ? o.m_ptr->clone() : 0);
+            assign(o);
         }
         return *this;
     }
@@ -309,14 +455,14 @@ public:
     query_iterator(query_iterator && o)
         : m_ptr(0)
     {
-        m_ptr.swap(o.m_ptr);
+        move(o);
     }
     query_iterator & operator=(query_iterator && o)
     {
         if ( this != boost::addressof(o) )
         {
-            m_ptr.swap(o.m_ptr);
-            o.m_ptr.reset();
+            destroy();
+            move(o);
         }
         return *this;
     }
@@ -329,21 +475,21 @@ public:
     {
         if ( this != boost::addressof(o) )
         {
-            m_ptr.reset(o.m_ptr.get() ? o.m_ptr->clone() : 0);
+            assign(o);
         }
         return *this;
     }
     query_iterator(BOOST_RV_REF(query_iterator) o)
         : m_ptr(0)
     {
-        m_ptr.swap(o.m_ptr);
+        move(o);
     }
     query_iterator & operator=(BOOST_RV_REF(query_iterator) o)
     {
         if ( this != boost::addressof(o) )
         {
-            m_ptr.swap(o.m_ptr);
-            o.m_ptr.reset();
+            destroy();
+            move(o);
         }
         return *this;
     }
@@ -374,16 +520,16 @@ public:
 
     friend bool operator==(query_iterator const& l, query_iterator const& r)
     {
-        if ( l.m_ptr.get() )
+        if ( l.m_ptr )
         {
-            if ( r.m_ptr.get() )
+            if ( r.m_ptr )
                 return l.m_ptr->equals(*r.m_ptr);
             else
                 return l.m_ptr->is_end();
         }
         else
         {
-            if ( r.m_ptr.get() )
+            if ( r.m_ptr )
                 return r.m_ptr->is_end();
             else
                 return true;
@@ -391,7 +537,55 @@ public:
     }
 
 private:
-    iterator_ptr m_ptr;
+    bool is_buffered() const
+    {
+        return static_cast<void const*>(m_ptr) == m_buffer.address();
+    }
+
+    void destroy()
+    {
+        if ( is_buffered() )
+            m_ptr->~iterator_base();
+        else
+            delete m_ptr;
+        m_ptr = 0;
+    }
+
+    // The old iterator is destroyed after the copy is created so if an exception
+    // is thrown this iterator isn't modified, unless both are stored in the buffer
+    void assign(query_iterator const& o)
+    {
+        if ( is_buffered() )
+        {
+            destroy();
+            m_ptr = o.m_ptr ? o.m_ptr->clone(m_buffer) : 0;                                         // MAY THROW
+        }
+        else
+        {
+            iterator_base * old = m_ptr;
+            m_ptr = o.m_ptr ? o.m_ptr->clone(m_buffer) : 0;                                         // MAY THROW
+            delete old;
+        }
+    }
+
+    // The allocated iterator is passed, the state of the buffered one is moved
+    // so the containers of the traversal aren't copied
+    void move(query_iterator & o)
+    {
+        if ( o.is_buffered() )
+        {
+            m_ptr = o.m_ptr->move_to(m_buffer);                                                     // MAY THROW (copy)
+            o.destroy();
+        }
+        else
+        {
+            m_ptr = o.m_ptr;
+            o.m_ptr = 0;
+        }
+    }
+
+    query_iterator_buffer m_buffer;
+    iterator_base * m_ptr;
 };
 
 }}}}}} // namespace boost::geometry::index::detail::rtree::iterators
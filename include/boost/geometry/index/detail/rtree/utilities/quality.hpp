@@ -0,0 +1,190 @@
+// Boost.Geometry Index
+//
+// R-tree visitor calculating the quality metrics of the nodes
+//
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_UTILITIES_QUALITY_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_UTILITIES_QUALITY_HPP
+
+#include <vector>
+
+#include <boost/geometry/index/detail/algorithms/bounds.hpp>
+#include <boost/geometry/index/detail/algorithms/content.hpp>
+#include <boost/geometry/index/detail/algorithms/intersection_content.hpp>
+#include <boost/geometry/index/detail/algorithms/margin.hpp>
+#include <boost/geometry/index/detail/rtree/private_view.hpp>
+
+namespace boost { namespace geometry { namespace index { namespace detail { namespace rtree { namespace utilities {
+
+// The metrics of the nodes of one level of the tree, the root is at level 0.
+// The overlap is the sum of contents of intersections of the boxes of sibling nodes.
+// The dead space is the part of the box of a node not covered by its elements.
+// It's calculated as the content of the box minus the sum of contents of the
+// elements plus the sum of contents of pairwise intersections of the elements,
+// so it's exact unless more than two elements overlap at some point.
+template <typename Box>
+struct level_quality
+{
+    typedef typename index::detail::default_content_result<Box>::type content_type;
+    typedef typename index::detail::default_margin_result<Box>::type margin_type;
+
+    level_quality()
+        : nodes(0), content(0), margin(0), overlap(0), dead_space(0)
+    {}
+
+    std::size_t nodes;
+    content_type content;
+    margin_type margin;
+    content_type overlap;
+    content_type dead_space;
+};
+
+namespace visitors {
+
+template <typename MembersHolder>
+class quality
+    : public MembersHolder::visitor_const
+{
+    typedef typename MembersHolder::box_type box_type;
+    typedef typename MembersHolder::parameters_type parameters_type;
+    typedef typename MembersHolder::translator_type translator_type;
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+
+    typedef typename index::detail::strategy_type<parameters_type>::type strategy_type;
+
+public:
+    typedef level_quality<box_type> level_quality_type;
+    typedef typename level_quality_type::content_type content_type;
+    typedef std::vector<level_quality_type> levels_type;
+
+    inline quality(box_type const& root_box, parameters_type const& parameters, translator_type const& translator)
+        : m_translator(translator)
+        , m_strategy(index::detail::get_strategy(parameters))
+        , m_box(root_box)
+        , m_level(0)
+    {}
+
+    inline void operator()(internal_node const& n)
+    {
+        typedef typename rtree::elements_type<internal_node>::type elements_type;
+        elements_type const& elements = rtree::elements(n);
+
+        // the overlap of the children is added to the level below
+        level(m_level + 1).overlap += overlap(elements.begin(), elements.end(), element_box());
+        add_node(level(m_level), elements.begin(), elements.end(), element_box());
+
+        for ( typename elements_type::const_iterator it = elements.begin() ; it != elements.end() ; ++it )
+        {
+            m_box = it->first;
+            ++m_level;
+            rtree::apply_visitor(*this, *it->second);
+            --m_level;
+        }
+    }
+
+    inline void operator()(leaf const& n)
+    {
+        typedef typename rtree::elements_type<leaf>::type elements_type;
+        elements_type const& elements = rtree::elements(n);
+
+        add_node(level(m_level), elements.begin(), elements.end(), value_box(m_translator, m_strategy));
+    }
+
+    levels_type result;
+
+private:
+    struct element_box
+    {
+        template <typename Element>
+        box_type const& operator()(Element const& el) const { return el.first; }
+    };
+
+    struct value_box
+    {
+        value_box(translator_type const& t, strategy_type const& s) : tr(t), strategy(s) {}
+
+        template <typename Value>
+        box_type operator()(Value const& v) const
+        {
+            box_type result;
+            index::detail::bounds(tr(v), result, strategy);
+            return result;
+        }
+
+        translator_type const& tr;
+        strategy_type const& strategy;
+    };
+
+    level_quality_type & level(std::size_t l)
+    {
+        if ( result.size() <= l )
+            result.resize(l + 1);                                                               // MAY THROW (A)
+        return result[l];
+    }
+
+    template <typename It, typename BoxOf>
+    void add_node(level_quality_type & q, It first, It last, BoxOf const& box_of)
+    {
+        ++q.nodes;
+
+        content_type const node_content = index::detail::content(m_box);
+        q.content += node_content;
+        q.margin += index::detail::comparable_margin(m_box);
+
+        content_type covered = -overlap(first, last, box_of);
+        for ( It it = first ; it != last ; ++it )
+            covered += index::detail::content(box_of(*it));
+
+        if ( covered < node_content )
+            q.dead_space += node_content - covered;
+    }
+
+    template <typename It, typename BoxOf>
+    content_type overlap(It first, It last, BoxOf const& box_of) const
+    {
+        content_type result = 0;
+        for ( It it1 = first ; it1 != last ; ++it1 )
+        {
+            box_type const b1 = box_of(*it1);
+            for ( It it2 = it1 + 1 ; it2 != last ; ++it2 )
+                result += index::detail::intersection_content(b1, box_of(*it2), m_strategy);
+        }
+        return result;
+    }
+
+    translator_type const& m_translator;
+    strategy_type m_strategy;
+
+    box_type m_box;
+    std::size_t m_level;
+};
+
+} // namespace visitors
+
+// Returns the metrics of the levels of the tree, from the root to the leafs
+template <typename Rtree> inline
+std::vector<level_quality<typename Rtree::bounds_type> >
+quality(Rtree const& tree)
+{
+    typedef const_private_view<Rtree> RTV;
+    RTV rtv(tree);
+
+    visitors::quality<
+        typename RTV::members_holder
+    > quality_v(tree.bounds(), rtv.members().parameters(), rtv.members().translator());
+
+    if ( ! tree.empty() )
+        rtree::apply_visitor(quality_v, *rtv.members().root);
+
+    return quality_v.result;
+}
+
+}}}}}} // namespace boost::geometry::index::detail::rtree::utilities
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_RTREE_UTILITIES_QUALITY_HPP
@@ -0,0 +1,449 @@
+// Boost.Geometry Index
+//
+// R-tree bulk removing visitor implementation
+//
+// Copyright (c) 2011-2020 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_BULK_REMOVE_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_BULK_REMOVE_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/geometry/index/detail/rtree/visitors/destroy.hpp>
+#include <boost/geometry/index/detail/rtree/visitors/insert.hpp>
+
+#include <boost/geometry/algorithms/detail/covered_by/interface.hpp>
+
+namespace boost { namespace geometry { namespace index {
+
+namespace detail { namespace rtree { namespace visitors {
+
+// Selects the values equal to the values passed in a range. Each value passed
+// in the range removes at most one value stored in the tree. Only the values
+// which indexables are covered by the box of a node are passed into this node.
+template <typename MembersHolder>
+class bulk_remove_values_selector
+{
+    typedef typename MembersHolder::value_type value_type;
+    typedef typename MembersHolder::parameters_type parameters_type;
+    typedef typename MembersHolder::translator_type translator_type;
+    typedef typename MembersHolder::size_type size_type;
+
+    typedef std::vector<size_type> indexes_type;
+
+public:
+    template <typename FwdIt>
+    inline bulk_remove_values_selector(FwdIt first, FwdIt last,
+                                       parameters_type const& parameters,
+                                       translator_type const& translator)
+        : m_parameters(parameters)
+        , m_translator(translator)
+        , m_remaining_count(0)
+    {
+        for ( ; first != last ; ++first )
+            m_values.push_back(boost::addressof(*first));                                           // MAY THROW (alloc)
+
+        m_is_removed.resize(m_values.size(), false);                                                // MAY THROW (alloc)
+        m_remaining_count = m_values.size();
+
+        m_indexes.resize(1);                                                                        // MAY THROW (alloc)
+        m_indexes[0].resize(m_values.size());                                                       // MAY THROW (alloc)
+        for ( size_type i = 0 ; i < m_values.size() ; ++i )
+            m_indexes[0][i] = i;
+    }
+
+    inline bool is_done() const
+    {
+        return m_remaining_count == 0;
+    }
+
+    // Gathers the values covered by the box of a child of a node at the level
+    template <typename Box>
+    inline bool is_selected(Box const& child_box, size_type level)
+    {
+        if ( m_indexes.size() <= level + 1 )
+            m_indexes.resize(level + 2);                                                            // MAY THROW (alloc)
+
+        indexes_type const& indexes = m_indexes[level];
+        indexes_type & child_indexes = m_indexes[level + 1];
+        child_indexes.clear();
+
+        for ( typename indexes_type::const_iterator it = indexes.begin() ; it != indexes.end() ; ++it )
+        {
+            if ( ! m_is_removed[*it]
+              && index::detail::covered_by_bounds(m_translator(*m_values[*it]),
+                                                  child_box,
+                                                  index::detail::get_strategy(m_parameters)) )
+            {
+                child_indexes.push_back(*it);                                                       // MAY THROW (alloc)
+            }
+        }
+
+        return ! child_indexes.empty();
+    }
+
+    // Removes the values of a leaf at the level, returns the number of removed values
+    template <typename Elements>
+    inline size_type remove(Elements & elements, size_type level)
+    {
+        indexes_type const& indexes = m_indexes[level];
+
+        size_type result = 0;
+        for ( typename indexes_type::const_iterator it = indexes.begin() ;
+              it != indexes.end() && ! elements.empty() ; ++it )
+        {
+            if ( m_is_removed[*it] )
+                continue;
+
+            for ( typename Elements::iterator el_it = elements.begin() ; el_it != elements.end() ; ++el_it )
+            {
+                if ( m_translator.equals(*el_it, *m_values[*it], index::detail::get_strategy(m_parameters)) )
+                {
+                    rtree::move_from_back(elements, el_it);                                         // MAY THROW (V: copy)
+                    elements.pop_back();
+                    m_is_removed[*it] = true;
+                    --m_remaining_count;
+                    ++result;
+                    break;
+                }
+            }
+        }
+
+        return result;
+    }
+
+private:
+    parameters_type const& m_parameters;
+    translator_type const& m_translator;
+
+    std::vector<value_type const*> m_values;
+    std::vector<bool> m_is_removed;
+    size_type m_remaining_count;
+
+    // the indexes of the values passed into the nodes at subsequent levels
+    std::vector<indexes_type> m_indexes;
+};
+
+// Selects the values meeting the spatial predicates. The nodes which boxes
+// don't meet the predicates are not traversed.
+template <typename MembersHolder, typename Predicates>
+class bulk_remove_predicates_selector
+{
+    typedef typename MembersHolder::parameters_type parameters_type;
+    typedef typename MembersHolder::translator_type translator_type;
+    typedef typename MembersHolder::size_type size_type;
+
+    typedef typename index::detail::strategy_type<parameters_type>::type strategy_type;
+
+    static const unsigned predicates_len = index::detail::predicates_length<Predicates>::value;
+
+public:
+    inline bulk_remove_predicates_selector(Predicates const& predicates,
+                                           parameters_type const& parameters,
+                                           translator_type const& translator)
+        : m_predicates(predicates)
+        , m_translator(translator)
+        , m_strategy(index::detail::get_strategy(parameters))
+    {}
+
+    inline bool is_done() const
+    {
+        return false;
+    }
+
+    template <typename Box>
+    inline bool is_selected(Box const& child_box, size_type /*level*/) const
+    {
+        // 0 - dummy value
+        return index::detail::predicates_check
+                <
+                    index::detail::bounds_tag, 0, predicates_len
+                >(m_predicates, 0, child_box, m_strategy);
+    }
+
+    template <typename Elements>
+    inline size_type remove(Elements & elements, size_type /*level*/) const
+    {
+        size_type result = 0;
+        for ( typename Elements::size_type i = 0 ; i < elements.size() ; )
+        {
+            if ( index::detail::predicates_check
+                    <
+                        index::detail::value_tag, 0, predicates_len
+                    >(m_predicates, elements[i], m_translator(elements[i]), m_strategy) )
+            {
+                rtree::move_from_back(elements, elements.begin() + i);                              // MAY THROW (V: copy)
+                elements.pop_back();
+                ++result;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        return result;
+    }
+
+private:
+    Predicates m_predicates;
+    translator_type const& m_translator;
+    strategy_type m_strategy;
+};
+
+// Removes the values chosen by the Selector in one traversal of the tree.
+// In contrast to the remove visitor the underflowed nodes are not reinserted
+// on the way back to the root. They're gathered and their elements are
+// reinserted once after the whole tree was traversed.
+template <typename MembersHolder, typename Selector>
+class bulk_remove
+    : public MembersHolder::visitor
+{
+    typedef typename MembersHolder::box_type box_type;
+    typedef typename MembersHolder::parameters_type parameters_type;
+    typedef typename MembersHolder::translator_type translator_type;
+    typedef typename MembersHolder::allocators_type allocators_type;
+
+    typedef typename MembersHolder::node node;
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+
+    typedef typename allocators_type::node_pointer node_pointer;
+    typedef typename allocators_type::size_type size_type;
+
+    typedef typename rtree::elements_type<internal_node>::type internal_elements;
+    typedef typename internal_elements::size_type internal_size_type;
+
+public:
+    inline bulk_remove(node_pointer & root,
+                       size_type & leafs_level,
+                       Selector & selector,
+                       parameters_type const& parameters,
+                       translator_type const& translator,
+                       allocators_type & allocators)
+        : m_selector(selector)
+        , m_parameters(parameters)
+        , m_translator(translator)
+        , m_allocators(allocators)
+        , m_root_node(root)
+        , m_leafs_level(leafs_level)
+        , m_removed_count(0)
+        , m_current_level(0)
+        , m_child_size(0)
+    {}
+
+    inline ~bulk_remove()
+    {
+        // the nodes are left here only if an exception was thrown
+        for ( typename underflow_nodes::iterator it = m_underflowed_nodes.begin() ;
+              it != m_underflowed_nodes.end() ; ++it )
+        {
+            rtree::visitors::destroy<MembersHolder>::apply(it->second, m_allocators);
+        }
+    }
+
+    inline void operator()(internal_node & n)
+    {
+        internal_elements & elements = rtree::elements(n);
+
+        for ( internal_size_type i = 0 ; i < elements.size() && ! m_selector.is_done() ; )
+        {
+            if ( ! m_selector.is_selected(elements[i].first, m_current_level) )                     // MAY THROW (alloc)
+            {
+                ++i;
+                continue;
+            }
+
+            size_type const removed_count_bckup = m_removed_count;
+
+            ++m_current_level;
+            rtree::apply_visitor(*this, *elements[i].second);                                       // MAY THROW (V, E: alloc, copy)
+            --m_current_level;
+
+            // nothing was removed from the child
+            if ( removed_count_bckup == m_removed_count )
+            {
+                ++i;
+                continue;
+            }
+
+            if ( m_child_size == 0 )
+            {
+                node_pointer child = elements[i].second;
+                rtree::move_from_back(elements, elements.begin() + i);                              // MAY THROW (E: copy)
+                elements.pop_back();
+                rtree::visitors::destroy<MembersHolder>::apply(child, m_allocators);
+            }
+            else if ( m_child_size < m_parameters.get_min_elements() )
+            {
+                // the child is stored with its relative level, the leafs have level 1
+                size_type const relative_level = m_leafs_level - m_current_level;
+                m_underflowed_nodes.push_back(std::make_pair(relative_level, elements[i].second));  // MAY THROW (E: alloc, copy)
+                rtree::move_from_back(elements, elements.begin() + i);                              // MAY THROW (E: copy)
+                elements.pop_back();
+            }
+            else
+            {
+                elements[i].first = m_child_box;
+                ++i;
+            }
+        }
+
+        m_child_size = elements.size();
+        if ( 0 < m_current_level && 0 < m_child_size )
+        {
+            m_child_box = rtree::elements_box<box_type>(elements.begin(), elements.end(), m_translator,
+                                                        index::detail::get_strategy(m_parameters));
+        }
+    }
+
+    inline void operator()(leaf & n)
+    {
+        typedef typename rtree::elements_type<leaf>::type elements_type;
+        elements_type & elements = rtree::elements(n);
+
+        m_removed_count += m_selector.remove(elements, m_current_level);                            // MAY THROW (V: copy)
+
+        m_child_size = elements.size();
+        if ( 0 < m_current_level && 0 < m_child_size )
+        {
+            m_child_box = rtree::values_box<box_type>(elements.begin(), elements.end(), m_translator,
+                                                      index::detail::get_strategy(m_parameters));
+        }
+    }
+
+    // Reinserts the elements of the underflowed nodes and shortens the tree.
+    // Should be called after the visitor was applied to the root.
+    inline void condense()
+    {
+        if ( m_removed_count == 0 || m_leafs_level == 0 )
+            return;
+
+        // the nodes are taken from the back, begin with levels closer to the root
+        std::stable_sort(m_underflowed_nodes.begin(), m_underflowed_nodes.end(), less_level());
+
+        // all children of the root were removed, the highest underflowed node becomes the root
+        if ( rtree::elements(rtree::get<internal_node>(*m_root_node)).empty() )
+        {
+            rtree::destroy_node<allocators_type, internal_node>::apply(m_allocators, m_root_node);
+            m_root_node = 0;
+
+            // all values were removed, the empty leaf becomes the root like in the remove visitor
+            if ( m_underflowed_nodes.empty() )
+            {
+                m_leafs_level = 0;
+                m_root_node = rtree::create_node<allocators_type, leaf>::apply(m_allocators);          // MAY THROW (N: alloc)
+                return;
+            }
+
+            m_root_node = m_underflowed_nodes.back().second;
+            m_leafs_level = m_underflowed_nodes.back().first - 1;
+            m_underflowed_nodes.pop_back();
+        }
+
+        while ( ! m_underflowed_nodes.empty() )
+        {
+            std::pair<size_type, node_pointer> const& un = m_underflowed_nodes.back();
+            if ( un.first == 1 )
+            {
+                reinsert_node_elements(rtree::get<leaf>(*un.second), un.first);                     // MAY THROW (V, E: alloc, copy, N: alloc)
+                rtree::destroy_node<allocators_type, leaf>::apply(m_allocators, un.second);
+            }
+            else
+            {
+                reinsert_node_elements(rtree::get<internal_node>(*un.second), un.first);            // MAY THROW (V, E: alloc, copy, N: alloc)
+                rtree::destroy_node<allocators_type, internal_node>::apply(m_allocators, un.second);
+            }
+            m_underflowed_nodes.pop_back();
+        }
+
+        // shorten the tree
+        while ( 0 < m_leafs_level
+             && rtree::elements(rtree::get<internal_node>(*m_root_node)).size() == 1 )
+        {
+            node_pointer root_to_destroy = m_root_node;
+            m_root_node = rtree::elements(rtree::get<internal_node>(*m_root_node))[0].second;
+            --m_leafs_level;
+
+            rtree::destroy_node<allocators_type, internal_node>::apply(m_allocators, root_to_destroy);
+        }
+    }
+
+    inline size_type removed_count() const
+    {
+        return m_removed_count;
+    }
+
+private:
+    typedef std::vector< std::pair<size_type, node_pointer> > underflow_nodes;
+
+    struct less_level
+    {
+        template <typename Pair>
+        inline bool operator()(Pair const& l, Pair const& r) const
+        {
+            return l.first < r.first;
+        }
+    };
+
+    template <typename Node>
+    void reinsert_node_elements(Node &n, size_type node_relative_level)
+    {
+        typedef typename rtree::elements_type<Node>::type elements_type;
+        elements_type & elements = rtree::elements(n);
+
+        typename elements_type::iterator it = elements.begin();
+        BOOST_TRY
+        {
+            for ( ; it != elements.end() ; ++it )
+            {
+                visitors::insert<typename elements_type::value_type, MembersHolder>
+                    insert_v(m_root_node, m_leafs_level, *it,
+                             m_parameters, m_translator, m_allocators,
+                             node_relative_level - 1);
+
+                rtree::apply_visitor(insert_v, *m_root_node);                                       // MAY THROW (V, E: alloc, copy, N: alloc)
+            }
+        }
+        BOOST_CATCH(...)
+        {
+            ++it;
+            rtree::destroy_elements<MembersHolder>::apply(it, elements.end(), m_allocators);
+            elements.clear();
+            BOOST_RETHROW                                                                           // RETHROW
+        }
+        BOOST_CATCH_END
+
+        // the elements are owned by the tree now
+        elements.clear();
+    }
+
+    Selector & m_selector;
+    parameters_type const& m_parameters;
+    translator_type const& m_translator;
+    allocators_type & m_allocators;
+
+    node_pointer & m_root_node;
+    size_type & m_leafs_level;
+
+    size_type m_removed_count;
+    underflow_nodes m_underflowed_nodes;
+
+    // traversing input parameters
+    size_type m_current_level;
+
+    // traversing output parameters
+    size_type m_child_size;
+    box_type m_child_box;
+};
+
+}}} // namespace detail::rtree::visitors
+
+}}} // namespace boost::geometry::index
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_BULK_REMOVE_HPP
@@ -15,6 +15,11 @@
 #ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_DELETE_HPP
 #define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_DELETE_HPP
 
+#include <boost/type_traits/has_trivial_destructor.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+#include <boost/geometry/index/arena_allocator.hpp>
+
 namespace boost { namespace geometry { namespace index {
 
 namespace detail { namespace rtree { namespace visitors {
@@ -75,6 +80,41 @@ private:
     allocators_type & m_allocators;
 };
 
+// Releases the whole tree at once if the nodes are stored in the arena owned only
+// by this tree and nothing has to be destroyed in the nodes.
+template
+<
+    typename MembersHolder,
+    bool IsReleasable = is_arena_allocator<typename MembersHolder::allocators_type::node_allocator_type>::value
+                     && boost::is_same<typename MembersHolder::node_tag, node_variant_static_tag>::value
+                     && boost::has_trivial_destructor<typename MembersHolder::value_type>::value
+                     && boost::has_trivial_destructor<typename MembersHolder::box_type>::value
+>
+struct release_arena
+{
+    static inline bool apply(typename MembersHolder::allocators_type &)
+    {
+        return false;
+    }
+};
+
+template <typename MembersHolder>
+struct release_arena<MembersHolder, true>
+{
+    static inline bool apply(typename MembersHolder::allocators_type & allocators)
+    {
+        return arena_allocator_access::release_if_unique(allocators.node_allocator());
+    }
+};
+
+template <typename MembersHolder>
+inline void destroy_tree(typename MembersHolder::node_pointer root,
+                         typename MembersHolder::allocators_type & allocators)
+{
+    if ( ! release_arena<MembersHolder>::apply(allocators) )
+        destroy<MembersHolder>::apply(root, allocators);
+}
+
 }}} // namespace detail::rtree::visitors
 
 }}} // namespace boost::geometry::index
@@ -15,22 +15,89 @@
 #ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_DISTANCE_QUERY_HPP
 #define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_DISTANCE_QUERY_HPP
 
+#include <deque>
+#include <vector>
+
 namespace boost { namespace geometry { namespace index {
 
 namespace detail { namespace rtree { namespace visitors {
 
+// The run of sorted branches of one node stored in best_first_distance_query
+template <typename Distance, typename SizeType>
+struct best_first_branch_run
+{
+    best_first_branch_run(Distance const& d, SizeType f, SizeType l)
+        : distance(d), first(f), last(l)
+    {}
+
+    Distance distance; // the distance of the closest branch in the run
+    SizeType first;
+    SizeType last;
+};
+
+// The level of the traversal stored in distance_query_incremental
+template <typename ActiveBranchList>
+struct distance_query_internal_stack_element
+{
+    distance_query_internal_stack_element() : current_branch(0) {}
+#ifdef BOOST_NO_CXX11_RVALUE_REFERENCES
+    // Required in c++03 for containers using Boost.Move
+    distance_query_internal_stack_element & operator=(distance_query_internal_stack_element const& o)
+    {
+        branches = o.branches;
+        current_branch = o.current_branch;
+        return *this;
+    }
+#endif
+    ActiveBranchList branches;
+    typename ActiveBranchList::size_type current_branch;
+};
+
+// The buffers used by the knn queries which may be stored in the query_context
+// and reused by subsequent queries. Each visitor uses only some of them.
+template <typename MembersHolder, typename ValueDistance, typename NodeDistance>
+struct distance_query_buffers
+    : public rtree::query_buffers_base
+{
+    typedef typename MembersHolder::value_type value_type;
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::allocators_type::node_pointer node_pointer;
+    typedef typename MembersHolder::allocators_type::size_type size_type;
+
+    typedef std::pair<NodeDistance, node_pointer> branch_data;
+    typedef typename index::detail::rtree::container_from_elements_type<
+        typename rtree::elements_type<internal_node>::type, branch_data
+    >::type active_branch_list_type;
+
+    // distance_query and best_first_distance_query
+    std::vector< std::pair<ValueDistance, value_type> > neighbors;
+    // distance_query, one list per level, the references to the elements
+    // of the deque aren't invalidated when new levels are added
+    std::deque<active_branch_list_type> active_branch_lists;
+    // best_first_distance_query
+    std::vector<branch_data> branches;
+    std::vector< best_first_branch_run<NodeDistance, size_type> > runs;
+    // distance_query_incremental
+    std::vector< std::pair<ValueDistance, const value_type *> > neighbor_ptrs;
+    std::vector< distance_query_internal_stack_element<active_branch_list_type> > internal_stack;
+};
+
 template <typename Value, typename Translator, typename DistanceType, typename OutIt>
 class distance_query_result
 {
 public:
     typedef DistanceType distance_type;
+    typedef std::vector< std::pair<distance_type, Value> > neighbors_type;
 
-    inline explicit distance_query_result(size_t k, OutIt out_it)
+    // If the buffer is passed it's used instead of the internal container
+    inline distance_query_result(size_t k, OutIt out_it, neighbors_type * buffer = 0)
         : m_count(k), m_out_it(out_it)
+        , m_neighbors(buffer ? *buffer : m_neighbors_storage)
     {
         BOOST_GEOMETRY_INDEX_ASSERT(0 < m_count, "Number of neighbors should be greater than 0");
 
-        m_neighbors.reserve(m_count);
+        m_neighbors.clear();
+        m_neighbors.reserve(m_count);                                                           // MAY THROW (A)
     }
 
     inline void store(Value const& val, distance_type const& curr_comp_dist)
@@ -76,7 +143,12 @@ public:
         for ( neighbors_iterator it = m_neighbors.begin() ; it != m_neighbors.end() ; ++it, ++m_out_it )
             *m_out_it = it->second;
 
-        return m_neighbors.size();
+        size_t const result = m_neighbors.size();
+
+        // the values aren't kept in the buffer, only the memory
+        m_neighbors.clear();
+
+        return result;
     }
 
 private:
@@ -90,7 +162,12 @@ private:
     size_t m_count;
     OutIt m_out_it;
 
-    std::vector< std::pair<distance_type, Value> > m_neighbors;
+    neighbors_type m_neighbors_storage;
+    neighbors_type & m_neighbors;
+
+    // the reference may point to the member
+    distance_query_result(distance_query_result const&);
+    distance_query_result & operator=(distance_query_result const&);
 };
 
 template
@@ -98,7 +175,8 @@ template
     typename MembersHolder,
     typename Predicates,
     unsigned DistancePredicateIndex,
-    typename OutIter
+    typename OutIter,
+    typename Statistics = rtree::no_query_statistics
 >
 class distance_query
     : public MembersHolder::visitor_const
@@ -125,13 +203,19 @@ public:
     typedef typename calculate_value_distance::result_type value_distance_type;
     typedef typename calculate_node_distance::result_type node_distance_type;
 
+    typedef distance_query_buffers<MembersHolder, value_distance_type, node_distance_type> buffers_type;
+
     static const unsigned predicates_len = index::detail::predicates_length<Predicates>::value;
 
-    inline distance_query(parameters_type const& parameters, translator_type const& translator, Predicates const& pred, OutIter out_it)
+    inline distance_query(parameters_type const& parameters, translator_type const& translator, Predicates const& pred, OutIter out_it,
+                          buffers_type * buffers = 0, Statistics const& stats = Statistics())
         : m_parameters(parameters), m_translator(translator)
         , m_pred(pred)
-        , m_result(nearest_predicate_access::get(m_pred).count, out_it)
+        , m_result(nearest_predicate_access::get(m_pred).count, out_it, buffers ? &buffers->neighbors : 0)
         , m_strategy(index::detail::get_strategy(parameters))
+        , m_active_branch_lists(buffers ? &buffers->active_branch_lists : 0)
+        , m_level(0)
+        , m_statistics(stats)
     {}
 
     inline void operator()(internal_node const& n)
@@ -139,16 +223,20 @@ public:
         typedef typename rtree::elements_type<internal_node>::type elements_type;
 
         // array of active nodes
-        typedef typename index::detail::rtree::container_from_elements_type<
-            elements_type,
-            std::pair<node_distance_type, typename allocators_type::node_pointer>
-        >::type active_branch_list_type;
-
-        active_branch_list_type active_branch_list;
+        typedef typename buffers_type::active_branch_list_type active_branch_list_type;
+
+        // the list of the current level is taken from the buffers if available
+        active_branch_list_type local_active_branch_list;
+        active_branch_list_type & active_branch_list = m_active_branch_lists ?
+                                                       level_active_branch_list() :
+                                                       local_active_branch_list;
+        active_branch_list.clear();
         active_branch_list.reserve(m_parameters.get_max_elements());
         
         elements_type const& elements = rtree::elements(n);
 
+        m_statistics.internal_node(elements.size());
+
         // fill array of nodes meeting predicates
         for (typename elements_type::const_iterator it = elements.begin();
             it != elements.end(); ++it)
@@ -181,6 +269,8 @@ public:
             }
         }
 
+        m_statistics.rejected_nodes(elements.size() - active_branch_list.size());
+
         // if there aren't any nodes in ABL - return
         if ( active_branch_list.empty() )
             return;
@@ -195,17 +285,21 @@ public:
             // if current node is further than furthest neighbor, the rest of nodes also will be further
             if ( m_result.has_enough_neighbors() &&
                  is_node_prunable(m_result.greatest_comparable_distance(), it->first) )
+            {
+                m_statistics.rejected_nodes(active_branch_list.end() - it);
                 break;
+            }
 
+            ++m_level;
             rtree::apply_visitor(*this, *(it->second));
+            --m_level;
         }
 
         // ALTERNATIVE VERSION - use heap instead of sorted container
         // It seems to be faster for greater MaxElements and slower otherwise
-        // CONSIDER: using one global container/heap for active branches
-        //           instead of a sorted container per level
-        //           This would also change the way how branches are traversed!
-        //           The same may be applied to the iterative version which btw suffers
+        // NOTE: the version using one global heap for active branches
+        //       is implemented in best_first_distance_query
+        // CONSIDER: the same may be applied to the iterative version which btw suffers
         //           from the copying of the whole containers on resize of the ABLs container
 
         //// make a heap
@@ -232,6 +326,9 @@ public:
     {
         typedef typename rtree::elements_type<leaf>::type elements_type;
         elements_type const& elements = rtree::elements(n);
+
+        m_statistics.leaf();
+        m_statistics.checked_values(elements.size());
         
         // search leaf for closest value meeting predicates
         for (typename elements_type::const_iterator it = elements.begin();
@@ -251,6 +348,7 @@ public:
                 {
                     // store value
                     m_result.store(*it, value_distance);
+                    m_statistics.found_value();
                 }
             }
         }
@@ -287,6 +385,13 @@ private:
         return nearest_predicate_access::get(m_pred);
     }
 
+    typename buffers_type::active_branch_list_type & level_active_branch_list()
+    {
+        if ( m_active_branch_lists->size() <= m_level )
+            m_active_branch_lists->resize(m_level + 1);                                         // MAY THROW (A)
+        return (*m_active_branch_lists)[m_level];
+    }
+
     parameters_type const& m_parameters;
     translator_type const& m_translator;
 
@@ -294,12 +399,289 @@ private:
     distance_query_result<value_type, translator_type, value_distance_type, OutIter> m_result;
 
     strategy_type m_strategy;
+
+    std::deque<typename buffers_type::active_branch_list_type> * m_active_branch_lists;
+    size_t m_level;
+
+    Statistics m_statistics;
+};
+
+// Best-first k-nearest neighbors search (Hjaltason, Samet).
+// The branches of all visited internal nodes are kept in one global
+// priority queue, the closest branch is always taken from it, so nodes
+// are visited in the order of increasing distance and the traversal stops
+// when the closest branch is further than the furthest of k neighbors
+// found so far. In contrast to distance_query no node which could be pruned
+// by a neighbor found in another subtree is visited.
+//
+// The priority queue is implemented as a min-heap of sorted runs of branches.
+// The branches of an expanded node are sorted and stored in one container
+// shared by all runs and only one heap element is pushed per node. So the heap
+// is small and the branches which are never visited don't have to be pushed
+// into the heap.
+//
+// Only the root node is traversed from the outside, nested calls of
+// operator()(internal_node) only push the children into the queue.
+//
+// Less nodes are visited than in distance_query if the nodes overlap but
+// the traversal jumps between subtrees so memory locality is worse and
+// the containers are allocated for each query unless the buffers are passed.
+// It's used by rtree::query() if nearest() predicate is generated with best_first.
+template
+<
+    typename MembersHolder,
+    typename Predicates,
+    unsigned DistancePredicateIndex,
+    typename OutIter,
+    typename Statistics = rtree::no_query_statistics
+>
+class best_first_distance_query
+    : public MembersHolder::visitor_const
+{
+public:
+    typedef typename MembersHolder::value_type value_type;
+    typedef typename MembersHolder::box_type box_type;
+    typedef typename MembersHolder::parameters_type parameters_type;
+    typedef typename MembersHolder::translator_type translator_type;
+    typedef typename MembersHolder::allocators_type allocators_type;
+
+    typedef typename index::detail::strategy_type<parameters_type>::type strategy_type;
+
+    typedef typename MembersHolder::node node;
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+
+    typedef index::detail::predicates_element<DistancePredicateIndex, Predicates> nearest_predicate_access;
+    typedef typename nearest_predicate_access::type nearest_predicate_type;
+    typedef typename indexable_type<translator_type>::type indexable_type;
+
+    typedef index::detail::calculate_distance<nearest_predicate_type, indexable_type, strategy_type, value_tag> calculate_value_distance;
+    typedef index::detail::calculate_distance<nearest_predicate_type, box_type, strategy_type, bounds_tag> calculate_node_distance;
+    typedef typename calculate_value_distance::result_type value_distance_type;
+    typedef typename calculate_node_distance::result_type node_distance_type;
+
+    typedef typename allocators_type::node_pointer node_pointer;
+    typedef typename allocators_type::size_type size_type;
+
+    typedef distance_query_buffers<MembersHolder, value_distance_type, node_distance_type> buffers_type;
+
+    typedef std::pair<node_distance_type, node_pointer> branch_data;
+    typedef std::vector<branch_data> branches_type;
+
+    typedef best_first_branch_run<node_distance_type, size_type> run_data;
+    typedef std::vector<run_data> runs_type;
+
+    static const unsigned predicates_len = index::detail::predicates_length<Predicates>::value;
+
+    inline best_first_distance_query(parameters_type const& parameters, translator_type const& translator, Predicates const& pred, OutIter out_it,
+                                     buffers_type * buffers = 0, Statistics const& stats = Statistics())
+        : m_translator(translator)
+        , m_pred(pred)
+        , m_result(nearest_predicate_access::get(m_pred).count, out_it, buffers ? &buffers->neighbors : 0)
+        , m_strategy(index::detail::get_strategy(parameters))
+        , m_branches(buffers ? buffers->branches : m_branches_storage)
+        , m_runs(buffers ? buffers->runs : m_runs_storage)
+        , m_traversing(false)
+        , m_statistics(stats)
+    {
+        m_branches.clear();
+        m_runs.clear();
+        m_branches.reserve(parameters.get_max_elements() * 4);                                  // MAY THROW (A)
+        m_runs.reserve(16);                                                                     // MAY THROW (A)
+    }
+
+    inline void operator()(internal_node const& n)
+    {
+        typedef typename rtree::elements_type<internal_node>::type elements_type;
+        elements_type const& elements = rtree::elements(n);
+
+        size_type const first = m_branches.size();
+
+        m_statistics.internal_node(elements.size());
+
+        // store the branches meeting predicates
+        for (typename elements_type::const_iterator it = elements.begin();
+            it != elements.end(); ++it)
+        {
+            // 0 - dummy value
+            if ( index::detail::predicates_check
+                    <
+                        index::detail::bounds_tag, 0, predicates_len
+                    >(m_pred, 0, it->first, m_strategy) )
+            {
+                node_distance_type node_distance;
+                if ( !calculate_node_distance::apply(predicate(), it->first,
+                                                     m_strategy, node_distance) )
+                {
+                    continue;
+                }
+
+                if ( m_result.has_enough_neighbors() &&
+                     is_node_prunable(m_result.greatest_comparable_distance(), node_distance) )
+                {
+                    continue;
+                }
+
+                m_branches.push_back(std::make_pair(node_distance, it->second));                // MAY THROW (A)
+            }
+        }
+
+        m_statistics.rejected_nodes(elements.size() - (m_branches.size() - first));
+
+        // push the sorted run into the heap
+        if ( first < m_branches.size() )
+        {
+            std::sort(m_branches.begin() + first, m_branches.end(), branch_less);
+
+            m_runs.push_back(run_data(m_branches[first].first, first, m_branches.size()));       // MAY THROW (A)
+            std::push_heap(m_runs.begin(), m_runs.end(), run_greater);
+        }
+
+        if ( m_traversing )
+            return;
+
+        m_traversing = true;
+
+        // visit the closest branch until the rest of branches is further
+        // than the furthest neighbor
+        while ( !m_runs.empty() )
+        {
+            if ( m_result.has_enough_neighbors() &&
+                 is_node_prunable(m_result.greatest_comparable_distance(), m_runs.front().distance) )
+            {
+                for ( typename runs_type::const_iterator it = m_runs.begin() ; it != m_runs.end() ; ++it )
+                    m_statistics.rejected_nodes(it->last - it->first);
+                break;
+            }
+
+            std::pop_heap(m_runs.begin(), m_runs.end(), run_greater);
+            run_data & run = m_runs.back();
+
+            node_pointer ptr = m_branches[run.first].second;
+            ++run.first;
+
+            if ( run.first < run.last )
+            {
+                run.distance = m_branches[run.first].first;
+                std::push_heap(m_runs.begin(), m_runs.end(), run_greater);
+            }
+            else
+            {
+                m_runs.pop_back();
+            }
+
+            rtree::apply_visitor(*this, *ptr);
+        }
+
+        m_traversing = false;
+    }
+    inline void operator()(leaf const& n)
+    {
+        typedef typename rtree::elements_type<leaf>::type elements_type;
+        elements_type const& elements = rtree::elements(n);
+
+        m_statistics.leaf();
+        m_statistics.checked_values(elements.size());
+
+        for (typename elements_type::const_iterator it = elements.begin();
+            it != elements.end(); ++it)
+        {
+            if ( index::detail::predicates_check
+                    <
+                        index::detail::value_tag, 0, predicates_len
+                    >(m_pred, *it, m_translator(*it), m_strategy) )
+            {
+                value_distance_type value_distance;
+                if ( calculate_value_distance::apply(predicate(), m_translator(*it),
+                                                     m_strategy, value_distance) )
+                {
+                    m_result.store(*it, value_distance);
+                    m_statistics.found_value();
+                }
+            }
+        }
+    }
+
+    inline size_t finish()
+    {
+        return m_result.finish();
+    }
+
+private:
+    static inline bool branch_less(branch_data const& p1, branch_data const& p2)
+    {
+        return p1.first < p2.first;
+    }
+
+    static inline bool run_greater(run_data const& r1, run_data const& r2)
+    {
+        return r1.distance > r2.distance;
+    }
+
+    template <typename Distance>
+    static inline bool is_node_prunable(Distance const& greatest_dist, node_distance_type const& d)
+    {
+        return greatest_dist <= d;
+    }
+
+    nearest_predicate_type const& predicate() const
+    {
+        return nearest_predicate_access::get(m_pred);
+    }
+
+    translator_type const& m_translator;
+
+    Predicates m_pred;
+    distance_query_result<value_type, translator_type, value_distance_type, OutIter> m_result;
+
+    strategy_type m_strategy;
+
+    branches_type m_branches_storage;
+    runs_type m_runs_storage;
+    branches_type & m_branches;
+    runs_type & m_runs;
+    bool m_traversing;
+
+    Statistics m_statistics;
+};
+
+// The visitor performing the traversal of the tree requested by the distance predicate
+template
+<
+    typename MembersHolder,
+    typename Predicates,
+    unsigned DistancePredicateIndex,
+    typename OutIter,
+    typename Statistics = rtree::no_query_statistics,
+    typename Traversal = typename index::detail::predicates_distance_traversal
+        <
+            typename index::detail::predicates_element<DistancePredicateIndex, Predicates>::type
+        >::type
+>
+struct distance_query_visitor
+{
+    typedef distance_query<MembersHolder, Predicates, DistancePredicateIndex, OutIter, Statistics> type;
+};
+
+template
+<
+    typename MembersHolder,
+    typename Predicates,
+    unsigned DistancePredicateIndex,
+    typename OutIter,
+    typename Statistics
+>
+struct distance_query_visitor<MembersHolder, Predicates, DistancePredicateIndex, OutIter, Statistics,
+                              index::detail::predicates::best_first_tag>
+{
+    typedef best_first_distance_query<MembersHolder, Predicates, DistancePredicateIndex, OutIter, Statistics> type;
 };
 
 template <
     typename MembersHolder,
     typename Predicates,
-    unsigned DistancePredicateIndex
+    unsigned DistancePredicateIndex,
+    typename Statistics = rtree::no_query_statistics
 >
 class distance_query_incremental
     : public MembersHolder::visitor_const
@@ -340,23 +722,11 @@ public:
     typedef typename index::detail::rtree::container_from_elements_type<
         internal_elements, branch_data
     >::type active_branch_list_type;
-    struct internal_stack_element
-    {
-        internal_stack_element() : current_branch(0) {}
-#ifdef BOOST_NO_CXX11_RVALUE_REFERENCES
-        // Required in c++03 for containers using Boost.Move
-        internal_stack_element & operator=(internal_stack_element const& o)
-        {
-            branches = o.branches;
-            current_branch = o.current_branch;
-            return *this;
-        }
-#endif
-        active_branch_list_type branches;
-        typename active_branch_list_type::size_type current_branch;
-    };
+    typedef distance_query_internal_stack_element<active_branch_list_type> internal_stack_element;
     typedef std::vector<internal_stack_element> internal_stack_type;
 
+    typedef distance_query_buffers<MembersHolder, value_distance_type, node_distance_type> buffers_type;
+
     inline distance_query_incremental()
         : m_translator(NULL)
 //        , m_pred()
@@ -365,14 +735,49 @@ public:
 //        , m_strategy_type()
     {}
 
-    inline distance_query_incremental(parameters_type const& params, translator_type const& translator, Predicates const& pred)
+    inline distance_query_incremental(parameters_type const& params, translator_type const& translator, Predicates const& pred,
+                                      buffers_type * buffers = 0, Statistics const& stats = Statistics())
         : m_translator(::boost::addressof(translator))
         , m_pred(pred)
         , current_neighbor((std::numeric_limits<size_type>::max)())
         , next_closest_node_distance((std::numeric_limits<node_distance_type>::max)())
         , m_strategy(index::detail::get_strategy(params))
+        , m_buffers(buffers)
+        , m_statistics(stats)
     {
         BOOST_GEOMETRY_INDEX_ASSERT(0 < max_count(), "k must be greather than 0");
+
+        // the containers of the buffers are empty, only the memory is reused
+        if ( buffers )
+        {
+            internal_stack.swap(buffers->internal_stack);
+            neighbors.swap(buffers->neighbor_ptrs);
+        }
+    }
+
+    // Takes over the state of the traversal of the other visitor
+    inline distance_query_incremental(distance_query_incremental & o, move_state_tag)
+        : m_translator(o.m_translator)
+        , m_pred(o.m_pred)
+        , current_neighbor(o.current_neighbor)
+        , next_closest_node_distance(o.next_closest_node_distance)
+        , m_strategy(o.m_strategy)
+        , m_buffers(o.m_buffers, move_state_tag())
+        , m_statistics(o.m_statistics)
+    {
+        internal_stack.swap(o.internal_stack);
+        neighbors.swap(o.neighbors);
+    }
+
+    inline ~distance_query_incremental()
+    {
+        if ( m_buffers.get() )
+        {
+            internal_stack.clear();
+            neighbors.clear();
+            internal_stack.swap(m_buffers.get()->internal_stack);
+            neighbors.swap(m_buffers.get()->neighbor_ptrs);
+        }
     }
 
     const_reference dereference() const
@@ -431,6 +836,7 @@ public:
                 if ( max_count() <= neighbors.size() &&
                      is_node_prunable(neighbors.back().first, branches[current_branch].first) )
                 {
+                    m_statistics.rejected_nodes(branches.size() - current_branch);
                     // stop traversing current level
                     internal_stack.pop_back();
                     continue;
@@ -470,6 +876,8 @@ public:
         typedef typename rtree::elements_type<internal_node>::type elements_type;
         elements_type const& elements = rtree::elements(n);
 
+        m_statistics.internal_node(elements.size());
+
         // add new element
         internal_stack.resize(internal_stack.size()+1);
 
@@ -504,6 +912,8 @@ public:
             }
         }
 
+        m_statistics.rejected_nodes(elements.size() - internal_stack.back().branches.size());
+
         if ( internal_stack.back().branches.empty() )
             internal_stack.pop_back();
         else
@@ -522,6 +932,9 @@ public:
         // store distance to the furthest neighbour
         bool not_enough_neighbors = neighbors.size() < max_count();
         value_distance_type greatest_distance = !not_enough_neighbors ? neighbors.back().first : (std::numeric_limits<value_distance_type>::max)();
+
+        m_statistics.leaf();
+        m_statistics.checked_values(elements.size());
         
         // search leaf for closest value meeting predicates
         for ( typename elements_type::const_iterator it = elements.begin() ; it != elements.end() ; ++it)
@@ -542,6 +955,7 @@ public:
                     if ( not_enough_neighbors || value_distance < greatest_distance )
                     {
                         neighbors.push_back(std::make_pair(value_distance, boost::addressof(*it)));
+                        m_statistics.found_value();
                     }
                 }
             }
@@ -610,6 +1024,10 @@ private:
     node_distance_type next_closest_node_distance;
 
     strategy_type m_strategy;
+
+    rtree::attached_buffers_ptr<buffers_type> m_buffers;
+
+    Statistics m_statistics;
 };
 
 }}} // namespace detail::rtree::visitors
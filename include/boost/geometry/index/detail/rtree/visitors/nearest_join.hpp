@@ -0,0 +1,731 @@
+// Boost.Geometry Index
+//
+// R-tree all nearest neighbors and closest pairs of two rtrees
+//
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_NEAREST_JOIN_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_NEAREST_JOIN_HPP
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <boost/geometry/algorithms/detail/distance/box_to_box.hpp>
+#include <boost/geometry/index/detail/algorithms/diff_abs.hpp>
+
+namespace boost { namespace geometry { namespace index {
+
+namespace detail { namespace rtree { namespace visitors {
+
+// The upper bound of the comparable distance between any points of two boxes.
+// It's calculated only for cartesian boxes, for other coordinate systems
+// false is returned and the candidates aren't pruned.
+template <typename Box1, typename Box2,
+          typename CSTag = typename geometry::cs_tag<Box1>::type>
+struct nearest_join_far_distance
+{
+    template <typename Result>
+    static inline bool apply(Box1 const& , Box2 const& , Result & )
+    {
+        return false;
+    }
+};
+
+template <typename Box1, typename Box2>
+struct nearest_join_far_distance<Box1, Box2, cartesian_tag>
+{
+    template <typename Result>
+    static inline bool apply(Box1 const& b1, Box2 const& b2, Result & result)
+    {
+        result = 0;
+        apply_dimension<0>(b1, b2, result);
+        return true;
+    }
+
+private:
+    template <std::size_t I, typename Result>
+    static inline void apply_dimension(Box1 const& b1, Box2 const& b2, Result & result)
+    {
+        Result const min1 = geometry::get<min_corner, I>(b1);
+        Result const max1 = geometry::get<max_corner, I>(b1);
+        Result const min2 = geometry::get<min_corner, I>(b2);
+        Result const max2 = geometry::get<max_corner, I>(b2);
+        Result const d1 = index::detail::diff_abs(max1, min2);
+        Result const d2 = index::detail::diff_abs(max2, min1);
+        Result const d = d1 < d2 ? d2 : d1;
+        result += d * d;
+
+        apply_dimension<I + 1>(b1, b2, result, boost::mpl::bool_<I + 1 < dimension<Box1>::value>());
+    }
+
+    template <std::size_t I, typename Result>
+    static inline void apply_dimension(Box1 const& b1, Box2 const& b2, Result & result, boost::mpl::bool_<true> const&)
+    {
+        apply_dimension<I>(b1, b2, result);
+    }
+
+    template <std::size_t I, typename Result>
+    static inline void apply_dimension(Box1 const& , Box2 const& , Result & , boost::mpl::bool_<false> const&)
+    {}
+};
+
+// The types of nodes and distances used by all_nearest and closest_pairs
+template <typename MembersHolder1, typename MembersHolder2>
+struct nearest_join_traits
+{
+    typedef typename MembersHolder1::parameters_type parameters_type;
+    typedef typename index::detail::strategy_type<parameters_type>::type strategy_type;
+
+    typedef typename MembersHolder1::translator_type translator1_type;
+    typedef typename MembersHolder2::translator_type translator2_type;
+    typedef typename MembersHolder1::box_type box1_type;
+    typedef typename MembersHolder2::box_type box2_type;
+    typedef typename indexable_type<translator1_type>::type indexable1_type;
+    typedef typename indexable_type<translator2_type>::type indexable2_type;
+
+    typedef typename MembersHolder1::internal_node internal_node1;
+    typedef typename MembersHolder1::leaf leaf1;
+    typedef typename MembersHolder2::internal_node internal_node2;
+    typedef typename MembersHolder2::leaf leaf2;
+    typedef typename MembersHolder1::allocators_type::node_pointer node1_pointer;
+    typedef typename MembersHolder2::allocators_type::node_pointer node2_pointer;
+
+    typedef typename MembersHolder1::value_type value1_type;
+    typedef typename MembersHolder2::value_type value2_type;
+
+    typedef index::detail::comparable_distance_call<indexable1_type, indexable2_type, strategy_type> value_distance_call;
+    typedef index::detail::comparable_distance_call<indexable1_type, box2_type, strategy_type> value_node_distance_call;
+    typedef index::detail::comparable_distance_call<box1_type, box2_type, strategy_type> node_distance_call;
+    typedef typename value_distance_call::result_type value_distance_type;
+    typedef typename value_node_distance_call::result_type value_node_distance_type;
+    typedef typename node_distance_call::result_type node_distance_type;
+
+    typedef nearest_join_far_distance<box1_type, box2_type> far_distance_call;
+};
+
+// For each value of the first tree finds k nearest values of the second tree.
+//
+// The first tree is traversed depth-first and the list of candidate nodes of
+// the second tree is passed down. For each node of the first tree the nodes of
+// the second tree are expanded one level and the ones further than the upper
+// bound of the distance of k-th neighbor of any point of the node are pruned.
+// So the nodes of the second tree are checked once for a group of values.
+// For each value of a leaf the nearest neighbors are searched starting from
+// the candidates of the leaf, like in distance_query.
+template <typename MembersHolder1, typename MembersHolder2, typename OutIter>
+class all_nearest
+{
+    typedef nearest_join_traits<MembersHolder1, MembersHolder2> traits;
+
+    typedef typename traits::strategy_type strategy_type;
+    typedef typename traits::translator1_type translator1_type;
+    typedef typename traits::translator2_type translator2_type;
+    typedef typename traits::box1_type box1_type;
+    typedef typename traits::box2_type box2_type;
+    typedef typename traits::indexable1_type indexable1_type;
+    typedef typename traits::internal_node1 internal_node1;
+    typedef typename traits::leaf1 leaf1;
+    typedef typename traits::internal_node2 internal_node2;
+    typedef typename traits::leaf2 leaf2;
+    typedef typename traits::node1_pointer node1_pointer;
+    typedef typename traits::node2_pointer node2_pointer;
+    typedef typename traits::value1_type value1_type;
+    typedef typename traits::value2_type value2_type;
+    typedef typename traits::value_distance_type value_distance_type;
+    typedef typename traits::value_node_distance_type value_node_distance_type;
+    typedef typename traits::node_distance_type node_distance_type;
+
+public:
+    typedef typename MembersHolder1::allocators_type::size_type size_type;
+
+    struct candidate
+    {
+        candidate(node_distance_type const& d, box2_type const* b, node2_pointer n)
+            : distance(d), box(b), node(n)
+        {}
+
+        node_distance_type distance;
+        box2_type const* box;
+        node2_pointer node;
+    };
+    typedef std::vector<candidate> candidates_type;
+    typedef std::vector< std::pair<value_node_distance_type, node2_pointer> > branches_type;
+    typedef std::vector< std::pair<value_distance_type, value2_type const*> > neighbors_type;
+    typedef std::vector<value2_type const*> previous_type;
+
+    inline all_nearest(MembersHolder1 const& members1, MembersHolder2 const& members2,
+                       unsigned k, OutIter out_it)
+        : m_tr1(members1.translator()), m_tr2(members2.translator())
+        , m_leafs_level1(members1.leafs_level), m_leafs_level2(members2.leafs_level)
+        , m_count(k), m_out_it(out_it), m_found_count(0)
+        , m_strategy(index::detail::get_strategy(members1.parameters()))
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(0 < m_count, "Number of neighbors should be greater than 0");
+    }
+
+    inline void apply(node1_pointer root1, box1_type const& box1,
+                      node2_pointer root2, box2_type const& box2)
+    {
+        m_root_box2 = box2;
+
+        candidates_type & candidates = level_candidates(0);
+        candidates.clear();
+        candidates.push_back(candidate(traits::node_distance_call::apply(box1, m_root_box2, m_strategy),
+                                       boost::addressof(m_root_box2), root2));
+
+        traverse(root1, 0, candidates, 0);
+    }
+
+    inline size_type found_count() const
+    {
+        return m_found_count;
+    }
+
+    inline OutIter out_iter() const
+    {
+        return m_out_it;
+    }
+
+private:
+    inline void traverse(node1_pointer n1, size_type level1,
+                         candidates_type const& candidates, size_type level2)
+    {
+        if ( level1 == m_leafs_level1 )
+        {
+            search_leaf(rtree::get<leaf1>(*n1), candidates, level2);
+            return;
+        }
+
+        typedef typename rtree::elements_type<internal_node1>::type elements1_type;
+        elements1_type const& elements1 = rtree::elements(rtree::get<internal_node1>(*n1));
+
+        bool const expand = level2 < m_leafs_level2;
+        size_type const child_level2 = expand ? level2 + 1 : level2;
+
+        // the list of the child is overwritten for each child
+        candidates_type & child_candidates = level_candidates(level1 + 1);
+
+        for ( typename elements1_type::const_iterator it1 = elements1.begin();
+              it1 != elements1.end(); ++it1 )
+        {
+            child_candidates.clear();
+
+            // the candidates are pruned before the expansion
+            node_distance_type bound = 0;
+            bool const has_bound = calculate_bound(it1->first, candidates, level2, bound);
+
+            for ( typename candidates_type::const_iterator it = candidates.begin();
+                  it != candidates.end(); ++it )
+            {
+                node_distance_type const d = traits::node_distance_call::apply(it1->first, *it->box, m_strategy);
+                if ( has_bound && bound < d )
+                    continue;
+
+                if ( expand )
+                {
+                    typedef typename rtree::elements_type<internal_node2>::type elements2_type;
+                    elements2_type const& elements2 = rtree::elements(rtree::get<internal_node2>(*it->node));
+
+                    for ( typename elements2_type::const_iterator it2 = elements2.begin();
+                          it2 != elements2.end(); ++it2 )
+                    {
+                        child_candidates.push_back(                                             // MAY THROW (A)
+                            candidate(traits::node_distance_call::apply(it1->first, it2->first, m_strategy),
+                                      boost::addressof(it2->first), it2->second));
+                    }
+                }
+                else
+                {
+                    child_candidates.push_back(candidate(d, it->box, it->node));                // MAY THROW (A)
+                }
+            }
+
+            if ( expand && calculate_bound(it1->first, child_candidates, child_level2, bound) )
+            {
+                child_candidates.erase(std::remove_if(child_candidates.begin(), child_candidates.end(),
+                                                      further_than(bound)),
+                                       child_candidates.end());
+            }
+
+            traverse(it1->second, level1 + 1, child_candidates, child_level2);
+        }
+    }
+
+    // Calculates the upper bound of the distance of the k-th nearest neighbor
+    // of any point of the box. Each node contains at least one value so
+    // the k-th smallest far distance is the bound. The leafs store the exact
+    // number of values so a leaf containing at least k values is also the bound.
+    inline bool calculate_bound(box1_type const& b1, candidates_type const& candidates, size_type level2,
+                                node_distance_type & bound)
+    {
+        bool const are_leafs = level2 == m_leafs_level2;
+        bool has_bound = false;
+
+        m_far_distances.clear();
+        for ( typename candidates_type::const_iterator it = candidates.begin();
+              it != candidates.end(); ++it )
+        {
+            node_distance_type far_distance = 0;
+            if ( ! traits::far_distance_call::apply(b1, *it->box, far_distance) )
+                return false;
+
+            if ( are_leafs
+              && m_count <= rtree::elements(rtree::get<leaf2>(*it->node)).size()
+              && ( ! has_bound || far_distance < bound ) )
+            {
+                bound = far_distance;
+                has_bound = true;
+            }
+
+            m_far_distances.push_back(far_distance);                                            // MAY THROW (A)
+        }
+
+        if ( m_count <= m_far_distances.size() )
+        {
+            typename far_distances_type::iterator nth = m_far_distances.begin() + (m_count - 1);
+            std::nth_element(m_far_distances.begin(), nth, m_far_distances.end());
+            if ( ! has_bound || *nth < bound )
+            {
+                bound = *nth;
+                has_bound = true;
+            }
+        }
+
+        return has_bound;
+    }
+
+    inline void search_leaf(leaf1 const& n1, candidates_type const& candidates, size_type level2)
+    {
+        typedef typename rtree::elements_type<leaf1>::type elements1_type;
+        elements1_type const& elements1 = rtree::elements(n1);
+
+        for ( typename elements1_type::const_iterator it1 = elements1.begin();
+              it1 != elements1.end(); ++it1 )
+        {
+            indexable1_type const& indexable1 = m_tr1(*it1);
+
+            // the neighbors of the previous value are probably close to this one
+            // so they're the initial neighbors and the nodes are pruned sooner
+            m_neighbors.clear();
+            for ( typename previous_type::const_iterator it = m_previous.begin();
+                  it != m_previous.end(); ++it )
+            {
+                insert_neighbor(traits::value_distance_call::apply(indexable1, m_tr2(**it), m_strategy), *it);
+            }
+
+            branches_type & branches = level_branches(level2);
+            branches.clear();
+            for ( typename candidates_type::const_iterator it = candidates.begin();
+                  it != candidates.end(); ++it )
+            {
+                value_node_distance_type d = traits::value_node_distance_call::apply(indexable1, *it->box, m_strategy);
+                if ( ! is_prunable(d) )
+                    branches.push_back(std::make_pair(d, it->node));                            // MAY THROW (A)
+            }
+
+            search_branches(indexable1, branches, level2);
+
+            std::sort(m_neighbors.begin(), m_neighbors.end(), neighbors_less);
+            m_previous.clear();
+            for ( typename neighbors_type::const_iterator it = m_neighbors.begin();
+                  it != m_neighbors.end(); ++it )
+            {
+                *m_out_it = std::pair<value1_type, value2_type>(*it1, *it->second);
+                ++m_out_it;
+                ++m_found_count;
+
+                m_previous.push_back(it->second);                                               // MAY THROW (A)
+            }
+        }
+    }
+
+    // depth-first search of the nearest neighbors of the indexable, see distance_query
+    inline void search_branches(indexable1_type const& indexable1, branches_type & branches, size_type level2)
+    {
+        std::sort(branches.begin(), branches.end(), branches_less);
+
+        for ( typename branches_type::const_iterator it = branches.begin();
+              it != branches.end(); ++it )
+        {
+            if ( is_prunable(it->first) )
+                break;
+
+            if ( level2 == m_leafs_level2 )
+            {
+                search_values(indexable1, rtree::get<leaf2>(*it->second));
+            }
+            else
+            {
+                typedef typename rtree::elements_type<internal_node2>::type elements2_type;
+                elements2_type const& elements2 = rtree::elements(rtree::get<internal_node2>(*it->second));
+
+                branches_type & child_branches = level_branches(level2 + 1);
+                child_branches.clear();
+                for ( typename elements2_type::const_iterator it2 = elements2.begin();
+                      it2 != elements2.end(); ++it2 )
+                {
+                    value_node_distance_type d = traits::value_node_distance_call::apply(indexable1, it2->first, m_strategy);
+                    if ( is_prunable(d) )
+                        continue;
+                    child_branches.push_back(std::make_pair(d, it2->second));                  // MAY THROW (A)
+                }
+
+                search_branches(indexable1, child_branches, level2 + 1);
+            }
+        }
+    }
+
+    inline void search_values(indexable1_type const& indexable1, leaf2 const& n2)
+    {
+        typedef typename rtree::elements_type<leaf2>::type elements2_type;
+        elements2_type const& elements2 = rtree::elements(n2);
+
+        for ( typename elements2_type::const_iterator it2 = elements2.begin();
+              it2 != elements2.end(); ++it2 )
+        {
+            value_distance_type d = traits::value_distance_call::apply(indexable1, m_tr2(*it2), m_strategy);
+
+            // the value may already be one of the neighbors of the previous value
+            if ( ( m_neighbors.size() < m_count || d < m_neighbors.front().first )
+              && ! is_neighbor(boost::addressof(*it2)) )
+            {
+                insert_neighbor(d, boost::addressof(*it2));
+            }
+        }
+    }
+
+    inline void insert_neighbor(value_distance_type const& d, value2_type const* v)
+    {
+        if ( m_neighbors.size() < m_count )
+        {
+            m_neighbors.push_back(std::make_pair(d, v));                                        // MAY THROW (A)
+            if ( m_neighbors.size() == m_count )
+                std::make_heap(m_neighbors.begin(), m_neighbors.end(), neighbors_less);
+        }
+        else if ( d < m_neighbors.front().first )
+        {
+            std::pop_heap(m_neighbors.begin(), m_neighbors.end(), neighbors_less);
+            m_neighbors.back().first = d;
+            m_neighbors.back().second = v;
+            std::push_heap(m_neighbors.begin(), m_neighbors.end(), neighbors_less);
+        }
+    }
+
+    inline bool is_neighbor(value2_type const* v) const
+    {
+        for ( typename neighbors_type::const_iterator it = m_neighbors.begin();
+              it != m_neighbors.end(); ++it )
+        {
+            if ( it->second == v )
+                return true;
+        }
+        return false;
+    }
+
+    template <typename Distance>
+    inline bool is_prunable(Distance const& d) const
+    {
+        return m_count <= m_neighbors.size() && m_neighbors.front().first <= d;
+    }
+
+    candidates_type & level_candidates(size_type level)
+    {
+        if ( m_candidates.size() <= level )
+            m_candidates.resize(level + 1);                                                     // MAY THROW (A)
+        return m_candidates[level];
+    }
+
+    branches_type & level_branches(size_type level)
+    {
+        if ( m_branches.size() <= level )
+            m_branches.resize(level + 1);                                                       // MAY THROW (A)
+        return m_branches[level];
+    }
+
+    struct further_than
+    {
+        explicit further_than(node_distance_type const& b) : bound(b) {}
+        bool operator()(candidate const& c) const { return bound < c.distance; }
+        node_distance_type bound;
+    };
+
+    typedef std::vector<node_distance_type> far_distances_type;
+
+    static inline bool branches_less(std::pair<value_node_distance_type, node2_pointer> const& p1,
+                                     std::pair<value_node_distance_type, node2_pointer> const& p2)
+    {
+        return p1.first < p2.first;
+    }
+
+    static inline bool neighbors_less(std::pair<value_distance_type, value2_type const*> const& p1,
+                                      std::pair<value_distance_type, value2_type const*> const& p2)
+    {
+        return p1.first < p2.first;
+    }
+
+    translator1_type const& m_tr1;
+    translator2_type const& m_tr2;
+    size_type m_leafs_level1;
+    size_type m_leafs_level2;
+
+    size_type m_count;
+    OutIter m_out_it;
+    size_type m_found_count;
+
+    strategy_type m_strategy;
+
+    box2_type m_root_box2;
+    // one list per level, the references to the elements of the deques
+    // aren't invalidated when new levels are added
+    std::deque<candidates_type> m_candidates;
+    std::deque<branches_type> m_branches;
+    far_distances_type m_far_distances;
+    neighbors_type m_neighbors;
+    previous_type m_previous;
+};
+
+// Finds k closest pairs of values of two rtrees.
+//
+// The pairs of nodes of both trees are processed in the order of increasing
+// distance using a priority queue. For a pair of internal nodes both of them
+// are expanded, otherwise the internal one. The pairs of nodes further than
+// the furthest of k closest pairs of values found so far are pruned.
+template <typename MembersHolder1, typename MembersHolder2, typename OutIter>
+class closest_pairs
+{
+    typedef nearest_join_traits<MembersHolder1, MembersHolder2> traits;
+
+    typedef typename traits::strategy_type strategy_type;
+    typedef typename traits::translator1_type translator1_type;
+    typedef typename traits::translator2_type translator2_type;
+    typedef typename traits::box1_type box1_type;
+    typedef typename traits::box2_type box2_type;
+    typedef typename traits::internal_node1 internal_node1;
+    typedef typename traits::leaf1 leaf1;
+    typedef typename traits::internal_node2 internal_node2;
+    typedef typename traits::leaf2 leaf2;
+    typedef typename traits::node1_pointer node1_pointer;
+    typedef typename traits::node2_pointer node2_pointer;
+    typedef typename traits::value1_type value1_type;
+    typedef typename traits::value2_type value2_type;
+    typedef typename traits::value_distance_type value_distance_type;
+    typedef typename traits::node_distance_type node_distance_type;
+
+public:
+    typedef typename MembersHolder1::allocators_type::size_type size_type;
+
+    struct node_pair
+    {
+        node_pair(node_distance_type const& d,
+                  box1_type const* b1, node1_pointer n1, size_type l1,
+                  box2_type const* b2, node2_pointer n2, size_type l2)
+            : distance(d), box1(b1), node1(n1), level1(l1), box2(b2), node2(n2), level2(l2)
+        {}
+
+        node_distance_type distance;
+        box1_type const* box1;
+        node1_pointer node1;
+        size_type level1;
+        box2_type const* box2;
+        node2_pointer node2;
+        size_type level2;
+    };
+    typedef std::vector<node_pair> node_pairs_type;
+
+    typedef std::pair<value1_type const*, value2_type const*> values_pair;
+    typedef std::vector< std::pair<value_distance_type, values_pair> > pairs_type;
+
+    inline closest_pairs(MembersHolder1 const& members1, MembersHolder2 const& members2,
+                         unsigned k, OutIter out_it)
+        : m_tr1(members1.translator()), m_tr2(members2.translator())
+        , m_leafs_level1(members1.leafs_level), m_leafs_level2(members2.leafs_level)
+        , m_count(k), m_out_it(out_it)
+        , m_strategy(index::detail::get_strategy(members1.parameters()))
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(0 < m_count, "Number of pairs should be greater than 0");
+
+        m_pairs.reserve(m_count);                                                               // MAY THROW (A)
+    }
+
+    inline void apply(node1_pointer root1, box1_type const& box1,
+                      node2_pointer root2, box2_type const& box2)
+    {
+        m_root_box1 = box1;
+        m_root_box2 = box2;
+
+        m_node_pairs.clear();
+        m_node_pairs.push_back(node_pair(traits::node_distance_call::apply(m_root_box1, m_root_box2, m_strategy),
+                                         boost::addressof(m_root_box1), root1, 0,
+                                         boost::addressof(m_root_box2), root2, 0));
+
+        while ( ! m_node_pairs.empty() )
+        {
+            std::pop_heap(m_node_pairs.begin(), m_node_pairs.end(), node_pairs_greater);
+            node_pair const p = m_node_pairs.back();
+            m_node_pairs.pop_back();
+
+            // the rest of pairs is further
+            if ( is_prunable(p.distance) )
+                break;
+
+            bool const is_leaf1 = p.level1 == m_leafs_level1;
+            bool const is_leaf2 = p.level2 == m_leafs_level2;
+
+            if ( is_leaf1 && is_leaf2 )
+                search_values(rtree::get<leaf1>(*p.node1), rtree::get<leaf2>(*p.node2));
+            else if ( is_leaf1 )
+                expand_second(p);
+            else if ( is_leaf2 )
+                expand_first(p);
+            else
+                expand_both(p);
+        }
+    }
+
+    // Writes the pairs sorted by the distance to the output iterator
+    inline size_type finish()
+    {
+        std::sort(m_pairs.begin(), m_pairs.end(), pairs_less);
+        for ( typename pairs_type::const_iterator it = m_pairs.begin(); it != m_pairs.end(); ++it )
+        {
+            *m_out_it = std::pair<value1_type, value2_type>(*it->second.first, *it->second.second);
+            ++m_out_it;
+        }
+        return m_pairs.size();
+    }
+
+private:
+    inline void expand_first(node_pair const& p)
+    {
+        typedef typename rtree::elements_type<internal_node1>::type elements1_type;
+        elements1_type const& elements1 = rtree::elements(rtree::get<internal_node1>(*p.node1));
+
+        for ( typename elements1_type::const_iterator it1 = elements1.begin();
+              it1 != elements1.end(); ++it1 )
+        {
+            push(boost::addressof(it1->first), it1->second, p.level1 + 1,
+                 p.box2, p.node2, p.level2);
+        }
+    }
+
+    inline void expand_second(node_pair const& p)
+    {
+        typedef typename rtree::elements_type<internal_node2>::type elements2_type;
+        elements2_type const& elements2 = rtree::elements(rtree::get<internal_node2>(*p.node2));
+
+        for ( typename elements2_type::const_iterator it2 = elements2.begin();
+              it2 != elements2.end(); ++it2 )
+        {
+            push(p.box1, p.node1, p.level1,
+                 boost::addressof(it2->first), it2->second, p.level2 + 1);
+        }
+    }
+
+    inline void expand_both(node_pair const& p)
+    {
+        typedef typename rtree::elements_type<internal_node1>::type elements1_type;
+        typedef typename rtree::elements_type<internal_node2>::type elements2_type;
+        elements1_type const& elements1 = rtree::elements(rtree::get<internal_node1>(*p.node1));
+        elements2_type const& elements2 = rtree::elements(rtree::get<internal_node2>(*p.node2));
+
+        for ( typename elements1_type::const_iterator it1 = elements1.begin();
+              it1 != elements1.end(); ++it1 )
+        {
+            for ( typename elements2_type::const_iterator it2 = elements2.begin();
+                  it2 != elements2.end(); ++it2 )
+            {
+                push(boost::addressof(it1->first), it1->second, p.level1 + 1,
+                     boost::addressof(it2->first), it2->second, p.level2 + 1);
+            }
+        }
+    }
+
+    inline void push(box1_type const* b1, node1_pointer n1, size_type l1,
+                     box2_type const* b2, node2_pointer n2, size_type l2)
+    {
+        node_distance_type d = traits::node_distance_call::apply(*b1, *b2, m_strategy);
+        if ( is_prunable(d) )
+            return;
+
+        m_node_pairs.push_back(node_pair(d, b1, n1, l1, b2, n2, l2));                          // MAY THROW (A)
+        std::push_heap(m_node_pairs.begin(), m_node_pairs.end(), node_pairs_greater);
+    }
+
+    inline void search_values(leaf1 const& n1, leaf2 const& n2)
+    {
+        typedef typename rtree::elements_type<leaf1>::type elements1_type;
+        typedef typename rtree::elements_type<leaf2>::type elements2_type;
+        elements1_type const& elements1 = rtree::elements(n1);
+        elements2_type const& elements2 = rtree::elements(n2);
+
+        for ( typename elements1_type::const_iterator it1 = elements1.begin();
+              it1 != elements1.end(); ++it1 )
+        {
+            for ( typename elements2_type::const_iterator it2 = elements2.begin();
+                  it2 != elements2.end(); ++it2 )
+            {
+                value_distance_type d = traits::value_distance_call::apply(m_tr1(*it1), m_tr2(*it2), m_strategy);
+                values_pair values(boost::addressof(*it1), boost::addressof(*it2));
+
+                if ( m_pairs.size() < m_count )
+                {
+                    m_pairs.push_back(std::make_pair(d, values));
+                    if ( m_pairs.size() == m_count )
+                        std::make_heap(m_pairs.begin(), m_pairs.end(), pairs_less);
+                }
+                else if ( d < m_pairs.front().first )
+                {
+                    std::pop_heap(m_pairs.begin(), m_pairs.end(), pairs_less);
+                    m_pairs.back().first = d;
+                    m_pairs.back().second = values;
+                    std::push_heap(m_pairs.begin(), m_pairs.end(), pairs_less);
+                }
+            }
+        }
+    }
+
+    template <typename Distance>
+    inline bool is_prunable(Distance const& d) const
+    {
+        return m_count <= m_pairs.size() && m_pairs.front().first <= d;
+    }
+
+    static inline bool node_pairs_greater(node_pair const& p1, node_pair const& p2)
+    {
+        return p2.distance < p1.distance;
+    }
+
+    static inline bool pairs_less(std::pair<value_distance_type, values_pair> const& p1,
+                                  std::pair<value_distance_type, values_pair> const& p2)
+    {
+        return p1.first < p2.first;
+    }
+
+    translator1_type const& m_tr1;
+    translator2_type const& m_tr2;
+    size_type m_leafs_level1;
+    size_type m_leafs_level2;
+
+    size_type m_count;
+    OutIter m_out_it;
+
+    strategy_type m_strategy;
+
+    box1_type m_root_box1;
+    box2_type m_root_box2;
+    node_pairs_type m_node_pairs;
+    pairs_type m_pairs;
+};
+
+}}} // namespace detail::rtree::visitors
+
+}}} // namespace boost::geometry::index
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_NEAREST_JOIN_HPP
@@ -0,0 +1,249 @@
+// Boost.Geometry Index
+//
+// R-tree spatial join visitor implementation
+//
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_SPATIAL_JOIN_HPP
+#define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_SPATIAL_JOIN_HPP
+
+#include <utility>
+
+namespace boost { namespace geometry { namespace index {
+
+namespace detail { namespace rtree { namespace visitors {
+
+// The predicate used if no additional predicate is passed to join()
+struct join_always_true
+{
+    template <typename Value1, typename Value2>
+    bool operator()(Value1 const& , Value2 const& ) const
+    {
+        return true;
+    }
+};
+
+// Synchronized traversal of two rtrees. Pairs of nodes are visited only
+// if their bounding boxes intersect. If both nodes are internal nodes the
+// traversal descends in both trees, otherwise only in the one containing
+// the internal node. For a pair of leafs the pairs of values whose
+// Indexables intersect and meeting the predicate are written to the output.
+//
+// The node of the first tree is dispatched with first_visitor and then
+// the node of the second tree with second_visitor<Node1>. The nodes are
+// passed by references to the exact types so no temporaries are created.
+template <typename MembersHolder1, typename MembersHolder2, typename Predicate, typename OutIter>
+class spatial_join
+{
+    typedef typename MembersHolder1::parameters_type parameters_type;
+    typedef typename MembersHolder1::translator_type translator1_type;
+    typedef typename MembersHolder2::translator_type translator2_type;
+    typedef typename MembersHolder1::box_type box1_type;
+    typedef typename MembersHolder2::box_type box2_type;
+
+    typedef typename index::detail::strategy_type<parameters_type>::type strategy_type;
+
+    typedef typename MembersHolder1::node node1;
+    typedef typename MembersHolder1::internal_node internal_node1;
+    typedef typename MembersHolder1::leaf leaf1;
+    typedef typename MembersHolder2::node node2;
+    typedef typename MembersHolder2::internal_node internal_node2;
+    typedef typename MembersHolder2::leaf leaf2;
+
+    typedef typename MembersHolder1::value_type value1_type;
+    typedef typename MembersHolder2::value_type value2_type;
+
+    typedef index::detail::spatial_predicate_call<index::detail::predicates::intersects_tag> intersects_call;
+
+public:
+    typedef typename MembersHolder1::allocators_type::size_type size_type;
+
+    inline spatial_join(parameters_type const& par,
+                        translator1_type const& t1, translator2_type const& t2,
+                        Predicate const& p, OutIter out_it)
+        : tr1(t1), tr2(t2), pred(p), out_iter(out_it), found_count(0)
+        , strategy(index::detail::get_strategy(par))
+    {}
+
+    inline void apply(node1 const& n1, box1_type const& b1, node2 const& n2, box2_type const& b2)
+    {
+        first_visitor<node2> v(*this, b1, n2, b2);
+        rtree::apply_visitor(v, n1);
+    }
+
+    inline void operator()(internal_node1 const& n1, box1_type const& ,
+                           internal_node2 const& n2, box2_type const& )
+    {
+        typedef typename rtree::elements_type<internal_node1>::type elements1_type;
+        typedef typename rtree::elements_type<internal_node2>::type elements2_type;
+        elements1_type const& elements1 = rtree::elements(n1);
+        elements2_type const& elements2 = rtree::elements(n2);
+
+        for ( typename elements1_type::const_iterator it1 = elements1.begin();
+              it1 != elements1.end(); ++it1 )
+        {
+            for ( typename elements2_type::const_iterator it2 = elements2.begin();
+                  it2 != elements2.end(); ++it2 )
+            {
+                if ( intersects_call::apply(it1->first, it2->first, strategy) )
+                {
+                    apply(*it1->second, it1->first, *it2->second, it2->first);
+                }
+            }
+        }
+    }
+
+    inline void operator()(internal_node1 const& n1, box1_type const& ,
+                           leaf2 const& n2, box2_type const& b2)
+    {
+        typedef typename rtree::elements_type<internal_node1>::type elements1_type;
+        elements1_type const& elements1 = rtree::elements(n1);
+
+        for ( typename elements1_type::const_iterator it1 = elements1.begin();
+              it1 != elements1.end(); ++it1 )
+        {
+            if ( intersects_call::apply(it1->first, b2, strategy) )
+            {
+                first_visitor<leaf2> v(*this, it1->first, n2, b2);
+                rtree::apply_visitor(v, *it1->second);
+            }
+        }
+    }
+
+    inline void operator()(leaf1 const& n1, box1_type const& b1,
+                           internal_node2 const& n2, box2_type const& )
+    {
+        typedef typename rtree::elements_type<internal_node2>::type elements2_type;
+        elements2_type const& elements2 = rtree::elements(n2);
+
+        for ( typename elements2_type::const_iterator it2 = elements2.begin();
+              it2 != elements2.end(); ++it2 )
+        {
+            if ( intersects_call::apply(b1, it2->first, strategy) )
+            {
+                second_visitor<leaf1> v(*this, n1, b1, it2->first);
+                rtree::apply_visitor(v, *it2->second);
+            }
+        }
+    }
+
+    inline void operator()(leaf1 const& n1, box1_type const& ,
+                           leaf2 const& n2, box2_type const& b2)
+    {
+        typedef typename rtree::elements_type<leaf1>::type elements1_type;
+        typedef typename rtree::elements_type<leaf2>::type elements2_type;
+        elements1_type const& elements1 = rtree::elements(n1);
+        elements2_type const& elements2 = rtree::elements(n2);
+
+        for ( typename elements1_type::const_iterator it1 = elements1.begin();
+              it1 != elements1.end(); ++it1 )
+        {
+            typename translator1_type::result_type indexable1 = tr1(*it1);
+
+            // skip the values outside the other node
+            if ( ! intersects_call::apply(indexable1, b2, strategy) )
+                continue;
+
+            for ( typename elements2_type::const_iterator it2 = elements2.begin();
+                  it2 != elements2.end(); ++it2 )
+            {
+                if ( intersects_call::apply(indexable1, tr2(*it2), strategy)
+                  && pred(*it1, *it2) )
+                {
+                    *out_iter = std::pair<value1_type, value2_type>(*it1, *it2);
+                    ++out_iter;
+
+                    ++found_count;
+                }
+            }
+        }
+    }
+
+    translator1_type const& tr1;
+    translator2_type const& tr2;
+
+    Predicate pred;
+
+    OutIter out_iter;
+    size_type found_count;
+
+    strategy_type strategy;
+
+private:
+    template <typename Node1>
+    inline void dispatch_second(Node1 const& n1, box1_type const& b1, node2 const& n2, box2_type const& b2)
+    {
+        second_visitor<Node1> v(*this, n1, b1, b2);
+        rtree::apply_visitor(v, n2);
+    }
+
+    template <typename Node1>
+    inline void dispatch_second(Node1 const& n1, box1_type const& b1, leaf2 const& n2, box2_type const& b2)
+    {
+        (*this)(n1, b1, n2, b2);
+    }
+
+    // Node2 is either the node of the second tree of unknown kind
+    // or the leaf of the second tree
+    template <typename Node2>
+    class first_visitor
+        : public MembersHolder1::visitor_const
+    {
+    public:
+        first_visitor(spatial_join & j, box1_type const& b1, Node2 const& n2, box2_type const& b2)
+            : m_join(j), m_box1(b1), m_node2(n2), m_box2(b2)
+        {}
+
+        inline void operator()(internal_node1 const& n1)
+        {
+            m_join.dispatch_second(n1, m_box1, m_node2, m_box2);
+        }
+
+        inline void operator()(leaf1 const& n1)
+        {
+            m_join.dispatch_second(n1, m_box1, m_node2, m_box2);
+        }
+
+    private:
+        spatial_join & m_join;
+        box1_type const& m_box1;
+        Node2 const& m_node2;
+        box2_type const& m_box2;
+    };
+
+    template <typename Node1>
+    class second_visitor
+        : public MembersHolder2::visitor_const
+    {
+    public:
+        second_visitor(spatial_join & j, Node1 const& n1, box1_type const& b1, box2_type const& b2)
+            : m_join(j), m_node1(n1), m_box1(b1), m_box2(b2)
+        {}
+
+        inline void operator()(internal_node2 const& n2)
+        {
+            m_join(m_node1, m_box1, n2, m_box2);
+        }
+
+        inline void operator()(leaf2 const& n2)
+        {
+            m_join(m_node1, m_box1, n2, m_box2);
+        }
+
+    private:
+        spatial_join & m_join;
+        Node1 const& m_node1;
+        box1_type const& m_box1;
+        box2_type const& m_box2;
+    };
+};
+
+}}} // namespace detail::rtree::visitors
+
+}}} // namespace boost::geometry::index
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_SPATIAL_JOIN_HPP
@@ -15,17 +15,43 @@
 #ifndef BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_SPATIAL_QUERY_HPP
 #define BOOST_GEOMETRY_INDEX_DETAIL_RTREE_VISITORS_SPATIAL_QUERY_HPP
 
+#include <vector>
+
+#include <boost/mpl/bool.hpp>
+
+#include <boost/geometry/index/detail/algorithms/intersecting_children.hpp>
+
 namespace boost { namespace geometry { namespace index {
 
 namespace detail { namespace rtree { namespace visitors {
 
-template <typename MembersHolder, typename Predicates, typename OutIter>
+// The buffers used by spatial_query_incremental which may be stored
+// in the query_context and reused by subsequent queries.
+template <typename MembersHolder>
+struct spatial_query_buffers
+    : public rtree::query_buffers_base
+{
+    typedef typename rtree::elements_type<
+        typename MembersHolder::internal_node
+    >::type::const_iterator internal_iterator;
+
+    std::vector< std::pair<internal_iterator, internal_iterator> > internal_stack;
+};
+
+template
+<
+    typename MembersHolder,
+    typename Predicates,
+    typename OutIter,
+    typename Statistics = rtree::no_query_statistics
+>
 struct spatial_query
     : public MembersHolder::visitor_const
 {
     typedef typename MembersHolder::parameters_type parameters_type;
     typedef typename MembersHolder::translator_type translator_type;
     typedef typename MembersHolder::allocators_type allocators_type;
+    typedef typename MembersHolder::box_type box_type;
 
     typedef typename index::detail::strategy_type<parameters_type>::type strategy_type;
 
@@ -37,11 +63,51 @@ struct spatial_query
 
     static const unsigned predicates_len = index::detail::predicates_length<Predicates>::value;
 
-    inline spatial_query(parameters_type const& par, translator_type const& t, Predicates const& p, OutIter out_it)
+    inline spatial_query(parameters_type const& par, translator_type const& t, Predicates const& p, OutIter out_it,
+                         Statistics const& stats = Statistics())
         : tr(t), pred(p), out_iter(out_it), found_count(0), strategy(index::detail::get_strategy(par))
+        , statistics(stats)
     {}
 
     inline void operator()(internal_node const& n)
+    {
+        statistics.internal_node(rtree::elements(n).size());
+
+        apply_internal(n, boost::mpl::bool_
+            <
+                index::detail::is_box_intersects_bounds_check<Predicates, box_type>::value
+            >());
+    }
+
+    inline void operator()(leaf const& n)
+    {
+        typedef typename rtree::elements_type<leaf>::type elements_type;
+        elements_type const& elements = rtree::elements(n);
+
+        statistics.leaf();
+        statistics.checked_values(elements.size());
+
+        // get all values meeting predicates
+        for (typename elements_type::const_iterator it = elements.begin();
+            it != elements.end(); ++it)
+        {
+            // if value meets predicates
+            if ( index::detail::predicates_check
+                    <
+                        index::detail::value_tag, 0, predicates_len
+                    >(pred, *it, tr(*it), strategy) )
+            {
+                *out_iter = *it;
+                ++out_iter;
+
+                ++found_count;
+                statistics.found_value();
+            }
+        }
+    }
+
+private:
+    inline void apply_internal(internal_node const& n, boost::mpl::bool_<false> const& /*is_box_intersects*/)
     {
         typedef typename rtree::elements_type<internal_node>::type elements_type;
         elements_type const& elements = rtree::elements(n);
@@ -59,43 +125,180 @@ struct spatial_query
             {
                 rtree::apply_visitor(*this, *it->second);
             }
+            else
+            {
+                statistics.rejected_nodes(1);
+            }
+        }
+    }
+
+    // intersects(box) and equivalent predicates, the children of the node are tested
+    // all at once and the ones intersecting the query box are traversed
+    inline void apply_internal(internal_node const& n, boost::mpl::bool_<true> const& /*is_box_intersects*/)
+    {
+        typedef typename rtree::elements_type<internal_node>::type elements_type;
+        typedef typename index::detail::is_box_intersects_bounds_check
+            <
+                Predicates, box_type
+            >::query_box_type query_box_type;
+        typedef index::detail::intersecting_children<box_type, query_box_type> intersecting_children;
+
+        elements_type const& elements = rtree::elements(n);
+        std::size_t const size = elements.size();
+
+        for ( std::size_t first = 0 ; first < size ; first += index::detail::intersecting_children_max_count )
+        {
+            std::size_t const count = (std::min)(index::detail::intersecting_children_max_count, size - first);
+            boost::uint64_t const mask = intersecting_children::apply(elements.begin() + first, count, pred.geometry);
+
+            for ( std::size_t i = 0 ; i < count ; ++i )
+            {
+                if ( mask & (boost::uint64_t(1) << i) )
+                    rtree::apply_visitor(*this, *elements[first + i].second);
+                else
+                    statistics.rejected_nodes(1);
+            }
         }
     }
 
+public:
+    translator_type const& tr;
+
+    Predicates pred;
+
+    OutIter out_iter;
+    size_type found_count;
+
+    strategy_type strategy;
+
+    Statistics statistics;
+};
+
+// Performs a group of spatial queries during one traversal of the tree.
+// Each node is visited once for all queries meeting the predicates for
+// the bounding box of this node. The indexes of these queries are stored
+// in a stack of active sets, the set of the currently visited node
+// is kept at the end of the stack.
+template <typename MembersHolder, typename Predicates, typename Function>
+class batch_spatial_query
+    : public MembersHolder::visitor_const
+{
+    typedef typename MembersHolder::parameters_type parameters_type;
+    typedef typename MembersHolder::translator_type translator_type;
+    typedef typename MembersHolder::allocators_type allocators_type;
+
+    typedef typename index::detail::strategy_type<parameters_type>::type strategy_type;
+
+public:
+    typedef typename MembersHolder::node node;
+    typedef typename MembersHolder::internal_node internal_node;
+    typedef typename MembersHolder::leaf leaf;
+
+    typedef typename allocators_type::size_type size_type;
+
+    static const unsigned predicates_len = index::detail::predicates_length<Predicates>::value;
+
+    inline batch_spatial_query(parameters_type const& par, translator_type const& t,
+                               std::vector<Predicates> const& preds, size_type first_index,
+                               Function & f)
+        : tr(t), predicates(preds), index_offset(first_index), function(f)
+        , found_count(0), strategy(index::detail::get_strategy(par))
+        , active_first(0), active_last(preds.size())
+    {
+        active.reserve(preds.size() * 2);                                                       // MAY THROW (A)
+        for ( size_type i = 0 ; i < preds.size() ; ++i )
+            active.push_back(i);
+    }
+
+    inline void operator()(internal_node const& n)
+    {
+        typedef typename rtree::elements_type<internal_node>::type elements_type;
+        elements_type const& elements = rtree::elements(n);
+
+        size_type const first = active_first;
+        size_type const last = active_last;
+
+        for (typename elements_type::const_iterator it = elements.begin();
+            it != elements.end(); ++it)
+        {
+            // gather the queries meeting predicates for this child node
+            size_type const child_first = active.size();
+            for ( size_type i = first ; i < last ; ++i )
+            {
+                size_type const q = active[i];
+                // 0 - dummy value
+                if ( index::detail::predicates_check
+                        <
+                            index::detail::bounds_tag, 0, predicates_len
+                        >(predicates[q], 0, it->first, strategy) )
+                {
+                    active.push_back(q);                                                        // MAY THROW (A)
+                }
+            }
+
+            if ( child_first < active.size() )
+            {
+                active_first = child_first;
+                active_last = active.size();
+
+                rtree::apply_visitor(*this, *it->second);
+
+                active.resize(child_first);
+            }
+        }
+
+        active_first = first;
+        active_last = last;
+    }
+
     inline void operator()(leaf const& n)
     {
         typedef typename rtree::elements_type<leaf>::type elements_type;
         elements_type const& elements = rtree::elements(n);
 
-        // get all values meeting predicates
         for (typename elements_type::const_iterator it = elements.begin();
             it != elements.end(); ++it)
         {
-            // if value meets predicates
-            if ( index::detail::predicates_check
-                    <
-                        index::detail::value_tag, 0, predicates_len
-                    >(pred, *it, tr(*it), strategy) )
+            typename translator_type::result_type indexable = tr(*it);
+
+            for ( size_type i = active_first ; i < active_last ; ++i )
             {
-                *out_iter = *it;
-                ++out_iter;
+                size_type const q = active[i];
+                if ( index::detail::predicates_check
+                        <
+                            index::detail::value_tag, 0, predicates_len
+                        >(predicates[q], *it, indexable, strategy) )
+                {
+                    function(index_offset + q, *it);
 
-                ++found_count;
+                    ++found_count;
+                }
             }
         }
     }
 
     translator_type const& tr;
 
-    Predicates pred;
+    std::vector<Predicates> const& predicates;
+    size_type index_offset;
 
-    OutIter out_iter;
+    Function & function;
     size_type found_count;
 
     strategy_type strategy;
+
+private:
+    std::vector<size_type> active;
+    size_type active_first;
+    size_type active_last;
 };
 
-template <typename MembersHolder, typename Predicates>
+template
+<
+    typename MembersHolder,
+    typename Predicates,
+    typename Statistics = rtree::no_query_statistics
+>
 class spatial_query_incremental
     : public MembersHolder::visitor_const
 {
@@ -119,6 +322,8 @@ public:
     typedef typename rtree::elements_type<leaf>::type leaf_elements;
     typedef typename rtree::elements_type<leaf>::type::const_iterator leaf_iterator;
 
+    typedef spatial_query_buffers<MembersHolder> buffers_type;
+
     static const unsigned predicates_len = index::detail::predicates_length<Predicates>::value;
 
     inline spatial_query_incremental()
@@ -129,24 +334,57 @@ public:
 //        , m_strategy()
     {}
 
-    inline spatial_query_incremental(parameters_type const& params, translator_type const& t, Predicates const& p)
+    inline spatial_query_incremental(parameters_type const& params, translator_type const& t, Predicates const& p,
+                                     buffers_type * buffers = 0, Statistics const& stats = Statistics())
         : m_translator(::boost::addressof(t))
         , m_pred(p)
         , m_values(NULL)
         , m_current()
         , m_strategy(index::detail::get_strategy(params))
-    {}
+        , m_buffers(buffers)
+        , m_statistics(stats)
+    {
+        // the stack of the buffers is empty, only the memory is reused
+        if ( buffers )
+            m_internal_stack.swap(buffers->internal_stack);
+    }
+
+    // Takes over the state of the traversal of the other visitor
+    inline spatial_query_incremental(spatial_query_incremental & o, move_state_tag)
+        : m_translator(o.m_translator)
+        , m_pred(o.m_pred)
+        , m_values(o.m_values)
+        , m_current(o.m_current)
+        , m_strategy(o.m_strategy)
+        , m_buffers(o.m_buffers, move_state_tag())
+        , m_statistics(o.m_statistics)
+    {
+        m_internal_stack.swap(o.m_internal_stack);
+    }
+
+    inline ~spatial_query_incremental()
+    {
+        if ( m_buffers.get() )
+        {
+            m_internal_stack.clear();
+            m_internal_stack.swap(m_buffers.get()->internal_stack);
+        }
+    }
 
     inline void operator()(internal_node const& n)
     {
         typedef typename rtree::elements_type<internal_node>::type elements_type;
         elements_type const& elements = rtree::elements(n);
 
+        m_statistics.internal_node(elements.size());
+
         m_internal_stack.push_back(std::make_pair(elements.begin(), elements.end()));
     }
 
     inline void operator()(leaf const& n)
     {
+        m_statistics.leaf();
+
         m_values = ::boost::addressof(rtree::elements(n));
         m_current = rtree::elements(n).begin();
     }
@@ -180,11 +418,13 @@ public:
                 {
                     // return if next value is found
                     value_type const& v = *m_current;
+                    m_statistics.checked_values(1);
                     if (index::detail::predicates_check
                             <
                                index::detail::value_tag, 0, predicates_len
                             >(m_pred, v, (*m_translator)(v), m_strategy))
                     {
+                        m_statistics.found_value();
                         return;
                     }
 
@@ -221,6 +461,10 @@ public:
                 {
                     rtree::apply_visitor(*this, *(it->second));
                 }
+                else
+                {
+                    m_statistics.rejected_nodes(1);
+                }
             }
         }
     }
@@ -246,6 +490,10 @@ private:
     leaf_iterator m_current;
 
     strategy_type m_strategy;
+
+    rtree::attached_buffers_ptr<buffers_type> m_buffers;
+
+    Statistics m_statistics;
 };
 
 }}} // namespace detail::rtree::visitors
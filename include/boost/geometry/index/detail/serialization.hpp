@@ -14,6 +14,8 @@
 #include <boost/serialization/version.hpp>
 //#include <boost/serialization/nvp.hpp>
 
+#include <boost/geometry/index/detail/rtree/private_view.hpp>
+
 // TODO
 // how about using the unsigned type capable of storing Max in compile-time versions?
 
@@ -156,6 +158,29 @@ void load_construct_data(Archive & ar, boost::geometry::index::rstar<Max, Min, R
 template<class Archive, size_t Max, size_t Min, size_t RE, size_t OCT>
 void serialize(Archive &, boost::geometry::index::rstar<Max, Min, RE, OCT> &, unsigned int) {}
 
+// boost::geometry::index::kmeans
+
+template<class Archive, size_t Max, size_t Min>
+void save_construct_data(Archive & ar, const boost::geometry::index::kmeans<Max, Min> * params, unsigned int )
+{
+    size_t max = params->get_max_elements(), min = params->get_min_elements();
+    ar << boost::serialization::make_nvp("max", max);
+    ar << boost::serialization::make_nvp("min", min);
+}
+template<class Archive, size_t Max, size_t Min>
+void load_construct_data(Archive & ar, boost::geometry::index::kmeans<Max, Min> * params, unsigned int )
+{
+    size_t max, min;
+    ar >> boost::serialization::make_nvp("max", max);
+    ar >> boost::serialization::make_nvp("min", min);
+    if ( max != params->get_max_elements() || min != params->get_min_elements() )
+        // TODO change exception type
+        BOOST_THROW_EXCEPTION(std::runtime_error("parameters not compatible"));
+    // the constructor musn't be called for this type
+    //::new(params)boost::geometry::index::kmeans<Max, Min>();
+}
+template<class Archive, size_t Max, size_t Min> void serialize(Archive &, boost::geometry::index::kmeans<Max, Min> &, unsigned int) {}
+
 // boost::geometry::index::dynamic_linear
 
 template<class Archive>
@@ -220,6 +245,25 @@ inline void load_construct_data(Archive & ar, boost::geometry::index::dynamic_rs
 }
 template<class Archive> void serialize(Archive &, boost::geometry::index::dynamic_rstar &, unsigned int) {}
 
+// boost::geometry::index::dynamic_kmeans
+
+template<class Archive>
+inline void save_construct_data(Archive & ar, const boost::geometry::index::dynamic_kmeans * params, unsigned int )
+{
+    size_t max = params->get_max_elements(), min = params->get_min_elements();
+    ar << boost::serialization::make_nvp("max", max);
+    ar << boost::serialization::make_nvp("min", min);
+}
+template<class Archive>
+inline void load_construct_data(Archive & ar, boost::geometry::index::dynamic_kmeans * params, unsigned int )
+{
+    size_t max, min;
+    ar >> boost::serialization::make_nvp("max", max);
+    ar >> boost::serialization::make_nvp("min", min);
+    ::new(params)boost::geometry::index::dynamic_kmeans(max, min);
+}
+template<class Archive> void serialize(Archive &, boost::geometry::index::dynamic_kmeans &, unsigned int) {}
+
 }} // boost::serialization
 
 // TODO - move to index/detail/serialization.hpp or maybe geometry/serialization.hpp
@@ -445,62 +489,6 @@ private:
 
 }}}}} // boost::geometry::index::detail::rtree
 
-// TODO - move to index/detail/rtree/private_view.hpp
-namespace boost { namespace geometry { namespace index { namespace detail { namespace rtree {
-
-template <typename Rtree>
-class const_private_view
-{
-public:
-    typedef typename Rtree::size_type size_type;
-
-    typedef typename Rtree::translator_type translator_type;
-    typedef typename Rtree::value_type value_type;
-    typedef typename Rtree::options_type options_type;
-    typedef typename Rtree::box_type box_type;
-    typedef typename Rtree::allocators_type allocators_type;    
-
-    const_private_view(Rtree const& rt) : m_rtree(rt) {}
-
-    typedef typename Rtree::members_holder members_holder;
-
-    members_holder const& members() const { return m_rtree.m_members; }
-
-private:
-    const_private_view(const_private_view const&);
-    const_private_view & operator=(const_private_view const&);
-
-    Rtree const& m_rtree;
-};
-
-template <typename Rtree>
-class private_view
-{
-public:
-    typedef typename Rtree::size_type size_type;
-
-    typedef typename Rtree::translator_type translator_type;
-    typedef typename Rtree::value_type value_type;
-    typedef typename Rtree::options_type options_type;
-    typedef typename Rtree::box_type box_type;
-    typedef typename Rtree::allocators_type allocators_type;    
-
-    private_view(Rtree & rt) : m_rtree(rt) {}
-
-    typedef typename Rtree::members_holder members_holder;
-
-    members_holder & members() { return m_rtree.m_members; }
-    members_holder const& members() const { return m_rtree.m_members; }
-
-private:
-    private_view(private_view const&);
-    private_view & operator=(private_view const&);
-
-    Rtree & m_rtree;
-};
-
-}}}}} // namespace boost::geometry::index::detail::rtree
-
 // TODO - move to index/serialization/rtree.hpp
 namespace boost { namespace serialization {
 
@@ -6,6 +6,7 @@
 // Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
 // http://www.boost.org/LICENSE_1_0.txt)
 
+#include <boost/core/addressof.hpp>
 #include <boost/swap.hpp>
 //#include <boost/type_traits/is_empty.hpp>
 
@@ -41,6 +42,22 @@ void swap_cond(T & l, T & r, boost::mpl::bool_<true> const&)
 template <typename T> inline
 void swap_cond(T &, T &, boost::mpl::bool_<false> const&) {}
 
+// Calls the function object stored outside, e.g. to keep its state when it's
+// passed to an algorithm or an output iterator which copies it.
+template <typename Function>
+struct function_ref
+{
+    explicit function_ref(Function & f) : m_f(boost::addressof(f)) {}
+
+    template <typename T>
+    void operator()(T const& v) const
+    {
+        (*m_f)(v);
+    }
+
+    Function * m_f;
+};
+
 }}}} // namespace boost::geometry::index::detail
 
 #endif // BOOST_GEOMETRY_INDEX_DETAIL_UTILITIES_HPP
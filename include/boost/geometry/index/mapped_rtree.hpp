@@ -0,0 +1,440 @@
+// Boost.Geometry Index
+//
+// R-tree stored in the flat, pointer-free layout
+//
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_MAPPED_RTREE_HPP
+#define BOOST_GEOMETRY_INDEX_MAPPED_RTREE_HPP
+
+#include <cstddef>
+#include <ostream>
+
+#include <boost/mpl/assert.hpp>
+#include <boost/type_traits/has_trivial_copy.hpp>
+#include <boost/type_traits/has_trivial_destructor.hpp>
+
+#include <boost/geometry/index/rtree.hpp>
+
+#include <boost/geometry/index/detail/rtree/flat/layout.hpp>
+#include <boost/geometry/index/detail/rtree/flat/query.hpp>
+
+namespace boost { namespace geometry { namespace index {
+
+/*!
+\brief The read-only R-tree stored in the flat, pointer-free layout.
+
+The mapped_rtree is a view of the memory containing the rtree written by write_mapped(),
+e.g. a memory-mapped file. The nodes are referenced by offsets so the memory may be
+mapped at any address and the queries are performed directly on it, nothing is
+deserialized or allocated when the view is created.
+
+The Value and the Box must be trivially copyable, they're stored in their native
+representation so the data may only be read on the same kind of platform on which it was written.
+The header is checked when the view is created, the nodes aren't validated.
+
+The memory must be alive and unchanged as long as the mapped_rtree and the query iterators are used.
+
+\par Example
+\verbatim
+// writing
+std::ofstream ofs("tree.bin", std::ios::binary);
+bgi::write_mapped(tree, ofs);
+
+// reading, e.g. using Boost.Interprocess
+bip::file_mapping file("tree.bin", bip::read_only);
+bip::mapped_region region(file, bip::read_only);
+bgi::mapped_rtree<value_t, bgi::rstar<16> > mapped(region.get_address(), region.get_size());
+mapped.query(bgi::intersects(box), std::back_inserter(result));
+\endverbatim
+
+\tparam Value           The type of objects stored in the container.
+\tparam Parameters      Parameters of the rtree which was written, only the strategy is used.
+\tparam IndexableGetter The function object extracting Indexable from Value.
+\tparam EqualTo         The function object comparing objects of type Value.
+*/
+template
+<
+    typename Value,
+    typename Parameters,
+    typename IndexableGetter = index::indexable<Value>,
+    typename EqualTo = index::equal_to<Value>
+>
+class mapped_rtree
+{
+    BOOST_MPL_ASSERT_MSG((boost::has_trivial_copy<Value>::value && boost::has_trivial_destructor<Value>::value),
+                         VALUE_MUST_BE_TRIVIALLY_COPYABLE, (Value));
+
+public:
+    /*! \brief The type of Value stored in the container. */
+    typedef Value value_type;
+    /*! \brief R-tree parameters type. */
+    typedef Parameters parameters_type;
+    /*! \brief The function object extracting Indexable from Value. */
+    typedef IndexableGetter indexable_getter;
+    /*! \brief The function object comparing objects of type Value. */
+    typedef EqualTo value_equal;
+
+    /*! \brief The Indexable type to which Value is translated. */
+    typedef typename index::detail::indexable_type<
+        detail::translator<IndexableGetter, EqualTo>
+    >::type indexable_type;
+
+    /*! \brief The Box type used by the R-tree. */
+    typedef geometry::model::box<
+                geometry::model::point<
+                    typename coordinate_type<indexable_type>::type,
+                    dimension<indexable_type>::value,
+                    typename coordinate_system<indexable_type>::type
+                >
+            >
+    bounds_type;
+
+    /*! \brief Unsigned integral type used by the container. */
+    typedef std::size_t size_type;
+    /*! \brief The const reference type to the contained value. */
+    typedef Value const& const_reference;
+
+    /*! \brief Type of const query iterator, category ForwardIterator. */
+    typedef index::detail::rtree::iterators::query_iterator
+        <
+            value_type, detail::rtree::flat::query_iterator_types<value_type>
+        > const_query_iterator;
+
+private:
+    struct members_holder
+        : public detail::translator<IndexableGetter, EqualTo>
+        , public Parameters
+    {
+        typedef Value value_type;
+        typedef Parameters parameters_type;
+        typedef bounds_type box_type;
+        typedef detail::translator<IndexableGetter, EqualTo> translator_type;
+        typedef detail::rtree::flat::layout<Value, bounds_type> layout_type;
+
+        members_holder(char const* d, detail::rtree::flat::file_header const* h,
+                       IndexableGetter const& ind_get, EqualTo const& val_eq,
+                       Parameters const& parameters)
+            : translator_type(ind_get, val_eq)
+            , Parameters(parameters)
+            , data(d)
+            , header(h)
+        {}
+
+        translator_type const& translator() const { return *this; }
+        Parameters const& parameters() const { return *this; }
+
+        char const* data;
+        detail::rtree::flat::file_header const* header;
+    };
+
+    typedef typename members_holder::layout_type layout_type;
+
+public:
+    /*!
+    \brief The constructor.
+
+    \param data         The pointer to the data written by write_mapped(). It must be aligned
+                        at least to the alignment of Value and 8.
+    \param size         The size of the data in bytes.
+    \param parameters   The parameters object.
+    \param getter       The function object extracting Indexable from Value.
+    \param equal        The function object comparing Values.
+
+    \par Throws
+    std::runtime_error if the data is not aligned, its header is invalid or the
+    Value or Box type is different than the one used to write the data.
+    */
+    inline mapped_rtree(void const* data, size_type size,
+                        parameters_type const& parameters = parameters_type(),
+                        indexable_getter const& getter = indexable_getter(),
+                        value_equal const& equal = value_equal())
+        : m_members(static_cast<char const*>(data),
+                    boost::addressof(layout_type::check_header(static_cast<char const*>(data), size)),
+                    getter, equal, parameters)
+    {}
+
+    /*!
+    \brief Returns the number of stored values.
+
+    \return         The number of stored values.
+
+    \par Throws
+    Nothing.
+    */
+    inline size_type size() const
+    {
+        return static_cast<size_type>(m_members.header->size);
+    }
+
+    /*!
+    \brief Query if the container is empty.
+
+    \return         true if the container is empty.
+
+    \par Throws
+    Nothing.
+    */
+    inline bool empty() const
+    {
+        return 0 == m_members.header->size;
+    }
+
+    /*!
+    \brief Returns the depth of the R-tree, the level of the leafs.
+
+    \par Throws
+    Nothing.
+    */
+    inline size_type depth() const
+    {
+        return static_cast<size_type>(m_members.header->depth);
+    }
+
+    /*!
+    \brief Finds values meeting passed predicates e.g. nearest to some Point and/or intersecting some Box.
+
+    The same predicates as in rtree::query() may be passed.
+
+    \par Throws
+    If Value copy constructor or copy assignment throws.
+    If predicates copy throws.
+
+    \param predicates   Predicates.
+    \param out_it       The output iterator, e.g. generated by std::back_inserter().
+
+    \return             The number of values found.
+    */
+    template <typename Predicates, typename OutIter>
+    size_type query(Predicates const& predicates, OutIter out_it) const
+    {
+        if ( !m_members.header->root )
+            return 0;
+
+        static const unsigned distance_predicates_count = detail::predicates_count_distance<Predicates>::value;
+        static const bool is_distance_predicate = 0 < distance_predicates_count;
+        BOOST_MPL_ASSERT_MSG((distance_predicates_count <= 1), PASS_ONLY_ONE_DISTANCE_PREDICATE, (Predicates));
+
+        return query_dispatch(predicates, out_it, boost::mpl::bool_<is_distance_predicate>());
+    }
+
+    /*!
+    \brief Returns the query iterator pointing at the begin of the query range.
+
+    The same predicates as in rtree::qbegin() may be passed.
+
+    \par Example
+    \verbatim
+    std::copy(mapped.qbegin(bgi::nearest(pt, 3)), mapped.qend(), std::back_inserter(result));
+    \endverbatim
+
+    \par Iterator category
+    ForwardIterator
+
+    \par Throws
+    If predicates copy throws.
+    If allocation throws.
+
+    \warning
+    The iterator is invalidated when the mapped_rtree is destroyed.
+
+    \param predicates   Predicates.
+
+    \return             The iterator pointing at the begin of the query range.
+    */
+    template <typename Predicates>
+    const_query_iterator qbegin(Predicates const& predicates) const
+    {
+        return const_query_iterator(qbegin_(predicates));
+    }
+
+    /*!
+    \brief Returns the query iterator pointing at the end of the query range.
+
+    \par Throws
+    Nothing.
+
+    \return             The iterator pointing at the end of the query range.
+    */
+    const_query_iterator qend() const
+    {
+        return const_query_iterator();
+    }
+
+    /*!
+    \brief Returns the query iterator pointing at the begin of the query range.
+
+    This method returns the iterator of the type depending on the predicates which
+    isn't type-erased as the one returned by qbegin(). It may only be compared
+    with the iterator returned by qend_().
+
+    \par Example
+    \verbatim
+    for ( auto it = mapped.qbegin_(bgi::nearest(pt, 10000)) ; it != mapped.qend_() ; ++it )
+    {
+        // do something with value
+        if ( has_enough_nearest_values() )
+            break;
+    }
+    \endverbatim
+
+    \par Throws
+    If predicates copy throws.
+    If allocation throws.
+
+    \param predicates   Predicates.
+
+    \return             The iterator pointing at the begin of the query range.
+    */
+    template <typename Predicates>
+    typename boost::mpl::if_c<
+        detail::predicates_count_distance<Predicates>::value == 0,
+        detail::rtree::flat::spatial_query_iterator<members_holder, Predicates>,
+        detail::rtree::flat::distance_query_iterator<
+            members_holder, Predicates,
+            detail::predicates_find_distance<Predicates>::value
+        >
+    >::type
+    qbegin_(Predicates const& predicates) const
+    {
+        static const unsigned distance_predicates_count = detail::predicates_count_distance<Predicates>::value;
+        BOOST_MPL_ASSERT_MSG((distance_predicates_count <= 1), PASS_ONLY_ONE_DISTANCE_PREDICATE, (Predicates));
+
+        typedef typename boost::mpl::if_c<
+            detail::predicates_count_distance<Predicates>::value == 0,
+            detail::rtree::flat::spatial_query_iterator<members_holder, Predicates>,
+            detail::rtree::flat::distance_query_iterator<
+                members_holder, Predicates,
+                detail::predicates_find_distance<Predicates>::value
+            >
+        >::type iterator_type;
+
+        return iterator_type(m_members, predicates);
+    }
+
+    /*!
+    \brief Returns the query iterator pointing at the end of the query range.
+
+    \par Throws
+    Nothing.
+
+    \return             The iterator pointing at the end of the query range.
+    */
+    detail::rtree::iterators::end_query_iterator
+        <
+            value_type, detail::rtree::flat::query_iterator_types<value_type>
+        >
+    qend_() const
+    {
+        return detail::rtree::iterators::end_query_iterator
+            <
+                value_type, detail::rtree::flat::query_iterator_types<value_type>
+            >();
+    }
+
+private:
+    template <typename Predicates, typename OutIter>
+    size_type query_dispatch(Predicates const& predicates, OutIter out_it, boost::mpl::bool_<false> const& /*is_distance_predicate*/) const
+    {
+        detail::rtree::flat::spatial_query<members_holder, Predicates, OutIter>
+            find_v(m_members, predicates, out_it);
+
+        find_v.apply(m_members.header->root);
+
+        return find_v.found_count;
+    }
+
+    template <typename Predicates, typename OutIter>
+    size_type query_dispatch(Predicates const& predicates, OutIter out_it, boost::mpl::bool_<true> const& /*is_distance_predicate*/) const
+    {
+        static const unsigned distance_predicate_index = detail::predicates_find_distance<Predicates>::value;
+        detail::rtree::flat::distance_query
+            <
+                members_holder, Predicates, distance_predicate_index, OutIter
+            > distance_v(m_members, predicates, out_it);
+
+        distance_v.apply(m_members.header->root);
+
+        return distance_v.finish();
+    }
+
+    members_holder m_members;
+};
+
+/*!
+\brief Writes the rtree in the flat layout read by the mapped_rtree.
+
+The nodes are written in breadth-first order. The internal nodes store the coordinates
+of the boxes of the children as cache-line aligned arrays, one array per corner and
+dimension, followed by the offsets of the children in the file. The leafs store the Values.
+The Value and the coordinates are written in their native representation so the Value
+must be trivially copyable.
+
+If child_box_bits is 8 or 16 the boxes of the children are quantized, their coordinates
+are stored as 8 or 16-bit integers relative to the box of the node. They're rounded
+outward so the queries return the same values, only more nodes may be traversed.
+The Values in the leafs are stored unchanged. This reduces the size of the internal
+nodes 4 or 8 times for double coordinates. It is supported only for floating point
+coordinates.
+
+\ingroup rtree_functions
+
+\par Example
+\verbatim
+std::ofstream ofs("tree.bin", std::ios::binary);
+bgi::write_mapped(tree, ofs);
+\endverbatim
+
+\par Throws
+If allocation throws. The errors of the stream are reported by its state.
+std::invalid_argument if child_box_bits is not 0, 8 or 16 or the boxes can't be quantized.
+
+\param tree            The spatial index.
+\param os              The output stream opened in binary mode.
+\param child_box_bits  The number of bits of the quantized coordinates of the boxes of the children,
+                        0 if the boxes are stored unchanged.
+*/
+template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator>
+inline void write_mapped(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> const& tree,
+                         std::ostream & os, unsigned child_box_bits = 0)
+{
+    BOOST_MPL_ASSERT_MSG((boost::has_trivial_copy<Value>::value && boost::has_trivial_destructor<Value>::value),
+                         VALUE_MUST_BE_TRIVIALLY_COPYABLE, (Value));
+
+    typedef rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> rtree_type;
+    typedef detail::rtree::const_private_view<rtree_type> view_type;
+
+    view_type view(tree);
+    detail::rtree::flat::write(view.members(), tree.size(), os, child_box_bits);
+}
+
+/*!
+\brief Finds values meeting passed predicates in the mapped_rtree.
+
+It calls \c mapped_rtree::query(Predicates const&, OutIter).
+
+\ingroup rtree_functions
+
+\param tree         The mapped rtree.
+\param predicates   Predicates.
+\param out_it       The output iterator, e.g. generated by std::back_inserter().
+
+\return             The number of values found.
+*/
+template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo,
+          typename Predicates, typename OutIter> inline
+typename mapped_rtree<Value, Parameters, IndexableGetter, EqualTo>::size_type
+query(mapped_rtree<Value, Parameters, IndexableGetter, EqualTo> const& tree,
+      Predicates const& predicates,
+      OutIter out_it)
+{
+    return tree.query(predicates, out_it);
+}
+
+}}} // namespace boost::geometry::index
+
+#endif // BOOST_GEOMETRY_INDEX_MAPPED_RTREE_HPP
@@ -147,12 +147,28 @@ struct rstar
     static size_t get_overlap_cost_threshold() { return OverlapCostThreshold; }
 };
 
-//template <size_t MaxElements, size_t MinElements>
-//struct kmeans
-//{
-//    static const size_t max_elements = MaxElements;
-//    static const size_t min_elements = MinElements;
-//};
+/*!
+\brief K-means r-tree creation algorithm parameters.
+
+The overflowing node is split into two clusters of elements using Lloyd's
+k-means algorithm applied to the centers of elements' bounding boxes.
+
+\tparam MaxElements     Maximum number of elements in nodes.
+\tparam MinElements     Minimum number of elements in nodes. Default: 0.3*Max.
+*/
+template <size_t MaxElements,
+          size_t MinElements = detail::default_min_elements_s<MaxElements>::value>
+struct kmeans
+{
+    BOOST_MPL_ASSERT_MSG((0 < MinElements && 2*MinElements <= MaxElements+1),
+                         INVALID_STATIC_MIN_MAX_PARAMETERS, (kmeans));
+
+    static const size_t max_elements = MaxElements;
+    static const size_t min_elements = MinElements;
+
+    static size_t get_max_elements() { return MaxElements; }
+    static size_t get_min_elements() { return MinElements; }
+};
 
 /*!
 \brief Linear r-tree creation algorithm parameters - run-time version.
@@ -257,6 +273,36 @@ private:
     size_t m_overlap_cost_threshold;
 };
 
+/*!
+\brief K-means r-tree creation algorithm parameters - run-time version.
+*/
+class dynamic_kmeans
+{
+public:
+    /*!
+    \brief The constructor.
+
+    \param max_elements     Maximum number of elements in nodes.
+    \param min_elements     Minimum number of elements in nodes. Default: 0.3*Max.
+    */
+    explicit dynamic_kmeans(size_t max_elements,
+                            size_t min_elements = detail::default_min_elements_d())
+        : m_max_elements(max_elements)
+        , m_min_elements(detail::default_min_elements_d_calc(max_elements, min_elements))
+    {
+        if (!(0 < m_min_elements && 2*m_min_elements <= m_max_elements+1))
+            detail::throw_invalid_argument("invalid min or/and max parameters of dynamic_kmeans");
+    }
+
+    size_t get_max_elements() const { return m_max_elements; }
+    size_t get_min_elements() const { return m_min_elements; }
+
+private:
+    size_t m_max_elements;
+    size_t m_min_elements;
+};
+
+
 
 template <typename Parameters, typename Strategy>
 class parameters
@@ -283,9 +329,58 @@ public:
 };
 
 
+namespace packing {
+
+/*!
+\brief Top-down r-tree packing algorithm.
+
+Recursively splits the elements at the object median along the longest edge
+of their bounding box. This is the algorithm used by default.
+*/
+struct top_down {};
+
+/*!
+\brief Sort-Tile-Recursive r-tree packing algorithm.
+
+Builds the tree bottom-up. On each level the elements are sorted by the first
+coordinate of their centroids, divided into slices, the slices are sorted by
+the following coordinates and tiled into nodes.
+*/
+struct str {};
+
+/*!
+\brief Hilbert-curve r-tree packing algorithm.
+
+Builds the tree bottom-up. On each level the elements are sorted by the
+position of their centroids on the Hilbert curve and tiled into nodes.
+*/
+struct hilbert {};
+
+/*!
+\brief Z-order-curve r-tree packing algorithm.
+
+Builds the tree bottom-up. On each level the elements are sorted by the
+position of their centroids on the Z-order (Morton) curve and tiled into nodes.
+*/
+struct z_order {};
+
+} // namespace packing
+
+
 namespace detail
 {
 
+template <typename PackingTag>
+struct is_packing_tag
+{
+    static const bool value = false;
+};
+
+template <> struct is_packing_tag<packing::top_down> { static const bool value = true; };
+template <> struct is_packing_tag<packing::str> { static const bool value = true; };
+template <> struct is_packing_tag<packing::hilbert> { static const bool value = true; };
+template <> struct is_packing_tag<packing::z_order> { static const bool value = true; };
+
 template <typename Parameters>
 struct strategy_type
 {
@@ -154,11 +154,14 @@ disjoint(Geometry const& g)
 Generate a predicate defining Value and Geometry relationship. With this
 predicate query returns indexed Values that intersect passed Geometry.
 Value is returned by the query if <tt>bg::intersects(Indexable, Geometry)</tt>
-returns <tt>true</tt>.
+returns <tt>true</tt>. If the Geometry is a cartesian box having less dimensions than
+the cartesian points or boxes stored in the rtree only the first coordinates of
+the Indexables are checked, e.g. a 2d box may be used to query (x, y, t) samples.
 
 \par Example
 \verbatim
 bgi::query(spatial_index, bgi::intersects(box), std::back_inserter(result));
+bgi::query(spatial_index, bgi::intersects(box2d) && bgi::during(t0, t1), std::back_inserter(result));
 bgi::query(spatial_index, bgi::intersects(ring), std::back_inserter(result));
 bgi::query(spatial_index, bgi::intersects(polygon), std::back_inserter(result));
 \endverbatim
@@ -273,6 +276,62 @@ within(Geometry const& g)
                 >(g);
 }
 
+/*!
+\brief Generate \c during() predicate.
+
+Generate a predicate defining the closed interval of coordinates in the last dimension of
+the Indexables, e.g. the time of samples indexed with their positions as (x, y, t).
+With this predicate query returns indexed Values whose coordinates in this dimension overlap
+the interval <tt>[first, last]</tt>. It may be connected with spatial predicates using
+a box of lower dimension which constrains only the first dimensions of the Indexables.
+
+\par Example
+\verbatim
+// the samples intersecting 2d box between t0 and t1
+bgi::query(spatial_index, bgi::intersects(box2d) && bgi::during(t0, t1), std::back_inserter(result));
+\endverbatim
+
+\ingroup predicates
+
+\tparam T           The type of coordinates.
+
+\param first        The first coordinate of the interval.
+\param last         The last coordinate of the interval.
+*/
+template <typename T> inline
+detail::predicates::during<T, detail::predicates::last_dimension>
+during(T const& first, T const& last)
+{
+    return detail::predicates::during<T, detail::predicates::last_dimension>(first, last);
+}
+
+/*!
+\brief Generate \c during() predicate for a dimension.
+
+Generate a predicate defining the closed interval of coordinates in the Dimension of the Indexables.
+With this predicate query returns indexed Values whose coordinates in this dimension overlap
+the interval <tt>[first, last]</tt>.
+
+\par Example
+\verbatim
+bgi::query(spatial_index, bgi::during<2>(t0, t1), std::back_inserter(result));
+\endverbatim
+
+\ingroup predicates
+
+\tparam Dimension   The dimension of the coordinates.
+\tparam T           The type of coordinates.
+
+\param first        The first coordinate of the interval.
+\param last         The last coordinate of the interval.
+*/
+template <std::size_t Dimension, typename T> inline
+detail::predicates::during<T, Dimension>
+during(T const& first, T const& last)
+{
+    return detail::predicates::during<T, Dimension>(first, last);
+}
+
 /*!
 \brief Generate satisfies() predicate.
 
@@ -343,6 +402,72 @@ nearest(Geometry const& geometry, unsigned k)
     return detail::predicates::nearest<Geometry>(geometry, k);
 }
 
+/*!
+\brief The depth-first traversal of the k-nearest neighbours query.
+
+The nodes are traversed recursively and the children of each node are visited in the order
+of their distances. This is the default traversal used by \c nearest() predicate.
+
+\ingroup predicates
+*/
+struct depth_first {};
+
+/*!
+\brief The best-first traversal of the k-nearest neighbours query.
+
+The nodes of the whole tree are visited in the order of their distances, using one priority queue.
+
+\ingroup predicates
+*/
+struct best_first {};
+
+/*!
+\brief Generate nearest() predicate performing the depth-first traversal of the tree.
+
+The same as \c nearest(geometry, k).
+
+\ingroup predicates
+
+\param geometry     The geometry from which distance is calculated.
+\param k            The maximum number of values to return.
+*/
+template <typename Geometry> inline
+detail::predicates::nearest<Geometry>
+nearest(Geometry const& geometry, unsigned k, depth_first const&)
+{
+    return detail::predicates::nearest<Geometry>(geometry, k);
+}
+
+/*!
+\brief Generate nearest() predicate performing the best-first traversal of the tree.
+
+The k-nearest neighbours query visits the nodes in the order of their distances to the \c Geometry
+regardless of the subtrees containing them. Less nodes are visited than in the default depth-first
+traversal if the nodes overlap, e.g. in the rtree created by inserting the values one by one.
+For the rtree created with the packing algorithm the depth-first traversal is usually faster
+because it accesses the memory in a more local way. The priority queue is allocated
+for each query unless the \c query_context is passed to the query.
+
+The traversal is used by \c rtree::query() and \c cow_rtree::query(). The query iterators
+and \c mapped_rtree always traverse the tree in the default way.
+
+\par Example
+\verbatim
+bgi::query(spatial_index, bgi::nearest(pt, 5, bgi::best_first()), std::back_inserter(result));
+\endverbatim
+
+\ingroup predicates
+
+\param geometry     The geometry from which distance is calculated.
+\param k            The maximum number of values to return.
+*/
+template <typename Geometry> inline
+detail::predicates::nearest<Geometry, detail::predicates::best_first_tag>
+nearest(Geometry const& geometry, unsigned k, best_first const&)
+{
+    return detail::predicates::nearest<Geometry, detail::predicates::best_first_tag>(geometry, k);
+}
+
 #ifdef BOOST_GEOMETRY_INDEX_DETAIL_EXPERIMENTAL
 
 /*!
@@ -0,0 +1,177 @@
+// Boost.Geometry Index
+//
+// Context of queries storing reusable buffers
+//
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_QUERY_CONTEXT_HPP
+#define BOOST_GEOMETRY_INDEX_QUERY_CONTEXT_HPP
+
+#include <boost/core/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+namespace boost { namespace geometry { namespace index {
+
+namespace detail { namespace rtree {
+
+// The base of the buffers stored in the query_context. The actual type of the buffers
+// depends on the type of the rtree and the types of distances of the query.
+struct query_buffers_base
+{
+    virtual ~query_buffers_base() {}
+};
+
+// The id of the type of the buffers. The address of the function-local static object
+// is unique for each Buffers so the type is checked without RTTI.
+template <typename Buffers>
+inline void const* query_buffers_id()
+{
+    static const char id = 0;
+    return &id;
+}
+
+// The buffers stored in the query_context along with the id of their type.
+struct query_buffers_holder
+{
+    query_buffers_holder() : id(0) {}
+
+    void reset()
+    {
+        ptr.reset();
+        id = 0;
+    }
+
+    boost::scoped_ptr<query_buffers_base> ptr;
+    void const* id;
+};
+
+struct query_context_access;
+
+}} // namespace detail::rtree
+
+/*!
+\brief The context of queries storing the buffers reused in subsequent queries.
+
+The memory required by the k-nearest neighbors queries and query iterators is not released
+when the query ends but kept in the context. So if the context is passed into subsequent
+queries the memory doesn't have to be allocated again. Subsequent knn queries performed
+with query() for the same rtree and the same type of the nearest predicate don't allocate
+memory after the buffers grew to the required size. If the context is used with queries
+requiring different types of the buffers the old buffers are replaced.
+
+The rtree with the dynamic parameters stores the lists of branches in std::vectors so
+the knn query iterators using the context still allocate memory for each traversed node.
+
+The context may be used by one query or iterator at a time. It may be used with any rtree.
+
+\par Example
+\verbatim
+bgi::query_context ctx;
+for ( ... )
+{
+    result.clear();
+    tree.query(bgi::nearest(pt, 5), std::back_inserter(result), ctx);
+}
+\endverbatim
+*/
+class query_context
+    : boost::noncopyable
+{
+public:
+    /*!
+    \brief The constructor.
+
+    \par Throws
+    Nothing.
+    */
+    query_context() {}
+
+    /*!
+    \brief Releases the memory stored in the context.
+
+    \par Throws
+    Nothing.
+    */
+    void clear()
+    {
+        m_query_buffers.reset();
+        m_iterator_buffers.reset();
+    }
+
+private:
+    friend struct detail::rtree::query_context_access;
+
+    detail::rtree::query_buffers_holder m_query_buffers;
+    detail::rtree::query_buffers_holder m_iterator_buffers;
+};
+
+namespace detail { namespace rtree {
+
+// Returns the buffers of a given type, creates them if the context stores
+// the buffers of different type or doesn't store them at all.
+struct query_context_access
+{
+    // The buffers used by rtree::query()
+    template <typename Buffers>
+    static Buffers & query_buffers(query_context & ctx)
+    {
+        return get<Buffers>(ctx.m_query_buffers);
+    }
+
+    // The buffers used by the query iterators
+    template <typename Buffers>
+    static Buffers & iterator_buffers(query_context & ctx)
+    {
+        return get<Buffers>(ctx.m_iterator_buffers);
+    }
+
+private:
+    template <typename Buffers>
+    static Buffers & get(query_buffers_holder & holder)
+    {
+        void const* const id = query_buffers_id<Buffers>();
+        if ( holder.id != id )
+        {
+            holder.reset();
+            holder.ptr.reset(new Buffers());                                                    // MAY THROW (A)
+            holder.id = id;
+        }
+        return static_cast<Buffers&>(*holder.ptr);
+    }
+};
+
+// Passed to the constructors of the incremental visitors and the query iterators taking
+// over the state of the traversal of another object. The containers are swapped so
+// nothing is copied and no memory is allocated.
+struct move_state_tag {};
+
+// The pointer to the buffers used by the incremental visitors. The visitors
+// swap their containers with the ones stored in the buffers when created and
+// swap them back when destroyed. The copies of the pointer are null so the
+// copies of the iterators use their own containers.
+template <typename Buffers>
+class attached_buffers_ptr
+{
+public:
+    explicit attached_buffers_ptr(Buffers * ptr = 0) : m_ptr(ptr) {}
+    attached_buffers_ptr(attached_buffers_ptr const& ) : m_ptr(0) {}
+    attached_buffers_ptr & operator=(attached_buffers_ptr const& ) { m_ptr = 0; return *this; }
+
+    // The buffers are taken over from the other pointer
+    attached_buffers_ptr(attached_buffers_ptr & o, move_state_tag) : m_ptr(o.m_ptr) { o.m_ptr = 0; }
+
+    Buffers * get() const { return m_ptr; }
+
+private:
+    Buffers * m_ptr;
+};
+
+}} // namespace detail::rtree
+
+}}} // namespace boost::geometry::index
+
+#endif // BOOST_GEOMETRY_INDEX_QUERY_CONTEXT_HPP
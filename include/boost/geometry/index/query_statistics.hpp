@@ -0,0 +1,170 @@
+// Boost.Geometry Index
+//
+// Statistics of the traversal of the tree gathered by queries
+//
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+//
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_GEOMETRY_INDEX_QUERY_STATISTICS_HPP
+#define BOOST_GEOMETRY_INDEX_QUERY_STATISTICS_HPP
+
+#include <cstddef>
+
+namespace boost { namespace geometry { namespace index {
+
+/*!
+\brief The statistics of the traversal of the tree gathered by queries.
+
+The object may be passed into the query and the counters are increased while the nodes and values
+are visited. The counters are not reset by the query so the statistics of many queries may be
+gathered in one object. The queries which are not passed the object are not instrumented at all.
+
+The statistics may be used to find out why a query is slow or to compare the trees built with
+different parameters for the same data. The number of visited leafs not containing any value
+meeting the predicates is the measure of the overlap of the nodes traversed by the query.
+
+For the k-nearest neighbors queries the found values are the values meeting the predicates
+which were considered as the neighbors, the number of values returned by the query may be smaller.
+For the query iterators the counters are increased while the iterator is incremented.
+
+\par Example
+\verbatim
+bgi::query_statistics stats;
+tree.query(bgi::intersects(box), std::back_inserter(result), stats);
+std::cout << stats.leafs << " leafs visited, " << stats.empty_leafs << " of them were empty" << std::endl;
+\endverbatim
+*/
+struct query_statistics
+{
+    /*!
+    \brief The constructor, all counters are set to 0.
+
+    \par Throws
+    Nothing.
+    */
+    query_statistics()
+    {
+        reset();
+    }
+
+    /*!
+    \brief Sets all counters to 0.
+
+    \par Throws
+    Nothing.
+    */
+    void reset()
+    {
+        internal_nodes = 0;
+        leafs = 0;
+        checked_nodes = 0;
+        rejected_nodes = 0;
+        checked_values = 0;
+        found_values = 0;
+        empty_leafs = 0;
+    }
+
+    /*!
+    \brief Adds the counters of other statistics.
+
+    \par Throws
+    Nothing.
+    */
+    query_statistics & operator+=(query_statistics const& other)
+    {
+        internal_nodes += other.internal_nodes;
+        leafs += other.leafs;
+        checked_nodes += other.checked_nodes;
+        rejected_nodes += other.rejected_nodes;
+        checked_values += other.checked_values;
+        found_values += other.found_values;
+        empty_leafs += other.empty_leafs;
+        return *this;
+    }
+
+    /*! \brief The number of visited internal nodes. */
+    std::size_t internal_nodes;
+    /*! \brief The number of visited leafs. */
+    std::size_t leafs;
+    /*! \brief The number of the children of visited internal nodes whose bounding boxes were checked. */
+    std::size_t checked_nodes;
+    /*! \brief The number of checked children which weren't visited, not meeting the predicates or pruned by the knn search. */
+    std::size_t rejected_nodes;
+    /*! \brief The number of values checked against the predicates. */
+    std::size_t checked_values;
+    /*! \brief The number of values meeting the predicates. */
+    std::size_t found_values;
+    /*! \brief The number of visited leafs not containing any value meeting the predicates. */
+    std::size_t empty_leafs;
+};
+
+namespace detail { namespace rtree {
+
+// The statistics policy of the query visitors used by default, all calls are no-ops
+struct no_query_statistics
+{
+    inline void internal_node(std::size_t /*children_count*/) const {}
+    inline void leaf() const {}
+    inline void rejected_nodes(std::size_t /*count*/) const {}
+    inline void checked_values(std::size_t /*count*/) const {}
+    inline void found_value() const {}
+};
+
+// The statistics policy increasing the counters of the query_statistics.
+// The copies of the visitors, e.g. stored in the copies of query iterators,
+// increase the counters of the same object.
+class query_statistics_counter
+{
+public:
+    explicit query_statistics_counter(query_statistics & stats)
+        : m_stats(&stats), m_leaf_empty(false)
+    {}
+
+    // The bounding boxes of the children are checked after the node is visited
+    inline void internal_node(std::size_t children_count)
+    {
+        ++m_stats->internal_nodes;
+        m_stats->checked_nodes += children_count;
+    }
+
+    // The leaf is empty until the first found value
+    inline void leaf()
+    {
+        ++m_stats->leafs;
+        ++m_stats->empty_leafs;
+        m_leaf_empty = true;
+    }
+
+    inline void rejected_nodes(std::size_t count)
+    {
+        m_stats->rejected_nodes += count;
+    }
+
+    inline void checked_values(std::size_t count)
+    {
+        m_stats->checked_values += count;
+    }
+
+    inline void found_value()
+    {
+        ++m_stats->found_values;
+        if ( m_leaf_empty )
+        {
+            --m_stats->empty_leafs;
+            m_leaf_empty = false;
+        }
+    }
+
+private:
+    query_statistics * m_stats;
+    bool m_leaf_empty;
+};
+
+}} // namespace detail::rtree
+
+}}} // namespace boost::geometry::index
+
+#endif // BOOST_GEOMETRY_INDEX_QUERY_STATISTICS_HPP
@@ -18,11 +18,18 @@
 
 // STD
 #include <algorithm>
+#include <iterator>
 
 // Boost
 #include <boost/container/new_allocator.hpp>
+#include <boost/core/enable_if.hpp>
+#include <boost/iterator/function_output_iterator.hpp>
 #include <boost/move/move.hpp>
 #include <boost/tuple/tuple.hpp>
+#include <boost/type_traits/is_reference.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/remove_cv.hpp>
+#include <boost/type_traits/remove_reference.hpp>
 
 // Boost.Geometry
 #include <boost/geometry/algorithms/detail/comparable_distance/interface.hpp>
@@ -53,6 +60,8 @@
 
 #include <boost/geometry/index/predicates.hpp>
 #include <boost/geometry/index/distance_predicates.hpp>
+#include <boost/geometry/index/query_context.hpp>
+#include <boost/geometry/index/query_statistics.hpp>
 #include <boost/geometry/index/detail/rtree/adaptors.hpp>
 
 #include <boost/geometry/index/detail/meta.hpp>
@@ -64,26 +73,34 @@
 #include <boost/geometry/index/detail/rtree/visitors/insert.hpp>
 #include <boost/geometry/index/detail/rtree/visitors/iterator.hpp>
 #include <boost/geometry/index/detail/rtree/visitors/remove.hpp>
+#include <boost/geometry/index/detail/rtree/visitors/bulk_remove.hpp>
 #include <boost/geometry/index/detail/rtree/visitors/copy.hpp>
 #include <boost/geometry/index/detail/rtree/visitors/destroy.hpp>
 #include <boost/geometry/index/detail/rtree/visitors/spatial_query.hpp>
 #include <boost/geometry/index/detail/rtree/visitors/distance_query.hpp>
 #include <boost/geometry/index/detail/rtree/visitors/count.hpp>
 #include <boost/geometry/index/detail/rtree/visitors/children_box.hpp>
+#include <boost/geometry/index/detail/rtree/visitors/spatial_join.hpp>
+#include <boost/geometry/index/detail/rtree/visitors/nearest_join.hpp>
 
 #include <boost/geometry/index/detail/rtree/linear/linear.hpp>
 #include <boost/geometry/index/detail/rtree/quadratic/quadratic.hpp>
 #include <boost/geometry/index/detail/rtree/rstar/rstar.hpp>
-//#include <boost/geometry/extensions/index/detail/rtree/kmeans/kmeans.hpp>
+#include <boost/geometry/index/detail/rtree/kmeans/kmeans.hpp>
 
 #include <boost/geometry/index/detail/rtree/pack_create.hpp>
+#include <boost/geometry/index/detail/rtree/pack_bottom_up.hpp>
+#include <boost/geometry/index/detail/rtree/pack_insert.hpp>
+#include <boost/geometry/index/detail/rtree/optimize.hpp>
 
 #include <boost/geometry/index/inserter.hpp>
 
 #include <boost/geometry/index/detail/rtree/utilities/view.hpp>
+#include <boost/geometry/index/detail/rtree/private_view.hpp>
 
 #include <boost/geometry/index/detail/rtree/iterators.hpp>
 #include <boost/geometry/index/detail/rtree/query_iterators.hpp>
+#include <boost/geometry/index/detail/rtree/parallel_query.hpp>
 
 #ifdef BOOST_GEOMETRY_INDEX_DETAIL_EXPERIMENTAL
 // serialization
@@ -113,13 +130,15 @@ algorithm with specific parameters like min and max number of elements in node.
 Predefined algorithms with compile-time parameters are:
 \li <tt>boost::geometry::index::linear</tt>,
  \li <tt>boost::geometry::index::quadratic</tt>,
- \li <tt>boost::geometry::index::rstar</tt>.
+ \li <tt>boost::geometry::index::rstar</tt>,
+ \li <tt>boost::geometry::index::kmeans</tt>.
 
 \par
 Predefined algorithms with run-time parameters are:
  \li \c boost::geometry::index::dynamic_linear,
  \li \c boost::geometry::index::dynamic_quadratic,
- \li \c boost::geometry::index::dynamic_rstar.
+ \li \c boost::geometry::index::dynamic_rstar,
+ \li \c boost::geometry::index::dynamic_kmeans.
 
 \par IndexableGetter
 The object of IndexableGetter type translates from Value to Indexable each time
@@ -305,10 +324,8 @@ private:
     typedef typename members_holder::allocator_traits_type allocator_traits_type;
 
     friend class detail::rtree::utilities::view<rtree>;
-#ifdef BOOST_GEOMETRY_INDEX_DETAIL_EXPERIMENTAL
     friend class detail::rtree::private_view<rtree>;
     friend class detail::rtree::const_private_view<rtree>;
-#endif
 
 public:
 
@@ -337,6 +354,20 @@ public:
             value_type, allocators_type
         > const_query_iterator;
 
+private:
+    // The type of the iterator returned by qbegin_()
+    template <typename Predicates>
+    struct qbegin_iterator
+        : boost::mpl::if_c<
+            detail::predicates_count_distance<Predicates>::value == 0,
+            detail::rtree::iterators::spatial_query_iterator<members_holder, Predicates>,
+            detail::rtree::iterators::distance_query_iterator<
+                members_holder, Predicates,
+                detail::predicates_find_distance<Predicates>::value
+            >
+        >
+    {};
+
 public:
 
     /*!
@@ -440,6 +471,186 @@ public:
         m_members.leafs_level = ll;
     }
 
+    /*!
+    \brief The constructor.
+
+    The tree is created using packing algorithm run in parallel by the
+    specified number of threads. The resulting tree is the same as the one
+    created by the serial packing algorithm. If threads are not supported
+    the tree is created in the calling thread.
+
+    \param first            The beginning of the range of Values.
+    \param last             The end of the range of Values.
+    \param parameters       The parameters object.
+    \param threads_count    The maximum number of threads used to create the tree.
+    \param getter           The function object extracting Indexable from Value.
+    \param equal            The function object comparing Values.
+    \param allocator        The allocator object.
+
+    \par Throws
+    \li If allocator copy constructor throws.
+    \li If Value copy constructor or copy assignment throws.
+    \li If allocation throws or returns invalid value.
+    \li If a thread can't be created.
+
+    \warning
+    The allocator, Value copy constructor and IndexableGetter are used concurrently
+    so they must be safe to use from multiple threads.
+    */
+    template<typename Iterator>
+    inline rtree(Iterator first, Iterator last,
+                 parameters_type const& parameters,
+                 size_type threads_count,
+                 indexable_getter const& getter = indexable_getter(),
+                 value_equal const& equal = value_equal(),
+                 allocator_type const& allocator = allocator_type())
+        : m_members(getter, equal, parameters, allocator)
+    {
+        typedef detail::rtree::pack<members_holder> pack;
+        size_type vc = 0, ll = 0;
+        m_members.root = pack::apply(first, last, vc, ll,
+                                     m_members.parameters(), m_members.translator(),
+                                     m_members.allocators(), threads_count);
+        m_members.values_count = vc;
+        m_members.leafs_level = ll;
+    }
+
+    /*!
+    \brief The constructor.
+
+    The tree is created using packing algorithm run in parallel by the
+    specified number of threads. The resulting tree is the same as the one
+    created by the serial packing algorithm. If threads are not supported
+    the tree is created in the calling thread.
+
+    \param rng              The range of Values.
+    \param parameters       The parameters object.
+    \param threads_count    The maximum number of threads used to create the tree.
+    \param getter           The function object extracting Indexable from Value.
+    \param equal            The function object comparing Values.
+    \param allocator        The allocator object.
+
+    \par Throws
+    \li If allocator copy constructor throws.
+    \li If Value copy constructor or copy assignment throws.
+    \li If allocation throws or returns invalid value.
+    \li If a thread can't be created.
+
+    \warning
+    The allocator, Value copy constructor and IndexableGetter are used concurrently
+    so they must be safe to use from multiple threads.
+    */
+    template<typename Range>
+    inline rtree(Range const& rng,
+                 parameters_type const& parameters,
+                 size_type threads_count,
+                 indexable_getter const& getter = indexable_getter(),
+                 value_equal const& equal = value_equal(),
+                 allocator_type const& allocator = allocator_type())
+        : m_members(getter, equal, parameters, allocator)
+    {
+        typedef detail::rtree::pack<members_holder> pack;
+        size_type vc = 0, ll = 0;
+        m_members.root = pack::apply(::boost::begin(rng), ::boost::end(rng), vc, ll,
+                                     m_members.parameters(), m_members.translator(),
+                                     m_members.allocators(), threads_count);
+        m_members.values_count = vc;
+        m_members.leafs_level = ll;
+    }
+
+    /*!
+    \brief The constructor.
+
+    The tree is created using the packing algorithm selected by the packing tag.
+    Currently bgi::packing::top_down (the default), bgi::packing::str,
+    bgi::packing::hilbert and bgi::packing::z_order are supported.
+
+    \param first        The beginning of the range of Values.
+    \param last         The end of the range of Values.
+    \param parameters   The parameters object.
+    \param packing_tag  The packing algorithm tag.
+    \param getter       The function object extracting Indexable from Value.
+    \param equal        The function object comparing Values.
+    \param allocator    The allocator object.
+
+    \par Throws
+    \li If allocator copy constructor throws.
+    \li If Value copy constructor or copy assignment throws.
+    \li If allocation throws or returns invalid value.
+    */
+    template<typename Iterator, typename PackingTag>
+    inline rtree(Iterator first, Iterator last,
+                 parameters_type const& parameters,
+                 PackingTag const& packing_tag,
+                 indexable_getter const& getter = indexable_getter(),
+                 value_equal const& equal = value_equal(),
+                 allocator_type const& allocator = allocator_type(),
+                 typename boost::enable_if_c
+                    <
+                        detail::is_packing_tag<PackingTag>::value
+                    >::type * = 0)
+        : m_members(getter, equal, parameters, allocator)
+    {
+        boost::ignore_unused(packing_tag);
+
+        typedef typename detail::rtree::packing_algorithm
+            <
+                members_holder, PackingTag
+            >::type pack;
+        size_type vc = 0, ll = 0;
+        m_members.root = pack::apply(first, last, vc, ll,
+                                     m_members.parameters(), m_members.translator(),
+                                     m_members.allocators());
+        m_members.values_count = vc;
+        m_members.leafs_level = ll;
+    }
+
+    /*!
+    \brief The constructor.
+
+    The tree is created using the packing algorithm selected by the packing tag.
+    Currently bgi::packing::top_down (the default), bgi::packing::str,
+    bgi::packing::hilbert and bgi::packing::z_order are supported.
+
+    \param rng          The range of Values.
+    \param parameters   The parameters object.
+    \param packing_tag  The packing algorithm tag.
+    \param getter       The function object extracting Indexable from Value.
+    \param equal        The function object comparing Values.
+    \param allocator    The allocator object.
+
+    \par Throws
+    \li If allocator copy constructor throws.
+    \li If Value copy constructor or copy assignment throws.
+    \li If allocation throws or returns invalid value.
+    */
+    template<typename Range, typename PackingTag>
+    inline rtree(Range const& rng,
+                 parameters_type const& parameters,
+                 PackingTag const& packing_tag,
+                 indexable_getter const& getter = indexable_getter(),
+                 value_equal const& equal = value_equal(),
+                 allocator_type const& allocator = allocator_type(),
+                 typename boost::enable_if_c
+                    <
+                        detail::is_packing_tag<PackingTag>::value
+                    >::type * = 0)
+        : m_members(getter, equal, parameters, allocator)
+    {
+        boost::ignore_unused(packing_tag);
+
+        typedef typename detail::rtree::packing_algorithm
+            <
+                members_holder, PackingTag
+            >::type pack;
+        size_type vc = 0, ll = 0;
+        m_members.root = pack::apply(::boost::begin(rng), ::boost::end(rng), vc, ll,
+                                     m_members.parameters(), m_members.translator(),
+                                     m_members.allocators());
+        m_members.values_count = vc;
+        m_members.leafs_level = ll;
+    }
+
     /*!
     \brief The destructor.
 
@@ -691,6 +902,11 @@ public:
     /*!
     \brief Insert a range of values to the index.
 
+    If the iterators are forward iterators and the range is big enough the values
+    are packed into a new tree with the packing algorithm and the leafs of the lower
+    of the two trees are grafted into the higher one. Otherwise the values are inserted
+    one by one.
+
     \param first    The beginning of the range of values.
     \param last     The end of the range of values.
 
@@ -707,11 +923,16 @@ public:
     template <typename Iterator>
     inline void insert(Iterator first, Iterator last)
     {
-        if ( !m_members.root )
-            this->raw_create();
-
-        for ( ; first != last ; ++first )
-            this->raw_insert(*first);
+        typedef boost::mpl::bool_
+            <
+                boost::is_convertible
+                    <
+                        typename std::iterator_traits<Iterator>::iterator_category,
+                        std::forward_iterator_tag
+                    >::value
+            > is_forward_t;
+
+        this->raw_insert_range(first, last, is_forward_t());
     }
 
     /*!
@@ -779,6 +1000,9 @@ public:
     to these passed as a range. Furthermore this method removes only one value for each one passed
     in the range, not all equal values.
 
+    If the iterators are forward iterators referencing values the tree is traversed
+    only once and the underflowed nodes are reinserted at the end.
+
     \param first    The beginning of the range of values.
     \param last     The end of the range of values.
 
@@ -797,14 +1021,75 @@ public:
     template <typename Iterator>
     inline size_type remove(Iterator first, Iterator last)
     {
-        size_type result = 0;
+        if ( !m_members.root )
+            return 0;
+
+        typedef typename std::iterator_traits<Iterator>::reference reference;
+        typedef boost::mpl::bool_
+            <
+                boost::is_convertible
+                    <
+                        typename std::iterator_traits<Iterator>::iterator_category,
+                        std::forward_iterator_tag
+                    >::value
+             && boost::is_reference<reference>::value
+             && boost::is_same
+                    <
+                        typename boost::remove_cv
+                            <
+                                typename boost::remove_reference<reference>::type
+                            >::type,
+                        value_type
+                    >::value
+            > is_bulk_t;
+
+        return this->raw_remove_range(first, last, is_bulk_t());
+    }
+
+    /*!
+    \brief Remove values meeting passed spatial predicates e.g. intersecting some Box.
+
+    In contrast to the other remove() methods all values meeting the predicates are removed.
+    The tree is traversed only once, the nodes not meeting the predicates are skipped and
+    the underflowed nodes are reinserted at the end. Spatial predicates and satisfies() may be
+    passed, nearest predicate is not supported.
+
+    <b>Example</b>
+    \verbatim
+    tree.remove_if(bgi::intersects(box));
+    tree.remove_if(bgi::within(box) && bgi::satisfies(is_expired));
+    \endverbatim
+
+    \param predicates   Predicates.
+
+    \return             The number of removed values.
+
+    \par Throws
+    \li If Value copy constructor or copy assignment throws.
+    \li If allocation throws or returns invalid value.
+
+    \warning
+    This operation only guarantees that there will be no memory leaks.
+    After an exception is thrown the R-tree may be left in an inconsistent state,
+    elements must not be inserted or removed. Other operations are allowed however
+    some of them may return invalid data.
+    */
+    template <typename Predicates>
+    inline size_type remove_if(Predicates const& predicates)
+    {
+        static const unsigned distance_predicates_count = detail::predicates_count_distance<Predicates>::value;
+        BOOST_MPL_ASSERT_MSG((distance_predicates_count == 0), NEAREST_PREDICATE_IS_NOT_SUPPORTED_BY_REMOVE_IF, (Predicates));
 
         if ( !m_members.root )
-            return result;
+            return 0;
 
-        for ( ; first != last ; ++first )
-            result += this->raw_remove(*first);
-        return result;
+        typedef detail::rtree::visitors::bulk_remove_predicates_selector
+            <
+                members_holder, Predicates
+            > selector_type;
+
+        selector_type selector(predicates, m_members.parameters(), m_members.translator());
+        return this->raw_bulk_remove(selector);                                                     // MAY THROW (V, E: alloc, copy, N: alloc)
     }
 
     /*!
@@ -880,6 +1165,9 @@ public:
     in returning k values to the output iterator. Only one nearest predicate may be passed to the query.
     It may be generated by:
     \li \c boost::geometry::index::nearest().
+
+    The tree is traversed depth-first by default. The best-first traversal may be requested
+    by passing \c boost::geometry::index::best_first() to \c nearest().
         
     <b>Connecting predicates</b>
 
@@ -940,127 +1228,226 @@ public:
         static const bool is_distance_predicate = 0 < distance_predicates_count;
         BOOST_MPL_ASSERT_MSG((distance_predicates_count <= 1), PASS_ONLY_ONE_DISTANCE_PREDICATE, (Predicates));
 
-        return query_dispatch(predicates, out_it, boost::mpl::bool_<is_distance_predicate>());
+        return query_dispatch(predicates, out_it, boost::mpl::bool_<is_distance_predicate>(), 0,
+                              detail::rtree::no_query_statistics());
     }
 
     /*!
-    \brief Returns a query iterator pointing at the begin of the query range.
+    \brief Finds values meeting passed predicates e.g. nearest to some Point and/or intersecting some Box.
 
-    This method returns an iterator which may be used to perform iterative queries.
-    For the information about predicates which may be passed to this method see query().
+    This query function performs the same query as query(Predicates const&, OutIter) but the memory
+    required by the k-nearest neighbors search is taken from the context and kept there after the
+    query ends. Subsequent knn queries using the same context don't allocate memory once the buffers
+    grew to the required size. The spatial queries don't allocate memory so they don't use the context.
 
     \par Example
-    \verbatim    
-    for ( Rtree::const_query_iterator it = tree.qbegin(bgi::nearest(pt, 10000)) ;
-          it != tree.qend() ; ++it )
-    {
-        // do something with value
-        if ( has_enough_nearest_values() )
-            break;
-    }
-
-    // C++11 (auto)
-    for ( auto it = tree.qbegin(bgi::nearest(pt, 3)) ; it != tree.qend() ; ++it )
+    \verbatim
+    bgi::query_context ctx;
+    for ( std::size_t i = 0 ; i < points.size() ; ++i )
     {
-        // do something with value
+        result.clear();
+        tree.query(bgi::nearest(points[i], 5), std::back_inserter(result), ctx);
     }
-
-    // C++14 (generic lambda expression)
-    std::for_each(tree.qbegin(bgi::nearest(pt, 3)), tree.qend(), [](auto const& val){
-        // do something with value
-    });
     \endverbatim
 
-    \par Iterator category
-    ForwardIterator
-
     \par Throws
+    If Value copy constructor or copy assignment throws.
     If predicates copy throws.
     If allocation throws.
 
     \warning
-    The modification of the rtree may invalidate the iterators.
+    The context may be used by one query at a time.
 
     \param predicates   Predicates.
-    
-    \return             The iterator pointing at the begin of the query range.
+    \param out_it       The output iterator, e.g. generated by std::back_inserter().
+    \param ctx          The context storing the buffers.
+
+    \return             The number of values found.
     */
-    template <typename Predicates>
-    const_query_iterator qbegin(Predicates const& predicates) const
+    template <typename Predicates, typename OutIter>
+    size_type query(Predicates const& predicates, OutIter out_it, query_context & ctx) const
     {
-        return const_query_iterator(qbegin_(predicates));
+        if ( !m_members.root )
+            return 0;
+
+        static const unsigned distance_predicates_count = detail::predicates_count_distance<Predicates>::value;
+        static const bool is_distance_predicate = 0 < distance_predicates_count;
+        BOOST_MPL_ASSERT_MSG((distance_predicates_count <= 1), PASS_ONLY_ONE_DISTANCE_PREDICATE, (Predicates));
+
+        return query_dispatch(predicates, out_it, boost::mpl::bool_<is_distance_predicate>(), boost::addressof(ctx),
+                              detail::rtree::no_query_statistics());
     }
 
     /*!
-    \brief Returns a query iterator pointing at the end of the query range.
+    \brief Finds values meeting passed predicates e.g. nearest to some Point and/or intersecting some Box.
 
-    This method returns an iterator which may be used to check if the query has ended.
+    This query function performs the same query as query(Predicates const&, OutIter) and gathers
+    the statistics of the traversal of the tree, e.g. the numbers of visited nodes and checked values.
+    The counters of the statistics are increased so the statistics of subsequent queries may be
+    gathered in one object. The queries performed without the statistics object aren't affected.
 
     \par Example
-    \verbatim    
-    for ( Rtree::const_query_iterator it = tree.qbegin(bgi::nearest(pt, 10000)) ;
-          it != tree.qend() ; ++it )
-    {
-        // do something with value
-        if ( has_enough_nearest_values() )
-            break;
-    }
-
-    // C++11 (auto)
-    for ( auto it = tree.qbegin(bgi::nearest(pt, 3)) ; it != tree.qend() ; ++it )
-    {
-        // do something with value
-    }
-
-    // C++14 (generic lambda expression)
-    std::for_each(tree.qbegin(bgi::nearest(pt, 3)), tree.qend(), [](auto const& val){
-        // do something with value
-    });
+    \verbatim
+    bgi::query_statistics stats;
+    tree.query(bgi::intersects(box), std::back_inserter(result), stats);
+    std::cout << stats.internal_nodes << " " << stats.leafs << " " << stats.empty_leafs << std::endl;
     \endverbatim
 
-    \par Iterator category
-    ForwardIterator
-
     \par Throws
-    Nothing
+    If Value copy constructor or copy assignment throws.
+    If predicates copy throws.
 
-    \warning
-    The modification of the rtree may invalidate the iterators.
-    
-    \return             The iterator pointing at the end of the query range.
+    \param predicates   Predicates.
+    \param out_it       The output iterator, e.g. generated by std::back_inserter().
+    \param stats        The statistics object.
+
+    \return             The number of values found.
     */
-    const_query_iterator qend() const
+    template <typename Predicates, typename OutIter>
+    size_type query(Predicates const& predicates, OutIter out_it, query_statistics & stats) const
     {
-        return const_query_iterator();
-    }
+        if ( !m_members.root )
+            return 0;
+
+        static const unsigned distance_predicates_count = detail::predicates_count_distance<Predicates>::value;
+        static const bool is_distance_predicate = 0 < distance_predicates_count;
+        BOOST_MPL_ASSERT_MSG((distance_predicates_count <= 1), PASS_ONLY_ONE_DISTANCE_PREDICATE, (Predicates));
+
+        return query_dispatch(predicates, out_it, boost::mpl::bool_<is_distance_predicate>(), 0,
+                              detail::rtree::query_statistics_counter(stats));
+    }
 
-#ifndef BOOST_GEOMETRY_INDEX_DETAIL_EXPERIMENTAL
-private:
-#endif
     /*!
-    \brief Returns a query iterator pointing at the begin of the query range.
+    \brief Calls a function object for each value meeting passed predicates.
 
-    This method returns an iterator which may be used to perform iterative queries.
+    This query function performs the same query as query(Predicates const&, OutIter) but
+    instead of storing the values in the output iterator the function object is called
+    for each of them. The tree is traversed at once, so unlike the query iterators there is
+    no state of the traversal stored between the values and no memory is allocated for
+    the type-erased iterator. For the information about predicates which may be passed
+    to this method see query().
+
+    \par Example
+    \verbatim
+    tree.query_visit(bgi::intersects(box), do_something());
+
+    // C++11 (lambda expression)
+    tree.query_visit(bgi::nearest(pt, 5), [&](value_type const& val){
+        // do something
+    });
+    \endverbatim
+
+    \par Throws
+    If the function object throws.
+    If predicates copy throws.
+
+    \param predicates   Predicates.
+    \param f            The function object called with each found value.
+
+    \return             The function object after it was called for all found values,
+                        like in std::for_each().
+    */
+    template <typename Predicates, typename Function>
+    Function query_visit(Predicates const& predicates, Function f) const
+    {
+        query(predicates, boost::make_function_output_iterator(detail::function_ref<Function>(f)));
+        return f;
+    }
+
+    /*!
+    \brief Performs a group of spatial queries at once.
+
+    This function is an equivalent of calling query() for each of the predicates
+    stored in a range but the tree is traversed once for a group of queries.
+    Each node is visited once for all queries whose predicates are met for the
+    bounding box of this node so the upper levels of the tree are not loaded
+    from memory for each query separately. The queries are processed in groups
+    of consecutive predicates so it's beneficial if spatially close queries
+    are stored next to each other, e.g. if they're sorted along a space-filling curve.
+
+    For each value meeting the predicates of a query the function object is
+    called with the index of the predicates in the range and the value.
+    The order of values and queries passed to the function object is unspecified.
     For the information about predicates which may be passed to this method see query().
-    
-    The type of the returned iterator depends on the type of passed Predicates but the iterator of this type
-    may be assigned to the variable of const_query_iterator type. If you'd like to use the type of the iterator
-    returned by this method you may get the type e.g. by using C++11 decltype or Boost.Typeof library.
-    This iterator may be compared with iterators returned by both versions of qend() method.
 
     \par Example
     \verbatim
-    // Store the result in the container using std::copy() - it requires both iterators of the same type
-    std::copy(tree.qbegin_(bgi::intersects(box)), tree.qend_(bgi::intersects(box)), std::back_inserter(result));
+    std::vector<Box> boxes;
+    // C++11 (lambda expression)
+    tree.batch_query(boxes | boost::adaptors::transformed(
+                                 [](Box const& b){ return bgi::intersects(b); }),
+                     [&](size_t query_index, value_type const& val){
+                         results[query_index].push_back(val);
+                     });
+    \endverbatim
 
-    // Store the result in the container using std::copy() and type-erased iterators
-    Rtree::const_query_iterator first = tree.qbegin_(bgi::intersects(box));
-    Rtree::const_query_iterator last = tree.qend_();
-    std::copy(first, last, std::back_inserter(result));
+    \par Throws
+    If Value copy constructor or copy assignment throws.
+    If predicates copy throws.
+    If allocation throws.
 
-    // Boost.Typeof
-    typedef BOOST_TYPEOF(tree.qbegin(bgi::nearest(pt, 10000))) Iter;
-    for ( Iter it = tree.qbegin_(bgi::nearest(pt, 10000)) ; it != tree.qend_() ; ++it )
+    \warning
+    Only spatial predicates and satisfies() may be passed. Passing the nearest()
+    predicate results in compile-time error.
+
+    \param predicates   The range of Predicates.
+    \param f            The function object called for each found value.
+
+    \return             The number of values found by all queries.
+    */
+    template <typename PredicatesRange, typename Function>
+    size_type batch_query(PredicatesRange const& predicates, Function f) const
+    {
+        typedef typename boost::range_value<PredicatesRange>::type predicates_type;
+
+        static const unsigned distance_predicates_count = detail::predicates_count_distance<predicates_type>::value;
+        BOOST_MPL_ASSERT_MSG((distance_predicates_count == 0), NEAREST_PREDICATE_IS_NOT_SUPPORTED_BY_BATCH_QUERY, (predicates_type));
+
+        if ( !m_members.root )
+            return 0;
+
+        typedef detail::rtree::visitors::batch_spatial_query
+            <
+                members_holder, predicates_type, Function
+            > batch_query_v;
+
+        // the maximum number of queries performed during one traversal
+        static const size_type group_size = 1024;
+
+        std::vector<predicates_type> group;
+        group.reserve(group_size);                                                              // MAY THROW (A)
+
+        size_type found_count = 0;
+        size_type first_index = 0;
+        typedef typename boost::range_iterator<PredicatesRange const>::type iterator_type;
+        iterator_type it = ::boost::begin(predicates);
+        iterator_type const last = ::boost::end(predicates);
+        while ( it != last )
+        {
+            group.clear();
+            for ( ; it != last && group.size() < group_size ; ++it )
+                group.push_back(*it);                                                           // MAY THROW (C)
+
+            batch_query_v v(m_members.parameters(), m_members.translator(), group, first_index, f);
+            detail::rtree::apply_visitor(v, *m_members.root);
+
+            found_count += v.found_count;
+            first_index += static_cast<size_type>(group.size());
+        }
+
+        return found_count;
+    }
+
+    /*!
+    \brief Returns a query iterator pointing at the begin of the query range.
+
+    This method returns an iterator which may be used to perform iterative queries.
+    For the information about predicates which may be passed to this method see query().
+
+    \par Example
+    \verbatim    
+    for ( Rtree::const_query_iterator it = tree.qbegin(bgi::nearest(pt, 10000)) ;
+          it != tree.qend() ; ++it )
     {
         // do something with value
         if ( has_enough_nearest_values() )
@@ -1068,12 +1455,15 @@ private:
     }
 
     // C++11 (auto)
-    for ( auto it = tree.qbegin_(bgi::nearest(pt, 10000)) ; it != tree.qend_() ; ++it )
+    for ( auto it = tree.qbegin(bgi::nearest(pt, 3)) ; it != tree.qend() ; ++it )
     {
         // do something with value
-        if ( has_enough_nearest_values() )
-            break;
     }
+
+    // C++14 (generic lambda expression)
+    std::for_each(tree.qbegin(bgi::nearest(pt, 3)), tree.qend(), [](auto const& val){
+        // do something with value
+    });
     \endverbatim
 
     \par Iterator category
@@ -1091,51 +1481,42 @@ private:
     \return             The iterator pointing at the begin of the query range.
     */
     template <typename Predicates>
-    typename boost::mpl::if_c<
-        detail::predicates_count_distance<Predicates>::value == 0,
-        detail::rtree::iterators::spatial_query_iterator<members_holder, Predicates>,
-        detail::rtree::iterators::distance_query_iterator<
-            members_holder, Predicates,
-            detail::predicates_find_distance<Predicates>::value
-        >
-    >::type
-    qbegin_(Predicates const& predicates) const
+    const_query_iterator qbegin(Predicates const& predicates) const
     {
         static const unsigned distance_predicates_count = detail::predicates_count_distance<Predicates>::value;
         BOOST_MPL_ASSERT_MSG((distance_predicates_count <= 1), PASS_ONLY_ONE_DISTANCE_PREDICATE, (Predicates));
 
-        typedef typename boost::mpl::if_c<
-            detail::predicates_count_distance<Predicates>::value == 0,
-            detail::rtree::iterators::spatial_query_iterator<members_holder, Predicates>,
-            detail::rtree::iterators::distance_query_iterator<
-                members_holder, Predicates,
-                detail::predicates_find_distance<Predicates>::value
-            >
-        >::type iterator_type;
-
-        if ( !m_members.root )
-            return iterator_type(m_members.parameters(), m_members.translator(), predicates);
+        typedef typename qbegin_iterator<Predicates>::type iterator_type;
 
-        return iterator_type(m_members.root, m_members.parameters(), m_members.translator(), predicates);
+        // the iterator is created in place so the containers of the traversal aren't copied
+        return const_query_iterator(detail::rtree::iterators::query_iterator_emplace_tag<iterator_type>(),
+                                    m_members.root, m_members.parameters(),                     // MAY THROW (A)
+                                    m_members.translator(), predicates,
+                                    static_cast<typename iterator_type::buffers_type *>(0));
     }
 
     /*!
-    \brief Returns the query iterator pointing at the end of the query range.
+    \brief Returns the query iterator pointing at the begin of the query range.
 
-    This method returns the iterator which may be used to perform iterative queries. For the information
-    about the predicates which may be passed to this method see query().
-    
-    The type of the returned iterator depends on the type of passed Predicates but the iterator of this type
-    may be assigned to the variable of const_query_iterator type. If you'd like to use the type of the iterator
-    returned by this method you may get the type e.g. by using C++11 decltype or Boost.Typeof library.
-
-    The type of the iterator returned by this method is the same as the one returned by qbegin() to which
-    the same predicates were passed.
+    This method returns the same iterator as qbegin(Predicates const&) but the memory used
+    by the traversal is taken from the context and returned into it when the iterator is destroyed.
+    The copies of the returned iterator use their own memory. The type-erased iterator is created
+    in place so no memory is allocated for it unless the predicates are big, e.g. they store big
+    function objects.
 
     \par Example
     \verbatim
-    // Store the result in the container using std::copy() - it requires both iterators of the same type
-    std::copy(tree.qbegin_(bgi::intersects(box)), tree.qend_(bgi::intersects(box)), std::back_inserter(result));
+    bgi::query_context ctx;
+    for ( std::size_t i = 0 ; i < points.size() ; ++i )
+    {
+        for ( Rtree::const_query_iterator it = tree.qbegin(bgi::nearest(points[i], 100), ctx) ;
+              it != tree.qend() ; ++it )
+        {
+            // do something with value
+            if ( has_enough_nearest_values() )
+                break;
+        }
+    }
     \endverbatim
 
     \par Iterator category
@@ -1143,316 +1524,652 @@ private:
 
     \par Throws
     If predicates copy throws.
+    If allocation throws.
 
     \warning
     The modification of the rtree may invalidate the iterators.
+    The context must outlive the iterator and may be used by one iterator at a time.
 
     \param predicates   Predicates.
-    
-    \return             The iterator pointing at the end of the query range.
+    \param ctx          The context storing the buffers.
+
+    \return             The iterator pointing at the begin of the query range.
     */
     template <typename Predicates>
-    typename boost::mpl::if_c<
-        detail::predicates_count_distance<Predicates>::value == 0,
-        detail::rtree::iterators::spatial_query_iterator<members_holder, Predicates>,
-        detail::rtree::iterators::distance_query_iterator<
-            members_holder, Predicates,
-            detail::predicates_find_distance<Predicates>::value
-        >
-    >::type
-    qend_(Predicates const& predicates) const
+    const_query_iterator qbegin(Predicates const& predicates, query_context & ctx) const
     {
         static const unsigned distance_predicates_count = detail::predicates_count_distance<Predicates>::value;
         BOOST_MPL_ASSERT_MSG((distance_predicates_count <= 1), PASS_ONLY_ONE_DISTANCE_PREDICATE, (Predicates));
 
-        typedef typename boost::mpl::if_c<
-            detail::predicates_count_distance<Predicates>::value == 0,
-            detail::rtree::iterators::spatial_query_iterator<members_holder, Predicates>,
-            detail::rtree::iterators::distance_query_iterator<
-                members_holder, Predicates,
-                detail::predicates_find_distance<Predicates>::value
-            >
-        >::type iterator_type;
+        typedef typename qbegin_iterator<Predicates>::type iterator_type;
 
-        return iterator_type(m_members.parameters(), m_members.translator(), predicates);
+        typename iterator_type::buffers_type & buffers
+            = detail::rtree::query_context_access::iterator_buffers
+                <
+                    typename iterator_type::buffers_type
+                >(ctx);
+
+        // the iterator is created in place so it's not detached from the buffers
+        return const_query_iterator(detail::rtree::iterators::query_iterator_emplace_tag<iterator_type>(),
+                                    m_members.root, m_members.parameters(),                     // MAY THROW (A)
+                                    m_members.translator(), predicates,
+                                    boost::addressof(buffers));
     }
 
     /*!
-    \brief Returns the query iterator pointing at the end of the query range.
-
-    This method returns the iterator which may be compared with the iterator returned by qbegin() in order to
-    check if the query has ended.
-    
-    The type of the returned iterator is different than the type returned by qbegin() but the iterator of this type
-    may be assigned to the variable of const_query_iterator type. If you'd like to use the type of the iterator returned by this
-    method, which most certainly will be faster than the type-erased iterator, you may get the type
-    e.g. by using C++11 decltype or Boost.Typeof library.
+    \brief Returns the query iterator pointing at the begin of the query range.
 
-    The type of the iterator returned by this method is different than the type returned by qbegin().
+    This method returns the same iterator as qbegin(Predicates const&) and the iterator gathers
+    the statistics of the traversal of the tree while it's incremented. The copies of the returned
+    iterator increase the counters of the same statistics object.
 
     \par Example
     \verbatim
-    // Store the result in the container using std::copy() and type-erased iterators
-    Rtree::const_query_iterator first = tree.qbegin_(bgi::intersects(box));
-    Rtree::const_query_iterator last = tree.qend_();
-    std::copy(first, last, std::back_inserter(result));
-
-    // Boost.Typeof
-    typedef BOOST_TYPEOF(tree.qbegin(bgi::nearest(pt, 10000))) Iter;
-    for ( Iter it = tree.qbegin_(bgi::nearest(pt, 10000)) ; it != tree.qend_() ; ++it )
-    {
-        // do something with value
-        if ( has_enough_nearest_values() )
-            break;
-    }
-
-    // C++11 (auto)
-    for ( auto it = tree.qbegin_(bgi::nearest(pt, 10000)) ; it != tree.qend_() ; ++it )
+    bgi::query_statistics stats;
+    for ( Rtree::const_query_iterator it = tree.qbegin(bgi::nearest(pt, 100), stats) ;
+          it != tree.qend() ; ++it )
     {
         // do something with value
         if ( has_enough_nearest_values() )
             break;
     }
+    std::cout << stats.internal_nodes << " " << stats.leafs << std::endl;
     \endverbatim
 
     \par Iterator category
     ForwardIterator
 
     \par Throws
-    Nothing
+    If predicates copy throws.
+    If allocation throws.
 
     \warning
     The modification of the rtree may invalidate the iterators.
-    
-    \return             The iterator pointing at the end of the query range.
+    The statistics object must outlive the iterator.
+
+    \param predicates   Predicates.
+    \param stats        The statistics object.
+
+    \return             The iterator pointing at the begin of the query range.
     */
-    detail::rtree::iterators::end_query_iterator<value_type, allocators_type>
-    qend_() const
+    template <typename Predicates>
+    const_query_iterator qbegin(Predicates const& predicates, query_statistics & stats) const
     {
-        return detail::rtree::iterators::end_query_iterator<value_type, allocators_type>();
-    }
+        static const unsigned distance_predicates_count = detail::predicates_count_distance<Predicates>::value;
+        BOOST_MPL_ASSERT_MSG((distance_predicates_count <= 1), PASS_ONLY_ONE_DISTANCE_PREDICATE, (Predicates));
 
-public:
+        typedef typename boost::mpl::if_c<
+            detail::predicates_count_distance<Predicates>::value == 0,
+            detail::rtree::iterators::spatial_query_iterator<
+                members_holder, Predicates,
+                detail::rtree::query_statistics_counter
+            >,
+            detail::rtree::iterators::distance_query_iterator<
+                members_holder, Predicates,
+                detail::predicates_find_distance<Predicates>::value,
+                detail::rtree::query_statistics_counter
+            >
+        >::type iterator_type;
+
+        return const_query_iterator(detail::rtree::iterators::query_iterator_emplace_tag<iterator_type>(),
+                                    m_members.root, m_members.parameters(),                     // MAY THROW (A)
+                                    m_members.translator(), predicates,
+                                    detail::rtree::query_statistics_counter(stats));
+    }
 
     /*!
-    \brief Returns the iterator pointing at the begin of the rtree values range.
+    \brief Returns a query iterator pointing at the end of the query range.
 
-    This method returns the iterator which may be used to iterate over all values
-    stored in the rtree.
+    This method returns an iterator which may be used to check if the query has ended.
 
     \par Example
-    \verbatim
-    // Copy all values into the vector
-    std::copy(tree.begin(), tree.end(), std::back_inserter(vec));
-
-    for ( Rtree::const_iterator it = tree.begin() ; it != tree.end() ; ++it )
+    \verbatim    
+    for ( Rtree::const_query_iterator it = tree.qbegin(bgi::nearest(pt, 10000)) ;
+          it != tree.qend() ; ++it )
     {
         // do something with value
+        if ( has_enough_nearest_values() )
+            break;
     }
 
     // C++11 (auto)
-    for ( auto it = tree.begin() ; it != tree.end() ; ++it )
+    for ( auto it = tree.qbegin(bgi::nearest(pt, 3)) ; it != tree.qend() ; ++it )
     {
         // do something with value
     }
 
     // C++14 (generic lambda expression)
-    std::for_each(tree.begin(), tree.end(), [](auto const& val){
+    std::for_each(tree.qbegin(bgi::nearest(pt, 3)), tree.qend(), [](auto const& val){
         // do something with value
-    })
+    });
     \endverbatim
 
     \par Iterator category
     ForwardIterator
 
     \par Throws
-    If allocation throws.
+    Nothing
 
     \warning
     The modification of the rtree may invalidate the iterators.
-
-    \return             The iterator pointing at the begin of the range.
+    
+    \return             The iterator pointing at the end of the query range.
     */
-    const_iterator begin() const
+    const_query_iterator qend() const
     {
-        if ( !m_members.root )
-            return const_iterator();
-
-        return const_iterator(m_members.root);
+        return const_query_iterator();
     }
 
+#ifndef BOOST_GEOMETRY_INDEX_DETAIL_EXPERIMENTAL
+private:
+#endif
     /*!
-    \brief Returns the iterator pointing at the end of the rtree values range.
+    \brief Returns a query iterator pointing at the begin of the query range.
 
-    This method returns the iterator which may be compared with the iterator returned by begin()
-    in order to check if the iteration has ended.
+    This method returns an iterator which may be used to perform iterative queries.
+    For the information about predicates which may be passed to this method see query().
+    
+    The type of the returned iterator depends on the type of passed Predicates but the iterator of this type
+    may be assigned to the variable of const_query_iterator type. If you'd like to use the type of the iterator
+    returned by this method you may get the type e.g. by using C++11 decltype or Boost.Typeof library.
+    This iterator may be compared with iterators returned by both versions of qend() method.
 
     \par Example
     \verbatim
-    for ( Rtree::const_iterator it = tree.begin() ; it != tree.end() ; ++it )
-    {
-        // do something with value
-    }
+    // Store the result in the container using std::copy() - it requires both iterators of the same type
+    std::copy(tree.qbegin_(bgi::intersects(box)), tree.qend_(bgi::intersects(box)), std::back_inserter(result));
 
-    // C++11 (lambda expression)
-    std::for_each(tree.begin(), tree.end(), [](value_type const& val){
+    // Store the result in the container using std::copy() and type-erased iterators
+    Rtree::const_query_iterator first = tree.qbegin_(bgi::intersects(box));
+    Rtree::const_query_iterator last = tree.qend_();
+    std::copy(first, last, std::back_inserter(result));
+
+    // Boost.Typeof
+    typedef BOOST_TYPEOF(tree.qbegin(bgi::nearest(pt, 10000))) Iter;
+    for ( Iter it = tree.qbegin_(bgi::nearest(pt, 10000)) ; it != tree.qend_() ; ++it )
+    {
         // do something with value
-    })
+        if ( has_enough_nearest_values() )
+            break;
+    }
+
+    // C++11 (auto)
+    for ( auto it = tree.qbegin_(bgi::nearest(pt, 10000)) ; it != tree.qend_() ; ++it )
+    {
+        // do something with value
+        if ( has_enough_nearest_values() )
+            break;
+    }
     \endverbatim
 
     \par Iterator category
     ForwardIterator
 
     \par Throws
-    Nothing.
+    If predicates copy throws.
+    If allocation throws.
 
     \warning
     The modification of the rtree may invalidate the iterators.
 
-    \return             The iterator pointing at the end of the range.
+    \param predicates   Predicates.
+    
+    \return             The iterator pointing at the begin of the query range.
     */
-    const_iterator end() const
+    template <typename Predicates>
+    typename boost::mpl::if_c<
+        detail::predicates_count_distance<Predicates>::value == 0,
+        detail::rtree::iterators::spatial_query_iterator<members_holder, Predicates>,
+        detail::rtree::iterators::distance_query_iterator<
+            members_holder, Predicates,
+            detail::predicates_find_distance<Predicates>::value
+        >
+    >::type
+    qbegin_(Predicates const& predicates) const
     {
-        return const_iterator();
-    }
+        static const unsigned distance_predicates_count = detail::predicates_count_distance<Predicates>::value;
+        BOOST_MPL_ASSERT_MSG((distance_predicates_count <= 1), PASS_ONLY_ONE_DISTANCE_PREDICATE, (Predicates));
 
-    /*!
-    \brief Returns the number of stored values.
+        typedef typename boost::mpl::if_c<
+            detail::predicates_count_distance<Predicates>::value == 0,
+            detail::rtree::iterators::spatial_query_iterator<members_holder, Predicates>,
+            detail::rtree::iterators::distance_query_iterator<
+                members_holder, Predicates,
+                detail::predicates_find_distance<Predicates>::value
+            >
+        >::type iterator_type;
 
-    \return         The number of stored values.
+        if ( !m_members.root )
+            return iterator_type(m_members.parameters(), m_members.translator(), predicates);
 
-    \par Throws
-    Nothing.
-    */
-    inline size_type size() const
-    {
-        return m_members.values_count;
+        return iterator_type(m_members.root, m_members.parameters(), m_members.translator(), predicates);
     }
 
     /*!
-    \brief Query if the container is empty.
+    \brief Returns the query iterator pointing at the begin of the query range.
 
-    \return         true if the container is empty.
+    This method returns the same iterator as qbegin_(Predicates const&) but the memory used
+    by the traversal is taken from the context and returned into it when the iterator is destroyed.
+    The copies of the returned iterator use their own memory so the returned iterator should be
+    used directly, e.g. stored in a variable of a type deduced with C++11 auto.
 
-    \par Throws
-    Nothing.
-    */
-    inline bool empty() const
+    \par Example
+    \verbatim
+    bgi::query_context ctx;
+    for ( auto it = tree.qbegin_(bgi::nearest(pt, 10000), ctx) ; it != tree.qend_() ; ++it )
     {
-        return 0 == m_members.values_count;
+        // do something with value
+        if ( has_enough_nearest_values() )
+            break;
     }
+    \endverbatim
 
-    /*!
-    \brief Removes all values stored in the container.
+    \par Iterator category
+    ForwardIterator
 
     \par Throws
-    Nothing.
-    */
-    inline void clear()
-    {
-        this->raw_destroy(*this);
-    }
-
-    /*!
-    \brief Returns the box able to contain all values stored in the container.
+    If predicates copy throws.
+    If allocation throws.
 
-    Returns the box able to contain all values stored in the container.
-    If the container is empty the result of \c geometry::assign_inverse() is returned.
+    \warning
+    The modification of the rtree may invalidate the iterators.
+    The context must outlive the iterator and may be used by one iterator at a time.
 
-    \return     The box able to contain all values stored in the container or an invalid box if
-                there are no values in the container.
+    \param predicates   Predicates.
+    \param ctx          The context storing the buffers.
 
-    \par Throws
-    Nothing.
+    \return             The iterator pointing at the begin of the query range.
     */
-    inline bounds_type bounds() const
+    template <typename Predicates>
+    typename qbegin_iterator<Predicates>::type
+    qbegin_(Predicates const& predicates, query_context & ctx) const
     {
-        bounds_type result;
-        // in order to suppress the uninitialized variable warnings
-        geometry::assign_inverse(result);
+        static const unsigned distance_predicates_count = detail::predicates_count_distance<Predicates>::value;
+        BOOST_MPL_ASSERT_MSG((distance_predicates_count <= 1), PASS_ONLY_ONE_DISTANCE_PREDICATE, (Predicates));
 
-        if ( m_members.root )
-        {
-            detail::rtree::visitors::children_box
-                <
-                    members_holder
-                > box_v(result, m_members.parameters(), m_members.translator());
-            detail::rtree::apply_visitor(box_v, *m_members.root);
-        }
+        typedef typename qbegin_iterator<Predicates>::type iterator_type;
 
-        return result;
+        return iterator_type(m_members.root, m_members.parameters(), m_members.translator(), predicates,
+                             boost::addressof(
+                                 detail::rtree::query_context_access::iterator_buffers
+                                    <
+                                        typename iterator_type::buffers_type
+                                    >(ctx)));
     }
 
     /*!
-    \brief Count Values or Indexables stored in the container.
+    \brief Returns the query iterator pointing at the end of the query range.
+
+    This method returns the iterator which may be used to perform iterative queries. For the information
+    about the predicates which may be passed to this method see query().
     
-    For indexable_type it returns the number of values which indexables equals the parameter.
-    For value_type it returns the number of values which equals the parameter.
+    The type of the returned iterator depends on the type of passed Predicates but the iterator of this type
+    may be assigned to the variable of const_query_iterator type. If you'd like to use the type of the iterator
+    returned by this method you may get the type e.g. by using C++11 decltype or Boost.Typeof library.
 
-    \param vori The value or indexable which will be counted.
+    The type of the iterator returned by this method is the same as the one returned by qbegin() to which
+    the same predicates were passed.
 
-    \return     The number of values found.
+    \par Example
+    \verbatim
+    // Store the result in the container using std::copy() - it requires both iterators of the same type
+    std::copy(tree.qbegin_(bgi::intersects(box)), tree.qend_(bgi::intersects(box)), std::back_inserter(result));
+    \endverbatim
+
+    \par Iterator category
+    ForwardIterator
 
     \par Throws
-    Nothing.
+    If predicates copy throws.
+
+    \warning
+    The modification of the rtree may invalidate the iterators.
+
+    \param predicates   Predicates.
+    
+    \return             The iterator pointing at the end of the query range.
     */
-    template <typename ValueOrIndexable>
-    size_type count(ValueOrIndexable const& vori) const
+    template <typename Predicates>
+    typename boost::mpl::if_c<
+        detail::predicates_count_distance<Predicates>::value == 0,
+        detail::rtree::iterators::spatial_query_iterator<members_holder, Predicates>,
+        detail::rtree::iterators::distance_query_iterator<
+            members_holder, Predicates,
+            detail::predicates_find_distance<Predicates>::value
+        >
+    >::type
+    qend_(Predicates const& predicates) const
     {
-        if ( !m_members.root )
-            return 0;
-
-        // the input should be convertible to Value or Indexable type
-        typedef typename index::detail::convertible_type
-            <
-                ValueOrIndexable,
-                value_type,
-                indexable_type
-            >::type value_or_indexable;
+        static const unsigned distance_predicates_count = detail::predicates_count_distance<Predicates>::value;
+        BOOST_MPL_ASSERT_MSG((distance_predicates_count <= 1), PASS_ONLY_ONE_DISTANCE_PREDICATE, (Predicates));
 
-        static const bool is_void = boost::is_same<value_or_indexable, void>::value;
-        BOOST_MPL_ASSERT_MSG((! is_void),
-                             PASSED_OBJECT_NOT_CONVERTIBLE_TO_VALUE_NOR_INDEXABLE_TYPE,
-                             (ValueOrIndexable));
+        typedef typename boost::mpl::if_c<
+            detail::predicates_count_distance<Predicates>::value == 0,
+            detail::rtree::iterators::spatial_query_iterator<members_holder, Predicates>,
+            detail::rtree::iterators::distance_query_iterator<
+                members_holder, Predicates,
+                detail::predicates_find_distance<Predicates>::value
+            >
+        >::type iterator_type;
 
-        // NOTE: If an object of convertible but not the same type is passed
-        // into the function, here a temporary will be created.
-        return this->template raw_count<value_or_indexable>(vori);
+        return iterator_type(m_members.parameters(), m_members.translator(), predicates);
     }
 
     /*!
-    \brief Returns parameters.
+    \brief Returns the query iterator pointing at the end of the query range.
 
-    \return     The parameters object.
+    This method returns the iterator which may be compared with the iterator returned by qbegin() in order to
+    check if the query has ended.
+    
+    The type of the returned iterator is different than the type returned by qbegin() but the iterator of this type
+    may be assigned to the variable of const_query_iterator type. If you'd like to use the type of the iterator returned by this
+    method, which most certainly will be faster than the type-erased iterator, you may get the type
+    e.g. by using C++11 decltype or Boost.Typeof library.
 
-    \par Throws
-    Nothing.
-    */
-    inline parameters_type parameters() const
+    The type of the iterator returned by this method is different than the type returned by qbegin().
+
+    \par Example
+    \verbatim
+    // Store the result in the container using std::copy() and type-erased iterators
+    Rtree::const_query_iterator first = tree.qbegin_(bgi::intersects(box));
+    Rtree::const_query_iterator last = tree.qend_();
+    std::copy(first, last, std::back_inserter(result));
+
+    // Boost.Typeof
+    typedef BOOST_TYPEOF(tree.qbegin(bgi::nearest(pt, 10000))) Iter;
+    for ( Iter it = tree.qbegin_(bgi::nearest(pt, 10000)) ; it != tree.qend_() ; ++it )
     {
-        return m_members.parameters();
+        // do something with value
+        if ( has_enough_nearest_values() )
+            break;
     }
 
-    /*!
-    \brief Returns function retrieving Indexable from Value.
+    // C++11 (auto)
+    for ( auto it = tree.qbegin_(bgi::nearest(pt, 10000)) ; it != tree.qend_() ; ++it )
+    {
+        // do something with value
+        if ( has_enough_nearest_values() )
+            break;
+    }
+    \endverbatim
 
-    \return     The indexable_getter object.
+    \par Iterator category
+    ForwardIterator
 
     \par Throws
-    Nothing.
+    Nothing
+
+    \warning
+    The modification of the rtree may invalidate the iterators.
+    
+    \return             The iterator pointing at the end of the query range.
     */
-    indexable_getter indexable_get() const
+    detail::rtree::iterators::end_query_iterator<value_type, allocators_type>
+    qend_() const
     {
-        return m_members.indexable_getter();
+        return detail::rtree::iterators::end_query_iterator<value_type, allocators_type>();
     }
 
+public:
+
     /*!
-    \brief Returns function comparing Values
+    \brief Returns the iterator pointing at the begin of the rtree values range.
 
-    \return     The value_equal function.
+    This method returns the iterator which may be used to iterate over all values
+    stored in the rtree.
 
-    \par Throws
-    Nothing.
+    \par Example
+    \verbatim
+    // Copy all values into the vector
+    std::copy(tree.begin(), tree.end(), std::back_inserter(vec));
+
+    for ( Rtree::const_iterator it = tree.begin() ; it != tree.end() ; ++it )
+    {
+        // do something with value
+    }
+
+    // C++11 (auto)
+    for ( auto it = tree.begin() ; it != tree.end() ; ++it )
+    {
+        // do something with value
+    }
+
+    // C++14 (generic lambda expression)
+    std::for_each(tree.begin(), tree.end(), [](auto const& val){
+        // do something with value
+    })
+    \endverbatim
+
+    \par Iterator category
+    ForwardIterator
+
+    \par Throws
+    If allocation throws.
+
+    \warning
+    The modification of the rtree may invalidate the iterators.
+
+    \return             The iterator pointing at the begin of the range.
+    */
+    const_iterator begin() const
+    {
+        if ( !m_members.root )
+            return const_iterator();
+
+        return const_iterator(m_members.root);
+    }
+
+    /*!
+    \brief Returns the iterator pointing at the end of the rtree values range.
+
+    This method returns the iterator which may be compared with the iterator returned by begin()
+    in order to check if the iteration has ended.
+
+    \par Example
+    \verbatim
+    for ( Rtree::const_iterator it = tree.begin() ; it != tree.end() ; ++it )
+    {
+        // do something with value
+    }
+
+    // C++11 (lambda expression)
+    std::for_each(tree.begin(), tree.end(), [](value_type const& val){
+        // do something with value
+    })
+    \endverbatim
+
+    \par Iterator category
+    ForwardIterator
+
+    \par Throws
+    Nothing.
+
+    \warning
+    The modification of the rtree may invalidate the iterators.
+
+    \return             The iterator pointing at the end of the range.
+    */
+    const_iterator end() const
+    {
+        return const_iterator();
+    }
+
+    /*!
+    \brief Returns the number of stored values.
+
+    \return         The number of stored values.
+
+    \par Throws
+    Nothing.
+    */
+    inline size_type size() const
+    {
+        return m_members.values_count;
+    }
+
+    /*!
+    \brief Query if the container is empty.
+
+    \return         true if the container is empty.
+
+    \par Throws
+    Nothing.
+    */
+    inline bool empty() const
+    {
+        return 0 == m_members.values_count;
+    }
+
+    /*!
+    \brief Removes all values stored in the container.
+
+    \par Throws
+    Nothing.
+    */
+    inline void clear()
+    {
+        this->raw_destroy(*this);
+    }
+
+    /*!
+    \brief Repacks the subtrees whose nodes overlap.
+
+    The nodes of the tree created by many insertions and removals may overlap more and contain more
+    dead space than the nodes of the packed tree. This method traverses the tree from the root
+    and checks the overlap of the children of each internal node, i.e. the sum of contents of pairwise
+    intersections of their boxes divided by the sum of their contents. If it's greater than the
+    threshold the values of the subtree are packed again and the new subtree replaces the old one
+    if its children overlap less. So only the parts of the tree having bad structure are rebuilt.
+    The root of the tree and the leafs are not repacked.
+
+    \par Example
+    \verbatim
+    // after many insertions and removals
+    tree.optimize();
+    \endverbatim
+
+    \par Throws
+    If Value copy constructor or copy assignment throws.
+    If allocation throws.
+
+    \par Exception-safety
+    strong
+
+    \param overlap_threshold   The overlap of the children of a node above which its subtree is repacked.
+
+    \return                    The number of repacked subtrees.
+    */
+    inline size_type optimize(double overlap_threshold = 0.1)
+    {
+        if ( !m_members.root )
+            return 0;
+
+        detail::rtree::optimize<members_holder>
+            optimize_v(overlap_threshold, m_members.parameters(), m_members.translator(), m_members.allocators());
+
+        return optimize_v.apply(m_members.root, m_members.leafs_level);                         // MAY THROW (V, E: alloc, copy, N: alloc)
+    }
+
+    /*!
+    \brief Returns the box able to contain all values stored in the container.
+
+    Returns the box able to contain all values stored in the container.
+    If the container is empty the result of \c geometry::assign_inverse() is returned.
+
+    \return     The box able to contain all values stored in the container or an invalid box if
+                there are no values in the container.
+
+    \par Throws
+    Nothing.
+    */
+    inline bounds_type bounds() const
+    {
+        bounds_type result;
+        // in order to suppress the uninitialized variable warnings
+        geometry::assign_inverse(result);
+
+        if ( m_members.root )
+        {
+            detail::rtree::visitors::children_box
+                <
+                    members_holder
+                > box_v(result, m_members.parameters(), m_members.translator());
+            detail::rtree::apply_visitor(box_v, *m_members.root);
+        }
+
+        return result;
+    }
+
+    /*!
+    \brief Count Values or Indexables stored in the container.
+    
+    For indexable_type it returns the number of values which indexables equals the parameter.
+    For value_type it returns the number of values which equals the parameter.
+
+    \param vori The value or indexable which will be counted.
+
+    \return     The number of values found.
+
+    \par Throws
+    Nothing.
+    */
+    template <typename ValueOrIndexable>
+    size_type count(ValueOrIndexable const& vori) const
+    {
+        if ( !m_members.root )
+            return 0;
+
+        // the input should be convertible to Value or Indexable type
+        typedef typename index::detail::convertible_type
+            <
+                ValueOrIndexable,
+                value_type,
+                indexable_type
+            >::type value_or_indexable;
+
+        static const bool is_void = boost::is_same<value_or_indexable, void>::value;
+        BOOST_MPL_ASSERT_MSG((! is_void),
+                             PASSED_OBJECT_NOT_CONVERTIBLE_TO_VALUE_NOR_INDEXABLE_TYPE,
+                             (ValueOrIndexable));
+
+        // NOTE: If an object of convertible but not the same type is passed
+        // into the function, here a temporary will be created.
+        return this->template raw_count<value_or_indexable>(vori);
+    }
+
+    /*!
+    \brief Returns parameters.
+
+    \return     The parameters object.
+
+    \par Throws
+    Nothing.
+    */
+    inline parameters_type parameters() const
+    {
+        return m_members.parameters();
+    }
+
+    /*!
+    \brief Returns function retrieving Indexable from Value.
+
+    \return     The indexable_getter object.
+
+    \par Throws
+    Nothing.
+    */
+    indexable_getter indexable_get() const
+    {
+        return m_members.indexable_getter();
+    }
+
+    /*!
+    \brief Returns function comparing Values
+
+    \return     The value_equal function.
+
+    \par Throws
+    Nothing.
     */
     value_equal value_eq() const
     {
@@ -1554,25 +2271,74 @@ private:
     }
 
     /*!
-    \brief Remove the value from the container.
+    \brief Insert a range of values into the index, packing them if it's worth it.
 
-    \param value    The value which will be removed from the container.
+    \param first    The beginning of the range of values.
+    \param last     The end of the range of values.
 
     \par Exception-safety
     basic
     */
-    inline size_type raw_remove(value_type const& value)
+    template <typename Iterator>
+    inline void raw_insert_range(Iterator first, Iterator last,
+                                 boost::mpl::bool_<true> const& /*is_forward*/)
     {
-        // TODO: awulkiew - assert for correct value (indexable) ?
-        BOOST_GEOMETRY_INDEX_ASSERT(m_members.root, "The root must exist");
+        typedef detail::rtree::pack_insert<members_holder> pack_insert;
 
-        detail::rtree::visitors::remove<members_holder>
-            remove_v(m_members.root, m_members.leafs_level, value,
-                     m_members.parameters(), m_members.translator(), m_members.allocators());
+        size_type const count = static_cast<size_type>(std::distance(first, last));
+        if ( pack_insert::is_worth(count, m_members.parameters()) )
+        {
+            pack_insert::apply(first, last, m_members.root,
+                               m_members.values_count, m_members.leafs_level,
+                               m_members.parameters(), m_members.translator(),
+                               m_members.allocators());                                             // MAY THROW (V, E: alloc, copy, N: alloc)
+        }
+        else
+        {
+            this->raw_insert_range(first, last, boost::mpl::bool_<false>());
+        }
+    }
 
-        detail::rtree::apply_visitor(remove_v, *m_members.root);
+    /*!
+    \brief Insert a range of values into the index one by one.
 
-        // If exception is thrown, m_values_count may be invalid
+    \param first    The beginning of the range of values.
+    \param last     The end of the range of values.
+
+    \par Exception-safety
+    basic
+    */
+    template <typename Iterator>
+    inline void raw_insert_range(Iterator first, Iterator last,
+                                 boost::mpl::bool_<false> const& /*is_forward*/)
+    {
+        if ( !m_members.root )
+            this->raw_create();
+
+        for ( ; first != last ; ++first )
+            this->raw_insert(*first);
+    }
+
+    /*!
+    \brief Remove the value from the container.
+
+    \param value    The value which will be removed from the container.
+
+    \par Exception-safety
+    basic
+    */
+    inline size_type raw_remove(value_type const& value)
+    {
+        // TODO: awulkiew - assert for correct value (indexable) ?
+        BOOST_GEOMETRY_INDEX_ASSERT(m_members.root, "The root must exist");
+
+        detail::rtree::visitors::remove<members_holder>
+            remove_v(m_members.root, m_members.leafs_level, value,
+                     m_members.parameters(), m_members.translator(), m_members.allocators());
+
+        detail::rtree::apply_visitor(remove_v, *m_members.root);
+
+        // If exception is thrown, m_values_count may be invalid
 
         if ( remove_v.is_value_removed() )
         {
@@ -1586,6 +2352,72 @@ private:
         return 0;
     }
 
+    /*!
+    \brief Remove the values chosen by the selector in one traversal.
+
+    \param selector The selector of removed values.
+
+    \par Exception-safety
+    basic
+    */
+    template <typename Selector>
+    inline size_type raw_bulk_remove(Selector & selector)
+    {
+        BOOST_GEOMETRY_INDEX_ASSERT(m_members.root, "The root must exist");
+
+        detail::rtree::visitors::bulk_remove<members_holder, Selector>
+            remove_v(m_members.root, m_members.leafs_level, selector,
+                     m_members.parameters(), m_members.translator(), m_members.allocators());
+
+        detail::rtree::apply_visitor(remove_v, *m_members.root);                                    // MAY THROW (V, E: alloc, copy)
+
+        // If exception is thrown, m_values_count may be invalid
+        BOOST_GEOMETRY_INDEX_ASSERT(remove_v.removed_count() <= m_members.values_count, "unexpected state");
+        m_members.values_count -= remove_v.removed_count();
+
+        remove_v.condense();                                                                        // MAY THROW (V, E: alloc, copy, N: alloc)
+
+        return remove_v.removed_count();
+    }
+
+    /*!
+    \brief Remove a range of values from the container in one traversal.
+
+    \param first    The beginning of the range of values.
+    \param last     The end of the range of values.
+
+    \par Exception-safety
+    basic
+    */
+    template <typename Iterator>
+    inline size_type raw_remove_range(Iterator first, Iterator last,
+                                      boost::mpl::bool_<true> const& /*is_bulk*/)
+    {
+        typedef detail::rtree::visitors::bulk_remove_values_selector<members_holder> selector_type;
+
+        selector_type selector(first, last, m_members.parameters(), m_members.translator());        // MAY THROW (alloc)
+        return this->raw_bulk_remove(selector);                                                     // MAY THROW (V, E: alloc, copy, N: alloc)
+    }
+
+    /*!
+    \brief Remove a range of values from the container one by one.
+
+    \param first    The beginning of the range of values.
+    \param last     The end of the range of values.
+
+    \par Exception-safety
+    basic
+    */
+    template <typename Iterator>
+    inline size_type raw_remove_range(Iterator first, Iterator last,
+                                      boost::mpl::bool_<false> const& /*is_bulk*/)
+    {
+        size_type result = 0;
+        for ( ; first != last && m_members.root ; ++first )
+            result += this->raw_remove(*first);
+        return result;
+    }
+
     /*!
     \brief Create an empty R-tree i.e. new empty root node and clear other attributes.
 
@@ -1613,8 +2445,8 @@ private:
     {
         if ( t.m_members.root )
         {
-            detail::rtree::visitors::destroy<members_holder>
-                ::apply(t.m_members.root, t.m_members.allocators());
+            detail::rtree::visitors::destroy_tree<members_holder>
+                (t.m_members.root, t.m_members.allocators());
 
             t.m_members.root = 0;
         }
@@ -1692,9 +2524,7 @@ private:
                              PASSED_OBJECT_IS_NOT_CONVERTIBLE_TO_VALUE_NOR_A_RANGE,
                              (Range));
 
-        typedef typename boost::range_const_iterator<Range>::type It;
-        for ( It it = boost::const_begin(rng); it != boost::const_end(rng) ; ++it )
-            this->raw_insert(*it);
+        this->insert(boost::const_begin(rng), boost::const_end(rng));
     }
 
     /*!
@@ -1728,11 +2558,7 @@ private:
                              PASSED_OBJECT_IS_NOT_CONVERTIBLE_TO_VALUE_NOR_A_RANGE,
                              (Range));
 
-        size_type result = 0;
-        typedef typename boost::range_const_iterator<Range>::type It;
-        for ( It it = boost::const_begin(rng); it != boost::const_end(rng) ; ++it )
-            result += this->raw_remove(*it);
-        return result;
+        return this->remove(boost::const_begin(rng), boost::const_end(rng));
     }
 
     /*!
@@ -1741,11 +2567,12 @@ private:
     \par Exception-safety
     strong
     */
-    template <typename Predicates, typename OutIter>
-    size_type query_dispatch(Predicates const& predicates, OutIter out_it, boost::mpl::bool_<false> const& /*is_distance_predicate*/) const
+    template <typename Predicates, typename OutIter, typename Statistics>
+    size_type query_dispatch(Predicates const& predicates, OutIter out_it, boost::mpl::bool_<false> const& /*is_distance_predicate*/,
+                             query_context * /*ctx*/, Statistics const& stats) const
     {
-        detail::rtree::visitors::spatial_query<members_holder, Predicates, OutIter>
-            find_v(m_members.parameters(), m_members.translator(), predicates, out_it);
+        detail::rtree::visitors::spatial_query<members_holder, Predicates, OutIter, Statistics>
+            find_v(m_members.parameters(), m_members.translator(), predicates, out_it, stats);
 
         detail::rtree::apply_visitor(find_v, *m_members.root);
 
@@ -1758,18 +2585,28 @@ private:
     \par Exception-safety
     strong
     */
-    template <typename Predicates, typename OutIter>
-    size_type query_dispatch(Predicates const& predicates, OutIter out_it, boost::mpl::bool_<true> const& /*is_distance_predicate*/) const
+    template <typename Predicates, typename OutIter, typename Statistics>
+    size_type query_dispatch(Predicates const& predicates, OutIter out_it, boost::mpl::bool_<true> const& /*is_distance_predicate*/,
+                             query_context * ctx, Statistics const& stats) const
     {
         BOOST_GEOMETRY_INDEX_ASSERT(m_members.root, "The root must exist");
 
         static const unsigned distance_predicate_index = detail::predicates_find_distance<Predicates>::value;
-        detail::rtree::visitors::distance_query<
+        // depth-first or best-first traversal depending on the nearest predicate
+        typedef typename detail::rtree::visitors::distance_query_visitor<
             members_holder,
             Predicates,
             distance_predicate_index,
-            OutIter
-        > distance_v(m_members.parameters(), m_members.translator(), predicates, out_it);
+            OutIter,
+            Statistics
+        >::type visitor_type;
+        typedef typename visitor_type::buffers_type buffers_type;
+
+        buffers_type * buffers = ctx ?
+            boost::addressof(detail::rtree::query_context_access::query_buffers<buffers_type>(*ctx)) :
+            0;
+
+        visitor_type distance_v(m_members.parameters(), m_members.translator(), predicates, out_it, buffers, stats);
 
         detail::rtree::apply_visitor(distance_v, *m_members.root);
 
@@ -1808,221 +2645,805 @@ It calls <tt>rtree::insert(value_type const&)</tt>.
 
 \ingroup rtree_functions
 
-\param tree The spatial index.
-\param v    The value which will be stored in the index.
+\param tree The spatial index.
+\param v    The value which will be stored in the index.
+*/
+template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator>
+inline void insert(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree,
+                   Value const& v)
+{
+    tree.insert(v);
+}
+
+/*!
+\brief Insert a range of values to the index.
+
+It calls <tt>rtree::insert(Iterator, Iterator)</tt>.
+
+\ingroup rtree_functions
+
+\param tree     The spatial index.
+\param first    The beginning of the range of values.
+\param last     The end of the range of values.
+*/
+template<typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
+         typename Iterator>
+inline void insert(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree,
+                   Iterator first, Iterator last)
+{
+    tree.insert(first, last);
+}
+
+/*!
+\brief Insert a value created using convertible object or a range of values to the index.
+
+It calls <tt>rtree::insert(ConvertibleOrRange const&)</tt>.
+
+\ingroup rtree_functions
+
+\param tree             The spatial index.
+\param conv_or_rng      The object of type convertible to value_type or a range of values.
+*/
+template<typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
+         typename ConvertibleOrRange>
+inline void insert(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree,
+                   ConvertibleOrRange const& conv_or_rng)
+{
+    tree.insert(conv_or_rng);
+}
+
+/*!
+\brief Remove a value from the container.
+
+Remove a value from the container. In contrast to the \c std::set or <tt>std::map erase()</tt> method
+this function removes only one value from the container.
+
+It calls <tt>rtree::remove(value_type const&)</tt>.
+
+\ingroup rtree_functions
+
+\param tree The spatial index.
+\param v    The value which will be removed from the index.
+
+\return     1 if value was removed, 0 otherwise.
+*/
+template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator>
+inline typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
+remove(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree,
+       Value const& v)
+{
+    return tree.remove(v);
+}
+
+/*!
+\brief Remove a range of values from the container.
+
+Remove a range of values from the container. In contrast to the \c std::set or <tt>std::map erase()</tt> method
+it doesn't take iterators pointing to values stored in this container. It removes values equal
+to these passed as a range. Furthermore this function removes only one value for each one passed
+in the range, not all equal values.
+
+It calls <tt>rtree::remove(Iterator, Iterator)</tt>.
+
+\ingroup rtree_functions
+
+\param tree     The spatial index.
+\param first    The beginning of the range of values.
+\param last     The end of the range of values.
+
+\return         The number of removed values.
+*/
+template<typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
+         typename Iterator>
+inline typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
+remove(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree,
+       Iterator first, Iterator last)
+{
+    return tree.remove(first, last);
+}
+
+/*!
+\brief Remove a value corresponding to an object convertible to it or a range of values from the container.
+
+Remove a value corresponding to an object convertible to it or a range of values from the container.
+In contrast to the \c std::set or <tt>std::map erase()</tt> method
+it removes values equal to these passed as a range. Furthermore this method removes only
+one value for each one passed in the range, not all equal values.
+
+It calls <tt>rtree::remove(ConvertibleOrRange const&)</tt>.
+
+\ingroup rtree_functions
+
+\param tree                 The spatial index.
+\param conv_or_rng      The object of type convertible to value_type or the range of values.
+
+\return         The number of removed values.
+*/
+template<typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
+         typename ConvertibleOrRange>
+inline typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
+remove(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree,
+       ConvertibleOrRange const& conv_or_rng)
+{
+    return tree.remove(conv_or_rng);
+}
+
+/*!
+\brief Remove values meeting passed spatial predicates e.g. intersecting some Box.
+
+Remove all values meeting the predicates from the container in one traversal of the tree.
+
+It calls <tt>rtree::remove_if(Predicates const&)</tt>.
+
+\ingroup rtree_functions
+
+\param tree         The spatial index.
+\param predicates   Predicates.
+
+\return             The number of removed values.
+*/
+template<typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
+         typename Predicates>
+inline typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
+remove_if(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree,
+          Predicates const& predicates)
+{
+    return tree.remove_if(predicates);
+}
+
+/*!
+\brief Finds values meeting passed predicates e.g. nearest to some Point and/or intersecting some Box.
+
+This query function performs spatial and k-nearest neighbor searches. It allows to pass a set of predicates.
+Values will be returned only if all predicates are met.
+
+<b>Spatial predicates</b>
+    
+Spatial predicates may be generated by one of the functions listed below:
+\li \c boost::geometry::index::contains(),
+\li \c boost::geometry::index::covered_by(),
+\li \c boost::geometry::index::covers(),
+\li \c boost::geometry::index::disjoint(),
+\li \c boost::geometry::index::intersects(),
+\li \c boost::geometry::index::overlaps(),
+\li \c boost::geometry::index::within(),
+
+It is possible to negate spatial predicates:
+\li <tt>! boost::geometry::index::contains()</tt>,
+\li <tt>! boost::geometry::index::covered_by()</tt>,
+\li <tt>! boost::geometry::index::covers()</tt>,
+\li <tt>! boost::geometry::index::disjoint()</tt>,
+\li <tt>! boost::geometry::index::intersects()</tt>,
+\li <tt>! boost::geometry::index::overlaps()</tt>,
+\li <tt>! boost::geometry::index::within()</tt>
+
+<b>Satisfies predicate</b>
+
+This is a special kind of predicate which allows to pass a user-defined function or function object which checks
+if Value should be returned by the query. It's generated by:
+\li \c boost::geometry::index::satisfies().
+
+<b>Nearest predicate</b>
+
+If the nearest predicate is passed a k-nearest neighbor search will be performed. This query will result
+in returning k values to the output iterator. Only one nearest predicate may be passed to the query.
+It may be generated by:
+\li \c boost::geometry::index::nearest().
+        
+<b>Connecting predicates</b>
+
+Predicates may be passed together connected with \c operator&&().
+
+\par Example
+\verbatim
+// return elements intersecting box
+bgi::query(tree, bgi::intersects(box), std::back_inserter(result));
+// return elements intersecting poly but not within box
+bgi::query(tree, bgi::intersects(poly) && !bgi::within(box), std::back_inserter(result));
+// return elements overlapping box and meeting my_fun value predicate
+bgi::query(tree, bgi::overlaps(box) && bgi::satisfies(my_fun), std::back_inserter(result));
+// return 5 elements nearest to pt and elements are intersecting box
+bgi::query(tree, bgi::nearest(pt, 5) && bgi::intersects(box), std::back_inserter(result));
+
+// For each found value do_something (it is a type of function object)
+tree.query(bgi::intersects(box),
+           boost::make_function_output_iterator(do_something()));
+\endverbatim
+
+\par Throws
+If Value copy constructor or copy assignment throws.
+
+\warning
+Only one \c nearest() predicate may be passed to the query. Passing more of them results in compile-time error.
+
+\ingroup rtree_functions
+
+\param tree         The rtree.
+\param predicates   Predicates.
+\param out_it       The output iterator, e.g. generated by std::back_inserter().
+
+\return             The number of values found.
+*/
+template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
+          typename Predicates, typename OutIter> inline
+typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
+query(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> const& tree,
+      Predicates const& predicates,
+      OutIter out_it)
+{
+    return tree.query(predicates, out_it);
+}
+
+/*!
+\brief Finds values meeting passed predicates e.g. nearest to some Point and/or intersecting some Box.
+
+This query function performs the same query as query(tree, predicates, out_it) but the memory
+required by the k-nearest neighbors search is taken from the context and kept there after the
+query ends. For the details see rtree::query(Predicates const&, OutIter, query_context &).
+
+\par Example
+\verbatim
+bgi::query_context ctx;
+bgi::query(tree, bgi::nearest(pt, 5), std::back_inserter(result), ctx);
+\endverbatim
+
+\par Throws
+If Value copy constructor or copy assignment throws.
+If allocation throws.
+
+\warning
+The context may be used by one query at a time.
+
+\ingroup rtree_functions
+
+\param tree         The rtree.
+\param predicates   Predicates.
+\param out_it       The output iterator, e.g. generated by std::back_inserter().
+\param ctx          The context storing the buffers.
+
+\return             The number of values found.
+*/
+template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
+          typename Predicates, typename OutIter> inline
+typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
+query(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> const& tree,
+      Predicates const& predicates,
+      OutIter out_it,
+      query_context & ctx)
+{
+    return tree.query(predicates, out_it, ctx);
+}
+
+/*!
+\brief Finds values meeting passed predicates e.g. nearest to some Point and/or intersecting some Box.
+
+This query function performs the same query as query(tree, predicates, out_it) and gathers
+the statistics of the traversal of the tree. For the details see
+rtree::query(Predicates const&, OutIter, query_statistics &).
+
+\par Example
+\verbatim
+bgi::query_statistics stats;
+bgi::query(tree, bgi::intersects(box), std::back_inserter(result), stats);
+\endverbatim
+
+\par Throws
+If Value copy constructor or copy assignment throws.
+
+\ingroup rtree_functions
+
+\param tree         The rtree.
+\param predicates   Predicates.
+\param out_it       The output iterator, e.g. generated by std::back_inserter().
+\param stats        The statistics object.
+
+\return             The number of values found.
+*/
+template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
+          typename Predicates, typename OutIter> inline
+typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
+query(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> const& tree,
+      Predicates const& predicates,
+      OutIter out_it,
+      query_statistics & stats)
+{
+    return tree.query(predicates, out_it, stats);
+}
+
+/*!
+\brief Calls a function object for each value meeting passed predicates.
+
+This query function performs the same query as query(tree, predicates, out_it) but the function
+object is called for each found value. For the details see
+rtree::query_visit(Predicates const&, Function).
+
+\par Example
+\verbatim
+bgi::query_visit(tree, bgi::intersects(box), do_something());
+\endverbatim
+
+\par Throws
+If the function object throws.
+
+\ingroup rtree_functions
+
+\param tree         The rtree.
+\param predicates   Predicates.
+\param f            The function object called with each found value.
+
+\return             The function object after it was called for all found values.
+*/
+template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
+          typename Predicates, typename Function> inline
+Function query_visit(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> const& tree,
+                     Predicates const& predicates,
+                     Function f)
+{
+    return tree.query_visit(predicates, f);
+}
+
+/*!
+\brief Performs a group of spatial queries at once.
+
+For each value meeting the predicates of a query the function object is
+called with the index of the predicates in the range and the value.
+For the information about the algorithm see rtree::batch_query().
+
+\par Example
+\verbatim
+// C++11 (lambda expression)
+bgi::batch_query(tree, predicates, [&](size_t query_index, value_type const& val){
+    results[query_index].push_back(val);
+});
+\endverbatim
+
+\par Throws
+If Value copy constructor or copy assignment throws.
+If predicates copy throws.
+If allocation throws.
+
+\warning
+Only spatial predicates and satisfies() may be passed. Passing the nearest()
+predicate results in compile-time error.
+
+\ingroup rtree_functions
+
+\param tree         The rtree.
+\param predicates   The range of Predicates.
+\param f            The function object called for each found value.
+
+\return             The number of values found by all queries.
 */
-template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator>
-inline void insert(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree,
-                   Value const& v)
+template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
+          typename PredicatesRange, typename Function> inline
+typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
+batch_query(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> const& tree,
+            PredicatesRange const& predicates,
+            Function f)
 {
-    tree.insert(v);
+    return tree.batch_query(predicates, f);
 }
 
 /*!
-\brief Insert a range of values to the index.
+\brief Performs queries for a range of predicates in parallel.
+
+For each predicates stored in the range a query is performed, see rtree::query(),
+and the values found are written to the output iterator corresponding to these predicates.
+The queries are distributed between the threads by a work-stealing scheduler.
+Each thread starts with a contiguous part of the range of predicates and
+when it finishes its work it takes over half of the remaining queries of another thread.
+If threads are not supported the queries are performed in the calling thread.
+
+\par Thread safety
+Const member functions of the rtree may be called concurrently, e.g. query(), qbegin()
+or count(), as long as the rtree is not modified in the meantime. The state
+of a query is stored in the visitor or iterator created for this query.
+The IndexableGetter, the function objects passed in predicates (e.g. to satisfies())
+and the distance and spatial strategies must be safe to call concurrently.
+query_parallel() calls a copy of the i-th output iterator only for the i-th query
+so the output iterators must write to different containers or be synchronized.
 
-It calls <tt>rtree::insert(Iterator, Iterator)</tt>.
+\par Example
+\verbatim
+std::vector<Box> boxes;
+std::vector<BOOST_TYPEOF(bgi::intersects(Box()))> predicates;
+std::vector< std::vector<Value> > results(boxes.size());
+std::vector< std::back_insert_iterator<std::vector<Value> > > outs;
+for ( size_t i = 0 ; i < boxes.size() ; ++i )
+{
+    predicates.push_back(bgi::intersects(boxes[i]));
+    outs.push_back(std::back_inserter(results[i]));
+}
+bgi::query_parallel(tree, predicates, outs, 4);
+\endverbatim
+
+\par Throws
+If Value copy constructor or copy assignment throws.
+If predicates copy throws.
+If allocation throws.
+If a thread can't be created.
+If a query throws the remaining queries are not performed and the exception is rethrown
+in the calling thread after all threads are joined.
 
 \ingroup rtree_functions
 
-\param tree     The spatial index.
-\param first    The beginning of the range of values.
-\param last     The end of the range of values.
+\param tree             The rtree.
+\param predicates       The RandomAccess range of Predicates.
+\param out_per_query    The RandomAccess range of output iterators, one for each Predicates.
+\param threads_count    The maximum number of threads used to perform the queries.
+
+\return                 The number of values found by all queries.
 */
-template<typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
-         typename Iterator>
-inline void insert(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree,
-                   Iterator first, Iterator last)
+template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
+          typename PredicatesRange, typename OutIterRange> inline
+typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
+query_parallel(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> const& tree,
+               PredicatesRange const& predicates,
+               OutIterRange const& out_per_query,
+               typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type threads_count)
 {
-    tree.insert(first, last);
+    return detail::rtree::parallel_query(tree, predicates, out_per_query, threads_count);
 }
 
 /*!
-\brief Insert a value created using convertible object or a range of values to the index.
+\brief Finds pairs of values of two rtrees whose Indexables intersect and meeting the predicate.
 
-It calls <tt>rtree::insert(ConvertibleOrRange const&)</tt>.
+The spatial join is performed by a synchronized traversal of both rtrees.
+The trees are descended only where the bounding boxes of nodes intersect.
+For each pair of values whose Indexables intersect the predicate is called with
+the value of the first and the second tree. If it returns true the pair of values
+is written to the output iterator as <tt>std::pair<Value1, Value2></tt>.
+
+The predicate may be used to refine the relation, e.g. to find pairs of values whose
+Indexables are within each other, or to compare the non-spatial data of values.
+It must not return true for values whose Indexables don't intersect since
+such pairs are not checked.
+
+\par Example
+\verbatim
+std::vector< std::pair<Value1, Value2> > result;
+// C++11 (lambda expression)
+bgi::join(tree1, tree2,
+          [](Value1 const& v1, Value2 const& v2){ return bg::within(v1.first, v2.first); },
+          std::back_inserter(result));
+\endverbatim
+
+\par Throws
+If Value copy constructor or copy assignment throws.
+If the predicate throws.
 
 \ingroup rtree_functions
 
-\param tree             The spatial index.
-\param conv_or_rng      The object of type convertible to value_type or a range of values.
+\param tree1        The first rtree.
+\param tree2        The second rtree.
+\param predicate    The binary predicate called for pairs of values whose Indexables intersect.
+\param out_it       The output iterator, e.g. generated by std::back_inserter().
+
+\return             The number of pairs of values found.
 */
-template<typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
-         typename ConvertibleOrRange>
-inline void insert(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree,
-                   ConvertibleOrRange const& conv_or_rng)
+template <typename Value1, typename Parameters1, typename IndexableGetter1, typename EqualTo1, typename Allocator1,
+          typename Value2, typename Parameters2, typename IndexableGetter2, typename EqualTo2, typename Allocator2,
+          typename Predicate, typename OutIter> inline
+typename rtree<Value1, Parameters1, IndexableGetter1, EqualTo1, Allocator1>::size_type
+join(rtree<Value1, Parameters1, IndexableGetter1, EqualTo1, Allocator1> const& tree1,
+     rtree<Value2, Parameters2, IndexableGetter2, EqualTo2, Allocator2> const& tree2,
+     Predicate const& predicate,
+     OutIter out_it)
 {
-    tree.insert(conv_or_rng);
+    typedef rtree<Value1, Parameters1, IndexableGetter1, EqualTo1, Allocator1> rtree1_type;
+    typedef rtree<Value2, Parameters2, IndexableGetter2, EqualTo2, Allocator2> rtree2_type;
+    typedef detail::rtree::const_private_view<rtree1_type> view1_type;
+    typedef detail::rtree::const_private_view<rtree2_type> view2_type;
+    typedef typename view1_type::members_holder members_holder1;
+    typedef typename view2_type::members_holder members_holder2;
+
+    view1_type view1(tree1);
+    view2_type view2(tree2);
+    members_holder1 const& members1 = view1.members();
+    members_holder2 const& members2 = view2.members();
+
+    if ( ! members1.root || ! members2.root )
+        return 0;
+
+    typename members_holder1::box_type box1;
+    typename members_holder2::box_type box2;
+    detail::rtree::visitors::children_box<members_holder1>
+        box1_v(box1, members1.parameters(), members1.translator());
+    detail::rtree::apply_visitor(box1_v, *members1.root);
+    detail::rtree::visitors::children_box<members_holder2>
+        box2_v(box2, members2.parameters(), members2.translator());
+    detail::rtree::apply_visitor(box2_v, *members2.root);
+
+    detail::rtree::visitors::spatial_join
+        <
+            members_holder1, members_holder2, Predicate, OutIter
+        > join_v(members1.parameters(), members1.translator(), members2.translator(),
+                 predicate, out_it);
+
+    if ( detail::spatial_predicate_call<detail::predicates::intersects_tag>
+            ::apply(box1, box2, join_v.strategy) )
+    {
+        join_v.apply(*members1.root, box1, *members2.root, box2);
+    }
+
+    return join_v.found_count;
 }
 
 /*!
-\brief Remove a value from the container.
+\brief Finds pairs of values of two rtrees whose Indexables intersect.
 
-Remove a value from the container. In contrast to the \c std::set or <tt>std::map erase()</tt> method
-this function removes only one value from the container.
+The spatial join is performed by a synchronized traversal of both rtrees.
+The trees are descended only where the bounding boxes of nodes intersect.
+The pairs of values are written to the output iterator as <tt>std::pair<Value1, Value2></tt>.
 
-It calls <tt>rtree::remove(value_type const&)</tt>.
+\par Example
+\verbatim
+std::vector< std::pair<Value1, Value2> > result;
+bgi::join(tree1, tree2, std::back_inserter(result));
+\endverbatim
+
+\par Throws
+If Value copy constructor or copy assignment throws.
 
 \ingroup rtree_functions
 
-\param tree The spatial index.
-\param v    The value which will be removed from the index.
+\param tree1        The first rtree.
+\param tree2        The second rtree.
+\param out_it       The output iterator, e.g. generated by std::back_inserter().
 
-\return     1 if value was removed, 0 otherwise.
+\return             The number of pairs of values found.
 */
-template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator>
-inline typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
-remove(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree,
-       Value const& v)
+template <typename Value1, typename Parameters1, typename IndexableGetter1, typename EqualTo1, typename Allocator1,
+          typename Value2, typename Parameters2, typename IndexableGetter2, typename EqualTo2, typename Allocator2,
+          typename OutIter> inline
+typename rtree<Value1, Parameters1, IndexableGetter1, EqualTo1, Allocator1>::size_type
+join(rtree<Value1, Parameters1, IndexableGetter1, EqualTo1, Allocator1> const& tree1,
+     rtree<Value2, Parameters2, IndexableGetter2, EqualTo2, Allocator2> const& tree2,
+     OutIter out_it)
 {
-    return tree.remove(v);
+    return index::join(tree1, tree2, detail::rtree::visitors::join_always_true(), out_it);
 }
 
 /*!
-\brief Remove a range of values from the container.
+\brief Finds k nearest values of the second rtree for each value of the first rtree.
 
-Remove a range of values from the container. In contrast to the \c std::set or <tt>std::map erase()</tt> method
-it doesn't take iterators pointing to values stored in this container. It removes values equal
-to these passed as a range. Furthermore this function removes only one value for each one passed
-in the range, not all equal values.
+The result is the same as if the k-nearest neighbors query was performed in the second rtree
+for the Indexable of each value of the first rtree but the nodes of the second rtree are
+checked once for a group of values close to each other. The first rtree is traversed and the
+nodes of the second rtree which can't contain the nearest neighbors of any value of the
+currently traversed node are pruned.
 
-It calls <tt>rtree::remove(Iterator, Iterator)</tt>.
+For each value of the first rtree up to k pairs of values are written to the output iterator
+as <tt>std::pair<Value1, Value2></tt>, sorted by the distance. The order of the values of the
+first rtree is not specified.
+
+\par Example
+\verbatim
+std::vector< std::pair<Value1, Value2> > result;
+bgi::all_nearest(tree1, tree2, 3, std::back_inserter(result));
+\endverbatim
+
+\par Throws
+If Value copy constructor or copy assignment throws.
+If allocation throws.
 
 \ingroup rtree_functions
 
-\param tree     The spatial index.
-\param first    The beginning of the range of values.
-\param last     The end of the range of values.
+\param tree1        The rtree whose values are the query points.
+\param tree2        The rtree in which the nearest values are searched.
+\param k            The number of nearest values found for each value of the first rtree.
+\param out_it       The output iterator, e.g. generated by std::back_inserter().
 
-\return         The number of removed values.
+\return             The number of pairs of values found.
 */
-template<typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
-         typename Iterator>
-inline typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
-remove(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree,
-       Iterator first, Iterator last)
+template <typename Value1, typename Parameters1, typename IndexableGetter1, typename EqualTo1, typename Allocator1,
+          typename Value2, typename Parameters2, typename IndexableGetter2, typename EqualTo2, typename Allocator2,
+          typename OutIter> inline
+typename rtree<Value1, Parameters1, IndexableGetter1, EqualTo1, Allocator1>::size_type
+all_nearest(rtree<Value1, Parameters1, IndexableGetter1, EqualTo1, Allocator1> const& tree1,
+            rtree<Value2, Parameters2, IndexableGetter2, EqualTo2, Allocator2> const& tree2,
+            unsigned k,
+            OutIter out_it)
 {
-    return tree.remove(first, last);
+    typedef rtree<Value1, Parameters1, IndexableGetter1, EqualTo1, Allocator1> rtree1_type;
+    typedef rtree<Value2, Parameters2, IndexableGetter2, EqualTo2, Allocator2> rtree2_type;
+    typedef detail::rtree::const_private_view<rtree1_type> view1_type;
+    typedef detail::rtree::const_private_view<rtree2_type> view2_type;
+    typedef typename view1_type::members_holder members_holder1;
+    typedef typename view2_type::members_holder members_holder2;
+
+    view1_type view1(tree1);
+    view2_type view2(tree2);
+    members_holder1 const& members1 = view1.members();
+    members_holder2 const& members2 = view2.members();
+
+    if ( ! members1.root || ! members2.root || k == 0 )
+        return 0;
+
+    typename members_holder1::box_type box1;
+    typename members_holder2::box_type box2;
+    detail::rtree::visitors::children_box<members_holder1>
+        box1_v(box1, members1.parameters(), members1.translator());
+    detail::rtree::apply_visitor(box1_v, *members1.root);
+    detail::rtree::visitors::children_box<members_holder2>
+        box2_v(box2, members2.parameters(), members2.translator());
+    detail::rtree::apply_visitor(box2_v, *members2.root);
+
+    detail::rtree::visitors::all_nearest
+        <
+            members_holder1, members_holder2, OutIter
+        > nearest_v(members1, members2, k, out_it);
+
+    nearest_v.apply(members1.root, box1, members2.root, box2);
+
+    return nearest_v.found_count();
 }
 
 /*!
-\brief Remove a value corresponding to an object convertible to it or a range of values from the container.
+\brief Finds k closest pairs of values of two rtrees.
 
-Remove a value corresponding to an object convertible to it or a range of values from the container.
-In contrast to the \c std::set or <tt>std::map erase()</tt> method
-it removes values equal to these passed as a range. Furthermore this method removes only
-one value for each one passed in the range, not all equal values.
+The pairs of nodes of both rtrees are traversed in the order of increasing distance
+and the pairs further than the k closest pairs of values found so far are pruned.
 
-It calls <tt>rtree::remove(ConvertibleOrRange const&)</tt>.
+Up to k pairs of values are written to the output iterator as <tt>std::pair<Value1, Value2></tt>,
+sorted by the distance between the Indexables.
+
+\par Example
+\verbatim
+std::vector< std::pair<Value1, Value2> > result;
+bgi::closest_pairs(tree1, tree2, 10, std::back_inserter(result));
+\endverbatim
+
+\par Throws
+If Value copy constructor or copy assignment throws.
+If allocation throws.
 
 \ingroup rtree_functions
 
-\param tree                 The spatial index.
-\param conv_or_rng      The object of type convertible to value_type or the range of values.
+\param tree1        The first rtree.
+\param tree2        The second rtree.
+\param k            The number of pairs.
+\param out_it       The output iterator, e.g. generated by std::back_inserter().
 
-\return         The number of removed values.
+\return             The number of pairs of values found.
 */
-template<typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
-         typename ConvertibleOrRange>
-inline typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
-remove(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree,
-       ConvertibleOrRange const& conv_or_rng)
+template <typename Value1, typename Parameters1, typename IndexableGetter1, typename EqualTo1, typename Allocator1,
+          typename Value2, typename Parameters2, typename IndexableGetter2, typename EqualTo2, typename Allocator2,
+          typename OutIter> inline
+typename rtree<Value1, Parameters1, IndexableGetter1, EqualTo1, Allocator1>::size_type
+closest_pairs(rtree<Value1, Parameters1, IndexableGetter1, EqualTo1, Allocator1> const& tree1,
+              rtree<Value2, Parameters2, IndexableGetter2, EqualTo2, Allocator2> const& tree2,
+              unsigned k,
+              OutIter out_it)
 {
-    return tree.remove(conv_or_rng);
+    typedef rtree<Value1, Parameters1, IndexableGetter1, EqualTo1, Allocator1> rtree1_type;
+    typedef rtree<Value2, Parameters2, IndexableGetter2, EqualTo2, Allocator2> rtree2_type;
+    typedef detail::rtree::const_private_view<rtree1_type> view1_type;
+    typedef detail::rtree::const_private_view<rtree2_type> view2_type;
+    typedef typename view1_type::members_holder members_holder1;
+    typedef typename view2_type::members_holder members_holder2;
+
+    view1_type view1(tree1);
+    view2_type view2(tree2);
+    members_holder1 const& members1 = view1.members();
+    members_holder2 const& members2 = view2.members();
+
+    if ( ! members1.root || ! members2.root || k == 0 )
+        return 0;
+
+    typename members_holder1::box_type box1;
+    typename members_holder2::box_type box2;
+    detail::rtree::visitors::children_box<members_holder1>
+        box1_v(box1, members1.parameters(), members1.translator());
+    detail::rtree::apply_visitor(box1_v, *members1.root);
+    detail::rtree::visitors::children_box<members_holder2>
+        box2_v(box2, members2.parameters(), members2.translator());
+    detail::rtree::apply_visitor(box2_v, *members2.root);
+
+    detail::rtree::visitors::closest_pairs
+        <
+            members_holder1, members_holder2, OutIter
+        > pairs_v(members1, members2, k, out_it);
+
+    pairs_v.apply(members1.root, box1, members2.root, box2);
+
+    return pairs_v.finish();
 }
 
 /*!
-\brief Finds values meeting passed predicates e.g. nearest to some Point and/or intersecting some Box.
-
-This query function performs spatial and k-nearest neighbor searches. It allows to pass a set of predicates.
-Values will be returned only if all predicates are met.
+\brief Returns the query iterator pointing at the begin of the query range.
 
-<b>Spatial predicates</b>
+This method returns the iterator which may be used to perform iterative queries. For the information
+about the predicates which may be passed to this method see query().
     
-Spatial predicates may be generated by one of the functions listed below:
-\li \c boost::geometry::index::contains(),
-\li \c boost::geometry::index::covered_by(),
-\li \c boost::geometry::index::covers(),
-\li \c boost::geometry::index::disjoint(),
-\li \c boost::geometry::index::intersects(),
-\li \c boost::geometry::index::overlaps(),
-\li \c boost::geometry::index::within(),
+\par Example
+\verbatim
+std::for_each(bgi::qbegin(tree, bgi::nearest(pt, 3)), bgi::qend(tree), do_something());
+\endverbatim
 
-It is possible to negate spatial predicates:
-\li <tt>! boost::geometry::index::contains()</tt>,
-\li <tt>! boost::geometry::index::covered_by()</tt>,
-\li <tt>! boost::geometry::index::covers()</tt>,
-\li <tt>! boost::geometry::index::disjoint()</tt>,
-\li <tt>! boost::geometry::index::intersects()</tt>,
-\li <tt>! boost::geometry::index::overlaps()</tt>,
-\li <tt>! boost::geometry::index::within()</tt>
+\par Iterator category
+ForwardIterator
 
-<b>Satisfies predicate</b>
+\par Throws
+If predicates copy throws.
+If allocation throws.
 
-This is a special kind of predicate which allows to pass a user-defined function or function object which checks
-if Value should be returned by the query. It's generated by:
-\li \c boost::geometry::index::satisfies().
+\warning
+The modification of the rtree may invalidate the iterators.
 
-<b>Nearest predicate</b>
+\ingroup rtree_functions
 
-If the nearest predicate is passed a k-nearest neighbor search will be performed. This query will result
-in returning k values to the output iterator. Only one nearest predicate may be passed to the query.
-It may be generated by:
-\li \c boost::geometry::index::nearest().
-        
-<b>Connecting predicates</b>
+\param tree         The rtree.
+\param predicates   Predicates.
+    
+\return             The iterator pointing at the begin of the query range.
+*/
+template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
+          typename Predicates> inline
+typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::const_query_iterator
+qbegin(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> const& tree,
+       Predicates const& predicates)
+{
+    return tree.qbegin(predicates);
+}
 
-Predicates may be passed together connected with \c operator&&().
+/*!
+\brief Returns the query iterator pointing at the begin of the query range.
+
+This method returns the same iterator as qbegin(tree, predicates) but the memory used
+by the traversal is taken from the context. For the details see
+rtree::qbegin(Predicates const&, query_context &).
 
 \par Example
 \verbatim
-// return elements intersecting box
-bgi::query(tree, bgi::intersects(box), std::back_inserter(result));
-// return elements intersecting poly but not within box
-bgi::query(tree, bgi::intersects(poly) && !bgi::within(box), std::back_inserter(result));
-// return elements overlapping box and meeting my_fun value predicate
-bgi::query(tree, bgi::overlaps(box) && bgi::satisfies(my_fun), std::back_inserter(result));
-// return 5 elements nearest to pt and elements are intersecting box
-bgi::query(tree, bgi::nearest(pt, 5) && bgi::intersects(box), std::back_inserter(result));
-
-// For each found value do_something (it is a type of function object)
-tree.query(bgi::intersects(box),
-           boost::make_function_output_iterator(do_something()));
+bgi::query_context ctx;
+for ( Rtree::const_query_iterator it = bgi::qbegin(tree, bgi::nearest(pt, 3), ctx) ;
+      it != bgi::qend(tree) ; ++it )
+    do_something(*it);
 \endverbatim
 
+\par Iterator category
+ForwardIterator
+
 \par Throws
-If Value copy constructor or copy assignment throws.
+If predicates copy throws.
+If allocation throws.
 
 \warning
-Only one \c nearest() predicate may be passed to the query. Passing more of them results in compile-time error.
+The modification of the rtree may invalidate the iterators.
+The context must outlive the iterator and may be used by one iterator at a time.
 
 \ingroup rtree_functions
 
 \param tree         The rtree.
 \param predicates   Predicates.
-\param out_it       The output iterator, e.g. generated by std::back_inserter().
+\param ctx          The context storing the buffers.
 
-\return             The number of values found.
+\return             The iterator pointing at the begin of the query range.
 */
 template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
-          typename Predicates, typename OutIter> inline
-typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
-query(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> const& tree,
-      Predicates const& predicates,
-      OutIter out_it)
+          typename Predicates> inline
+typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::const_query_iterator
+qbegin(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> const& tree,
+       Predicates const& predicates,
+       query_context & ctx)
 {
-    return tree.query(predicates, out_it);
+    return tree.qbegin(predicates, ctx);
 }
 
 /*!
 \brief Returns the query iterator pointing at the begin of the query range.
 
-This method returns the iterator which may be used to perform iterative queries. For the information
-about the predicates which may be passed to this method see query().
-    
+This method returns the same iterator as qbegin(tree, predicates) and the iterator gathers
+the statistics of the traversal of the tree. For the details see
+rtree::qbegin(Predicates const&, query_statistics &).
+
 \par Example
 \verbatim
-std::for_each(bgi::qbegin(tree, bgi::nearest(pt, 3)), bgi::qend(tree), do_something());
+bgi::query_statistics stats;
+for ( Rtree::const_query_iterator it = bgi::qbegin(tree, bgi::nearest(pt, 3), stats) ;
+      it != bgi::qend(tree) ; ++it )
+    do_something(*it);
 \endverbatim
 
 \par Iterator category
@@ -2034,21 +3455,24 @@ If allocation throws.
 
 \warning
 The modification of the rtree may invalidate the iterators.
+The statistics object must outlive the iterator.
 
 \ingroup rtree_functions
 
 \param tree         The rtree.
 \param predicates   Predicates.
-    
+\param stats        The statistics object.
+
 \return             The iterator pointing at the begin of the query range.
 */
 template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator,
           typename Predicates> inline
 typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::const_query_iterator
 qbegin(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> const& tree,
-       Predicates const& predicates)
+       Predicates const& predicates,
+       query_statistics & stats)
 {
-    return tree.qbegin(predicates);
+    return tree.qbegin(predicates, stats);
 }
 
 /*!
@@ -2162,6 +3586,25 @@ inline void clear(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>
     return tree.clear();
 }
 
+/*!
+\brief Repacks the subtrees whose nodes overlap.
+
+It calls \c rtree::optimize().
+
+\ingroup rtree_functions
+
+\param tree                The spatial index.
+\param overlap_threshold   The overlap of the children of a node above which its subtree is repacked.
+
+\return                    The number of repacked subtrees.
+*/
+template <typename Value, typename Parameters, typename IndexableGetter, typename EqualTo, typename Allocator>
+inline typename rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator>::size_type
+optimize(rtree<Value, Parameters, IndexableGetter, EqualTo, Allocator> & tree, double overlap_threshold = 0.1)
+{
+    return tree.optimize(overlap_threshold);
+}
+
 /*!
 \brief Get the number of values stored in the index.
 
@@ -0,0 +1,143 @@
+// Boost.Geometry Index
+// Additional tests
+
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// Compares the depth-first k-nearest neighbors search using per-node sorted
+// branch lists, used by default, with the best-first search using one global
+// priority queue, requested with nearest(P, k, best_first()). The rtree
+// created with packing algorithm and by insertion of values are tested.
+// The query() using the query_context reusing the buffers is also tested.
+
+#include <iostream>
+#include <vector>
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include <boost/chrono.hpp>
+#include <boost/random.hpp>
+
+namespace bg = boost::geometry;
+namespace bgi = bg::index;
+
+typedef boost::chrono::thread_clock clock_type;
+typedef boost::chrono::duration<float> dur_t;
+
+template <typename RT, typename P>
+void test_knn(RT const& t, std::vector<P> const& query_points)
+{
+    std::vector<P> result;
+    result.reserve(100);
+
+    unsigned const neighbours_counts[] = { 1, 2, 5, 10 };
+    for ( size_t k = 0 ; k < sizeof(neighbours_counts) / sizeof(neighbours_counts[0]) ; ++k )
+    {
+        unsigned const neighbours_count = neighbours_counts[k];
+
+        {
+            clock_type::time_point start = clock_type::now();
+            size_t temp = 0;
+            for (size_t i = 0 ; i < query_points.size() ; ++i )
+            {
+                result.clear();
+                temp += t.query(bgi::nearest(query_points[i], neighbours_count), std::back_inserter(result));
+            }
+            dur_t time = clock_type::now() - start;
+            std::cout << time << " - query(nearest(P, " << neighbours_count << ")) "
+                      << query_points.size() << " found " << temp << '\n';
+        }
+
+        {
+            clock_type::time_point start = clock_type::now();
+            size_t temp = 0;
+            for (size_t i = 0 ; i < query_points.size() ; ++i )
+            {
+                result.clear();
+                temp += t.query(bgi::nearest(query_points[i], neighbours_count, bgi::best_first()),
+                                std::back_inserter(result));
+            }
+            dur_t time = clock_type::now() - start;
+            std::cout << time << " - query(nearest(P, " << neighbours_count << ", best_first())) "
+                      << query_points.size() << " found " << temp << '\n';
+        }
+
+        {
+            bgi::query_context ctx;
+            clock_type::time_point start = clock_type::now();
+            size_t temp = 0;
+            for (size_t i = 0 ; i < query_points.size() ; ++i )
+            {
+                result.clear();
+                temp += t.query(bgi::nearest(query_points[i], neighbours_count), std::back_inserter(result), ctx);
+            }
+            dur_t time = clock_type::now() - start;
+            std::cout << time << " - query(nearest(P, " << neighbours_count << "), ctx) "
+                      << query_points.size() << " found " << temp << '\n';
+        }
+
+        {
+            bgi::query_context ctx;
+            clock_type::time_point start = clock_type::now();
+            size_t temp = 0;
+            for (size_t i = 0 ; i < query_points.size() ; ++i )
+            {
+                result.clear();
+                temp += t.query(bgi::nearest(query_points[i], neighbours_count, bgi::best_first()),
+                                std::back_inserter(result), ctx);
+            }
+            dur_t time = clock_type::now() - start;
+            std::cout << time << " - query(nearest(P, " << neighbours_count << ", best_first()), ctx) "
+                      << query_points.size() << " found " << temp << '\n';
+        }
+    }
+}
+
+int main()
+{
+    size_t values_count = 1000000;
+    size_t nearest_queries_count = 100000;
+
+    typedef bg::model::point<double, 2, bg::cs::cartesian> P;
+    typedef bgi::rtree<P, bgi::linear<16, 4> > RT;
+
+    std::vector<P> values;
+    std::vector<P> query_points;
+
+    //randomize values
+    {
+        boost::mt19937 rng;
+        float max_val = static_cast<float>(values_count / 2);
+        boost::uniform_real<float> range(-max_val, max_val);
+        boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > rnd(rng, range);
+
+        std::cout << "randomizing data\n";
+        values.reserve(values_count);
+        for ( size_t i = 0 ; i < values_count ; ++i )
+            values.push_back(P(rnd(), rnd()));
+        query_points.reserve(nearest_queries_count);
+        for ( size_t i = 0 ; i < nearest_queries_count ; ++i )
+            query_points.push_back(P(rnd(), rnd()));
+        std::cout << "randomized\n";
+    }
+
+    {
+        RT t(values.begin(), values.end());
+        std::cout << "packed rtree\n";
+        test_knn(t, query_points);
+    }
+
+    {
+        RT t;
+        for ( size_t i = 0 ; i < values.size() ; ++i )
+            t.insert(values[i]);
+        std::cout << "rtree created by insertion\n";
+        test_knn(t, query_points);
+    }
+
+    return 0;
+}
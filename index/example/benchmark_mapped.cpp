@@ -0,0 +1,128 @@
+// Boost.Geometry Index
+// Additional tests
+
+// Copyright (c) 2011-2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// Compares the time needed to get a queryable rtree after a restart:
+// packing the values again vs. memory-mapping the file written by
+// write_mapped() and querying it with the mapped_rtree.
+// The files with quantized boxes of the children are tested as well.
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+#include <boost/geometry/index/mapped_rtree.hpp>
+
+#include <boost/chrono.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/random.hpp>
+
+namespace bg = boost::geometry;
+namespace bgi = bg::index;
+namespace bip = boost::interprocess;
+
+typedef boost::chrono::steady_clock clock_type;
+typedef boost::chrono::duration<float> dur_t;
+
+int main()
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> P;
+    typedef bg::model::box<P> B;
+    typedef std::pair<P, unsigned> V;
+    typedef bgi::rtree<V, bgi::rstar<16, 4> > RT;
+    typedef bgi::mapped_rtree<V, bgi::rstar<16, 4> > MRT;
+
+    size_t const values_count = 2000000;
+    size_t const queries_count = 100000;
+    char const* const file_name = "benchmark_mapped.bin";
+    unsigned const child_box_bits[] = { 0, 8, 16 };
+
+    boost::mt19937 rng;
+    boost::uniform_real<double> range(-1000, 1000);
+    boost::variate_generator<boost::mt19937&, boost::uniform_real<double> > rnd(rng, range);
+
+    std::vector<V> values;
+    for ( size_t i = 0 ; i < values_count ; ++i )
+        values.push_back(std::make_pair(P(rnd(), rnd()), static_cast<unsigned>(i)));
+
+    std::vector<B> query_boxes;
+    for ( size_t i = 0 ; i < queries_count ; ++i )
+    {
+        double const x = rnd(), y = rnd();
+        query_boxes.push_back(B(P(x - 10, y - 10), P(x + 10, y + 10)));
+    }
+
+    std::vector<V> result;
+    result.reserve(1000);
+
+    clock_type::time_point start = clock_type::now();
+    RT t(values.begin(), values.end());
+    dur_t time = clock_type::now() - start;
+    std::cout << time << " - pack " << values_count << std::endl;
+
+    {
+        size_t found = 0;
+        start = clock_type::now();
+        for ( size_t i = 0 ; i < queries_count ; ++i )
+        {
+            result.clear();
+            found += t.query(bgi::intersects(query_boxes[i]), std::back_inserter(result));
+        }
+        time = clock_type::now() - start;
+        std::cout << time << " - rtree query(B) " << queries_count << " found " << found << std::endl;
+    }
+
+    for ( size_t b = 0 ; b < sizeof(child_box_bits) / sizeof(child_box_bits[0]) ; ++b )
+    {
+        std::cout << "child_box_bits: " << child_box_bits[b] << std::endl;
+
+        {
+            std::ofstream ofs(file_name, std::ios::binary);
+            start = clock_type::now();
+            bgi::write_mapped(t, ofs, child_box_bits[b]);
+            ofs.close();
+            time = clock_type::now() - start;
+            std::cout << time << " - write_mapped" << std::endl;
+        }
+
+        start = clock_type::now();
+        bip::file_mapping file(file_name, bip::read_only);
+        bip::mapped_region region(file, bip::read_only);
+        MRT mt(region.get_address(), region.get_size());
+        time = clock_type::now() - start;
+        std::cout << time << " - map " << region.get_size() << " bytes" << std::endl;
+
+        size_t found = 0;
+        start = clock_type::now();
+        for ( size_t i = 0 ; i < queries_count ; ++i )
+        {
+            result.clear();
+            found += mt.query(bgi::intersects(query_boxes[i]), std::back_inserter(result));
+        }
+        time = clock_type::now() - start;
+        std::cout << time << " - mapped_rtree query(B) " << queries_count << " found " << found << std::endl;
+
+        found = 0;
+        start = clock_type::now();
+        for ( size_t i = 0 ; i < queries_count ; ++i )
+        {
+            result.clear();
+            found += mt.query(bgi::nearest(query_boxes[i].min_corner(), 5), std::back_inserter(result));
+        }
+        time = clock_type::now() - start;
+        std::cout << time << " - mapped_rtree query(nearest(P, 5)) " << queries_count << " found " << found << std::endl;
+    }
+
+    std::remove(file_name);
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+// Boost.Geometry Index
+// Additional tests
+
+// Copyright (c) 2011-2020 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// Compares the insertion of batches of values into an existing rtree
+// one by one and with the range insert packing the batch and grafting
+// the leafs of the packed tree, and the speed of the queries afterwards.
+
+#include <iostream>
+#include <vector>
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include <boost/chrono.hpp>
+#include <boost/random.hpp>
+
+namespace bg = boost::geometry;
+namespace bgi = bg::index;
+
+typedef boost::chrono::thread_clock clock_type;
+typedef boost::chrono::duration<float> dur_t;
+
+typedef bg::model::point<double, 2, bg::cs::cartesian> P;
+typedef bg::model::box<P> B;
+typedef bgi::rtree<B, bgi::rstar<16, 4> > RT;
+
+template <typename Insert>
+void run(char const* name, std::vector<B> const& initial,
+         std::vector<std::vector<B> > const& batches,
+         std::vector<B> const& query_boxes,
+         Insert const& insert)
+{
+    RT t(initial.begin(), initial.end());
+
+    {
+        clock_type::time_point start = clock_type::now();
+        for ( size_t i = 0 ; i < batches.size() ; ++i )
+            insert(t, batches[i]);
+        dur_t time = clock_type::now() - start;
+        std::cout << time << " - " << name << " insert " << batches.size() << " batches" << std::endl;
+    }
+
+    {
+        std::vector<B> result;
+        result.reserve(1000);
+        size_t found = 0;
+        clock_type::time_point start = clock_type::now();
+        for ( size_t i = 0 ; i < query_boxes.size() ; ++i )
+        {
+            result.clear();
+            found += t.query(bgi::intersects(query_boxes[i]), std::back_inserter(result));
+        }
+        dur_t time = clock_type::now() - start;
+        std::cout << time << " - " << name << " query(B) " << query_boxes.size() << " found " << found << std::endl;
+    }
+}
+
+struct insert_one_by_one
+{
+    void operator()(RT & t, std::vector<B> const& batch) const
+    {
+        for ( size_t i = 0 ; i < batch.size() ; ++i )
+            t.insert(batch[i]);
+    }
+};
+
+struct insert_range
+{
+    void operator()(RT & t, std::vector<B> const& batch) const
+    {
+        t.insert(batch.begin(), batch.end());
+    }
+};
+
+int main()
+{
+    size_t const values_count = 1000000;
+    size_t const batches_count = 4;
+    size_t const batch_size = 250000;
+    size_t const queries_count = 100000;
+
+    boost::mt19937 rng;
+    boost::uniform_real<double> range(-1000, 1000);
+    boost::variate_generator<boost::mt19937&, boost::uniform_real<double> > rnd(rng, range);
+
+    std::vector<B> initial;
+    for ( size_t i = 0 ; i < values_count ; ++i )
+    {
+        double const x = rnd(), y = rnd();
+        initial.push_back(B(P(x, y), P(x + 0.5, y + 0.5)));
+    }
+
+    std::vector<std::vector<B> > batches(batches_count);
+    for ( size_t j = 0 ; j < batches_count ; ++j )
+    {
+        for ( size_t i = 0 ; i < batch_size ; ++i )
+        {
+            double const x = rnd(), y = rnd();
+            batches[j].push_back(B(P(x, y), P(x + 0.5, y + 0.5)));
+        }
+    }
+
+    std::vector<B> query_boxes;
+    for ( size_t i = 0 ; i < queries_count ; ++i )
+    {
+        double const x = rnd(), y = rnd();
+        query_boxes.push_back(B(P(x, y), P(x + 10, y + 10)));
+    }
+
+    run("one by one", initial, batches, query_boxes, insert_one_by_one());
+    run("range", initial, batches, query_boxes, insert_range());
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+// Boost.Geometry Index
+// Additional tests
+
+// Copyright (c) 2011-2020 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// Compares the intersection tests of the boxes of the children of a node
+// with a query box performed one child at a time by the generic predicates
+// check and all at once by the specialised kernel used by the spatial query.
+// Build with -DBOOST_GEOMETRY_INDEX_DETAIL_NO_SIMD to compare the rtree
+// queries with the scalar fallback.
+
+#include <iostream>
+#include <vector>
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include <boost/chrono.hpp>
+#include <boost/random.hpp>
+
+namespace bg = boost::geometry;
+namespace bgi = bg::index;
+
+typedef boost::chrono::thread_clock clock_type;
+typedef boost::chrono::duration<float> dur_t;
+
+template <typename Box>
+struct child
+{
+    Box first;
+    void * second;
+};
+
+template <typename Point>
+void run(char const* name)
+{
+    typedef bg::model::box<Point> B;
+    typedef child<B> C;
+    typedef bgi::detail::predicates::spatial_predicate
+        <
+            B, bgi::detail::predicates::intersects_tag, false
+        > predicate_t;
+
+    size_t const nodes_count = 10000;
+    size_t const children_count = 16;
+    size_t const queries_count = 1000;
+
+    boost::mt19937 rng;
+    boost::uniform_real<double> range(-1000, 1000);
+    boost::variate_generator<boost::mt19937&, boost::uniform_real<double> > rnd(rng, range);
+
+    std::vector<C> children;
+    for ( size_t i = 0 ; i < nodes_count * children_count ; ++i )
+    {
+        double const x = rnd(), y = rnd();
+        C c;
+        bg::assign_values(c.first, x, y, x + 50, y + 50);
+        c.second = 0;
+        children.push_back(c);
+    }
+
+    std::vector<B> query_boxes;
+    for ( size_t i = 0 ; i < queries_count ; ++i )
+    {
+        double const x = rnd(), y = rnd();
+        B b;
+        bg::assign_values(b, x, y, x + 100, y + 100);
+        query_boxes.push_back(b);
+    }
+
+    bg::default_strategy strategy;
+
+    {
+        size_t found = 0;
+        clock_type::time_point start = clock_type::now();
+        for ( size_t q = 0 ; q < queries_count ; ++q )
+        {
+            predicate_t pred(query_boxes[q]);
+            for ( size_t i = 0 ; i < children.size() ; ++i )
+            {
+                if ( bgi::detail::predicates_check
+                        <
+                            bgi::detail::bounds_tag, 0, 1
+                        >(pred, 0, children[i].first, strategy) )
+                {
+                    ++found;
+                }
+            }
+        }
+        dur_t time = clock_type::now() - start;
+        std::cout << time << " - " << name << " predicates_check found " << found << std::endl;
+    }
+
+    {
+        size_t found = 0;
+        clock_type::time_point start = clock_type::now();
+        for ( size_t q = 0 ; q < queries_count ; ++q )
+        {
+            for ( size_t i = 0 ; i < children.size() ; i += children_count )
+            {
+                boost::uint64_t mask = bgi::detail::intersecting_children<B, B>
+                    ::apply(children.begin() + i, children_count, query_boxes[q]);
+                for ( ; mask ; mask &= mask - 1 )
+                    ++found;
+            }
+        }
+        dur_t time = clock_type::now() - start;
+        std::cout << time << " - " << name << " intersecting_children found " << found << std::endl;
+    }
+}
+
+template <typename Point>
+void run_rtree(char const* name)
+{
+    typedef bg::model::box<Point> B;
+    typedef bgi::rtree<B, bgi::rstar<16, 4> > RT;
+
+    size_t const values_count = 1000000;
+    size_t const queries_count = 100000;
+
+    boost::mt19937 rng;
+    boost::uniform_real<double> range(-1000, 1000);
+    boost::variate_generator<boost::mt19937&, boost::uniform_real<double> > rnd(rng, range);
+
+    std::vector<B> values;
+    for ( size_t i = 0 ; i < values_count ; ++i )
+    {
+        double const x = rnd(), y = rnd();
+        B b;
+        bg::assign_values(b, x, y, x + 0.5, y + 0.5);
+        values.push_back(b);
+    }
+
+    std::vector<B> query_boxes;
+    for ( size_t i = 0 ; i < queries_count ; ++i )
+    {
+        double const x = rnd(), y = rnd();
+        B b;
+        bg::assign_values(b, x, y, x + 10, y + 10);
+        query_boxes.push_back(b);
+    }
+
+    RT t(values.begin(), values.end());
+
+    std::vector<B> result;
+    result.reserve(1000);
+
+    size_t found = 0;
+    clock_type::time_point start = clock_type::now();
+    for ( size_t i = 0 ; i < queries_count ; ++i )
+    {
+        result.clear();
+        found += t.query(bgi::intersects(query_boxes[i]), std::back_inserter(result));
+    }
+    dur_t time = clock_type::now() - start;
+    std::cout << time << " - " << name << " rtree query(B) " << queries_count << " found " << found << std::endl;
+}
+
+int main()
+{
+    run<bg::model::point<double, 2, bg::cs::cartesian> >("double");
+    run<bg::model::point<float, 2, bg::cs::cartesian> >("float");
+
+    run_rtree<bg::model::point<double, 2, bg::cs::cartesian> >("double");
+    run_rtree<bg::model::point<float, 2, bg::cs::cartesian> >("float");
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2011-2020 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <geometry_index_test_common.hpp>
+
+#include <boost/geometry/index/detail/algorithms/intersecting_children.hpp>
+
+#include <boost/geometry/geometries/point_xy.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/box.hpp>
+
+#include <limits>
+#include <vector>
+
+template <typename Box>
+struct child
+{
+    Box first;
+    void * second;
+};
+
+template <typename Box, std::size_t I = 0, std::size_t D = bg::dimension<Box>::value>
+struct assign_box
+{
+    template <typename T>
+    static void apply(Box & b, T const* mins, T const* maxs)
+    {
+        bg::set<bg::min_corner, I>(b, mins[I]);
+        bg::set<bg::max_corner, I>(b, maxs[I]);
+        assign_box<Box, I + 1, D>::apply(b, mins, maxs);
+    }
+};
+
+template <typename Box, std::size_t D>
+struct assign_box<Box, D, D>
+{
+    template <typename T>
+    static void apply(Box &, T const*, T const*) {}
+};
+
+template <typename Box, typename QueryBox>
+void check_children(std::vector<child<Box> > const& children, QueryBox const& query_box)
+{
+    size_t const count = (std::min)(children.size(), bgi::detail::intersecting_children_max_count);
+
+    boost::uint64_t const mask = bgi::detail::intersecting_children<Box, QueryBox>
+                                    ::apply(children.begin(), count, query_box);
+    boost::uint64_t const scalar_mask = bgi::detail::intersecting_children_scalar<Box, QueryBox>
+                                    ::apply(children.begin(), count, query_box);
+    BOOST_CHECK_EQUAL(mask, scalar_mask);
+
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        bool const expected = bg::intersects(children[i].first, query_box);
+        BOOST_CHECK_EQUAL(((mask >> i) & 1) != 0, expected);
+    }
+}
+
+// the coordinates of the children are small integers so the boxes touch each other
+// and the query box in various ways
+template <typename Box, typename QueryBox>
+void test_children()
+{
+    typedef typename bg::coordinate_type<Box>::type coord_t;
+    typedef typename bg::coordinate_type<QueryBox>::type query_coord_t;
+    static const std::size_t dim = bg::dimension<Box>::value;
+
+    std::vector<child<Box> > children;
+    for ( size_t i = 0 ; i < 64 ; ++i )
+    {
+        coord_t mins[dim], maxs[dim];
+        for ( size_t d = 0 ; d < dim ; ++d )
+        {
+            mins[d] = static_cast<coord_t>((i * (d + 3) + d) % 7);
+            maxs[d] = mins[d] + static_cast<coord_t>((i + d) % 3);
+        }
+        child<Box> c;
+        assign_box<Box>::apply(c.first, mins, maxs);
+        c.second = 0;
+        children.push_back(c);
+    }
+
+    for ( size_t j = 0 ; j < 20 ; ++j )
+    {
+        query_coord_t mins[dim], maxs[dim];
+        for ( size_t d = 0 ; d < dim ; ++d )
+        {
+            mins[d] = static_cast<query_coord_t>((j * (d + 5)) % 6);
+            maxs[d] = mins[d] + static_cast<query_coord_t>(j % 4);
+        }
+        QueryBox query_box;
+        assign_box<QueryBox>::apply(query_box, mins, maxs);
+
+        check_children(children, query_box);
+    }
+
+    // less than the number of the elements processed at once
+    children.resize(3);
+    QueryBox query_box;
+    query_coord_t qmins[dim], qmaxs[dim];
+    for ( size_t d = 0 ; d < dim ; ++d )
+    {
+        qmins[d] = 1;
+        qmaxs[d] = 2;
+    }
+    assign_box<QueryBox>::apply(query_box, qmins, qmaxs);
+    check_children(children, query_box);
+}
+
+template <typename T>
+void test_nan()
+{
+    typedef bg::model::point<T, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+
+    T const nan = std::numeric_limits<T>::quiet_NaN();
+
+    std::vector<child<box_t> > children(2);
+    children[0].first = box_t(point_t(nan, 0), point_t(1, 1));
+    children[1].first = box_t(point_t(0, 0), point_t(1, nan));
+
+    box_t query_box(point_t(0, 0), point_t(2, 2));
+
+    boost::uint64_t const mask = bgi::detail::intersecting_children<box_t, box_t>
+                                    ::apply(children.begin(), children.size(), query_box);
+    boost::uint64_t const scalar_mask = bgi::detail::intersecting_children_scalar<box_t, box_t>
+                                    ::apply(children.begin(), children.size(), query_box);
+    BOOST_CHECK_EQUAL(mask, scalar_mask);
+}
+
+int test_main(int, char* [])
+{
+    typedef bg::model::point<int, 2, bg::cs::cartesian> P2ic;
+    typedef bg::model::point<float, 2, bg::cs::cartesian> P2fc;
+    typedef bg::model::point<double, 2, bg::cs::cartesian> P2dc;
+    typedef bg::model::d2::point_xy<double> P2xy;
+
+    typedef bg::model::point<float, 3, bg::cs::cartesian> P3fc;
+    typedef bg::model::point<double, 3, bg::cs::cartesian> P3dc;
+    typedef bg::model::point<float, 5, bg::cs::cartesian> P5fc;
+    typedef bg::model::point<double, 5, bg::cs::cartesian> P5dc;
+    typedef bg::model::point<double, 7, bg::cs::cartesian> P7dc;
+
+    test_children<bg::model::box<P2ic>, bg::model::box<P2ic> >();
+    test_children<bg::model::box<P2fc>, bg::model::box<P2fc> >();
+    test_children<bg::model::box<P2dc>, bg::model::box<P2dc> >();
+    test_children<bg::model::box<P2xy>, bg::model::box<P2dc> >();
+    test_children<bg::model::box<P2dc>, bg::model::box<P2xy> >();
+    test_children<bg::model::box<P2fc>, bg::model::box<P2dc> >();
+    test_children<bg::model::box<P3fc>, bg::model::box<P3fc> >();
+    test_children<bg::model::box<P3dc>, bg::model::box<P3dc> >();
+    test_children<bg::model::box<P5fc>, bg::model::box<P5fc> >();
+    test_children<bg::model::box<P5dc>, bg::model::box<P5dc> >();
+    test_children<bg::model::box<P7dc>, bg::model::box<P7dc> >();
+
+    test_nan<float>();
+    test_nan<double>();
+
+    return 0;
+}
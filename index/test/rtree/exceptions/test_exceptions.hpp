@@ -24,6 +24,34 @@
 #include <boost/geometry/geometries/point.hpp>
 #include <boost/geometry/geometries/box.hpp>
 
+// the range insert packs big ranges so the values are inserted one by one
+// to test the exceptions thrown by the insert visitors
+template <typename Tree, typename Values>
+void insert_one_by_one(Tree & tree, Values const& values)
+{
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+        tree.insert(*it);
+}
+
+// the range remove traverses the tree once so the values are removed one by one
+// to test the exceptions thrown by the remove visitor
+template <typename Tree, typename Values>
+void remove_one_by_one(Tree & tree, Values const& values)
+{
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+        tree.remove(*it);
+}
+
+// every other value is removed so the underflowed nodes are reinserted
+template <typename Values>
+Values every_other(Values const& values)
+{
+    Values result;
+    for ( size_t i = 0 ; i < values.size() ; i += 2 )
+        result.push_back(values[i]);
+    return result;
+}
+
 // test value exceptions
 template <typename Parameters>
 void test_rtree_value_exceptions(Parameters const& parameters = Parameters())
@@ -48,6 +76,21 @@ void test_rtree_value_exceptions(Parameters const& parameters = Parameters())
         throwing_value::reset_calls_counter();
         throwing_value::set_max_calls(i);
 
+        BOOST_CHECK_THROW( insert_one_by_one(tree, input), throwing_value_copy_exception );
+
+        BOOST_CHECK(bgi::detail::rtree::utilities::are_counts_ok(tree, false));
+    }
+
+    for ( size_t i = 0 ; i < input.size() ; i += 2 )
+    {
+        throwing_value::reset_calls_counter();
+        throwing_value::set_max_calls(10000);
+
+        Tree tree(input.begin(), input.end(), parameters);
+
+        throwing_value::reset_calls_counter();
+        throwing_value::set_max_calls(i);
+
         BOOST_CHECK_THROW( tree.insert(input.begin(), input.end()), throwing_value_copy_exception );
 
         BOOST_CHECK(bgi::detail::rtree::utilities::are_counts_ok(tree, false));
@@ -61,6 +104,31 @@ void test_rtree_value_exceptions(Parameters const& parameters = Parameters())
         BOOST_CHECK_THROW( Tree tree(input.begin(), input.end(), parameters), throwing_value_copy_exception );
     }
 
+    for ( size_t i = 0 ; i < 20 ; i += 1 )
+    {
+        throwing_value::reset_calls_counter();
+        throwing_value::set_max_calls(i);
+
+        BOOST_CHECK_THROW( Tree tree(input.begin(), input.end(), parameters, bgi::packing::str()), throwing_value_copy_exception );
+    }
+
+    for ( size_t i = 0 ; i < 10 ; i += 1 )
+    {
+        throwing_value::reset_calls_counter();
+        throwing_value::set_max_calls(10000);
+
+        Tree tree(parameters);
+
+        tree.insert(input.begin(), input.end());
+
+        throwing_value::reset_calls_counter();
+        throwing_value::set_max_calls(i);
+
+        BOOST_CHECK_THROW( remove_one_by_one(tree, input), throwing_value_copy_exception );
+
+        BOOST_CHECK(bgi::detail::rtree::utilities::are_counts_ok(tree, false));
+    }
+
     for ( size_t i = 0 ; i < 10 ; i += 1 )
     {
         throwing_value::reset_calls_counter();
@@ -137,6 +205,21 @@ void test_rtree_elements_exceptions(Parameters const& parameters = Parameters())
         throwing_varray_settings::reset_calls_counter();
         throwing_varray_settings::set_max_calls(i);
 
+        BOOST_CHECK_THROW( insert_one_by_one(tree, input), throwing_varray_exception );
+
+        BOOST_CHECK(bgi::detail::rtree::utilities::are_counts_ok(tree, false));
+    }
+
+    for ( size_t i = 0 ; i < 100 ; i += 2 )
+    {
+        throwing_varray_settings::reset_calls_counter();
+        throwing_varray_settings::set_max_calls(10000);
+
+        Tree tree(input.begin(), input.end(), parameters);
+
+        throwing_varray_settings::reset_calls_counter();
+        throwing_varray_settings::set_max_calls(i);
+
         BOOST_CHECK_THROW( tree.insert(input.begin(), input.end()), throwing_varray_exception );
 
         BOOST_CHECK(bgi::detail::rtree::utilities::are_counts_ok(tree, false));
@@ -154,6 +237,19 @@ void test_rtree_elements_exceptions(Parameters const& parameters = Parameters())
         BOOST_CHECK_EQUAL(throwing_nodes_stats::internal_nodes_count(), 0u);
         BOOST_CHECK_EQUAL(throwing_nodes_stats::leafs_count(), 0u);
     }
+
+    for ( size_t i = 0 ; i < 100 ; i += 2 )
+    {
+        throwing_varray_settings::reset_calls_counter();
+        throwing_varray_settings::set_max_calls(i);
+
+        throwing_nodes_stats::reset_counters();
+
+        BOOST_CHECK_THROW( Tree tree(input.begin(), input.end(), parameters, bgi::packing::hilbert()), throwing_varray_exception );
+
+        BOOST_CHECK_EQUAL(throwing_nodes_stats::internal_nodes_count(), 0u);
+        BOOST_CHECK_EQUAL(throwing_nodes_stats::leafs_count(), 0u);
+    }
     
     for ( size_t i = 0 ; i < 50 ; i += 2 )
     {
@@ -167,7 +263,26 @@ void test_rtree_elements_exceptions(Parameters const& parameters = Parameters())
         throwing_varray_settings::reset_calls_counter();
         throwing_varray_settings::set_max_calls(i);
 
-        BOOST_CHECK_THROW( tree.remove(input.begin(), input.end()), throwing_varray_exception );
+        BOOST_CHECK_THROW( remove_one_by_one(tree, input), throwing_varray_exception );
+
+        BOOST_CHECK(bgi::detail::rtree::utilities::are_counts_ok(tree, false));
+    }
+
+    std::vector<Value> const removed = every_other(input);
+
+    for ( size_t i = 0 ; i < 50 ; i += 2 )
+    {
+        throwing_varray_settings::reset_calls_counter();
+        throwing_varray_settings::set_max_calls(10000);
+
+        Tree tree(parameters);
+
+        insert_one_by_one(tree, input);
+
+        throwing_varray_settings::reset_calls_counter();
+        throwing_varray_settings::set_max_calls(i);
+
+        BOOST_CHECK_THROW( tree.remove(removed.begin(), removed.end()), throwing_varray_exception );
 
         BOOST_CHECK(bgi::detail::rtree::utilities::are_counts_ok(tree, false));
     }
@@ -0,0 +1,214 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2011-2020 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+#include <rtree/test_allocation_hooks.hpp>
+
+#include <boost/geometry/index/arena_allocator.hpp>
+
+#include <algorithm>
+#include <vector>
+
+template <typename Point>
+std::vector<std::pair<Point, int> > generate_values(size_t count)
+{
+    std::vector<std::pair<Point, int> > values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        values.push_back(std::make_pair(Point(x, y), static_cast<int>(i)));
+    }
+    return values;
+}
+
+template <typename Values>
+std::vector<int> sorted_ids(Values const& values)
+{
+    std::vector<int> result;
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+        result.push_back(it->second);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+template <typename Rtree, typename Box>
+std::vector<int> query_ids(Rtree const& tree, Box const& box)
+{
+    std::vector<typename Rtree::value_type> result;
+    tree.query(bgi::intersects(box), std::back_inserter(result));
+    return sorted_ids(result);
+}
+
+template <typename Rtree, typename Values>
+void check_tree(Rtree const& tree, Values const& values)
+{
+    typedef typename Rtree::bounds_type box_t;
+    typedef typename bg::point_type<box_t>::type point_t;
+
+    BOOST_CHECK(tree.size() == values.size());
+    BOOST_CHECK(bgi::detail::rtree::utilities::are_levels_ok(tree));
+    BOOST_CHECK(bgi::detail::rtree::utilities::are_boxes_ok(tree));
+
+    box_t query_box(point_t(100, 100), point_t(600, 400));
+    Values expected;
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+    {
+        if ( bg::intersects(it->first, query_box) )
+            expected.push_back(*it);
+    }
+    BOOST_CHECK(query_ids(tree, query_box) == sorted_ids(expected));
+}
+
+template <typename Parameters>
+void test_arena(Parameters const& parameters, bool is_released_at_once)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef std::pair<point_t, int> value_t;
+    typedef bgi::arena_allocator<value_t> allocator_t;
+    typedef bgi::rtree
+        <
+            value_t, Parameters, bgi::indexable<value_t>,
+            bgi::equal_to<value_t>, allocator_t
+        > rtree_t;
+
+    std::vector<value_t> values = generate_values<point_t>(10000);
+
+    // packing
+    {
+        rtree_t tree(values.begin(), values.end(), parameters);
+        check_tree(tree, values);
+        BOOST_CHECK(tree.get_allocator().allocated_bytes() > 0);
+    }
+
+    // incremental insert and remove, the memory of the removed nodes is reused
+    {
+        rtree_t tree(parameters);
+        for ( size_t i = 0 ; i < values.size() ; ++i )
+            tree.insert(values[i]);
+        check_tree(tree, values);
+
+        size_t const allocated = tree.get_allocator().allocated_bytes();
+
+        std::vector<value_t> remaining(values.begin() + values.size() / 2, values.end());
+        tree.remove(values.begin(), values.begin() + values.size() / 2);
+        check_tree(tree, remaining);
+
+        for ( size_t i = 0 ; i < values.size() / 2 ; ++i )
+            tree.insert(values[i]);
+        check_tree(tree, values);
+
+        BOOST_CHECK(tree.get_allocator().allocated_bytes() <= 2 * allocated);
+    }
+
+    // copy, move, swap and clear
+    {
+        rtree_t tree(values.begin(), values.end(), parameters);
+
+        rtree_t copied(tree);
+        check_tree(copied, values);
+        BOOST_CHECK(copied.get_allocator() != tree.get_allocator());
+
+        rtree_t moved(boost::move(copied));
+        check_tree(moved, values);
+        BOOST_CHECK(copied.empty());
+
+        std::vector<value_t> half(values.begin(), values.begin() + values.size() / 2);
+        rtree_t other(half.begin(), half.end(), parameters);
+        other = tree;
+        check_tree(other, values);
+        BOOST_CHECK(other.get_allocator() != tree.get_allocator());
+
+        other.clear();
+        BOOST_CHECK(other.empty());
+        // the nodes of the trees with dynamic parameters are destroyed one by one
+        // and the memory is kept for the nodes created later
+        BOOST_CHECK((other.get_allocator().allocated_bytes() == 0) == is_released_at_once);
+
+        other.insert(half.begin(), half.end());
+        check_tree(other, half);
+
+        tree.swap(other);
+        check_tree(tree, half);
+        check_tree(other, values);
+
+        moved = boost::move(other);
+        check_tree(moved, values);
+    }
+
+    // the allocator shared by two trees
+    {
+        allocator_t allocator;
+        rtree_t tree1(values.begin(), values.end(), parameters, bgi::indexable<value_t>(),
+                      bgi::equal_to<value_t>(), allocator);
+        {
+            rtree_t tree2(values.begin(), values.end(), parameters, bgi::indexable<value_t>(),
+                          bgi::equal_to<value_t>(), allocator);
+            check_tree(tree2, values);
+        }
+        check_tree(tree1, values);
+        tree1.clear();
+        BOOST_CHECK(tree1.empty());
+        tree1.insert(values.begin(), values.end());
+        check_tree(tree1, values);
+    }
+}
+
+// nodes are allocated in slabs and released at once if the tree owns the arena
+void test_allocations()
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef std::pair<point_t, int> value_t;
+    typedef bgi::rtree
+        <
+            value_t, bgi::rstar<16, 4>, bgi::indexable<value_t>,
+            bgi::equal_to<value_t>, bgi::arena_allocator<value_t>
+        > rtree_t;
+    typedef bgi::rtree<value_t, bgi::rstar<16, 4> > default_rtree_t;
+
+    std::vector<value_t> values = generate_values<point_t>(10000);
+
+    size_t default_allocations = 0;
+    {
+        default_rtree_t tree;
+        size_t const before = allocations_count;
+        for ( size_t i = 0 ; i < values.size() ; ++i )
+            tree.insert(values[i]);
+        default_allocations = allocations_count - before;
+    }
+
+    {
+        rtree_t tree;
+        size_t const before = allocations_count;
+        for ( size_t i = 0 ; i < values.size() ; ++i )
+            tree.insert(values[i]);
+        size_t const arena_allocations = allocations_count - before;
+        BOOST_CHECK(arena_allocations * 10 < default_allocations);
+
+        size_t const deallocations_before = deallocations_count;
+        tree.clear();
+        BOOST_CHECK(deallocations_count - deallocations_before <= arena_allocations + 1);
+        BOOST_CHECK(tree.get_allocator().allocated_bytes() == 0);
+
+        tree.insert(values.begin(), values.end());
+        check_tree(tree, values);
+    }
+}
+
+int test_main(int, char* [])
+{
+    test_arena(bgi::linear<16, 4>(), true);
+    test_arena(bgi::quadratic<4, 2>(), true);
+    test_arena(bgi::rstar<16, 4>(), true);
+    test_arena(bgi::dynamic_rstar(16, 4), false);
+
+    test_allocations();
+
+    return 0;
+}
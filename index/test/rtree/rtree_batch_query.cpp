@@ -0,0 +1,186 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+
+#include <algorithm>
+#include <vector>
+
+template <typename Value>
+struct ids_collector
+{
+    explicit ids_collector(std::vector<std::vector<int> > & r)
+        : results(&r)
+    {}
+
+    template <typename SizeType>
+    void operator()(SizeType query_index, Value const& v) const
+    {
+        (*results)[query_index].push_back(v.second);
+    }
+
+    std::vector<std::vector<int> > * results;
+};
+
+struct id_less_than
+{
+    explicit id_less_than(int t) : threshold(t) {}
+
+    template <typename Value>
+    bool operator()(Value const& v) const
+    {
+        return v.second < threshold;
+    }
+
+    int threshold;
+};
+
+template <typename Boxes, typename Predicates, typename Maker>
+std::vector<Predicates> make_predicates(Boxes const& boxes, Predicates const& , Maker const& maker)
+{
+    std::vector<Predicates> result;
+    for ( size_t i = 0 ; i < boxes.size() ; ++i )
+        result.push_back(maker(boxes[i]));
+    return result;
+}
+
+struct intersects_maker
+{
+    template <typename Box>
+    bgi::detail::predicates::spatial_predicate<Box, bgi::detail::predicates::intersects_tag, false>
+        operator()(Box const& b) const
+    {
+        return bgi::intersects(b);
+    }
+};
+
+struct within_maker
+{
+    template <typename Box>
+    bgi::detail::predicates::spatial_predicate<Box, bgi::detail::predicates::within_tag, false>
+        operator()(Box const& b) const
+    {
+        return bgi::within(b);
+    }
+};
+
+struct not_disjoint_id_maker
+{
+    explicit not_disjoint_id_maker(int t) : threshold(t) {}
+
+    template <typename Box>
+    boost::tuples::cons
+        <
+            bgi::detail::predicates::spatial_predicate<Box, bgi::detail::predicates::disjoint_tag, true>,
+            boost::tuples::cons
+                <
+                    bgi::detail::predicates::satisfies<id_less_than, false>,
+                    boost::tuples::null_type
+                >
+        >
+        operator()(Box const& b) const
+    {
+        return !bgi::disjoint(b) && bgi::satisfies(id_less_than(threshold));
+    }
+
+    int threshold;
+};
+
+template <typename Rtree, typename Predicates>
+void check_batch_query(Rtree const& tree, std::vector<Predicates> const& predicates)
+{
+    typedef typename Rtree::value_type value_t;
+
+    std::vector<std::vector<int> > results(predicates.size());
+    size_t found = tree.batch_query(predicates, ids_collector<value_t>(results));
+
+    std::vector<std::vector<int> > results_fun(predicates.size());
+    size_t found_fun = bgi::batch_query(tree, predicates, ids_collector<value_t>(results_fun));
+
+    BOOST_CHECK(found == found_fun);
+
+    size_t expected_found = 0;
+    for ( size_t i = 0 ; i < predicates.size() ; ++i )
+    {
+        std::vector<value_t> expected;
+        expected_found += tree.query(predicates[i], std::back_inserter(expected));
+
+        std::vector<int> expected_ids;
+        for ( size_t j = 0 ; j < expected.size() ; ++j )
+            expected_ids.push_back(expected[j].second);
+
+        std::sort(expected_ids.begin(), expected_ids.end());
+        std::sort(results[i].begin(), results[i].end());
+        std::sort(results_fun[i].begin(), results_fun[i].end());
+
+        BOOST_CHECK(expected_ids == results[i]);
+        BOOST_CHECK(expected_ids == results_fun[i]);
+    }
+
+    BOOST_CHECK(found == expected_found);
+}
+
+template <typename Indexable, typename Params>
+void test_rtree(Params const& params, size_t count, size_t queries_count)
+{
+    typedef std::pair<Indexable, int> value_t;
+    typedef bgi::rtree<value_t, Params> rtree_t;
+    typedef typename rtree_t::bounds_type box_t;
+    typedef typename bg::point_type<box_t>::type point_t;
+
+    std::vector<value_t> values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        values.push_back(std::make_pair(generate::value<Indexable>::apply(x, y), static_cast<int>(i)));
+    }
+
+    rtree_t tree(values, params);
+
+    std::vector<box_t> boxes;
+    for ( size_t i = 0 ; i < queries_count ; ++i )
+    {
+        int x = static_cast<int>((i * 31) % 1000);
+        int y = static_cast<int>((i * 17) % 1000);
+        int s = static_cast<int>(i % 50);
+        boxes.push_back(box_t(point_t(x, y), point_t(x + s, y + s)));
+    }
+
+    check_batch_query(tree, make_predicates(boxes, bgi::intersects(box_t()), intersects_maker()));
+    check_batch_query(tree, make_predicates(boxes, bgi::within(box_t()), within_maker()));
+    check_batch_query(tree, make_predicates(boxes,
+                                            !bgi::disjoint(box_t()) && bgi::satisfies(id_less_than(0)),
+                                            not_disjoint_id_maker(static_cast<int>(count / 2))));
+}
+
+template <typename Indexable>
+void test_rtree_all()
+{
+    size_t const counts[] = { 0, 1, 177, 5000 };
+    for ( size_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i )
+    {
+        // more queries than processed at once
+        test_rtree<Indexable>(bgi::linear<16, 4>(), counts[i], 3000);
+        test_rtree<Indexable>(bgi::rstar<5, 2>(), counts[i], 100);
+        test_rtree<Indexable>(bgi::dynamic_quadratic(8, 3), counts[i], 0);
+        test_rtree<Indexable>(bgi::dynamic_quadratic(8, 3), counts[i], 100);
+    }
+}
+
+int test_main(int, char* [])
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+
+    test_rtree_all<point_t>();
+    test_rtree_all<box_t>();
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+
+#include <algorithm>
+#include <vector>
+
+struct is_even
+{
+    template <typename Value>
+    bool operator()(Value const& v) const
+    {
+        return v.second % 2 == 0;
+    }
+};
+
+template <typename Indexable>
+std::vector<std::pair<Indexable, int> > generate_values(size_t count)
+{
+    std::vector<std::pair<Indexable, int> > values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        values.push_back(std::make_pair(generate::value<Indexable>::apply(x, y), static_cast<int>(i)));
+    }
+    return values;
+}
+
+// the results may differ for values having equal distances so the distances are compared
+template <typename Values, typename Point>
+std::vector<double> sorted_distances(Values const& values, Point const& pt)
+{
+    std::vector<double> result;
+    for ( size_t i = 0 ; i < values.size() ; ++i )
+        result.push_back(bg::comparable_distance(pt, values[i].first));
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+template <typename Rtree, typename Values, typename Point, typename Predicates, typename BestFirstPredicates>
+void check_nearest(Rtree const& tree, Values const& values, Point const& pt, unsigned k,
+                   Predicates const& predicates, BestFirstPredicates const& predicates_bf)
+{
+    typedef typename Rtree::value_type value_t;
+
+    std::vector<value_t> result;
+    size_t found = tree.query(predicates, std::back_inserter(result));
+    BOOST_CHECK(found == result.size());
+
+    std::vector<value_t> result_bf;
+    size_t found_bf = tree.query(predicates_bf, std::back_inserter(result_bf));
+    BOOST_CHECK(found_bf == result_bf.size());
+
+    bgi::query_context ctx;
+    std::vector<value_t> result_bf_ctx;
+    size_t found_bf_ctx = tree.query(predicates_bf, std::back_inserter(result_bf_ctx), ctx);
+    BOOST_CHECK(found_bf_ctx == result_bf_ctx.size());
+
+    std::vector<double> expected = sorted_distances(values, pt);
+    if ( k < expected.size() )
+        expected.resize(k);
+
+    BOOST_CHECK(sorted_distances(result, pt) == expected);
+    BOOST_CHECK(sorted_distances(result_bf, pt) == expected);
+    BOOST_CHECK(sorted_distances(result_bf_ctx, pt) == expected);
+}
+
+template <typename Indexable, typename Params>
+void test_nearest(Params const& params, size_t count)
+{
+    typedef std::pair<Indexable, int> value_t;
+    typedef bgi::rtree<value_t, Params> rtree_t;
+    typedef typename bg::point_type<Indexable>::type point_t;
+
+    std::vector<value_t> values = generate_values<Indexable>(count);
+    std::vector<value_t> even_values;
+    for ( size_t i = 0 ; i < values.size() ; ++i )
+        if ( is_even()(values[i]) )
+            even_values.push_back(values[i]);
+
+    rtree_t tree(values, params);
+    // created with insert() to test the tree with overlapping nodes
+    rtree_t tree_ins(params);
+    tree_ins.insert(values);
+
+    unsigned const ks[] = { 1, 2, 5, 10, 100 };
+    for ( size_t i = 0 ; i < sizeof(ks) / sizeof(ks[0]) ; ++i )
+    {
+        for ( int j = 0 ; j < 10 ; ++j )
+        {
+            point_t pt;
+            bg::assign_values(pt, j * 101 % 1013, j * 307 % 997);
+
+            check_nearest(tree, values, pt, ks[i],
+                          bgi::nearest(pt, ks[i]),
+                          bgi::nearest(pt, ks[i], bgi::best_first()));
+            check_nearest(tree, even_values, pt, ks[i],
+                          bgi::nearest(pt, ks[i]) && bgi::satisfies(is_even()),
+                          bgi::satisfies(is_even()) && bgi::nearest(pt, ks[i], bgi::best_first()));
+            check_nearest(tree_ins, values, pt, ks[i],
+                          bgi::nearest(pt, ks[i], bgi::depth_first()),
+                          bgi::nearest(pt, ks[i], bgi::best_first()));
+            check_nearest(tree_ins, even_values, pt, ks[i],
+                          bgi::nearest(pt, ks[i]) && bgi::satisfies(is_even()),
+                          bgi::nearest(pt, ks[i], bgi::best_first()) && bgi::satisfies(is_even()));
+        }
+    }
+}
+
+template <typename Indexable>
+void test_nearest_all()
+{
+    size_t const counts[] = { 0, 1, 30, 1000 };
+    for ( size_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i )
+    {
+        test_nearest<Indexable>(bgi::linear<16, 4>(), counts[i]);
+        test_nearest<Indexable>(bgi::dynamic_quadratic(8, 3), counts[i]);
+        test_nearest<Indexable>(bgi::rstar<4, 2>(), counts[i]);
+    }
+}
+
+int test_main(int, char* [])
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+
+    test_nearest_all<point_t>();
+    test_nearest_all<box_t>();
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2011-2020 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <vector>
+
+template <typename Point>
+std::vector<std::pair<Point, int> > generate_values(size_t count)
+{
+    std::vector<std::pair<Point, int> > values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        values.push_back(std::make_pair(Point(x, y), static_cast<int>(i)));
+    }
+    return values;
+}
+
+template <typename Values>
+std::vector<int> sorted_ids(Values const& values)
+{
+    std::vector<int> result;
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+        result.push_back(it->second);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+struct always_true
+{
+    template <typename Value>
+    bool operator()(Value const&) const { return true; }
+};
+
+struct is_odd
+{
+    template <typename Value>
+    bool operator()(Value const& v) const { return v.second % 2 == 1; }
+};
+
+template <typename Rtree, typename Values>
+void check_tree(Rtree & tree, Values const& values)
+{
+    BOOST_CHECK(tree.size() == values.size());
+    // the root of an empty tree may not exist
+    if ( ! tree.empty() )
+    {
+        BOOST_CHECK(bgi::detail::rtree::utilities::are_counts_ok(tree));
+        BOOST_CHECK(bgi::detail::rtree::utilities::are_levels_ok(tree));
+        BOOST_CHECK(bgi::detail::rtree::utilities::are_boxes_ok(tree));
+    }
+
+    Values all;
+    tree.query(bgi::satisfies(always_true()), std::back_inserter(all));
+    BOOST_CHECK(sorted_ids(all) == sorted_ids(values));
+
+    // the tree may be modified after the removal
+    if ( ! values.empty() )
+    {
+        BOOST_CHECK(tree.remove(values.front()) == 1);
+        tree.insert(values.front());
+        BOOST_CHECK(tree.size() == values.size());
+        BOOST_CHECK(bgi::detail::rtree::utilities::are_levels_ok(tree));
+    }
+}
+
+template <typename Rtree, typename Values, typename Box>
+void test_remove_if(Rtree const& tree, Values const& values, Box const& region)
+{
+    // intersects
+    {
+        Rtree t(tree);
+        Values expected;
+        for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+            if ( ! bg::intersects(it->first, region) )
+                expected.push_back(*it);
+
+        BOOST_CHECK(t.remove_if(bgi::intersects(region)) == values.size() - expected.size());
+        check_tree(t, expected);
+    }
+
+    // negated predicate and satisfies
+    {
+        Rtree t(tree);
+        Values expected;
+        for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+            if ( bg::intersects(it->first, region) || it->second % 2 == 0 )
+                expected.push_back(*it);
+
+        BOOST_CHECK(bgi::remove_if(t, !bgi::intersects(region) && bgi::satisfies(is_odd()))
+                    == values.size() - expected.size());
+        check_tree(t, expected);
+    }
+
+    // all values
+    {
+        Rtree t(tree);
+        BOOST_CHECK(t.remove_if(bgi::satisfies(always_true())) == values.size());
+        check_tree(t, Values());
+
+        t.insert(values.begin(), values.end());
+        check_tree(t, values);
+    }
+}
+
+template <typename Rtree, typename Values, typename Box>
+void test_remove_range(Rtree const& tree, Values const& values, Box const& region)
+{
+    Values to_remove, expected;
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+    {
+        if ( bg::intersects(it->first, region) )
+            to_remove.push_back(*it);
+        else
+            expected.push_back(*it);
+    }
+
+    // the outsider and the duplicate aren't removed
+    Values to_remove_ext = to_remove;
+    to_remove_ext.push_back(std::make_pair(values.front().first, -1));
+    if ( ! to_remove.empty() )
+        to_remove_ext.push_back(to_remove.front());
+
+    // forward iterators
+    {
+        Rtree t(tree);
+        BOOST_CHECK(t.remove(to_remove_ext.begin(), to_remove_ext.end()) == to_remove.size());
+        check_tree(t, expected);
+    }
+
+    // range
+    {
+        Rtree t(tree);
+        BOOST_CHECK(bgi::remove(t, to_remove_ext) == to_remove.size());
+        check_tree(t, expected);
+    }
+
+    // bidirectional iterators
+    {
+        Rtree t(tree);
+        std::list<typename Values::value_type> l(to_remove_ext.begin(), to_remove_ext.end());
+        BOOST_CHECK(t.remove(l.begin(), l.end()) == to_remove.size());
+        check_tree(t, expected);
+    }
+
+    // all values, the equal values are removed once per passed value
+    {
+        Rtree t(tree);
+        t.insert(values.begin(), values.end());
+        BOOST_CHECK(t.remove(values.begin(), values.end()) == values.size());
+        check_tree(t, values);
+        BOOST_CHECK(t.remove(values) == values.size());
+        check_tree(t, Values());
+    }
+}
+
+template <typename Parameters>
+void test_bulk_remove(Parameters const& parameters, size_t count)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+    typedef std::pair<point_t, int> value_t;
+    typedef bgi::rtree<value_t, Parameters> rtree_t;
+
+    std::vector<value_t> values = generate_values<point_t>(count);
+
+    box_t const regions[] = { box_t(point_t(100, 100), point_t(600, 400)),
+                              box_t(point_t(-10, -10), point_t(2000, 500)),
+                              box_t(point_t(2000, 2000), point_t(3000, 3000)) };
+    size_t const regions_count = sizeof(regions) / sizeof(box_t);
+
+    // packed tree
+    rtree_t packed(values, parameters);
+    // tree created by the insertion of values one by one
+    rtree_t inserted(parameters);
+    for ( size_t i = 0 ; i < values.size() ; ++i )
+        inserted.insert(values[i]);
+
+    for ( size_t i = 0 ; i < regions_count ; ++i )
+    {
+        test_remove_if(packed, values, regions[i]);
+        test_remove_if(inserted, values, regions[i]);
+        if ( ! values.empty() )
+        {
+            test_remove_range(packed, values, regions[i]);
+            test_remove_range(inserted, values, regions[i]);
+        }
+    }
+}
+
+template <typename Parameters>
+void test_bulk_remove(Parameters const& parameters)
+{
+    size_t const counts[] = { 0, 1, 10, 100, 1000, 5000 };
+    size_t const counts_count = sizeof(counts) / sizeof(size_t);
+
+    for ( size_t i = 0 ; i < counts_count ; ++i )
+        test_bulk_remove(parameters, counts[i]);
+}
+
+int test_main(int, char* [])
+{
+    test_bulk_remove(bgi::linear<4, 1>());
+    test_bulk_remove(bgi::linear<4, 2>());
+    test_bulk_remove(bgi::quadratic<8, 3>());
+    test_bulk_remove(bgi::rstar<16, 4>());
+    test_bulk_remove(bgi::dynamic_rstar(16, 4));
+
+    return 0;
+}
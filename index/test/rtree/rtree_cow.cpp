@@ -0,0 +1,292 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// This test should also be run with ThreadSanitizer enabled, e.g. with GCC or Clang:
+// -fsanitize=thread
+
+#include <rtree/test_rtree.hpp>
+
+#include <boost/geometry/index/cow_rtree.hpp>
+#include <boost/geometry/index/detail/parallel.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+template <typename Point>
+std::vector<std::pair<Point, int> > generate_values(size_t count)
+{
+    std::vector<std::pair<Point, int> > values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        values.push_back(std::make_pair(Point(x, y), static_cast<int>(i)));
+    }
+    return values;
+}
+
+template <typename Values>
+std::vector<int> sorted_ids(Values const& values)
+{
+    std::vector<int> result;
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+        result.push_back(it->second);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+template <typename Values, typename Point>
+std::vector<double> sorted_distances(Values const& values, Point const& pt)
+{
+    std::vector<double> result;
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+        result.push_back(bg::comparable_distance(it->first, pt));
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+struct always_true
+{
+    template <typename Value>
+    bool operator()(Value const&) const { return true; }
+};
+
+// compares the results of the queries of the snapshot and of the rtree containing the same values
+template <typename Snapshot, typename Rtree, typename Box, typename Point>
+void check_snapshot(Snapshot const& s, Rtree const& expected, Box const& box, Point const& pt)
+{
+    typedef typename Rtree::value_type value_t;
+
+    BOOST_CHECK(s.size() == expected.size());
+    BOOST_CHECK(s.empty() == expected.empty());
+
+    std::vector<value_t> all;
+    BOOST_CHECK(s.query(bgi::satisfies(always_true()), std::back_inserter(all)) == expected.size());
+    BOOST_CHECK(all.size() == expected.size());
+
+    std::vector<value_t> result, expected_result;
+    s.query(bgi::intersects(box), std::back_inserter(result));
+    expected.query(bgi::intersects(box), std::back_inserter(expected_result));
+    BOOST_CHECK(sorted_ids(result) == sorted_ids(expected_result));
+
+    result.clear();
+    expected_result.clear();
+    s.query(bgi::nearest(pt, 5), std::back_inserter(result));
+    expected.query(bgi::nearest(pt, 5), std::back_inserter(expected_result));
+    // the same distances, the values may differ for equal distances
+    BOOST_CHECK(sorted_distances(result, pt) == sorted_distances(expected_result, pt));
+
+    result.clear();
+    s.query(bgi::nearest(pt, 5, bgi::best_first()), std::back_inserter(result));
+    BOOST_CHECK(sorted_distances(result, pt) == sorted_distances(expected_result, pt));
+}
+
+template <typename Parameters>
+void test_cow_rtree(Parameters const& parameters, size_t count)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+    typedef std::pair<point_t, int> value_t;
+    typedef bgi::rtree<value_t, Parameters> rtree_t;
+    typedef bgi::cow_rtree<value_t, Parameters> cow_rtree_t;
+    typedef typename cow_rtree_t::snapshot_type snapshot_t;
+
+    std::vector<value_t> values = generate_values<point_t>(count);
+
+    box_t const box(point_t(100, 100), point_t(600, 400));
+    point_t const pt(500, 500);
+
+    std::vector<snapshot_t> snapshots;
+    std::vector<rtree_t*> expected;
+
+    {
+        cow_rtree_t tree(parameters);
+        rtree_t reference(parameters);
+
+        // the snapshots taken after inserting subsequent values
+        for ( size_t i = 0 ; i < values.size() ; ++i )
+        {
+            tree.insert(values[i]);
+            reference.insert(values[i]);
+            if ( i % 97 == 0 )
+            {
+                snapshots.push_back(tree.snapshot());
+                expected.push_back(new rtree_t(reference));
+            }
+        }
+
+        BOOST_CHECK(tree.size() == values.size());
+        check_snapshot(tree.snapshot(), reference, box, pt);
+
+        // the snapshots taken after removing subsequent values
+        for ( size_t i = 0 ; i < values.size() ; i += 2 )
+        {
+            BOOST_CHECK(tree.remove(values[i]) == 1);
+            reference.remove(values[i]);
+            if ( i % 194 == 0 )
+            {
+                snapshots.push_back(tree.snapshot());
+                expected.push_back(new rtree_t(reference));
+            }
+        }
+
+        // not existing value
+        if ( ! values.empty() )
+            BOOST_CHECK(tree.remove(std::make_pair(values.front().first, -1)) == 0);
+
+        BOOST_CHECK(tree.size() == reference.size());
+        check_snapshot(tree.snapshot(), reference, box, pt);
+
+        // ranges
+        tree.insert(values.begin(), values.end());
+        reference.insert(values.begin(), values.end());
+        snapshots.push_back(tree.snapshot());
+        expected.push_back(new rtree_t(reference));
+
+        BOOST_CHECK(tree.remove(values.begin(), values.end()) == values.size());
+        reference.remove(values.begin(), values.end());
+        snapshots.push_back(tree.snapshot());
+        expected.push_back(new rtree_t(reference));
+
+        tree.clear();
+        reference.clear();
+        BOOST_CHECK(tree.empty());
+        check_snapshot(tree.snapshot(), reference, box, pt);
+
+        // the tree may be used after clearing
+        tree.insert(values.begin(), values.end());
+        reference.insert(values.begin(), values.end());
+        check_snapshot(tree.snapshot(), reference, box, pt);
+
+        // the older snapshots are released before the newer ones
+        for ( size_t i = 0 ; i < snapshots.size() / 2 ; ++i )
+        {
+            check_snapshot(snapshots[i], *expected[i], box, pt);
+            snapshots[i] = snapshot_t();
+        }
+
+        // the snapshots aren't affected by the modifications
+        for ( size_t i = 0 ; i < snapshots.size() ; ++i )
+        {
+            if ( i < snapshots.size() / 2 )
+                BOOST_CHECK(snapshots[i].empty());
+            else
+                check_snapshot(snapshots[i], *expected[i], box, pt);
+        }
+    }
+
+    // the snapshots are valid after the tree is destroyed, the newer are released first
+    for ( size_t i = snapshots.size() ; i > 0 ; --i )
+    {
+        if ( snapshots.size() / 2 < i )
+            check_snapshot(snapshots[i - 1], *expected[i - 1], box, pt);
+        snapshots[i - 1] = snapshot_t();
+        delete expected[i - 1];
+    }
+
+    // packed tree
+    {
+        cow_rtree_t tree(values, parameters);
+        rtree_t reference(values, parameters);
+        snapshot_t s = tree.snapshot();
+        rtree_t const s_expected(reference);
+
+        for ( size_t i = 0 ; i < values.size() ; i += 3 )
+        {
+            tree.remove(values[i]);
+            reference.remove(values[i]);
+        }
+
+        check_snapshot(tree.snapshot(), reference, box, pt);
+        check_snapshot(s, s_expected, box, pt);
+    }
+}
+
+#ifdef BOOST_GEOMETRY_INDEX_DETAIL_HAS_THREADS
+
+// the values are inserted by the writer while the readers query the snapshots
+template <typename Parameters>
+void test_cow_rtree_threads(Parameters const& parameters)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef std::pair<point_t, int> value_t;
+    typedef bgi::cow_rtree<value_t, Parameters> cow_rtree_t;
+    typedef typename cow_rtree_t::snapshot_type snapshot_t;
+
+    std::vector<value_t> const values = generate_values<point_t>(2000);
+
+    cow_rtree_t tree(parameters);
+    std::vector<int> errors(3, 0);
+
+    {
+        std::vector<bgi::detail::worker_thread*> readers;
+        for ( size_t t = 0 ; t < errors.size() ; ++t )
+        {
+            int & err = errors[t];
+            readers.push_back(new bgi::detail::worker_thread([&tree, &err, &values]()
+            {
+                for ( size_t i = 0 ; i < 200 ; ++i )
+                {
+                    snapshot_t s = tree.snapshot();
+                    std::vector<value_t> result;
+                    s.query(bgi::satisfies(always_true()), std::back_inserter(result));
+                    if ( result.size() != s.size() )
+                        ++err;
+                    // the writer inserts the values in order and then removes them in order
+                    std::vector<int> ids = sorted_ids(result);
+                    for ( size_t j = 1 ; j < ids.size() ; ++j )
+                        if ( ids[j] != ids[j - 1] + 1 )
+                            ++err;
+                }
+            }));
+        }
+
+        for ( size_t i = 0 ; i < values.size() ; ++i )
+            tree.insert(values[i]);
+        for ( size_t i = 0 ; i < values.size() / 2 ; ++i )
+            tree.remove(values[i]);
+
+        for ( size_t t = 0 ; t < readers.size() ; ++t )
+        {
+            readers[t]->join_and_rethrow();
+            delete readers[t];
+        }
+    }
+
+    for ( size_t t = 0 ; t < errors.size() ; ++t )
+        BOOST_CHECK(errors[t] == 0);
+    BOOST_CHECK(tree.size() == values.size() - values.size() / 2);
+}
+
+#endif // BOOST_GEOMETRY_INDEX_DETAIL_HAS_THREADS
+
+template <typename Parameters>
+void test_cow_rtree(Parameters const& parameters)
+{
+    size_t const counts[] = { 0, 1, 10, 100, 1000 };
+    size_t const counts_count = sizeof(counts) / sizeof(size_t);
+
+    for ( size_t i = 0 ; i < counts_count ; ++i )
+        test_cow_rtree(parameters, counts[i]);
+
+#ifdef BOOST_GEOMETRY_INDEX_DETAIL_HAS_THREADS
+    test_cow_rtree_threads(parameters);
+#endif
+}
+
+int test_main(int, char* [])
+{
+    test_cow_rtree(bgi::linear<4, 2>());
+    test_cow_rtree(bgi::quadratic<8, 3>());
+    test_cow_rtree(bgi::rstar<16, 4>());
+    test_cow_rtree(bgi::dynamic_rstar(16, 4));
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+typedef bg::model::point<double, 2, bg::cs::cartesian> point2d;
+typedef bg::model::box<point2d> box2d;
+typedef bg::model::point<double, 3, bg::cs::cartesian> point3d;
+typedef bg::model::box<point3d> box3d;
+
+// the samples (x, y, t), the time is much bigger than the coordinates
+point3d make_indexable(size_t i, point3d const*)
+{
+    return point3d(double((i * 7919) % 101), double((i * 104729) % 97), double(i * 1000));
+}
+
+box3d make_indexable(size_t i, box3d const*)
+{
+    point3d p = make_indexable(i, (point3d const*)0);
+    return box3d(p, point3d(bg::get<0>(p) + double(i % 5), bg::get<1>(p) + double(i % 3),
+                            bg::get<2>(p) + double(i % 7) * 500));
+}
+
+template <typename Indexable>
+std::vector<std::pair<Indexable, int> > generate_values(size_t count)
+{
+    std::vector<std::pair<Indexable, int> > values;
+    for ( size_t i = 0 ; i < count ; ++i )
+        values.push_back(std::make_pair(make_indexable(i, (Indexable const*)0), static_cast<int>(i)));
+    return values;
+}
+
+template <typename Values>
+std::vector<int> sorted_ids(Values const& values)
+{
+    std::vector<int> result;
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+        result.push_back(it->second);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// the expected values are found by checking 3d geometries
+template <typename Rtree, typename Predicates, typename Values>
+void check_query(Rtree const& tree, Predicates const& predicates, Values const& values, box3d const& box)
+{
+    Values expected;
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+        if ( bg::intersects(it->first, box) )
+            expected.push_back(*it);
+
+    Values result;
+    tree.query(predicates, std::back_inserter(result));
+    BOOST_CHECK(sorted_ids(result) == sorted_ids(expected));
+
+    result.clear();
+    std::copy(tree.qbegin(predicates), tree.qend(), std::back_inserter(result));
+    BOOST_CHECK(sorted_ids(result) == sorted_ids(expected));
+}
+
+template <typename Indexable, typename Params>
+void test_during(Params const& params, size_t count)
+{
+    typedef std::pair<Indexable, int> value_t;
+    typedef bgi::rtree<value_t, Params> rtree_t;
+
+    std::vector<value_t> values = generate_values<Indexable>(count);
+    rtree_t tree(values, params);
+
+    double const inf = 1e100;
+    for ( int i = 0 ; i < 10 ; ++i )
+    {
+        double const x = i * 7, y = i * 5, t = i * 17000.0;
+        box2d box(point2d(x, y), point2d(x + 30, y + 40));
+
+        check_query(tree, bgi::during(t, t + 5000), values,
+                    box3d(point3d(-inf, -inf, t), point3d(inf, inf, t + 5000)));
+        check_query(tree, bgi::during<2>(t, t + 5000), values,
+                    box3d(point3d(-inf, -inf, t), point3d(inf, inf, t + 5000)));
+        check_query(tree, bgi::during<0>(x, x + 10), values,
+                    box3d(point3d(x, -inf, -inf), point3d(x + 10, inf, inf)));
+        check_query(tree, bgi::intersects(box), values,
+                    box3d(point3d(x, y, -inf), point3d(x + 30, y + 40, inf)));
+        check_query(tree, bgi::intersects(box) && bgi::during(t, t + 100000), values,
+                    box3d(point3d(x, y, t), point3d(x + 30, y + 40, t + 100000)));
+        check_query(tree, bgi::during(t, t) && bgi::intersects(box), values,
+                    box3d(point3d(x, y, t), point3d(x + 30, y + 40, t)));
+    }
+
+    // the nearest values in the time interval
+    if ( ! values.empty() )
+    {
+        std::vector<value_t> result;
+        tree.query(bgi::nearest(values[0].first, 5) && bgi::during(10000.0, 20000.0), std::back_inserter(result));
+        BOOST_CHECK(result.size() == (std::min)(size_t(5), count <= 10 ? size_t(0) : count - 10));
+        for ( size_t i = 0 ; i < result.size() ; ++i )
+            BOOST_CHECK(bgi::detail::during_check(bgi::during(10000.0, 20000.0), result[i].first));
+    }
+}
+
+void test_segments()
+{
+    typedef bg::model::segment<point3d> segment_t;
+
+    segment_t s(point3d(0, 0, 10), point3d(1, 1, 5));
+    BOOST_CHECK(bgi::detail::during_check(bgi::during(0, 5), s));
+    BOOST_CHECK(bgi::detail::during_check(bgi::during(6, 7), s));
+    BOOST_CHECK(bgi::detail::during_check(bgi::during(10, 12), s));
+    BOOST_CHECK(! bgi::detail::during_check(bgi::during(0, 4), s));
+    BOOST_CHECK(! bgi::detail::during_check(bgi::during(11, 12), s));
+}
+
+int test_main(int, char* [])
+{
+    size_t const counts[] = { 0, 1, 30, 1000 };
+    for ( size_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i )
+    {
+        test_during<point3d>(bgi::linear<16, 4>(), counts[i]);
+        test_during<point3d>(bgi::dynamic_rstar(8, 3), counts[i]);
+        test_during<box3d>(bgi::quadratic<8, 3>(), counts[i]);
+        test_during<box3d>(bgi::rstar<4, 2>(), counts[i]);
+    }
+
+    test_segments();
+
+    return 0;
+}
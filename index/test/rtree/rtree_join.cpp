@@ -0,0 +1,136 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+
+#include <algorithm>
+#include <vector>
+
+struct same_parity
+{
+    template <typename Value1, typename Value2>
+    bool operator()(Value1 const& v1, Value2 const& v2) const
+    {
+        return v1.second % 2 == v2.second % 2;
+    }
+};
+
+struct always_true
+{
+    template <typename Value1, typename Value2>
+    bool operator()(Value1 const& , Value2 const& ) const
+    {
+        return true;
+    }
+};
+
+template <typename Indexable>
+std::vector<std::pair<Indexable, int> > generate_values(size_t count, int seed)
+{
+    std::vector<std::pair<Indexable, int> > values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919 + seed) % 1013);
+        int y = static_cast<int>((i * 104729 + seed) % 997);
+        values.push_back(std::make_pair(generate::value<Indexable>::apply(x, y), static_cast<int>(i)));
+    }
+    return values;
+}
+
+template <typename Pairs>
+std::vector<std::pair<int, int> > ids(Pairs const& pairs)
+{
+    std::vector<std::pair<int, int> > result;
+    for ( size_t i = 0 ; i < pairs.size() ; ++i )
+        result.push_back(std::make_pair(pairs[i].first.second, pairs[i].second.second));
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+template <typename Rtree1, typename Rtree2, typename Values1, typename Predicate>
+void check_join(Rtree1 const& tree1, Rtree2 const& tree2, Values1 const& values1, Predicate const& pred)
+{
+    typedef typename Rtree1::value_type value1_t;
+    typedef typename Rtree2::value_type value2_t;
+    typedef std::pair<value1_t, value2_t> pair_t;
+
+    // the result of the join
+    std::vector<pair_t> result;
+    size_t found = bgi::join(tree1, tree2, pred, std::back_inserter(result));
+    BOOST_CHECK(found == result.size());
+
+    // the result of queries performed for each value of the first tree
+    std::vector<pair_t> expected;
+    for ( size_t i = 0 ; i < values1.size() ; ++i )
+    {
+        std::vector<value2_t> found2;
+        tree2.query(bgi::intersects(values1[i].first), std::back_inserter(found2));
+        for ( size_t j = 0 ; j < found2.size() ; ++j )
+            if ( pred(values1[i], found2[j]) )
+                expected.push_back(pair_t(values1[i], found2[j]));
+    }
+
+    BOOST_CHECK(ids(result) == ids(expected));
+}
+
+template <typename Indexable1, typename Indexable2, typename Params1, typename Params2>
+void test_join(Params1 const& params1, Params2 const& params2, size_t count1, size_t count2)
+{
+    typedef std::pair<Indexable1, int> value1_t;
+    typedef std::pair<Indexable2, int> value2_t;
+    typedef bgi::rtree<value1_t, Params1> rtree1_t;
+    typedef bgi::rtree<value2_t, Params2> rtree2_t;
+
+    std::vector<value1_t> values1 = generate_values<Indexable1>(count1, 0);
+    std::vector<value2_t> values2 = generate_values<Indexable2>(count2, 3);
+
+    rtree1_t tree1(values1, params1);
+    rtree2_t tree2(params2);
+    // created with insert() to test trees with different structure
+    tree2.insert(values2);
+
+    check_join(tree1, tree2, values1, always_true());
+    check_join(tree1, tree2, values1, same_parity());
+
+    std::vector<std::pair<value1_t, value2_t> > result;
+    size_t found = bgi::join(tree1, tree2, std::back_inserter(result));
+    BOOST_CHECK(found == result.size());
+    std::vector<std::pair<value1_t, value2_t> > result_pred;
+    bgi::join(tree1, tree2, always_true(), std::back_inserter(result_pred));
+    BOOST_CHECK(ids(result) == ids(result_pred));
+}
+
+template <typename Indexable1, typename Indexable2>
+void test_join_all()
+{
+    size_t const counts[] = { 0, 1, 30, 1000 };
+    for ( size_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i )
+    {
+        for ( size_t j = 0 ; j < sizeof(counts) / sizeof(counts[0]) ; ++j )
+        {
+            test_join<Indexable1, Indexable2>(bgi::linear<16, 4>(), bgi::rstar<4, 2>(), counts[i], counts[j]);
+            test_join<Indexable1, Indexable2>(bgi::dynamic_quadratic(8, 3), bgi::quadratic<5, 2>(), counts[i], counts[j]);
+        }
+    }
+}
+
+int test_main(int, char* [])
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+    typedef bg::model::point<int, 2, bg::cs::cartesian> ipoint_t;
+    typedef bg::model::box<ipoint_t> ibox_t;
+
+    test_join_all<box_t, box_t>();
+    test_join_all<box_t, point_t>();
+    test_join_all<point_t, box_t>();
+    test_join_all<ibox_t, ibox_t>();
+
+    return 0;
+}
@@ -0,0 +1,234 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+
+#include <boost/geometry/index/mapped_rtree.hpp>
+
+#include <boost/typeof/typeof.hpp>
+
+#include <functional>
+#include <sstream>
+#include <vector>
+
+struct is_even
+{
+    template <typename Value>
+    bool operator()(Value const& v) const
+    {
+        return v.second % 2 == 0;
+    }
+};
+
+template <typename Indexable>
+std::vector<std::pair<Indexable, int> > generate_values(size_t count)
+{
+    std::vector<std::pair<Indexable, int> > values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        values.push_back(std::make_pair(generate::value<Indexable>::apply(x, y), static_cast<int>(i)));
+    }
+    return values;
+}
+
+// the data is copied into 8-byte aligned memory
+template <typename Rtree>
+std::vector<boost::uint64_t> write_aligned(Rtree const& tree, unsigned child_box_bits = 0)
+{
+    std::ostringstream os(std::ios::binary);
+    bgi::write_mapped(tree, os, child_box_bits);
+    std::string const str = os.str();
+
+    std::vector<boost::uint64_t> data((str.size() + 7) / 8 + 1);
+    std::copy(str.begin(), str.end(), reinterpret_cast<char*>(&data[0]));
+    return data;
+}
+
+template <typename Values>
+std::vector<int> sorted_ids(Values const& values)
+{
+    std::vector<int> result;
+    for ( size_t i = 0 ; i < values.size() ; ++i )
+        result.push_back(values[i].second);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+template <typename Rtree, typename Mapped, typename Predicates>
+void check_spatial(Rtree const& tree, Mapped const& mapped, Predicates const& predicates)
+{
+    typedef typename Rtree::value_type value_t;
+
+    std::vector<value_t> expected;
+    tree.query(predicates, std::back_inserter(expected));
+
+    std::vector<value_t> result;
+    size_t found = mapped.query(predicates, std::back_inserter(result));
+    BOOST_CHECK(found == result.size());
+    BOOST_CHECK(sorted_ids(result) == sorted_ids(expected));
+
+    std::vector<value_t> result_it;
+    std::copy(mapped.qbegin(predicates), mapped.qend(), std::back_inserter(result_it));
+    BOOST_CHECK(sorted_ids(result_it) == sorted_ids(expected));
+
+    std::vector<value_t> result_it_;
+    for ( BOOST_TYPEOF(mapped.qbegin_(predicates)) it = mapped.qbegin_(predicates) ;
+          it != mapped.qend_() ; ++it )
+    {
+        result_it_.push_back(*it);
+    }
+    BOOST_CHECK(sorted_ids(result_it_) == sorted_ids(expected));
+}
+
+// the results may differ for values having equal distances so the distances are compared
+template <typename Rtree, typename Mapped, typename Point, typename Predicates>
+void check_nearest(Rtree const& tree, Mapped const& mapped, Point const& pt, Predicates const& predicates)
+{
+    typedef typename Rtree::value_type value_t;
+
+    std::vector<value_t> expected;
+    tree.query(predicates, std::back_inserter(expected));
+
+    std::vector<value_t> result;
+    size_t found = bgi::query(mapped, predicates, std::back_inserter(result));
+    BOOST_CHECK(found == result.size());
+    BOOST_CHECK(result.size() == expected.size());
+
+    std::vector<value_t> result_it;
+    std::copy(mapped.qbegin(predicates), mapped.qend(), std::back_inserter(result_it));
+    BOOST_CHECK(result_it.size() == expected.size());
+
+    std::vector<double> expected_dists, result_dists, result_it_dists;
+    for ( size_t i = 0 ; i < expected.size() ; ++i )
+        expected_dists.push_back(bg::comparable_distance(pt, expected[i].first));
+    for ( size_t i = 0 ; i < result.size() ; ++i )
+        result_dists.push_back(bg::comparable_distance(pt, result[i].first));
+    for ( size_t i = 0 ; i < result_it.size() ; ++i )
+        result_it_dists.push_back(bg::comparable_distance(pt, result_it[i].first));
+
+    // the iterator returns the values in the order of increasing distance
+    BOOST_CHECK(std::adjacent_find(result_it_dists.begin(), result_it_dists.end(),
+                                   std::greater<double>()) == result_it_dists.end());
+
+    std::sort(expected_dists.begin(), expected_dists.end());
+    std::sort(result_dists.begin(), result_dists.end());
+    BOOST_CHECK(result_dists == expected_dists);
+    BOOST_CHECK(result_it_dists == expected_dists);
+}
+
+template <typename Indexable, typename Params>
+void test_mapped(Params const& params, size_t count, unsigned child_box_bits = 0)
+{
+    typedef typename bg::point_type<Indexable>::type point_t;
+    typedef bg::model::box<point_t> box_t;
+    typedef std::pair<Indexable, int> value_t;
+    typedef bgi::rtree<value_t, Params> rtree_t;
+    typedef bgi::mapped_rtree<value_t, Params> mapped_t;
+
+    std::vector<value_t> values = generate_values<Indexable>(count);
+    rtree_t tree(values, params);
+
+    std::vector<boost::uint64_t> data = write_aligned(tree, child_box_bits);
+    mapped_t mapped(&data[0], data.size() * 8, params);
+
+    // the internal nodes are smaller, unless the arrays of coordinates of a few
+    // children are padded to the cache line size anyway
+    if ( child_box_bits != 0 && mapped.depth() > 0 && params.get_max_elements() >= 16 )
+        BOOST_CHECK(data.size() < write_aligned(tree).size());
+
+    BOOST_CHECK(mapped.size() == tree.size());
+    BOOST_CHECK(mapped.empty() == tree.empty());
+
+    for ( int i = 0 ; i < 10 ; ++i )
+    {
+        point_t pt;
+        bg::assign_values(pt, i * 101 % 1013, i * 307 % 997);
+        box_t box;
+        bg::assign_values(box, bg::get<0>(pt) - 100, bg::get<1>(pt) - 100,
+                               bg::get<0>(pt) + 100, bg::get<1>(pt) + 100);
+
+        check_spatial(tree, mapped, bgi::intersects(box));
+        check_spatial(tree, mapped, bgi::within(box));
+        check_spatial(tree, mapped, bgi::within(box) && bgi::satisfies(is_even()));
+        check_spatial(tree, mapped, bgi::contains(point_t(bg::get<0>(pt), bg::get<1>(pt))));
+        check_spatial(tree, mapped, !bgi::disjoint(box));
+
+        check_nearest(tree, mapped, pt, bgi::nearest(pt, 1));
+        check_nearest(tree, mapped, pt, bgi::nearest(pt, 5 + i * 10));
+        check_nearest(tree, mapped, pt, bgi::nearest(pt, 10) && bgi::satisfies(is_even()));
+    }
+}
+
+template <typename Params>
+void test_invalid(Params const& params)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::point<float, 2, bg::cs::cartesian> point_f_t;
+    typedef std::pair<point_t, int> value_t;
+
+    bgi::rtree<value_t, Params> tree(generate_values<point_t>(100), params);
+    std::vector<boost::uint64_t> data = write_aligned(tree);
+
+    // different Value type
+    BOOST_CHECK_THROW((bgi::mapped_rtree<std::pair<point_f_t, int>, Params>(&data[0], data.size() * 8, params)),
+                      std::runtime_error);
+    // truncated
+    BOOST_CHECK_THROW((bgi::mapped_rtree<value_t, Params>(&data[0], data.size() * 8 - 64, params)),
+                      std::runtime_error);
+    // not aligned
+    BOOST_CHECK_THROW((bgi::mapped_rtree<value_t, Params>(reinterpret_cast<char*>(&data[0]) + 1, data.size() * 8 - 8, params)),
+                      std::runtime_error);
+    // invalid number of bits of quantized boxes
+    {
+        std::ostringstream os(std::ios::binary);
+        BOOST_CHECK_THROW(bgi::write_mapped(tree, os, 12), std::invalid_argument);
+    }
+    // quantized integral coordinates
+    {
+        typedef bg::model::point<int, 2, bg::cs::cartesian> point_i_t;
+        bgi::rtree<std::pair<point_i_t, int>, Params> tree_i(generate_values<point_i_t>(100), params);
+        std::ostringstream os(std::ios::binary);
+        BOOST_CHECK_THROW(bgi::write_mapped(tree_i, os, 8), std::invalid_argument);
+    }
+    // corrupted magic
+    data[0] = 0;
+    BOOST_CHECK_THROW((bgi::mapped_rtree<value_t, Params>(&data[0], data.size() * 8, params)),
+                      std::runtime_error);
+}
+
+int test_main(int, char* [])
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+    typedef bg::model::point<float, 2, bg::cs::cartesian> point_f_t;
+
+    test_mapped<point_t>(bgi::rstar<16, 4>(), 0);
+    test_mapped<point_t>(bgi::rstar<16, 4>(), 10);
+    test_mapped<point_t>(bgi::rstar<16, 4>(), 1000);
+    test_mapped<point_t>(bgi::linear<4, 2>(), 1000);
+    test_mapped<point_t>(bgi::dynamic_quadratic(8, 3), 1000);
+    test_mapped<box_t>(bgi::rstar<16, 4>(), 1000);
+    test_mapped<box_t>(bgi::dynamic_rstar(4, 2), 1000);
+    // more than 64 children in a node
+    test_mapped<point_f_t>(bgi::rstar<100, 30>(), 10000);
+
+    // quantized boxes of the children
+    test_mapped<point_t>(bgi::rstar<16, 4>(), 10, 8);
+    test_mapped<point_t>(bgi::rstar<16, 4>(), 1000, 8);
+    test_mapped<point_t>(bgi::linear<4, 2>(), 1000, 16);
+    test_mapped<box_t>(bgi::rstar<16, 4>(), 1000, 8);
+    test_mapped<box_t>(bgi::dynamic_rstar(4, 2), 1000, 16);
+    test_mapped<point_f_t>(bgi::rstar<100, 30>(), 10000, 8);
+
+    test_invalid(bgi::rstar<16, 4>());
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+template <typename Indexable>
+std::vector<std::pair<Indexable, int> > generate_values(size_t count, int seed)
+{
+    std::vector<std::pair<Indexable, int> > values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919 + seed) % 1013);
+        int y = static_cast<int>((i * 104729 + seed) % 997);
+        values.push_back(std::make_pair(generate::value<Indexable>::apply(x, y), static_cast<int>(i)));
+    }
+    return values;
+}
+
+// the results may differ for values having equal distances so the distances are compared
+template <typename Pairs>
+std::map<int, std::vector<double> > distances_per_first(Pairs const& pairs)
+{
+    std::map<int, std::vector<double> > result;
+    for ( size_t i = 0 ; i < pairs.size() ; ++i )
+        result[pairs[i].first.second].push_back(bg::comparable_distance(pairs[i].first.first, pairs[i].second.first));
+    return result;
+}
+
+template <typename Pairs>
+std::vector<double> distances(Pairs const& pairs)
+{
+    std::vector<double> result;
+    for ( size_t i = 0 ; i < pairs.size() ; ++i )
+        result.push_back(bg::comparable_distance(pairs[i].first.first, pairs[i].second.first));
+    return result;
+}
+
+template <typename Rtree1, typename Rtree2, typename Values1, typename Values2>
+void check_all_nearest(Rtree1 const& tree1, Rtree2 const& tree2,
+                       Values1 const& values1, Values2 const& values2, unsigned k)
+{
+    typedef typename Rtree1::value_type value1_t;
+    typedef typename Rtree2::value_type value2_t;
+    typedef std::pair<value1_t, value2_t> pair_t;
+
+    std::vector<pair_t> result;
+    size_t found = bgi::all_nearest(tree1, tree2, k, std::back_inserter(result));
+    BOOST_CHECK(found == result.size());
+    BOOST_CHECK(found == values1.size() * (std::min)(size_t(k), values2.size()));
+
+    // brute force
+    std::vector<pair_t> expected;
+    for ( size_t i = 0 ; i < values1.size() ; ++i )
+    {
+        std::vector<std::pair<double, size_t> > dists;
+        for ( size_t j = 0 ; j < values2.size() ; ++j )
+            dists.push_back(std::make_pair(bg::comparable_distance(values1[i].first, values2[j].first), j));
+        std::sort(dists.begin(), dists.end());
+        for ( size_t j = 0 ; j < dists.size() && j < k ; ++j )
+            expected.push_back(pair_t(values1[i], values2[dists[j].second]));
+    }
+
+    // the pairs are sorted by distance for each value of the first tree
+    BOOST_CHECK(distances_per_first(result) == distances_per_first(expected));
+}
+
+template <typename Rtree1, typename Rtree2, typename Values1, typename Values2>
+void check_closest_pairs(Rtree1 const& tree1, Rtree2 const& tree2,
+                         Values1 const& values1, Values2 const& values2, unsigned k)
+{
+    typedef typename Rtree1::value_type value1_t;
+    typedef typename Rtree2::value_type value2_t;
+    typedef std::pair<value1_t, value2_t> pair_t;
+
+    std::vector<pair_t> result;
+    size_t found = bgi::closest_pairs(tree1, tree2, k, std::back_inserter(result));
+    BOOST_CHECK(found == result.size());
+
+    // brute force
+    std::vector<double> expected;
+    for ( size_t i = 0 ; i < values1.size() ; ++i )
+        for ( size_t j = 0 ; j < values2.size() ; ++j )
+            expected.push_back(bg::comparable_distance(values1[i].first, values2[j].first));
+    std::sort(expected.begin(), expected.end());
+    if ( k < expected.size() )
+        expected.resize(k);
+
+    // the pairs are sorted by distance
+    BOOST_CHECK(distances(result) == expected);
+}
+
+template <typename Indexable1, typename Indexable2, typename Params1, typename Params2>
+void test_nearest_join(Params1 const& params1, Params2 const& params2, size_t count1, size_t count2)
+{
+    typedef std::pair<Indexable1, int> value1_t;
+    typedef std::pair<Indexable2, int> value2_t;
+    typedef bgi::rtree<value1_t, Params1> rtree1_t;
+    typedef bgi::rtree<value2_t, Params2> rtree2_t;
+
+    std::vector<value1_t> values1 = generate_values<Indexable1>(count1, 0);
+    std::vector<value2_t> values2 = generate_values<Indexable2>(count2, 3);
+
+    rtree1_t tree1(values1, params1);
+    rtree2_t tree2(params2);
+    // created with insert() to test trees with different structure
+    tree2.insert(values2);
+
+    unsigned const ks[] = { 1, 3, 10 };
+    for ( size_t i = 0 ; i < sizeof(ks) / sizeof(ks[0]) ; ++i )
+    {
+        check_all_nearest(tree1, tree2, values1, values2, ks[i]);
+        check_all_nearest(tree2, tree1, values2, values1, ks[i]);
+        check_closest_pairs(tree1, tree2, values1, values2, ks[i]);
+        check_closest_pairs(tree2, tree1, values2, values1, ks[i]);
+    }
+}
+
+template <typename Indexable1, typename Indexable2>
+void test_nearest_join_all()
+{
+    size_t const counts[] = { 0, 1, 30, 300 };
+    for ( size_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i )
+    {
+        for ( size_t j = 0 ; j < sizeof(counts) / sizeof(counts[0]) ; ++j )
+        {
+            test_nearest_join<Indexable1, Indexable2>(bgi::linear<16, 4>(), bgi::rstar<4, 2>(), counts[i], counts[j]);
+            test_nearest_join<Indexable1, Indexable2>(bgi::dynamic_quadratic(8, 3), bgi::quadratic<5, 2>(), counts[i], counts[j]);
+        }
+    }
+}
+
+int test_main(int, char* [])
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+
+    test_nearest_join_all<point_t, point_t>();
+    test_nearest_join_all<box_t, point_t>();
+    test_nearest_join_all<box_t, box_t>();
+
+    return 0;
+}
@@ -0,0 +1,159 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+
+#include <boost/geometry/index/detail/rtree/utilities/quality.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+template <typename Box>
+std::vector<std::pair<Box, int> > generate_values(size_t count)
+{
+    typedef typename bg::point_type<Box>::type point_t;
+
+    std::vector<std::pair<Box, int> > values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        int w = static_cast<int>(i % 13);
+        int h = static_cast<int>(i % 7);
+        values.push_back(std::make_pair(Box(point_t(x, y), point_t(x + w, y + h)), static_cast<int>(i)));
+    }
+    return values;
+}
+
+template <typename Values>
+std::vector<int> sorted_ids(Values const& values)
+{
+    std::vector<int> result;
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+        result.push_back(it->second);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+template <typename Quality>
+typename Quality::value_type::content_type total_overlap(Quality const& q)
+{
+    typename Quality::value_type::content_type result = 0;
+    for ( size_t i = 0 ; i < q.size() ; ++i )
+        result += q[i].overlap;
+    return result;
+}
+
+template <typename Rtree>
+void check_structure(Rtree const& tree)
+{
+    BOOST_CHECK(bgi::detail::rtree::utilities::are_counts_ok(tree));
+    BOOST_CHECK(bgi::detail::rtree::utilities::are_levels_ok(tree));
+    BOOST_CHECK(tree.empty() || bgi::detail::rtree::utilities::are_boxes_ok(tree));
+}
+
+template <typename Parameters>
+void test_optimize(Parameters const& parameters, size_t count)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+    typedef std::pair<box_t, int> value_t;
+    typedef bgi::rtree<value_t, Parameters> rtree_t;
+
+    std::vector<value_t> values = generate_values<box_t>(count);
+
+    // the tree is created by inserting and removing values one by one
+    rtree_t tree(parameters);
+    for ( size_t i = 0 ; i < values.size() ; ++i )
+        tree.insert(values[i]);
+    for ( size_t i = 0 ; i < values.size() ; i += 3 )
+        tree.remove(values[i]);
+
+    std::vector<value_t> all_before;
+    tree.query(bgi::intersects(tree.bounds()), std::back_inserter(all_before));
+
+    std::vector<bgi::detail::rtree::utilities::level_quality<box_t> >
+        before = bgi::detail::rtree::utilities::quality(tree);
+
+    size_t const repacked = bgi::optimize(tree, 0.05);
+    check_structure(tree);
+
+    std::vector<bgi::detail::rtree::utilities::level_quality<box_t> >
+        after = bgi::detail::rtree::utilities::quality(tree);
+
+    // the values and the depth aren't changed
+    std::vector<value_t> all_after;
+    tree.query(bgi::intersects(tree.bounds()), std::back_inserter(all_after));
+    BOOST_CHECK(sorted_ids(all_before) == sorted_ids(all_after));
+    BOOST_CHECK(tree.size() == all_before.size());
+    BOOST_CHECK(before.size() == after.size());
+
+    if ( 0 < repacked )
+        BOOST_CHECK(total_overlap(after) < total_overlap(before));
+    else
+        BOOST_CHECK(total_overlap(after) == total_overlap(before));
+
+    // the tree may be modified after optimization
+    for ( size_t i = 0 ; i < values.size() ; i += 3 )
+        tree.insert(values[i]);
+    for ( size_t i = 1 ; i < values.size() ; i += 3 )
+        BOOST_CHECK(tree.remove(values[i]) == 1);
+    check_structure(tree);
+    BOOST_CHECK(tree.size() == values.size() - (values.size() + 1) / 3);
+
+    // the subtrees overlapping less than the threshold aren't repacked
+    rtree_t empty_tree(parameters);
+    BOOST_CHECK(empty_tree.optimize() == 0);
+    BOOST_CHECK(tree.optimize(1e9) == 0);
+}
+
+// the quality of the tree containing one leaf
+template <typename Parameters>
+void test_quality(Parameters const& parameters)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+    typedef std::pair<box_t, int> value_t;
+    typedef bgi::rtree<value_t, Parameters> rtree_t;
+
+    rtree_t tree(parameters);
+    BOOST_CHECK(bgi::detail::rtree::utilities::quality(tree).empty());
+
+    tree.insert(std::make_pair(box_t(point_t(0, 0), point_t(2, 2)), 0));
+    tree.insert(std::make_pair(box_t(point_t(1, 1), point_t(4, 4)), 1));
+
+    std::vector<bgi::detail::rtree::utilities::level_quality<box_t> >
+        q = bgi::detail::rtree::utilities::quality(tree);
+
+    BOOST_CHECK(q.size() == 1);
+    BOOST_CHECK(q[0].nodes == 1);
+    BOOST_CHECK_CLOSE(double(q[0].content), 16.0, 0.0001);
+    BOOST_CHECK_CLOSE(double(q[0].margin), 8.0, 0.0001);
+    BOOST_CHECK(q[0].overlap == 0);
+    // 16 - (4 + 9 - 1)
+    BOOST_CHECK_CLOSE(double(q[0].dead_space), 4.0, 0.0001);
+}
+
+int test_main(int, char* [])
+{
+    size_t const counts[] = { 0, 10, 100, 3000 };
+    for ( size_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i )
+    {
+        test_optimize(bgi::linear<4, 2>(), counts[i]);
+        test_optimize(bgi::quadratic<8, 3>(), counts[i]);
+        test_optimize(bgi::rstar<16, 4>(), counts[i]);
+        test_optimize(bgi::dynamic_linear(16, 4), counts[i]);
+    }
+
+    test_quality(bgi::linear<4, 2>());
+    test_quality(bgi::dynamic_rstar(16, 4));
+
+    return 0;
+}
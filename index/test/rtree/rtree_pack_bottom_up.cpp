@@ -0,0 +1,121 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/geometry/index/detail/rtree/utilities/are_boxes_ok.hpp>
+#include <boost/geometry/index/detail/rtree/utilities/are_counts_ok.hpp>
+#include <boost/geometry/index/detail/rtree/utilities/are_levels_ok.hpp>
+
+template <typename Rtree, typename Params>
+void check_counts(Rtree const& tree, Params const&)
+{
+    BOOST_CHECK(tree.empty() || bgi::detail::rtree::utilities::are_counts_ok(tree));
+}
+
+template <typename Rtree>
+void check_counts(Rtree const& , bgi::dynamic_quadratic const&)
+{}
+
+template <typename Rtree, typename Value>
+void check_packed_tree(Rtree const& reference, Rtree const& tree, std::vector<Value> const& values)
+{
+    namespace bgiu = bgi::detail::rtree::utilities;
+    typedef typename Rtree::bounds_type box_t;
+    typedef typename bg::point_type<box_t>::type point_t;
+
+    BOOST_CHECK(tree.size() == values.size());
+    BOOST_CHECK(tree.empty() || bgiu::are_boxes_ok(tree));
+    BOOST_CHECK(tree.empty() || bgiu::are_levels_ok(tree));
+    check_counts(tree, tree.parameters());
+
+    // every value is stored in the tree
+    for ( size_t i = 0 ; i < values.size() ; i += 97 )
+        BOOST_CHECK(tree.count(values[i]) == reference.count(values[i]));
+
+    // queries return the same values as in the case of the default algorithm
+    box_t qbox(point_t(100, 100), point_t(400, 400));
+    std::vector<Value> result1, result2;
+    reference.query(bgi::intersects(qbox), std::back_inserter(result1));
+    tree.query(bgi::intersects(qbox), std::back_inserter(result2));
+    BOOST_CHECK(result1.size() == result2.size());
+
+    result1.clear();
+    result2.clear();
+    reference.query(bgi::nearest(point_t(500, 500), 10), std::back_inserter(result1));
+    tree.query(bgi::nearest(point_t(500, 500), 10), std::back_inserter(result2));
+    BOOST_CHECK(result1.size() == result2.size());
+}
+
+template <typename Value, typename Params>
+void test_rtree(Params const& params, size_t count)
+{
+    typedef bgi::rtree<Value, Params> rtree_t;
+
+    std::vector<Value> values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        values.push_back(generate::value<Value>::apply(x, y));
+    }
+
+    rtree_t reference(values, params);
+
+    rtree_t top_down(values.begin(), values.end(), params, bgi::packing::top_down());
+    BOOST_CHECK(std::equal(reference.begin(), reference.end(), top_down.begin(),
+                           bgi::equal_to<Value>()));
+
+    rtree_t str(values.begin(), values.end(), params, bgi::packing::str());
+    check_packed_tree(reference, str, values);
+    rtree_t hilbert(values.begin(), values.end(), params, bgi::packing::hilbert());
+    check_packed_tree(reference, hilbert, values);
+    rtree_t z_order(values.begin(), values.end(), params, bgi::packing::z_order());
+    check_packed_tree(reference, z_order, values);
+
+    rtree_t str_rng(values, params, bgi::packing::str());
+    check_packed_tree(reference, str_rng, values);
+    rtree_t hilbert_rng(values, params, bgi::packing::hilbert());
+    check_packed_tree(reference, hilbert_rng, values);
+
+    // the tree remains valid after modifications
+    for ( size_t i = 0 ; i < values.size() ; i += 3 )
+        hilbert.remove(values[i]);
+    for ( size_t i = 0 ; i < values.size() ; i += 3 )
+        hilbert.insert(values[i]);
+    check_packed_tree(reference, hilbert, values);
+}
+
+template <typename Value>
+void test_rtree_all()
+{
+    size_t const counts[] = { 0, 1, 5, 17, 177, 5000, 20000 };
+    for ( size_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i )
+    {
+        test_rtree<Value>(bgi::linear<16, 4>(), counts[i]);
+        test_rtree<Value>(bgi::rstar<5, 2>(), counts[i]);
+        test_rtree<Value>(bgi::dynamic_quadratic(8, 3), counts[i]);
+    }
+}
+
+int test_main(int, char* [])
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::point<int, 2, bg::cs::cartesian> ipoint_t;
+    typedef bg::model::box<point_t> box_t;
+
+    test_rtree_all<point_t>();
+    test_rtree_all<ipoint_t>();
+    test_rtree_all<std::pair<box_t, int> >();
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2011-2020 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+template <typename Point>
+std::vector<std::pair<Point, int> > generate_values(size_t first_id, size_t count)
+{
+    std::vector<std::pair<Point, int> > values;
+    for ( size_t i = first_id ; i < first_id + count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        values.push_back(std::make_pair(Point(x, y), static_cast<int>(i)));
+    }
+    return values;
+}
+
+template <typename Values>
+std::vector<int> sorted_ids(Values const& values)
+{
+    std::vector<int> result;
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+        result.push_back(it->second);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// wraps an iterator to hide the forward iterator category
+template <typename It>
+class input_iterator
+{
+public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef typename std::iterator_traits<It>::value_type value_type;
+    typedef typename std::iterator_traits<It>::difference_type difference_type;
+    typedef typename std::iterator_traits<It>::pointer pointer;
+    typedef typename std::iterator_traits<It>::reference reference;
+
+    explicit input_iterator(It it) : m_it(it) {}
+
+    reference operator*() const { return *m_it; }
+    pointer operator->() const { return &*m_it; }
+    input_iterator & operator++() { ++m_it; return *this; }
+    input_iterator operator++(int) { input_iterator result = *this; ++m_it; return result; }
+    bool operator==(input_iterator const& other) const { return m_it == other.m_it; }
+    bool operator!=(input_iterator const& other) const { return m_it != other.m_it; }
+
+private:
+    It m_it;
+};
+
+struct always_true
+{
+    template <typename Value>
+    bool operator()(Value const&) const { return true; }
+};
+
+template <typename Rtree, typename Values>
+void check_tree(Rtree const& tree, Values const& values)
+{
+    typedef typename Rtree::bounds_type box_t;
+    typedef typename bg::point_type<box_t>::type point_t;
+
+    BOOST_CHECK(tree.size() == values.size());
+    BOOST_CHECK(bgi::detail::rtree::utilities::are_counts_ok(tree));
+    BOOST_CHECK(bgi::detail::rtree::utilities::are_levels_ok(tree));
+    BOOST_CHECK(bgi::detail::rtree::utilities::are_boxes_ok(tree));
+
+    Values all;
+    tree.query(bgi::satisfies(always_true()), std::back_inserter(all));
+    BOOST_CHECK(sorted_ids(all) == sorted_ids(values));
+
+    box_t query_box(point_t(100, 100), point_t(600, 400));
+    Values expected;
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+    {
+        if ( bg::intersects(it->first, query_box) )
+            expected.push_back(*it);
+    }
+    Values result;
+    tree.query(bgi::intersects(query_box), std::back_inserter(result));
+    BOOST_CHECK(sorted_ids(result) == sorted_ids(expected));
+}
+
+template <typename Parameters>
+void test_pack_insert(Parameters const& parameters, size_t existing_count, size_t inserted_count)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef std::pair<point_t, int> value_t;
+    typedef bgi::rtree<value_t, Parameters> rtree_t;
+    typedef typename std::vector<value_t>::const_iterator iterator_t;
+
+    std::vector<value_t> existing = generate_values<point_t>(0, existing_count);
+    std::vector<value_t> inserted = generate_values<point_t>(existing_count, inserted_count);
+    std::vector<value_t> all = existing;
+    all.insert(all.end(), inserted.begin(), inserted.end());
+
+    // forward iterators
+    {
+        rtree_t tree(existing, parameters);
+        tree.insert(inserted.begin(), inserted.end());
+        check_tree(tree, all);
+
+        // the tree may be modified after the insertion
+        BOOST_CHECK(tree.remove(existing.begin(), existing.end()) == existing_count);
+        check_tree(tree, inserted);
+        tree.insert(existing.begin(), existing.end());
+        check_tree(tree, all);
+    }
+
+    // range
+    {
+        rtree_t tree(parameters);
+        tree.insert(existing);
+        tree.insert(inserted);
+        check_tree(tree, all);
+    }
+
+    // input iterators, the values are inserted one by one
+    {
+        rtree_t tree(existing, parameters);
+        tree.insert(input_iterator<iterator_t>(inserted.begin()),
+                    input_iterator<iterator_t>(inserted.end()));
+        check_tree(tree, all);
+    }
+
+    // the same values are inserted one by one
+    {
+        rtree_t tree(parameters);
+        for ( iterator_t it = existing.begin() ; it != existing.end() ; ++it )
+            tree.insert(*it);
+        tree.insert(inserted.begin(), inserted.end());
+        check_tree(tree, all);
+    }
+}
+
+template <typename Parameters>
+void test_pack_insert(Parameters const& parameters)
+{
+    size_t const counts[] = { 0, 1, 10, 100, 1000, 10000 };
+    size_t const counts_count = sizeof(counts) / sizeof(size_t);
+
+    for ( size_t i = 0 ; i < counts_count ; ++i )
+        for ( size_t j = 0 ; j < counts_count ; ++j )
+            test_pack_insert(parameters, counts[i], counts[j]);
+}
+
+int test_main(int, char* [])
+{
+    test_pack_insert(bgi::linear<4, 2>());
+    test_pack_insert(bgi::quadratic<8, 3>());
+    test_pack_insert(bgi::rstar<16, 4>());
+    test_pack_insert(bgi::dynamic_rstar(16, 4));
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/geometry/index/detail/rtree/utilities/are_boxes_ok.hpp>
+#include <boost/geometry/index/detail/rtree/utilities/are_levels_ok.hpp>
+
+template <typename Rtree>
+void check_the_same_trees(Rtree const& serial, Rtree const& parallel)
+{
+    namespace bgiu = bgi::detail::rtree::utilities;
+
+    BOOST_CHECK(serial.size() == parallel.size());
+    BOOST_CHECK(bgiu::view<Rtree>(serial).depth() == bgiu::view<Rtree>(parallel).depth());
+    BOOST_CHECK(parallel.empty() || bgiu::are_boxes_ok(parallel));
+    BOOST_CHECK(parallel.empty() || bgiu::are_levels_ok(parallel));
+
+    // the order of values reflects the structure of the tree
+    BOOST_CHECK(std::equal(serial.begin(), serial.end(), parallel.begin(),
+                           bgi::equal_to<typename Rtree::value_type>()));
+}
+
+template <typename Value, typename Params>
+void test_rtree(Params const& params, size_t count)
+{
+    typedef bgi::rtree<Value, Params> rtree_t;
+    typedef typename rtree_t::bounds_type box_t;
+
+    std::vector<Value> values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        values.push_back(generate::value<Value>::apply(x, y));
+    }
+
+    rtree_t serial(values.begin(), values.end(), params);
+
+    for ( size_t threads = 1 ; threads <= 8 ; threads *= 2 )
+    {
+        rtree_t parallel(values.begin(), values.end(), params, threads);
+        check_the_same_trees(serial, parallel);
+
+        rtree_t parallel_rng(values, params, threads);
+        check_the_same_trees(serial, parallel_rng);
+    }
+
+    box_t qbox(typename bg::point_type<box_t>::type(100, 100),
+               typename bg::point_type<box_t>::type(400, 400));
+    rtree_t parallel(values, params, 4);
+    std::vector<Value> result1, result2;
+    serial.query(bgi::intersects(qbox), std::back_inserter(result1));
+    parallel.query(bgi::intersects(qbox), std::back_inserter(result2));
+    BOOST_CHECK(result1.size() == result2.size());
+    BOOST_CHECK(std::equal(result1.begin(), result1.end(), result2.begin(),
+                           bgi::equal_to<Value>()));
+}
+
+template <typename Value>
+void test_rtree_all()
+{
+    size_t const counts[] = { 0, 1, 177, 5000, 20000, 100000 };
+    for ( size_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i )
+    {
+        test_rtree<Value>(bgi::linear<16, 4>(), counts[i]);
+        test_rtree<Value>(bgi::rstar<5, 2>(), counts[i]);
+        test_rtree<Value>(bgi::dynamic_quadratic(8, 3), counts[i]);
+    }
+}
+
+int test_main(int, char* [])
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+
+    test_rtree_all<point_t>();
+    test_rtree_all<std::pair<box_t, int> >();
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include <boost/geometry/geometries/point_xy.hpp>
+
+template <typename Point, size_t D = bg::dimension<Point>::value>
+struct point_maker
+{
+    static Point apply(int x, int y, int)
+    {
+        Point p;
+        bg::assign_values(p, x, y);
+        return p;
+    }
+};
+
+template <typename Point>
+struct point_maker<Point, 3>
+{
+    static Point apply(int x, int y, int z)
+    {
+        Point p;
+        bg::assign_values(p, x, y, z);
+        return p;
+    }
+};
+
+// the points are placed on a grid so many of them lie on the boundaries of the query boxes
+template <typename Point>
+std::vector<std::pair<Point, int> > generate_values(size_t count)
+{
+    std::vector<std::pair<Point, int> > values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        Point p = point_maker<Point>::apply(static_cast<int>((i * 7) % 20),
+                                            static_cast<int>((i * 13) % 20),
+                                            static_cast<int>(i % 3));
+        values.push_back(std::make_pair(p, static_cast<int>(i)));
+    }
+    return values;
+}
+
+template <typename Values>
+std::vector<int> sorted_ids(Values const& values)
+{
+    std::vector<int> result;
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+        result.push_back(it->second);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+template <typename Rtree, typename Predicates, typename Values, typename Check>
+void check_query(Rtree const& tree, Predicates const& predicates, Values const& values, Check const& check)
+{
+    Values expected;
+    for ( typename Values::const_iterator it = values.begin() ; it != values.end() ; ++it )
+        if ( check(it->first) )
+            expected.push_back(*it);
+
+    Values result;
+    tree.query(predicates, std::back_inserter(result));
+    BOOST_CHECK(sorted_ids(result) == sorted_ids(expected));
+}
+
+template <typename Box>
+struct intersects_box
+{
+    intersects_box(Box const& b) : box(b) {}
+    template <typename Point> bool operator()(Point const& p) const { return bg::intersects(p, box); }
+    Box box;
+};
+
+template <typename Box>
+struct covered_by_box
+{
+    covered_by_box(Box const& b) : box(b) {}
+    template <typename Point> bool operator()(Point const& p) const { return bg::covered_by(p, box); }
+    Box box;
+};
+
+template <typename Box>
+struct within_box
+{
+    within_box(Box const& b) : box(b) {}
+    template <typename Point> bool operator()(Point const& p) const { return bg::within(p, box); }
+    Box box;
+};
+
+template <typename Box>
+struct disjoint_box
+{
+    disjoint_box(Box const& b) : box(b) {}
+    template <typename Point> bool operator()(Point const& p) const { return bg::disjoint(p, box); }
+    Box box;
+};
+
+template <typename Check>
+struct negated
+{
+    negated(Check const& c) : check(c) {}
+    template <typename Point> bool operator()(Point const& p) const { return ! check(p); }
+    Check check;
+};
+
+template <typename Point, typename Params>
+void test_point_predicates(Params const& params, size_t count)
+{
+    typedef bg::model::box<Point> box_t;
+    typedef std::pair<Point, int> value_t;
+    typedef bgi::rtree<value_t, Params> rtree_t;
+
+    std::vector<value_t> values = generate_values<Point>(count);
+    rtree_t tree(values, params);
+
+    for ( int i = 0 ; i < 10 ; ++i )
+    {
+        box_t box(point_maker<Point>::apply(i, (i * 3) % 10, i % 3),
+                  point_maker<Point>::apply(i + 5, (i * 3) % 10 + i, 2));
+
+        check_query(tree, bgi::intersects(box), values, intersects_box<box_t>(box));
+        check_query(tree, bgi::covered_by(box), values, covered_by_box<box_t>(box));
+        check_query(tree, bgi::within(box), values, within_box<box_t>(box));
+        check_query(tree, bgi::disjoint(box), values, disjoint_box<box_t>(box));
+        check_query(tree, !bgi::covered_by(box), values, negated<covered_by_box<box_t> >(covered_by_box<box_t>(box)));
+        check_query(tree, !bgi::disjoint(box), values, intersects_box<box_t>(box));
+    }
+}
+
+template <typename Point>
+void test_point_box_coordinates()
+{
+    typedef bg::model::box<Point> box_t;
+    typedef bgi::detail::point_box_coordinates<Point, box_t> kernel;
+
+    box_t box(point_maker<Point>::apply(1, 1, 1), point_maker<Point>::apply(3, 3, 3));
+
+    for ( int x = 0 ; x <= 4 ; ++x )
+    {
+        for ( int y = 0 ; y <= 4 ; ++y )
+        {
+            for ( int z = 1 ; z <= 2 ; ++z )
+            {
+                Point p = point_maker<Point>::apply(x, y, z);
+                BOOST_CHECK(kernel::covered_by(p, box) == bg::covered_by(p, box));
+                BOOST_CHECK(kernel::within(p, box) == bg::within(p, box));
+            }
+        }
+    }
+}
+
+int test_main(int, char* [])
+{
+    typedef bg::model::point<int, 2, bg::cs::cartesian> pi2;
+    typedef bg::model::point<double, 3, bg::cs::cartesian> pd3;
+    typedef bg::model::d2::point_xy<float> pf2;
+
+    BOOST_MPL_ASSERT((bgi::detail::is_cartesian_point_box<pi2, bg::model::box<pi2> >));
+    BOOST_MPL_ASSERT_NOT((bgi::detail::is_cartesian_point_box<bg::model::box<pi2>, bg::model::box<pi2> >));
+    BOOST_MPL_ASSERT_NOT((bgi::detail::is_cartesian_point_box<pd3, bg::model::box<pi2> >));
+
+    test_point_box_coordinates<pi2>();
+    test_point_box_coordinates<pd3>();
+    test_point_box_coordinates<pf2>();
+
+    size_t const counts[] = { 0, 1, 30, 1000 };
+    for ( size_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i )
+    {
+        test_point_predicates<pi2>(bgi::linear<16, 4>(), counts[i]);
+        test_point_predicates<pd3>(bgi::quadratic<8, 3>(), counts[i]);
+        test_point_predicates<pf2>(bgi::dynamic_rstar(4, 2), counts[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+#include <rtree/test_allocation_hooks.hpp>
+
+#include <vector>
+
+struct is_even
+{
+    template <typename Value>
+    bool operator()(Value const& v) const
+    {
+        return v.second % 2 == 0;
+    }
+};
+
+template <typename Point>
+std::vector<std::pair<Point, int> > generate_values(size_t count)
+{
+    std::vector<std::pair<Point, int> > values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        values.push_back(std::make_pair(Point(x, y), static_cast<int>(i)));
+    }
+    return values;
+}
+
+template <typename Values>
+std::vector<int> ids(Values const& values)
+{
+    std::vector<int> result;
+    for ( size_t i = 0 ; i < values.size() ; ++i )
+        result.push_back(values[i].second);
+    return result;
+}
+
+template <typename Rtree, typename Predicates>
+void check_query(Rtree const& tree, Predicates const& predicates, bgi::query_context & ctx)
+{
+    typedef typename Rtree::value_type value_t;
+
+    std::vector<value_t> expected;
+    tree.query(predicates, std::back_inserter(expected));
+
+    std::vector<value_t> result;
+    size_t found = tree.query(predicates, std::back_inserter(result), ctx);
+    BOOST_CHECK(found == result.size());
+    BOOST_CHECK(ids(result) == ids(expected));
+
+    std::vector<value_t> result_it;
+    for ( typename Rtree::const_query_iterator it = tree.qbegin(predicates, ctx) ;
+          it != tree.qend() ; ++it )
+    {
+        result_it.push_back(*it);
+    }
+
+    std::vector<value_t> expected_it;
+    std::copy(tree.qbegin(predicates), tree.qend(), std::back_inserter(expected_it));
+    BOOST_CHECK(ids(result_it) == ids(expected_it));
+}
+
+// the same buffers are used by many different queries
+template <typename Params>
+void test_results(Params const& params, size_t count)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+    typedef std::pair<point_t, int> value_t;
+    typedef bgi::rtree<value_t, Params> rtree_t;
+
+    std::vector<value_t> values = generate_values<point_t>(count);
+    rtree_t tree(values, params);
+
+    bgi::query_context ctx;
+    for ( int i = 0 ; i < 10 ; ++i )
+    {
+        point_t pt(i * 101 % 1013, i * 307 % 997);
+        box_t box(point_t(pt.get<0>() - 100, pt.get<1>() - 100),
+                  point_t(pt.get<0>() + 100, pt.get<1>() + 100));
+
+        check_query(tree, bgi::nearest(pt, 1), ctx);
+        check_query(tree, bgi::nearest(pt, 5 + i * 10), ctx);
+        check_query(tree, bgi::nearest(pt, 10) && bgi::satisfies(is_even()), ctx);
+        check_query(tree, bgi::nearest(box, 10), ctx);
+        check_query(tree, bgi::intersects(box), ctx);
+    }
+
+    // the iterator copies don't use the buffers
+    if ( ! values.empty() )
+    {
+        typename rtree_t::const_query_iterator it = tree.qbegin(bgi::nearest(values[0].first, 3), ctx);
+        typename rtree_t::const_query_iterator it2 = it;
+        BOOST_CHECK(it == it2);
+        ++it2;
+        BOOST_CHECK(it != it2);
+        BOOST_CHECK(it->second == values[0].second);
+    }
+
+    ctx.clear();
+    if ( ! values.empty() )
+        check_query(tree, bgi::nearest(values[0].first, 5), ctx);
+}
+
+// the subsequent queries don't allocate memory
+template <typename Params>
+void test_allocations(Params const& params)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef std::pair<point_t, int> value_t;
+    typedef bgi::rtree<value_t, Params> rtree_t;
+
+    std::vector<value_t> values = generate_values<point_t>(1000);
+    rtree_t tree(params);
+    tree.insert(values);
+
+    std::vector<value_t> result;
+    result.reserve(100);
+
+    bgi::query_context ctx;
+    // the buffers grow to the required size
+    for ( int i = 0 ; i < 10 ; ++i )
+    {
+        point_t pt(i * 101 % 1013, i * 307 % 997);
+        result.clear();
+        tree.query(bgi::nearest(pt, 100), std::back_inserter(result), ctx);
+    }
+
+    size_t const allocations_before = allocations_count;
+    for ( int i = 0 ; i < 10 ; ++i )
+    {
+        point_t pt(i * 101 % 1013, i * 307 % 997);
+        result.clear();
+        tree.query(bgi::nearest(pt, 100), std::back_inserter(result), ctx);
+        BOOST_CHECK(result.size() == 100);
+    }
+    BOOST_CHECK_EQUAL(allocations_count, allocations_before);
+}
+
+template <typename Params>
+void test_iterator_allocations(Params const& params)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef std::pair<point_t, int> value_t;
+    typedef bgi::rtree<value_t, Params> rtree_t;
+
+    std::vector<value_t> values = generate_values<point_t>(1000);
+    rtree_t tree(params);
+    tree.insert(values);
+
+    bgi::query_context ctx;
+    size_t allocations_before = 0;
+    for ( int i = 0 ; i < 20 ; ++i )
+    {
+        // the buffers grow to the required size in the first 10 queries
+        if ( i == 10 )
+            allocations_before = allocations_count;
+
+        point_t pt(i % 10 * 101 % 1013, i % 10 * 307 % 997);
+        size_t found = 0;
+        for ( typename rtree_t::const_query_iterator it = tree.qbegin(bgi::nearest(pt, 100), ctx) ;
+              it != tree.qend() ; ++it )
+            ++found;
+        BOOST_CHECK(found == 100);
+    }
+    // the polymorphic iterators are created in the internal buffers
+    BOOST_CHECK_EQUAL(allocations_count, allocations_before);
+}
+
+int test_main(int, char* [])
+{
+    size_t const counts[] = { 0, 1, 30, 1000 };
+    for ( size_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i )
+    {
+        test_results(bgi::linear<16, 4>(), counts[i]);
+        test_results(bgi::dynamic_quadratic(8, 3), counts[i]);
+        test_results(bgi::rstar<4, 2>(), counts[i]);
+    }
+
+    test_allocations(bgi::linear<16, 4>());
+    test_allocations(bgi::dynamic_rstar(8, 3));
+    // the lists of branches are std::vectors if the parameters are dynamic
+    test_iterator_allocations(bgi::linear<16, 4>());
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// This test should also be run with ThreadSanitizer enabled, e.g. with GCC or Clang:
+// -fsanitize=thread
+
+#include <rtree/test_rtree.hpp>
+
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+struct test_exception : std::runtime_error
+{
+    test_exception() : std::runtime_error("test_exception") {}
+};
+
+// throws for the values of the query of a given index
+struct throwing_for_query
+{
+    throwing_for_query(int q, int tq) : query(q), throwing_query(tq) {}
+
+    template <typename Value>
+    bool operator()(Value const& ) const
+    {
+        if ( query == throwing_query )
+            throw test_exception();
+        return true;
+    }
+
+    int query;
+    int throwing_query;
+};
+
+template <typename Rtree, typename Predicates>
+void check_query_parallel(Rtree const& tree, std::vector<Predicates> const& predicates, size_t threads_count)
+{
+    typedef typename Rtree::value_type value_t;
+    typedef std::back_insert_iterator<std::vector<value_t> > out_iter_t;
+
+    std::vector<std::vector<value_t> > results(predicates.size());
+    std::vector<out_iter_t> outs;
+    for ( size_t i = 0 ; i < predicates.size() ; ++i )
+        outs.push_back(std::back_inserter(results[i]));
+
+    size_t found = bgi::query_parallel(tree, predicates, outs, threads_count);
+
+    size_t expected_found = 0;
+    for ( size_t i = 0 ; i < predicates.size() ; ++i )
+    {
+        std::vector<value_t> expected;
+        expected_found += tree.query(predicates[i], std::back_inserter(expected));
+
+        // the same algorithm is used so the order of values is also the same
+        BOOST_CHECK(expected.size() == results[i].size());
+        BOOST_CHECK(std::equal(expected.begin(), expected.end(), results[i].begin(),
+                               bgi::equal_to<value_t>()));
+    }
+
+    BOOST_CHECK(found == expected_found);
+}
+
+template <typename Value, typename Params>
+void test_rtree(Params const& params, size_t count, size_t queries_count)
+{
+    typedef bgi::rtree<Value, Params> rtree_t;
+    typedef typename rtree_t::bounds_type box_t;
+    typedef typename bg::point_type<box_t>::type point_t;
+
+    std::vector<Value> values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        values.push_back(generate::value<Value>::apply(x, y));
+    }
+
+    rtree_t const tree(values, params);
+
+    std::vector<bgi::detail::predicates::spatial_predicate<box_t, bgi::detail::predicates::intersects_tag, false> >
+        intersects_predicates;
+    std::vector<bgi::detail::predicates::nearest<point_t> > nearest_predicates;
+    for ( size_t i = 0 ; i < queries_count ; ++i )
+    {
+        int x = static_cast<int>((i * 31) % 1000);
+        int y = static_cast<int>((i * 17) % 1000);
+        int s = static_cast<int>(i % 50);
+        intersects_predicates.push_back(bgi::intersects(box_t(point_t(x, y), point_t(x + s, y + s))));
+        nearest_predicates.push_back(bgi::nearest(point_t(x, y), 1 + i % 20));
+    }
+
+    size_t const threads_counts[] = { 0, 1, 2, 4, 8 };
+    for ( size_t i = 0 ; i < sizeof(threads_counts) / sizeof(threads_counts[0]) ; ++i )
+    {
+        check_query_parallel(tree, intersects_predicates, threads_counts[i]);
+        check_query_parallel(tree, nearest_predicates, threads_counts[i]);
+    }
+}
+
+template <typename Value>
+void test_exceptions(size_t threads_count)
+{
+    typedef bgi::rtree<Value, bgi::linear<16> > rtree_t;
+    typedef bgi::detail::predicates::satisfies<throwing_for_query, false> pred_t;
+
+    std::vector<Value> values;
+    for ( int i = 0 ; i < 1000 ; ++i )
+        values.push_back(generate::value<Value>::apply(i % 100, i / 100));
+    rtree_t const tree(values);
+
+    std::vector<pred_t> predicates;
+    for ( int i = 0 ; i < 1000 ; ++i )
+        predicates.push_back(bgi::satisfies(throwing_for_query(i, 500)));
+
+    std::vector<std::vector<Value> > results(predicates.size());
+    std::vector<std::back_insert_iterator<std::vector<Value> > > outs;
+    for ( size_t i = 0 ; i < predicates.size() ; ++i )
+        outs.push_back(std::back_inserter(results[i]));
+
+    BOOST_CHECK_THROW(bgi::query_parallel(tree, predicates, outs, threads_count), test_exception);
+}
+
+template <typename Value>
+void test_rtree_all()
+{
+    size_t const counts[] = { 0, 1, 177, 5000 };
+    for ( size_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i )
+    {
+        test_rtree<Value>(bgi::linear<16, 4>(), counts[i], 0);
+        test_rtree<Value>(bgi::linear<16, 4>(), counts[i], 1);
+        test_rtree<Value>(bgi::rstar<5, 2>(), counts[i], 2000);
+        test_rtree<Value>(bgi::dynamic_quadratic(8, 3), counts[i], 300);
+    }
+
+    test_exceptions<Value>(1);
+    test_exceptions<Value>(4);
+}
+
+int test_main(int, char* [])
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+
+    test_rtree_all<point_t>();
+    test_rtree_all<std::pair<box_t, int> >();
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+struct is_even
+{
+    template <typename Value>
+    bool operator()(Value const& v) const
+    {
+        return v.second % 2 == 0;
+    }
+};
+
+struct always_true
+{
+    template <typename Value>
+    bool operator()(Value const&) const { return true; }
+};
+
+template <typename Point>
+std::vector<std::pair<Point, int> > generate_values(size_t count)
+{
+    std::vector<std::pair<Point, int> > values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        values.push_back(std::make_pair(Point(x, y), static_cast<int>(i)));
+    }
+    return values;
+}
+
+template <typename Values>
+std::vector<int> ids(Values const& values)
+{
+    std::vector<int> result;
+    for ( size_t i = 0 ; i < values.size() ; ++i )
+        result.push_back(values[i].second);
+    return result;
+}
+
+// each checked child is either visited or rejected, the root is visited without checking
+void check_consistency(bgi::query_statistics const& s)
+{
+    BOOST_CHECK(s.empty_leafs <= s.leafs);
+    BOOST_CHECK(s.found_values <= s.checked_values);
+    BOOST_CHECK(s.rejected_nodes <= s.checked_nodes);
+    BOOST_CHECK_EQUAL(s.checked_nodes - s.rejected_nodes + 1, s.internal_nodes + s.leafs);
+}
+
+template <typename Rtree, typename Predicates>
+void check_query(Rtree const& tree, Predicates const& predicates, bool is_knn)
+{
+    typedef typename Rtree::value_type value_t;
+
+    if ( tree.empty() )
+    {
+        bgi::query_statistics stats;
+        std::vector<value_t> result;
+        BOOST_CHECK(tree.query(predicates, std::back_inserter(result), stats) == 0);
+        BOOST_CHECK(tree.qbegin(predicates, stats) == tree.qend());
+        BOOST_CHECK(stats.internal_nodes + stats.leafs == 0);
+        return;
+    }
+
+    // the results aren't affected by the statistics
+    std::vector<value_t> expected;
+    tree.query(predicates, std::back_inserter(expected));
+
+    bgi::query_statistics stats;
+    std::vector<value_t> result;
+    size_t found = bgi::query(tree, predicates, std::back_inserter(result), stats);
+    BOOST_CHECK(found == result.size());
+    BOOST_CHECK(ids(result) == ids(expected));
+
+    check_consistency(stats);
+    BOOST_CHECK(0 < stats.leafs);
+    if ( is_knn )
+        BOOST_CHECK(result.size() <= stats.found_values);
+    else
+        BOOST_CHECK_EQUAL(stats.found_values, result.size());
+
+    // the iterators gather the statistics while they're incremented
+    std::vector<value_t> expected_it;
+    std::copy(tree.qbegin(predicates), tree.qend(), std::back_inserter(expected_it));
+
+    bgi::query_statistics stats_it;
+    std::vector<value_t> result_it;
+    std::copy(bgi::qbegin(tree, predicates, stats_it), bgi::qend(tree), std::back_inserter(result_it));
+    BOOST_CHECK(ids(result_it) == ids(expected_it));
+
+    check_consistency(stats_it);
+    if ( is_knn )
+        BOOST_CHECK(result_it.size() <= stats_it.found_values);
+    else
+        BOOST_CHECK_EQUAL(stats_it.found_values, result_it.size());
+
+    // the counters are increased by subsequent queries
+    bgi::query_statistics sum = stats;
+    sum += stats_it;
+    tree.query(predicates, std::back_inserter(result), stats);
+    BOOST_CHECK_EQUAL(stats.leafs, 2 * (sum.leafs - stats_it.leafs));
+    BOOST_CHECK_EQUAL(stats.checked_values, 2 * (sum.checked_values - stats_it.checked_values));
+
+    stats.reset();
+    BOOST_CHECK(stats.internal_nodes == 0 && stats.leafs == 0 && stats.checked_nodes == 0
+             && stats.rejected_nodes == 0 && stats.checked_values == 0 && stats.found_values == 0
+             && stats.empty_leafs == 0);
+}
+
+template <typename Params>
+void test_query_statistics(Params const& params, size_t count)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+    typedef std::pair<point_t, int> value_t;
+    typedef bgi::rtree<value_t, Params> rtree_t;
+
+    std::vector<value_t> values = generate_values<point_t>(count);
+    rtree_t tree(values, params);
+
+    for ( int i = 0 ; i < 5 ; ++i )
+    {
+        point_t pt(i * 101 % 1013, i * 307 % 997);
+        box_t box(point_t(pt.get<0>() - 100, pt.get<1>() - 100),
+                  point_t(pt.get<0>() + 100, pt.get<1>() + 100));
+
+        check_query(tree, bgi::intersects(box), false);
+        check_query(tree, bgi::disjoint(box), false);
+        check_query(tree, bgi::intersects(box) && bgi::satisfies(is_even()), false);
+        check_query(tree, bgi::nearest(pt, 1), true);
+        check_query(tree, bgi::nearest(pt, 10) && bgi::satisfies(is_even()), true);
+    }
+
+    // all nodes and values are visited and no leaf is empty
+    if ( ! values.empty() )
+    {
+        bgi::query_statistics stats;
+        std::vector<value_t> result;
+        tree.query(bgi::satisfies(always_true()), std::back_inserter(result), stats);
+        BOOST_CHECK_EQUAL(stats.checked_values, values.size());
+        BOOST_CHECK_EQUAL(stats.found_values, values.size());
+        BOOST_CHECK_EQUAL(stats.rejected_nodes, 0u);
+        BOOST_CHECK_EQUAL(stats.empty_leafs, 0u);
+        BOOST_CHECK_EQUAL(stats.checked_nodes + 1, stats.internal_nodes + stats.leafs);
+    }
+
+    // no value meets the predicates so all visited leafs are empty
+    if ( ! values.empty() )
+    {
+        bgi::query_statistics stats;
+        std::vector<value_t> result;
+        tree.query(bgi::intersects(tree.bounds()) && bgi::satisfies(is_even()) && !bgi::satisfies(is_even()),
+                   std::back_inserter(result), stats);
+        BOOST_CHECK(result.empty());
+        BOOST_CHECK_EQUAL(stats.found_values, 0u);
+        BOOST_CHECK_EQUAL(stats.empty_leafs, stats.leafs);
+    }
+}
+
+int test_main(int, char* [])
+{
+    size_t const counts[] = { 0, 1, 30, 1000 };
+    for ( size_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i )
+    {
+        test_query_statistics(bgi::linear<16, 4>(), counts[i]);
+        test_query_statistics(bgi::dynamic_quadratic(8, 3), counts[i]);
+        test_query_statistics(bgi::rstar<4, 2>(), counts[i]);
+    }
+
+    return 0;
+}
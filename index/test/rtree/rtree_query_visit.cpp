@@ -0,0 +1,298 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <rtree/test_rtree.hpp>
+#include <rtree/test_allocation_hooks.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+struct is_even
+{
+    template <typename Value>
+    bool operator()(Value const& v) const
+    {
+        return v.second % 2 == 0;
+    }
+};
+
+// the predicate too big to be stored in the buffer of the type-erased iterator
+struct is_even_big
+{
+    is_even_big() { data[0] = 0; }
+
+    template <typename Value>
+    bool operator()(Value const& v) const
+    {
+        return v.second % 2 == data[0];
+    }
+
+    int data[256];
+};
+
+template <typename Value>
+struct push_back
+{
+    push_back(std::vector<Value> & r) : result(boost::addressof(r)) {}
+
+    void operator()(Value const& v) const
+    {
+        result->push_back(v);
+    }
+
+    std::vector<Value> * result;
+};
+
+// the state of the function object is returned from the query
+struct count_values
+{
+    count_values() : count(0) {}
+
+    template <typename Value>
+    void operator()(Value const& ) { ++count; }
+
+    size_t count;
+};
+
+template <typename Point>
+std::vector<std::pair<Point, int> > generate_values(size_t count)
+{
+    std::vector<std::pair<Point, int> > values;
+    for ( size_t i = 0 ; i < count ; ++i )
+    {
+        int x = static_cast<int>((i * 7919) % 1013);
+        int y = static_cast<int>((i * 104729) % 997);
+        values.push_back(std::make_pair(Point(x, y), static_cast<int>(i)));
+    }
+    return values;
+}
+
+template <typename Values>
+std::vector<int> ids(Values const& values)
+{
+    std::vector<int> result;
+    for ( size_t i = 0 ; i < values.size() ; ++i )
+        result.push_back(values[i].second);
+    return result;
+}
+
+template <typename Values>
+std::vector<int> sorted_ids(Values const& values)
+{
+    std::vector<int> result = ids(values);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+template <typename Rtree, typename Predicates>
+void check_query(Rtree const& tree, Predicates const& predicates)
+{
+    typedef typename Rtree::value_type value_t;
+    typedef typename Rtree::const_query_iterator iterator_t;
+
+    std::vector<value_t> expected;
+    tree.query(predicates, std::back_inserter(expected));
+
+    // the function object is called for each value
+    std::vector<value_t> result;
+    tree.query_visit(predicates, push_back<value_t>(result));
+    BOOST_CHECK(ids(result) == ids(expected));
+
+    result.clear();
+    bgi::query_visit(tree, predicates, push_back<value_t>(result));
+    BOOST_CHECK(ids(result) == ids(expected));
+
+    BOOST_CHECK_EQUAL(tree.query_visit(predicates, count_values()).count, expected.size());
+    BOOST_CHECK_EQUAL(bgi::query_visit(tree, predicates, count_values()).count, expected.size());
+
+    // the type-erased iterators
+    std::vector<value_t> expected_it;
+    std::copy(tree.qbegin(predicates), tree.qend(), std::back_inserter(expected_it));
+    BOOST_CHECK(sorted_ids(expected_it) == sorted_ids(expected));
+
+    std::vector<value_t> result_it;
+
+    if ( expected_it.empty() )
+    {
+        BOOST_CHECK(tree.qbegin(predicates) == tree.qend());
+        return;
+    }
+
+    // copies
+    iterator_t it = tree.qbegin(predicates);
+    iterator_t it2 = it;
+    BOOST_CHECK(it == it2);
+    ++it2;
+    BOOST_CHECK(it != it2);
+    BOOST_CHECK(it->second == expected_it[0].second);
+
+    // assignments
+    it2 = it;
+    BOOST_CHECK(it == it2);
+    it2 = it2;
+    BOOST_CHECK(it == it2);
+    it2 = tree.qend();
+    BOOST_CHECK(it2 == tree.qend());
+    it2 = tree.qbegin(predicates);
+    BOOST_CHECK(it == it2);
+
+    // post-increment
+    iterator_t it3 = it2++;
+    BOOST_CHECK(it3 == it);
+    if ( 1 < expected_it.size() )
+        BOOST_CHECK(it2->second == expected_it[1].second);
+
+    // the iterators are moved and swapped
+    std::vector<iterator_t> iterators;
+    iterators.push_back(it);
+    iterators.push_back(it2);
+    iterators.push_back(iterator_t());
+    std::swap(iterators[0], iterators[2]);
+    BOOST_CHECK(iterators[0] == tree.qend());
+    BOOST_CHECK(iterators[1] == it2);
+    BOOST_CHECK(iterators[2] == it);
+
+    result_it.clear();
+    for ( ; iterators[2] != tree.qend() ; ++iterators[2] )
+        result_it.push_back(*iterators[2]);
+    BOOST_CHECK(ids(result_it) == ids(expected_it));
+}
+
+template <typename Params>
+void test_query_visit(Params const& params, size_t count)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+    typedef std::pair<point_t, int> value_t;
+    typedef bgi::rtree<value_t, Params> rtree_t;
+
+    std::vector<value_t> values = generate_values<point_t>(count);
+    rtree_t tree(values, params);
+
+    for ( int i = 0 ; i < 5 ; ++i )
+    {
+        point_t pt(i * 101 % 1013, i * 307 % 997);
+        box_t box(point_t(pt.get<0>() - 100, pt.get<1>() - 100),
+                  point_t(pt.get<0>() + 100, pt.get<1>() + 100));
+
+        check_query(tree, bgi::intersects(box));
+        check_query(tree, bgi::intersects(box) && bgi::satisfies(is_even()));
+        check_query(tree, bgi::intersects(box) && bgi::satisfies(is_even_big()));
+        check_query(tree, bgi::nearest(pt, 10));
+        check_query(tree, bgi::nearest(pt, 10) && bgi::satisfies(is_even_big()));
+    }
+}
+
+// the iterators fitting the buffer aren't allocated
+template <typename Params>
+void test_allocations(Params const& params)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef bg::model::box<point_t> box_t;
+    typedef std::pair<point_t, int> value_t;
+    typedef bgi::rtree<value_t, Params> rtree_t;
+    typedef typename rtree_t::const_query_iterator iterator_t;
+
+    rtree_t tree(params);
+    box_t box(point_t(0, 0), point_t(10, 10));
+
+    size_t allocations_before = allocations_count;
+    {
+        iterator_t it = tree.qbegin(bgi::intersects(box));
+        iterator_t it2 = it;
+        it2 = it;
+        BOOST_CHECK(it == tree.qend());
+    }
+    BOOST_CHECK_EQUAL(allocations_count, allocations_before);
+
+    allocations_before = allocations_count;
+    {
+        iterator_t it = tree.qbegin(bgi::intersects(box) && bgi::satisfies(is_even_big()));
+        BOOST_CHECK(it == tree.qend());
+    }
+    BOOST_CHECK_EQUAL(allocations_count, allocations_before + 1);
+
+    // no memory is allocated by the query itself
+    tree.insert(generate_values<point_t>(100));
+    allocations_before = allocations_count;
+    size_t found = tree.query_visit(bgi::intersects(tree.bounds()), count_values()).count;
+    BOOST_CHECK_EQUAL(found, 100u);
+    BOOST_CHECK_EQUAL(allocations_count, allocations_before);
+}
+
+// the knn iterators are created in place and take the memory from the context
+// so nothing is allocated after the buffers grew to the required size
+template <typename Params>
+void test_knn_allocations(Params const& params)
+{
+    typedef bg::model::point<double, 2, bg::cs::cartesian> point_t;
+    typedef std::pair<point_t, int> value_t;
+    typedef bgi::rtree<value_t, Params> rtree_t;
+    typedef typename rtree_t::const_query_iterator iterator_t;
+
+    rtree_t tree(generate_values<point_t>(1000), params);
+    point_t pt(500, 500);
+
+    bgi::query_context ctx;
+    size_t allocations_before = 0;
+    size_t found = 0;
+    for ( int i = 0 ; i < 2 ; ++i )
+    {
+        allocations_before = allocations_count;
+        found = 0;
+        for ( iterator_t it = tree.qbegin(bgi::nearest(pt, 10), ctx) ; it != tree.qend() ; ++it )
+            ++found;
+    }
+    BOOST_CHECK_EQUAL(allocations_count, allocations_before);
+    BOOST_CHECK_EQUAL(found, 10u);
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    // the state of the moved iterator is taken over, the containers aren't copied
+    {
+        iterator_t it = tree.qbegin(bgi::nearest(pt, 10));
+        ++it;
+        int const id = it->second;
+
+        allocations_before = allocations_count;
+        iterator_t it2(std::move(it));
+        BOOST_CHECK_EQUAL(allocations_count, allocations_before);
+        BOOST_CHECK_EQUAL(it2->second, id);
+
+        it = std::move(it2);
+        BOOST_CHECK_EQUAL(allocations_count, allocations_before);
+        BOOST_CHECK_EQUAL(it->second, id);
+
+        found = 1;
+        for ( ; it != tree.qend() ; ++it )
+            ++found;
+        BOOST_CHECK_EQUAL(found, 10u);
+    }
+#endif
+}
+
+int test_main(int, char* [])
+{
+    size_t const counts[] = { 0, 1, 30, 1000 };
+    for ( size_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i )
+    {
+        test_query_visit(bgi::linear<16, 4>(), counts[i]);
+        test_query_visit(bgi::dynamic_quadratic(8, 3), counts[i]);
+        test_query_visit(bgi::rstar<4, 2>(), counts[i]);
+    }
+
+    test_allocations(bgi::linear<16, 4>());
+    test_allocations(bgi::dynamic_rstar(4, 2));
+    // the lists of branches are std::vectors if the parameters are dynamic
+    test_knn_allocations(bgi::linear<16, 4>());
+    test_knn_allocations(bgi::rstar<4, 2>());
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+// Boost.Geometry Index
+// Unit Test
+
+// Copyright (c) 2015 Adam Wulkiewicz, Lodz, Poland.
+
+// Use, modification and distribution is subject to the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// Replaces the global operator new and operator delete with the versions
+// counting the allocations and deallocations. The functions are defined here
+// and are not inline so this header may be included only in the one translation
+// unit of a test program which checks the allocations.
+
+#ifndef BOOST_GEOMETRY_INDEX_TEST_RTREE_ALLOCATION_HOOKS_HPP
+#define BOOST_GEOMETRY_INDEX_TEST_RTREE_ALLOCATION_HOOKS_HPP
+
+#include <cstdlib>
+#include <new>
+
+#include <boost/config.hpp>
+
+size_t allocations_count = 0;
+size_t deallocations_count = 0;
+
+void * operator new(std::size_t size)
+{
+    ++allocations_count;
+    void * p = std::malloc(size ? size : 1);
+    if ( p == 0 )
+        throw std::bad_alloc();
+    return p;
+}
+
+// noinline because otherwise GCC reports mismatched new/delete for the inlined free()
+BOOST_NOINLINE void operator delete(void * p) BOOST_NOEXCEPT
+{
+    if ( p )
+        ++deallocations_count;
+    std::free(p);
+}
+
+BOOST_NOINLINE void operator delete(void * p, std::size_t) BOOST_NOEXCEPT
+{
+    ::operator delete(p);
+}
+
+#endif // BOOST_GEOMETRY_INDEX_TEST_RTREE_ALLOCATION_HOOKS_HPP